@@ -0,0 +1,670 @@
+// Cooks the content caches that the demo otherwise fills on the first load of each model, without a GPU
+// Usage: content-cooker <content dir> [--jobs <count>] [--force]
+//
+// For every glTF under the directory, this writes the same files as FScene::LoadGltf does:
+// - .model-cache/<stem>.mesh-cache, with the generated tangents, meshlets and draw order index buffers
+// - .content-cache/<key>.dds and the manifest, with the mips and block compression of the material textures, and the vMF
+//   prefiltered normal/roughness pairs
+// And for every .hdr, the .content-cache/<key>.envmap that FTextureCache::CacheHDRI reads, with the prefiltered cubemap and the SH
+// baked on the CPU by envmap-filter instead of by the compute passes. These are keyed apart from the results of the compute passes,
+// which they don't match exactly, and CacheHDRI only uses them when it has none of its own cached.
+// Everything is keyed by content, so entries that are already cached are skipped and re-running after an edit only cooks what
+// changed. --force cooks everything again.
+
+#include <mesh-utils.h>
+#include <image-decode.h>
+#include <profiling.h>
+#include <common.h>
+#include <stb_image.h>
+#include <DirectXTex.h>
+#include <content-cache.h>
+#include <content-index.h>
+#include <normal-roughness-filter.h>
+#include <envmap-filter.h>
+#include <DirectXPackedVector.h>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <set>
+#include <map>
+#include <unordered_set>
+
+// The tool doesn't link the renderer, so CPU events are no-ops
+Profiling::ScopedCpuEvent::ScopedCpuEvent(const char* groupName, const char* eventName, uint64_t color) {}
+Profiling::ScopedCpuEvent::ScopedCpuEvent(const char* groupName, const wchar_t* eventName, uint64_t color) {}
+Profiling::ScopedCpuEvent::~ScopedCpuEvent() {}
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double GetSeconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	struct FOptions
+	{
+		std::filesystem::path m_root;
+		size_t m_jobCount = std::max(std::thread::hardware_concurrency(), 1u);
+		bool m_bForce = false;
+	};
+
+	// Same as LoadImageCallback in scene.cpp. The encoded bytes key the texture cache, and are only decoded if the texture is cooked.
+	bool KeepEncodedImage(
+		tinygltf::Image* image,
+		const int image_idx,
+		std::string* err,
+		std::string* warn,
+		int req_width,
+		int req_height,
+		const unsigned char* bytes,
+		int size,
+		void* user_data)
+	{
+		int width, height, component;
+		if (!stbi_info_from_memory(bytes, size, &width, &height, &component))
+		{
+			if (err)
+			{
+				*err += "Unknown image format. " + std::string{ stbi_failure_reason() } + "\n";
+			}
+
+			return false;
+		}
+
+		image->width = width;
+		image->height = height;
+		image->component = 4;
+		image->bits = 8;
+		image->pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+		image->image.assign(bytes, bytes + size);
+		return true;
+	}
+
+	bool LoadModel(const std::filesystem::path& filepath, tinygltf::Model& model)
+	{
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(&KeepEncodedImage, nullptr);
+
+		std::string errors, warnings;
+		const bool ok = loader.LoadASCIIFromFile(&model, &errors, &warnings, filepath.string());
+		if (!warnings.empty())
+		{
+			printf("Warn: %s\n", warnings.c_str());
+		}
+
+		if (!errors.empty())
+		{
+			printf("Error: %s\n", errors.c_str());
+		}
+
+		return ok;
+	}
+
+	// A texture that LoadMaterial would load, or a normal/roughness pair that it would prefilter together
+	struct FTextureJob
+	{
+		const tinygltf::Image* m_image;
+		DXGI_FORMAT m_srcFormat;
+		DXGI_FORMAT m_compressedFormat;
+		uint64_t m_key;
+
+		// Only set for a prefiltered pair, in which case the fields above are for the normal map
+		const tinygltf::Image* m_metallicRoughnessImage = nullptr;
+		DXGI_FORMAT m_metallicRoughnessFormat = DXGI_FORMAT_UNKNOWN;
+		uint64_t m_metallicRoughnessKey = 0;
+	};
+
+	struct FCookedTexture
+	{
+		uint64_t m_key;
+		ContentCache::FEntry m_entry;
+	};
+
+	// Collects the textures of a model that aren't cached yet. Slots are compressed with ContentCache::GetTextureSettings(), and prefiltered
+	// pairs keyed by ContentCache::GetPrefilteredTextureKeys(), like FScene::LoadMaterial does.
+	class FTextureGatherer
+	{
+	public:
+		FTextureGatherer(const tinygltf::Model& model, const ContentCache::FManifest& manifest, bool bForce) :
+			m_model{ model }, m_manifest{ manifest }, m_bForce{ bForce } {}
+
+		void AddMaterial(const tinygltf::Material& material)
+		{
+			AddTexture(material.emissiveTexture.index, ContentCache::TextureSlot::Emissive);
+			AddTexture(material.pbrMetallicRoughness.baseColorTexture.index, ContentCache::TextureSlot::BaseColor);
+			AddTexture(material.occlusionTexture.index, ContentCache::TextureSlot::Occlusion);
+			AddNormalRoughness(
+				material.normalTexture.index, ContentCache::TextureSlot::Normal,
+				material.pbrMetallicRoughness.metallicRoughnessTexture.index, ContentCache::TextureSlot::MetallicRoughness);
+
+			auto transmissionIt = material.extensions.find("KHR_materials_transmission");
+			if (transmissionIt != material.extensions.cend() && transmissionIt->second.Has("transmissionTexture"))
+			{
+				AddTexture(transmissionIt->second.Get("transmissionTexture").Get("index").GetNumberAsInt(), ContentCache::TextureSlot::Transmission);
+			}
+
+			auto clearcoatIt = material.extensions.find("KHR_materials_clearcoat");
+			if (clearcoatIt != material.extensions.cend())
+			{
+				const tinygltf::Value& clearcoat = clearcoatIt->second;
+				auto GetTextureIndex = [&clearcoat](const char* name) { return clearcoat.Has(name) ? clearcoat.Get(name).Get("index").GetNumberAsInt() : -1; };
+				AddTexture(GetTextureIndex("clearcoatTexture"), ContentCache::TextureSlot::Clearcoat);
+				AddNormalRoughness(
+					GetTextureIndex("clearcoatNormalTexture"), ContentCache::TextureSlot::ClearcoatNormal,
+					GetTextureIndex("clearcoatRoughnessTexture"), ContentCache::TextureSlot::ClearcoatRoughness);
+			}
+		}
+
+		const std::vector<FTextureJob>& GetJobs() const { return m_jobs; }
+		size_t GetCachedCount() const { return m_cachedCount; }
+
+	private:
+		const tinygltf::Image* GetImage(int textureIndex) const
+		{
+			return textureIndex != -1 ? &m_model.images[m_model.textures[textureIndex].source] : nullptr;
+		}
+
+		// Returns true if the key still has to be cooked. Keys that are shared by several textures are only cooked once.
+		bool Claim(uint64_t key)
+		{
+			if (!m_bForce && m_manifest.Find(key))
+			{
+				m_cachedCount++;
+				return false;
+			}
+
+			return m_claimedKeys.insert(key).second;
+		}
+
+		void AddTexture(int textureIndex, ContentCache::TextureSlot slot)
+		{
+			const tinygltf::Image* image = GetImage(textureIndex);
+			if (!image)
+				return;
+
+			const ContentCache::FTextureSettings settings = ContentCache::GetTextureSettings(slot);
+			const uint64_t key = ContentCache::GetTextureKey(ContentCache::HashSource(image->image), slot);
+			if (Claim(key))
+			{
+				m_jobs.push_back({ image, (DXGI_FORMAT)settings.m_srcFormat, (DXGI_FORMAT)settings.m_compressedFormat, key });
+			}
+		}
+
+		void AddNormalRoughness(int normalTextureIndex, ContentCache::TextureSlot normalSlot, int roughnessTextureIndex, ContentCache::TextureSlot roughnessSlot)
+		{
+			const tinygltf::Image* normalmap = GetImage(normalTextureIndex);
+			const tinygltf::Image* metallicRoughnessmap = GetImage(roughnessTextureIndex);
+
+			// Maps without the other half of the pair are filtered individually
+			if (!normalmap || !metallicRoughnessmap)
+			{
+				AddTexture(roughnessTextureIndex, roughnessSlot);
+				AddTexture(normalTextureIndex, normalSlot);
+				return;
+			}
+
+			if (normalmap->width != metallicRoughnessmap->width || normalmap->height != metallicRoughnessmap->height)
+			{
+				printf("Skipped prefiltering %s and %s, which have different sizes\n", normalmap->uri.c_str(), metallicRoughnessmap->uri.c_str());
+				return;
+			}
+
+			const auto [normalmapKey, metallicRoughnessKey] = ContentCache::GetPrefilteredTextureKeys(
+				ContentCache::HashSource(normalmap->image),
+				ContentCache::HashSource(metallicRoughnessmap->image));
+
+			const bool bNormalmapClaimed = Claim(normalmapKey);
+			const bool bMetallicRoughnessClaimed = Claim(metallicRoughnessKey);
+			if (bNormalmapClaimed || bMetallicRoughnessClaimed)
+			{
+				m_jobs.push_back({
+					normalmap,
+					(DXGI_FORMAT)ContentCache::PrefilteredNormalSettings.m_srcFormat,
+					(DXGI_FORMAT)ContentCache::PrefilteredNormalSettings.m_compressedFormat,
+					normalmapKey,
+					metallicRoughnessmap,
+					(DXGI_FORMAT)ContentCache::PrefilteredRoughnessSettings.m_compressedFormat,
+					metallicRoughnessKey });
+			}
+		}
+
+		const tinygltf::Model& m_model;
+		const ContentCache::FManifest& m_manifest;
+		bool m_bForce;
+		std::vector<FTextureJob> m_jobs;
+		std::unordered_set<uint64_t> m_claimedKeys;
+		size_t m_cachedCount = 0;
+	};
+
+	// Compresses a mip chain and writes it to the cache, as FTexturePipeline::Process and FScene::ProcessReadbackTexture do
+	bool CompressAndSave(const DirectX::Image* mips, size_t mipCount, DXGI_FORMAT compressedFormat, DirectX::TEX_COMPRESS_FLAGS compressFlags, const std::string& filepath)
+	{
+		DirectX::TexMetadata metadata = {};
+		metadata.width = mips[0].width;
+		metadata.height = mips[0].height;
+		metadata.depth = 1;
+		metadata.arraySize = 1;
+		metadata.mipLevels = mipCount;
+		metadata.format = mips[0].format;
+		metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+		DirectX::ScratchImage compressed;
+		if (FAILED(DirectX::Compress(mips, mipCount, metadata, compressedFormat, compressFlags, DirectX::TEX_THRESHOLD_DEFAULT, compressed)))
+			return false;
+
+		const std::wstring wideFilepath = std::filesystem::path{ filepath }.wstring();
+		return SUCCEEDED(DirectX::SaveToDDSFile(compressed.GetImages(), compressed.GetImageCount(), compressed.GetMetadata(), DirectX::DDS_FLAGS_NONE, wideFilepath.c_str()));
+	}
+
+	DirectX::Image GetMipImage(const NormalRoughnessFilter::FMip& mip)
+	{
+		DirectX::Image image = {};
+		image.width = mip.m_width;
+		image.height = mip.m_height;
+		image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		image.rowPitch = 4 * (size_t)mip.m_width;
+		image.slicePitch = image.rowPitch * mip.m_height;
+		image.pixels = (uint8_t*)mip.m_texels.data();
+		return image;
+	}
+
+	// Returns the cooked files, which are only added to the manifest once they are written
+	std::vector<FCookedTexture> CookTexture(const FTextureJob& job, const ContentCache::FManifest& manifest, DirectX::TEX_COMPRESS_FLAGS compressFlags)
+	{
+		const uint32_t width = job.m_image->width;
+		const uint32_t height = job.m_image->height;
+		const size_t mipCount = NormalRoughnessFilter::GetMipCount(width, height);
+
+		std::vector<uint8_t> pixels;
+		if (!ImageDecode::DecodeRgba8(*job.m_image, pixels))
+		{
+			printf("Failed to decode %s\n", job.m_image->uri.c_str());
+			return {};
+		}
+
+		if (!job.m_metallicRoughnessImage)
+		{
+			DirectX::Image srcImage = {};
+			srcImage.width = width;
+			srcImage.height = height;
+			srcImage.format = job.m_srcFormat;
+			srcImage.rowPitch = 4 * (size_t)width;
+			srcImage.slicePitch = srcImage.rowPitch * height;
+			srcImage.pixels = pixels.data();
+
+			DirectX::ScratchImage mipchain;
+			const HRESULT hr = mipCount > 1 ?
+				DirectX::GenerateMipMaps(srcImage, DirectX::TEX_FILTER_LINEAR, mipCount, mipchain) :
+				mipchain.InitializeFromImage(srcImage);
+
+			if (FAILED(hr) || !CompressAndSave(mipchain.GetImages(), mipchain.GetImageCount(), job.m_compressedFormat, compressFlags, manifest.GetFilepath(job.m_key)))
+			{
+				printf("Failed to cook %s\n", job.m_image->uri.c_str());
+				return {};
+			}
+
+			return { { job.m_key, { (uint32_t)job.m_compressedFormat, width, height, (uint32_t)mipCount } } };
+		}
+
+		std::vector<uint8_t> metallicRoughnessPixels;
+		if (!ImageDecode::DecodeRgba8(*job.m_metallicRoughnessImage, metallicRoughnessPixels))
+		{
+			printf("Failed to decode %s\n", job.m_metallicRoughnessImage->uri.c_str());
+			return {};
+		}
+
+		// Filtered on as many threads as the compression
+		std::vector<NormalRoughnessFilter::FMip> normalMips, metallicRoughnessMips;
+		const size_t filterThreadCount = (compressFlags & DirectX::TEX_COMPRESS_PARALLEL) ? 0 : 1;
+		NormalRoughnessFilter::Prefilter(pixels.data(), metallicRoughnessPixels.data(), width, height, mipCount, normalMips, metallicRoughnessMips, filterThreadCount);
+
+		std::vector<DirectX::Image> normalImages, metallicRoughnessImages;
+		for (size_t mipIndex = 0; mipIndex < mipCount; ++mipIndex)
+		{
+			normalImages.push_back(GetMipImage(normalMips[mipIndex]));
+			metallicRoughnessImages.push_back(GetMipImage(metallicRoughnessMips[mipIndex]));
+		}
+
+		if (!CompressAndSave(normalImages.data(), mipCount, job.m_compressedFormat, compressFlags, manifest.GetFilepath(job.m_key)) ||
+			!CompressAndSave(metallicRoughnessImages.data(), mipCount, job.m_metallicRoughnessFormat, compressFlags, manifest.GetFilepath(job.m_metallicRoughnessKey)))
+		{
+			printf("Failed to cook %s and %s\n", job.m_image->uri.c_str(), job.m_metallicRoughnessImage->uri.c_str());
+			return {};
+		}
+
+		return {
+			{ job.m_key, { (uint32_t)job.m_compressedFormat, width, height, (uint32_t)mipCount } },
+			{ job.m_metallicRoughnessKey, { (uint32_t)job.m_metallicRoughnessFormat, width, height, (uint32_t)mipCount } } };
+	}
+
+	// Same processing and cache entries as FScene::GenerateMeshlets, for the meshes that the scenes instance, with the default
+	// chunk size. Cluster LODs aren't cached, so they are still built at load if they are enabled. Returns true if anything was 
+	// generated.
+	bool CookMeshlets(tinygltf::Model& model, FModelCache& cache)
+	{
+		std::set<int> meshes;
+		std::vector<int> nodeStack;
+		for (const tinygltf::Scene& scene : model.scenes)
+		{
+			nodeStack.insert(nodeStack.end(), scene.nodes.cbegin(), scene.nodes.cend());
+		}
+
+		while (!nodeStack.empty())
+		{
+			const tinygltf::Node& node = model.nodes[nodeStack.back()];
+			nodeStack.pop_back();
+			if (node.mesh != -1)
+			{
+				meshes.insert(node.mesh);
+			}
+
+			nodeStack.insert(nodeStack.end(), node.children.cbegin(), node.children.cend());
+		}
+
+		// Primitives that share index and position accessors are meshletized once
+		using AccessorKey = std::pair<int, int>;
+		std::map<AccessorKey, const tinygltf::Primitive*> primitives;
+		for (const int meshIndex : meshes)
+		{
+			for (const tinygltf::Primitive& primitive : model.meshes[meshIndex].primitives)
+			{
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.indices != -1 && posIt != primitive.attributes.cend())
+				{
+					primitives[{ primitive.indices, posIt->second }] = &primitive;
+				}
+			}
+		}
+
+		const std::vector<std::pair<AccessorKey, const tinygltf::Primitive*>> workList{ primitives.cbegin(), primitives.cend() };
+		const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+		const uint32_t chunkSize = (uint32_t)FConfig{}.MeshletizeChunkSize;
+		std::atomic<bool> bGenerated = false;
+
+		Parallel::For(0, (int)workList.size(), [&](int i)
+			{
+				const auto [indexAccessor, positionAccessor] = workList[i].first;
+				std::vector<FInlineMeshlet> meshlets;
+				if (MeshUtils::GeneratePrimitiveMeshlets(model, workList[i].second, indexAccessor, positionAccessor, accessorRefCounts, chunkSize, cache, meshlets))
+				{
+					bGenerated = true;
+				}
+			});
+
+		return bGenerated;
+	}
+
+	struct FCookStats
+	{
+		size_t m_modelCount = 0;
+		size_t m_failedModelCount = 0;
+		size_t m_cookedTextureCount = 0;
+		size_t m_cachedTextureCount = 0;
+		size_t m_failedTextureCount = 0;
+		size_t m_cookedGeometryCount = 0;
+		size_t m_cookedEnvmapCount = 0;
+		size_t m_cachedEnvmapCount = 0;
+		size_t m_failedEnvmapCount = 0;
+	};
+
+	void CookModel(const std::filesystem::path& filepath, const FOptions& options, FCookStats& stats)
+	{
+		const auto start = Clock::now();
+		tinygltf::Model model;
+		if (!LoadModel(filepath, model))
+		{
+			printf("%s: failed to load\n", filepath.string().c_str());
+			stats.m_failedModelCount++;
+			return;
+		}
+
+		// Same locations as FScene::ReloadModel
+		const std::filesystem::path textureCachePath = filepath.parent_path() / ".content-cache";
+		const std::filesystem::path modelCachePath = filepath.parent_path() / ".model-cache";
+		std::error_code error;
+		std::filesystem::create_directories(textureCachePath, error);
+		std::filesystem::create_directories(modelCachePath, error);
+
+		ContentCache::FManifest manifest;
+		manifest.Open(textureCachePath.string());
+
+		FTextureGatherer gatherer{ model, manifest, options.m_bForce };
+		for (const tinygltf::Material& material : model.materials)
+		{
+			gatherer.AddMaterial(material);
+		}
+
+		// Textures are cooked on worker threads while the geometry is cooked on this one. Textures are already compressed in
+		// parallel with each other, so DirectXTex only splits each one up when there is a single worker.
+		const std::vector<FTextureJob>& jobs = gatherer.GetJobs();
+		const size_t workerCount = std::min(options.m_jobCount, jobs.size());
+		const DirectX::TEX_COMPRESS_FLAGS compressFlags = workerCount > 1 ? DirectX::TEX_COMPRESS_DEFAULT : DirectX::TEX_COMPRESS_PARALLEL;
+		std::vector<std::vector<FCookedTexture>> results(jobs.size());
+		std::atomic<size_t> nextJob = 0;
+		std::vector<std::thread> workers;
+		for (size_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+		{
+			workers.emplace_back([&]()
+				{
+					for (size_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++)
+					{
+						results[jobIndex] = CookTexture(jobs[jobIndex], manifest, compressFlags);
+					}
+				});
+		}
+
+		bool bGeometryCooked = false;
+		{
+			FModelCache meshCache;
+			std::filesystem::path meshCacheFilepath = modelCachePath / filepath.stem();
+			meshCacheFilepath += ".mesh-cache";
+			const uint64_t sourceKey = MeshUtils::HashModelFiles(filepath.string());
+			if (!options.m_bForce)
+			{
+				MeshUtils::LoadModelCache(meshCacheFilepath.string(), sourceKey, meshCache);
+			}
+			else
+			{
+				meshCache.m_sourceKey = sourceKey;
+			}
+
+			bGeometryCooked = MeshUtils::FixupMeshes(model, meshCache);
+			bGeometryCooked |= CookMeshlets(model, meshCache);
+			MeshUtils::SaveModelCache(meshCacheFilepath.string(), meshCache);
+
+		}
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		size_t cookedCount = 0, failedCount = 0;
+		for (size_t jobIndex = 0; jobIndex < jobs.size(); ++jobIndex)
+		{
+			failedCount += results[jobIndex].empty() ? 1 : 0;
+			for (const FCookedTexture& texture : results[jobIndex])
+			{
+				manifest.Add(texture.m_key, texture.m_entry);
+				cookedCount++;
+			}
+		}
+
+		if (!manifest.Save())
+		{
+			printf("%s: failed to save the texture cache manifest\n", filepath.string().c_str());
+		}
+
+		printf("%s: %zu textures cooked, %zu cached, %zu failed, geometry %s, %.2f s\n",
+			filepath.string().c_str(), cookedCount, gatherer.GetCachedCount(), failedCount, bGeometryCooked ? "cooked" : "cached", GetSeconds(start));
+
+		stats.m_modelCount++;
+		stats.m_cookedTextureCount += cookedCount;
+		stats.m_cachedTextureCount += gatherer.GetCachedCount();
+		stats.m_failedTextureCount += failedCount;
+		stats.m_cookedGeometryCount += bGeometryCooked ? 1 : 0;
+	}
+
+	// Same as FTextureCache::CacheHDRI, with the compute passes replaced by their CPU versions
+	void CookEnvmap(const std::filesystem::path& filepath, const FOptions& options, FCookStats& stats)
+	{
+		const auto start = Clock::now();
+		std::vector<uint8_t> hdrFile;
+		{
+			std::ifstream file(filepath, std::ios::binary);
+			hdrFile.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		}
+
+		DirectX::TexMetadata metadata;
+		if (FAILED(DirectX::GetMetadataFromHDRMemory(hdrFile.data(), hdrFile.size(), metadata)))
+		{
+			printf("%s: failed to load\n", filepath.string().c_str());
+			stats.m_failedEnvmapCount++;
+			return;
+		}
+
+		// Mips down to 4x4, like RenderUtils12::CalcMipCount for block compression
+		const uint32_t mipCount = (uint32_t)NormalRoughnessFilter::GetMipCount((uint32_t)metadata.width, (uint32_t)metadata.height);
+		const uint32_t cubemapSize = (uint32_t)metadata.height;
+		const uint32_t filteredEnvmapSize = cubemapSize >> 1;
+		const uint32_t filteredEnvmapMips = mipCount - 1;
+		if (filteredEnvmapMips == 0)
+		{
+			printf("%s: too small to prefilter\n", filepath.string().c_str());
+			stats.m_failedEnvmapCount++;
+			return;
+		}
+
+		const std::filesystem::path cacheDirectory = filepath.parent_path() / ".content-cache";
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+		const uint64_t cacheKey = ContentCache::GetEnvmapKey(ContentCache::HashSource(hdrFile), filteredEnvmapSize, ContentCache::EnvmapProducer::Cpu);
+		const std::string cacheFilepath = (cacheDirectory / ContentCache::GetEnvmapFilename(cacheKey)).string();
+
+		ContentCache::FEnvmap envmap{};
+		if (!options.m_bForce && ContentCache::LoadEnvmap(cacheFilepath, cacheKey, envmap) && envmap.m_producer == ContentCache::EnvmapProducer::Cpu &&
+			envmap.m_format == DXGI_FORMAT_R11G11B10_FLOAT && envmap.m_size == filteredEnvmapSize && envmap.m_mipCount == filteredEnvmapMips)
+		{
+			stats.m_cachedEnvmapCount++;
+			return;
+		}
+
+		// HDRIs are decoded to RGBA32F, which is the texel format of the filters
+		DirectX::ScratchImage scratch, mipchain;
+		if (FAILED(DirectX::LoadFromHDRMemory(hdrFile.data(), hdrFile.size(), &metadata, scratch)) ||
+			metadata.format != DXGI_FORMAT_R32G32B32A32_FLOAT ||
+			FAILED(DirectX::GenerateMipMaps(*scratch.GetImage(0, 0, 0), DirectX::TEX_FILTER_LINEAR, mipCount, mipchain)))
+		{
+			printf("%s: failed to decode\n", filepath.string().c_str());
+			stats.m_failedEnvmapCount++;
+			return;
+		}
+
+		std::vector<EnvmapFilter::FImage> latlongMips;
+		for (uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			const DirectX::Image* image = mipchain.GetImage(mip, 0, 0);
+			EnvmapFilter::FImage& latlong = latlongMips.emplace_back(EnvmapFilter::FImage{ (uint32_t)image->width, (uint32_t)image->height, {} });
+			latlong.m_texels.resize(image->width * image->height * 4);
+			for (size_t row = 0; row < image->height; ++row)
+			{
+				std::copy_n((const float*)(image->pixels + row * image->rowPitch), image->width * 4, &latlong.m_texels[row * image->width * 4]);
+			}
+		}
+
+		EnvmapFilter::FCubemap cubemap, filteredEnvmap;
+		EnvmapFilter::ConvertLatlongToCubemap(latlongMips, cubemapSize, mipCount, cubemap, options.m_jobCount);
+		EnvmapFilter::PrefilterCubemap(cubemap, filteredEnvmapSize, filteredEnvmapMips, EnvmapFilter::DefaultSampleCount, filteredEnvmap, options.m_jobCount);
+		EnvmapFilter::ProjectSH(latlongMips[0], envmap.m_sh, options.m_jobCount);
+
+		envmap.m_format = DXGI_FORMAT_R11G11B10_FLOAT;
+		envmap.m_size = filteredEnvmapSize;
+		envmap.m_mipCount = filteredEnvmapMips;
+		envmap.m_producer = ContentCache::EnvmapProducer::Cpu;
+		envmap.m_texels.resize(envmap.GetTexelCount());
+		for (uint32_t face = 0; face < ContentCache::EnvmapFaceCount; ++face)
+		{
+			for (uint32_t mip = 0; mip < filteredEnvmapMips; ++mip)
+			{
+				const EnvmapFilter::FImage& image = filteredEnvmap.GetImage(face, mip);
+				uint32_t* dest = &envmap.m_texels[envmap.GetMipOffset(face, mip)];
+				for (size_t i = 0; i < (size_t)image.m_width * image.m_height; ++i)
+				{
+					dest[i] = DirectX::PackedVector::XMFLOAT3PK{ image.m_texels[i * 4 + 0], image.m_texels[i * 4 + 1], image.m_texels[i * 4 + 2] }.v;
+				}
+			}
+		}
+
+		if (!ContentCache::SaveEnvmap(cacheFilepath, cacheKey, envmap))
+		{
+			printf("%s: failed to save %s\n", filepath.string().c_str(), cacheFilepath.c_str());
+			stats.m_failedEnvmapCount++;
+			return;
+		}
+
+		printf("%s: environment map cooked, %.2f s\n", filepath.string().c_str(), GetSeconds(start));
+		stats.m_cookedEnvmapCount++;
+	}
+
+	bool ParseOptions(int argc, char* argv[], FOptions& options)
+	{
+		if (argc < 2)
+			return false;
+
+		options.m_root = argv[1];
+		for (int i = 2; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--force")
+			{
+				options.m_bForce = true;
+			}
+			else if (arg == "--jobs" && i + 1 < argc)
+			{
+				options.m_jobCount = std::max(std::atoi(argv[++i]), 1);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return std::filesystem::is_directory(options.m_root);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	FOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: content-cooker <content dir> [--jobs <count>] [--force]\n");
+		printf("Cooks the texture and mesh caches of every glTF and the environment map of every HDRI under the directory. Only content that isn't cached yet is cooked, unless --force is given.\n");
+		return 1;
+	}
+
+	const auto start = Clock::now();
+	FContentIndex index;
+	index.Open(options.m_root);
+
+	FCookStats stats;
+	for (const std::filesystem::path& filepath : index.List(".gltf"))
+	{
+		CookModel(filepath, options, stats);
+	}
+
+	for (const std::filesystem::path& filepath : index.List(".hdr"))
+	{
+		CookEnvmap(filepath, options, stats);
+	}
+
+	printf("Cooked %zu models in %.2f s: %zu textures cooked, %zu cached, %zu failed, %zu mesh caches written, %zu environment maps cooked, %zu cached, %zu failed\n",
+		stats.m_modelCount, GetSeconds(start), stats.m_cookedTextureCount, stats.m_cachedTextureCount, stats.m_failedTextureCount, stats.m_cookedGeometryCount,
+		stats.m_cookedEnvmapCount, stats.m_cachedEnvmapCount, stats.m_failedEnvmapCount);
+
+	return stats.m_failedModelCount + stats.m_failedTextureCount + stats.m_failedEnvmapCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <tiny_gltf.h>
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <type_traits>
+
+// Non-owning strided view of the elements of a GLTF accessor. Views point straight into the buffers of the model, so they are only
+// valid until the buffers are resized or replaced. Sparse accessors are not supported, and accessors without a buffer view give an
+// empty view.
+template<typename ByteType>
+struct TAccessorView
+{
+	ByteType* m_data = nullptr;
+	size_t m_count = 0;
+	size_t m_byteStride = 0;
+	int m_componentType = 0;	// TINYGLTF_COMPONENT_TYPE_*
+	int m_componentCount = 0;
+	bool m_normalized = false;
+
+	bool IsEmpty() const { return m_count == 0; }
+	size_t GetComponentSize() const { return tinygltf::GetComponentSizeInBytes(m_componentType); }
+	size_t GetElementSize() const { return GetComponentSize() * m_componentCount; }
+	ByteType* GetElement(size_t index) const { return m_data + index * m_byteStride; }
+
+	// True if the elements are tightly packed with the layout of T, which is uint32_t for indices or 1-4 floats for other streams
+	template<typename T>
+	bool IsLayoutOf() const
+	{
+		constexpr bool bIndices = std::is_same_v<T, uint32_t>;
+		constexpr int floatCount = sizeof(T) / sizeof(float);
+		return m_byteStride == sizeof(T) &&
+			(uintptr_t)m_data % alignof(T) == 0 &&
+			(bIndices ?
+				m_componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT && m_componentCount == 1 :
+				m_componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && m_componentCount == floatCount);
+	}
+};
+
+using FAccessorView = TAccessorView<const uint8_t>;
+using FMutableAccessorView = TAccessorView<uint8_t>;
+
+namespace AccessorView
+{
+	FAccessorView Get(const tinygltf::Model& model, int accessorIndex);
+	FMutableAccessorView GetMutable(tinygltf::Model& model, int accessorIndex);
+
+	// Widens 8, 16 or 32-bit indices to 32-bit. Tightly packed 8 and 16-bit indices are converted with SSE2, 16 and 8 at a time.
+	void ConvertIndices(const FAccessorView& view, uint32_t* output);
+	void WriteIndices(const FMutableAccessorView& view, const uint32_t* indices);
+
+	// Converts each element to outputComponents floats. Components that the accessor doesn't have are 0, and extra ones are dropped.
+	// Integer components are converted as normalized or plain values depending on the accessor. Tightly packed integer streams with
+	// as many components as the output are converted with SSE2.
+	void ConvertFloats(const FAccessorView& view, uint32_t outputComponents, float* output);
+
+	// Returns the elements in place if they already have the layout of T, otherwise converts them into scratch and returns that.
+	// T is uint32_t for index streams, or a type made of 1 to 4 floats for vertex streams.
+	template<typename T>
+	std::span<const T> Read(const FAccessorView& view, std::vector<T>& scratch)
+	{
+		static_assert(std::is_same_v<T, uint32_t> || (sizeof(T) % sizeof(float) == 0 && sizeof(T) <= 4 * sizeof(float)));
+
+		if (view.template IsLayoutOf<T>())
+			return { (const T*)view.m_data, view.m_count };
+
+		scratch.resize(view.m_count);
+		if constexpr (std::is_same_v<T, uint32_t>)
+		{
+			ConvertIndices(view, scratch.data());
+		}
+		else
+		{
+			ConvertFloats(view, sizeof(T) / sizeof(float), (float*)scratch.data());
+		}
+
+		return scratch;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <mesh-utils.h>
+
+// A cluster in the LOD DAG of a primitive. Level 0 clusters are the full detail meshlets. Clusters at level N+1 are generated by
+// merging neighbouring level N clusters into a group, simplifying the group with its border locked and meshletizing the result.
+struct FLodCluster
+{
+	// Vertex indices refer to the vertex streams of the primitive
+	FInlineMeshlet m_meshlet;
+	uint32_t m_level;
+
+	// Group that this cluster was generated from, or -1 at level 0
+	int m_childGroup;
+
+	// Group that this cluster was merged into when generating the next level, or -1 for roots
+	int m_parentGroup;
+
+	// Object space simplification error of the cluster and the bounds it is measured over. The error and bounds of a cluster
+	// never exceed those of its parents, which keeps the cut consistent between all clusters that were generated from a group.
+	DirectX::BoundingSphere m_lodBounds;
+	float m_error;
+
+	// Error and bounds of the parent group. The error is FLT_MAX for roots so that they are drawn when nothing coarser exists.
+	DirectX::BoundingSphere m_parentLodBounds;
+	float m_parentError;
+};
+
+struct FLodClusterGroup
+{
+	std::vector<uint32_t> m_children;		// Clusters that were merged and simplified
+	std::vector<uint32_t> m_parents;		// Clusters generated from the simplified triangles
+	DirectX::BoundingSphere m_lodBounds;
+	float m_error;
+};
+
+struct FClusterDag
+{
+	std::vector<FLodCluster> m_clusters;
+	std::vector<FLodClusterGroup> m_groups;
+	uint32_t m_levelCount;
+};
+
+struct FClusterLodView
+{
+	DirectX::SimpleMath::Vector3 m_eyePosition;		// World space
+	float m_projectionScale;						// Pixels per world unit at unit distance, i.e. 0.5 * resY / tan(0.5 * fovY)
+	float m_nearPlane;
+	float m_errorThreshold;							// Pixels
+};
+
+namespace ClusterLod
+{
+	// Builds the cluster DAG over meshlets of the primitive. Positions are the position stream that the meshlets index into, and
+	// vertexReps maps each vertex to one with identical attributes, see MeshUtils::WeldVertices(). If it is empty, every vertex is
+	// treated as having attributes of its own. Groups are simplified over welded positions, and vertices on attribute seams only
+	// collapse along the seam, so that the clusters of every level reference vertices of the primitive with the attributes of
+	// their side of the seam.
+	void BuildDag(
+		uint32_t maxVerts, uint32_t maxPrims,
+		const std::vector<FInlineMeshlet>& meshlets,
+		const XMFLOAT3* positions, uint32_t vertexCount,
+		const std::vector<uint32_t>& vertexReps,
+		FClusterDag& output);
+
+	// Screen space size in pixels of an object space error measured over lodBounds
+	float ProjectError(const DirectX::BoundingSphere& lodBounds, float error, const DirectX::SimpleMath::Matrix& localToWorld, const FClusterLodView& view);
+
+	// Returns the clusters whose own error is within the threshold but whose parents' error isn't. This does not depend on the
+	// renderer, and each cluster is tested independently so that the same test can run per cluster on the GPU.
+	void SelectCut(const FClusterDag& dag, const DirectX::SimpleMath::Matrix& localToWorld, const FClusterLodView& view, std::vector<uint32_t>& output);
+}
@@ -2,10 +2,23 @@
 #include <filesystem>
 #include <locale>
 #include <codecvt>
-
+#include <sstream>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <system_error>
+#include <DirectXMath.h>
+#include <content-index.h>
+
+// The renderer is Windows only, but the mesh processing that it shares with the tools also builds elsewhere. Print() and the 
+// asserts go to stderr there.
 struct FConfig
 {
+#if defined(_WIN32)
 	DXGI_FORMAT BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+#endif
 	bool UseGpuBasedValidation = false;
 	std::wstring ModelFilename = L"DamagedHelmet.gltf";
 	std::wstring HDRIFilename = L"lilienstein.hdr";
@@ -24,6 +37,7 @@ struct FConfig
 	bool PathTrace = false;
 	bool ForwardLighting = false;
 	bool FrustumCulling = true;
+	bool BackfaceCulling = true;
 	bool EnableTAA = true;
 	bool EnableHBAO = false;
 	bool UseBentNormals = EnableHBAO;
@@ -45,6 +59,13 @@ struct FConfig
 	int ToD_JulianDate = 200;
 	float ToD_Latitude = 42.5;
 	int EnvmapResolution = 256;
+	int MeshletizeChunkSize = 65536;
+	bool GenerateClusterLod = false;
+	bool CompactVertexFormat = false;
+	int GeometryArenaSizeMB = 512;		// Mesh buffers that don't fit get a buffer of their own. At most 512, the limit of a raw view.
+	int TextureLoadWorkers = 0;		// 0 uses one worker per hardware thread, and 1 loads the textures one at a time
+	int TextureLoadBudgetMB = 1024;
+	bool CompareNormalRoughnessWithGpu = false;	// Also runs the prefilter shader on every normal/roughness pair that is filtered, and prints its difference from the CPU filter
 };
 
 template<class T>
@@ -104,12 +125,20 @@ inline void Print(const T* formatString, ...)
 	std::basic_string<T> output = GetFormattedString(formatString, params);
 	output += '\n';
 
+#if defined(_WIN32)
 	if constexpr (std::is_same<T, wchar_t>::value)
 		OutputDebugStringW(output.c_str());
 	else 
 		OutputDebugStringA(output.c_str());
+#else
+	if constexpr (std::is_same<T, wchar_t>::value)
+		fputws(output.c_str(), stderr);
+	else 
+		fputs(output.c_str(), stderr);
+#endif
 }
 
+#if defined(_WIN32)
 inline void AssertIfFailed(HRESULT hr)
 {
 #if defined _DEBUG
@@ -120,6 +149,7 @@ inline void AssertIfFailed(HRESULT hr)
 	}
 #endif
 }
+#endif
 
 inline void DebugAssert(bool success, const char* msg = nullptr)
 {
@@ -133,11 +163,16 @@ inline void DebugAssert(bool success, const char* msg = nullptr)
 			Print("\n*****\n");
 		}
 
+#if defined(_WIN32)
 		_CrtDbgBreak();
+#else
+		std::abort();
+#endif
 	}
 #endif
 }
 
+#if defined(_WIN32)
 inline void AbortOnFailure(bool success, const char* msg, const HWND& windowHandle)
 {
 	if (!success)
@@ -146,59 +181,22 @@ inline void AbortOnFailure(bool success, const char* msg, const HWND& windowHand
 		ExitProcess(-1);
 	}
 }
+#endif
 
+// Files are looked up in the content index instead of walking CONTENT_DIR. Cache directories, which start with a '.', are skipped
+// unless includeCache is set.
 inline std::wstring GetFilepathW(const std::wstring& filename, bool includeCache = false)
 {
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
-	{
-		if (entry.is_regular_file() && entry.path().filename().wstring() == filename)
-		{
-			if (includeCache)
-			{
-				return entry.path().wstring();
-			}
-			else
-			{
-				// If cache directories are to be excluded in the search, look for the '.' in 
-				// the path which is the prefix for all cache directories
-				std::string parentPath = entry.path().parent_path().string();
-				if (parentPath.rfind('.') == std::string::npos)
-				{
-					return entry.path().wstring();
-				}
-			}
-		}
-	}
-
-	DebugAssert(false, "File not found");
-	return {};
+	const std::filesystem::path filepath = GetContentIndex().Find(filename, includeCache);
+	DebugAssert(!filepath.empty(), "File not found");
+	return filepath.wstring();
 }
 
 inline std::string GetFilepathA(const std::string& filename, bool includeCache = false)
 {
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
-	{
-		if (entry.is_regular_file() && entry.path().filename().string() == filename)
-		{
-			if (includeCache)
-			{
-				return entry.path().string();
-			}
-			else
-			{
-				// If cache directories are to be excluded in the search, look for the '.' in 
-				// the path which is the prefix for all cache directories
-				std::string parentPath = entry.path().parent_path().string();
-				if (parentPath.rfind('.') == std::string::npos)
-				{
-					return entry.path().string();
-				}
-			}
-		}
-	}
-
-	DebugAssert(false, "File not found");
-	return {};
+	const std::filesystem::path filepath = GetContentIndex().Find(filename, includeCache);
+	DebugAssert(!filepath.empty(), "File not found");
+	return filepath.string();
 }
 
 // https://stackoverflow.com/questions/4804298/how-to-convert-wstring-into-string
@@ -0,0 +1,143 @@
+#pragma once
+#include <dxgiformat.h>
+#include <cstdint>
+#include <string>
+#include <span>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <utility>
+
+// Content addressed store of the compressed textures in a cache directory. Each file is named by a key that is hashed from its
+// source images, the encoder settings and PipelineVersion, so changing a source or a setting never reads a stale file, and
+// identical textures that are referenced through different URIs share one file. The files in a directory are listed in a single
+// manifest, which is read once instead of checking for each file. This only depends on the standard library, like the scene cache.
+namespace ContentCache
+{
+	constexpr uint32_t ManifestMagic = 0x4e414d43; // "CMAN"
+	constexpr uint32_t ManifestVersion = 1;
+
+	// Bump whenever the texture processing produces different output from the same sources and settings
+	constexpr uint32_t PipelineVersion = 1;
+
+	enum class Encoder : uint32_t
+	{
+		MipsAndCompress,			// Linear filtered mips (TEX_FILTER_LINEAR), then block compressed
+		PrefilteredNormals,			// Normal map output of the vMF normal/roughness prefilter
+		PrefilteredRoughness,		// Metallic/roughness output of the vMF normal/roughness prefilter
+	};
+
+	// Everything except the sources that changes the output of an encoder
+	struct FTextureSettings
+	{
+		Encoder m_encoder;
+		uint32_t m_srcFormat;		// DXGI_FORMAT
+		uint32_t m_compressedFormat;
+	};
+
+	// Describes a cached file, so that the texture can be created without reading the file header
+	struct FEntry
+	{
+		uint32_t m_format;			// DXGI_FORMAT
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_mipCount;
+	};
+
+	// Textures that a GLTF material can reference
+	enum class TextureSlot : uint32_t
+	{
+		Emissive,
+		BaseColor,
+		Occlusion,
+		MetallicRoughness,			// Only if it isn't prefiltered with the normal map
+		Normal,						// Only if it isn't prefiltered with the metallic/roughness map
+		Transmission,
+		Clearcoat,
+		ClearcoatRoughness,			// Only if it isn't prefiltered with the clearcoat normal map
+		ClearcoatNormal,			// Only if it isn't prefiltered with the clearcoat roughness map
+	};
+
+	// The scene loader and the content cooker both compress the textures of each slot with these settings, so that they read and
+	// write the same entries. Normal and roughness maps that are prefiltered together use the settings below instead.
+	FTextureSettings GetTextureSettings(TextureSlot slot);
+
+	constexpr FTextureSettings PrefilteredNormalSettings = { Encoder::PrefilteredNormals, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC5_SNORM };
+	constexpr FTextureSettings PrefilteredRoughnessSettings = { Encoder::PrefilteredRoughness, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC5_UNORM };
+
+	uint64_t HashSource(std::span<const uint8_t> data);
+	uint64_t GetTextureKey(std::initializer_list<uint64_t> sourceHashes, const FTextureSettings& settings);
+	uint64_t GetTextureKey(uint64_t sourceHash, TextureSlot slot);
+
+	// Keys of the normal map and the metallic/roughness map that a pair is prefiltered into. Both outputs depend on both sources.
+	std::pair<uint64_t, uint64_t> GetPrefilteredTextureKeys(uint64_t normalmapHash, uint64_t metallicRoughnessHash);
+
+	// Name of the file of a key, relative to the cache directory
+	std::string GetFilename(uint64_t key);
+
+	struct FManifest
+	{
+		// Reads the manifest of a directory, if there is one. A missing or outdated manifest leaves the cache empty.
+		bool Open(const std::string& directory);
+
+		// Writes the manifest if entries were added since it was read
+		bool Save();
+
+		// Entries are only added once their file is written, or before the load that writes it finishes and the manifest is saved
+		const FEntry* Find(uint64_t key) const;
+		void Add(uint64_t key, const FEntry& entry);
+
+		std::string GetFilepath(uint64_t key) const;
+		size_t GetEntryCount() const { return m_entries.size(); }
+
+	private:
+		std::string m_directory;
+		std::unordered_map<uint64_t, FEntry> m_entries;
+		bool m_bDirty = false;
+	};
+
+	// Prefiltered environment maps and their SH are cached as a single file per HDRI. These are not listed in the manifest, since
+	// there is only one lookup per HDRI switch and the file header is validated on load anyway.
+	constexpr uint32_t EnvmapMagic = 0x564e4543; // "CENV"
+	constexpr uint32_t EnvmapFileVersion = 2;
+
+	// Bump whenever the latlong to cubemap conversion, the GGX prefilter or the SH projection produce different output
+	constexpr uint32_t EnvmapFilterVersion = 1;
+
+	constexpr uint32_t EnvmapFaceCount = 6;
+	constexpr uint32_t ShCoefficientCount = 9;
+
+	// The compute passes of FTextureCache::CacheHDRI and the CPU filters of the content cooker don't produce the same texels: the
+	// CPU clamps at face edges instead of filtering across them, keeps the intermediate cubemap in float instead of R11G11B10, and
+	// projects every latlong texel to SH where the GPU reduction only covers all of them for power of 2 sizes. Each producer is
+	// keyed separately. The renderer prefers the GPU result, and only falls back to the cooked one when no GPU result is cached.
+	enum class EnvmapProducer : uint32_t
+	{
+		Gpu,
+		Cpu,
+		Count
+	};
+
+	struct FEnvmap
+	{
+		uint32_t m_format;					// DXGI_FORMAT of 4 byte texels
+		uint32_t m_size;					// Width and height of the top mip of each face
+		uint32_t m_mipCount;
+		EnvmapProducer m_producer;
+		std::vector<uint32_t> m_texels;		// Each face in turn, as a chain of tightly packed mips. This is the subresource order of a cubemap.
+		std::array<float, 4 * ShCoefficientCount> m_sh;
+
+		size_t GetTexelCount() const;
+		size_t GetMipOffset(uint32_t face, uint32_t mip) const;
+	};
+
+	// The resolution is that of the prefiltered cubemap
+	uint64_t GetEnvmapKey(uint64_t sourceHash, uint32_t resolution, EnvmapProducer producer);
+	std::string GetEnvmapFilename(uint64_t key);
+
+	bool SaveEnvmap(const std::string& filepath, uint64_t key, const FEnvmap& envmap);
+
+	// Fails if the file is missing, was written for another key or by another version, or is truncated or corrupt
+	bool LoadEnvmap(const std::string& filepath, uint64_t key, FEnvmap& outEnvmap);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// Index of the files under a content root, so that files are found by name and listed by extension without walking the tree.
+// The index is saved in the root and checked on load against the write time of each directory, which changes whenever an entry
+// is added, removed or renamed in it, so only the directories that changed are listed again. Directories that start with a '.'
+// hold caches. They are indexed as well, and lookups skip them unless asked not to.
+struct FContentIndex
+{
+	static constexpr uint32_t Magic = 0x58444e49; // "INDX"
+	static constexpr uint32_t Version = 1;
+	static constexpr std::chrono::milliseconds RefreshInterval{ 100 };
+
+	FContentIndex() = default;
+	FContentIndex(const FContentIndex&) = delete;
+	FContentIndex& operator=(const FContentIndex&) = delete;
+	~FContentIndex();
+
+	// Loads the saved index of a root and brings it up to date. Returns the number of directories that changed since it was saved.
+	size_t Open(const std::filesystem::path& root);
+
+	// Lists the directories that changed since they were indexed, and saves the index if any did
+	size_t Refresh();
+
+	// Returns an empty path if there is no such file. The first match in path order is returned if there are several. A miss 
+	// refreshes the index, unless it is being watched or was refreshed less than RefreshInterval ago.
+	std::filesystem::path Find(const std::filesystem::path& filename, bool bIncludeCache = false);
+
+	// Extensions include the '.'
+	std::vector<std::filesystem::path> List(const std::filesystem::path& extension, bool bIncludeCache = false) const;
+
+	// Keeps the index up to date on a background thread while files are added or removed. Only implemented on Windows.
+	void StartWatching();
+	void StopWatching();
+
+	size_t GetFileCount() const;
+	size_t GetDirectoryCount() const;
+
+private:
+	struct FDirectory
+	{
+		int64_t m_writeTime = 0;
+		std::vector<std::filesystem::path> m_files;
+		std::vector<std::filesystem::path> m_subdirectories;
+	};
+
+	struct FFile
+	{
+		std::filesystem::path m_path;
+		bool m_bCache;
+	};
+
+	size_t UpdateAndSave();
+	size_t Update();
+	void RebuildLookups();
+	bool Load();
+	bool Save();
+	std::filesystem::path GetIndexFilepath() const;
+
+	std::filesystem::path m_root;
+	std::map<std::filesystem::path, FDirectory> m_directories;		// By path relative to the root
+	std::unordered_map<std::wstring, std::vector<FFile>> m_filesByName;
+	std::unordered_map<std::wstring, std::vector<FFile>> m_filesByExtension;
+	mutable std::shared_mutex m_mutex;
+	std::chrono::steady_clock::time_point m_lastRefreshTime;
+
+	std::thread m_watcher;
+	void* m_stopEvent = nullptr;
+	std::atomic<bool> m_bWatching = false;
+};
+
+// Index of CONTENT_DIR, which is opened on first use
+FContentIndex& GetContentIndex();
@@ -47,6 +47,7 @@ struct FTextureCache
 		const size_t mipCount);
 
 	FLightProbe CacheHDRI(const std::wstring& name);
+	FLightProbe CacheEnvmap(const std::wstring& envmapName, const std::wstring& shName, const ContentCache::FEnvmap& envmap);
 
 	void Clear();
 
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+// CPU versions of the compute passes that turn a latlong HDRI into image based lighting, so that HDRIs can be baked without a GPU
+// and the GPU passes have a reference to be checked against:
+// - ConvertLatlongToCubemap(), content-pipeline/cubemapgen.hlsl
+// - PrefilterCubemap(), image-based-lighting/split-sum-approx/prefilter.hlsl
+// - ProjectSH(), image-based-lighting/spherical-harmonics/projection.hlsl and parallel-reduction.hlsl
+//
+// Each has a line by line port of its shader, which the golden data is generated with, and a version that processes 8 texels at a
+// time with AVX2 on several threads. The AVX2 versions fall back to the reference on CPUs without AVX2 and FMA. Unlike the GPU,
+// cubemaps are not filtered across face edges, which are clamped instead, so the content cache keys CPU bakes apart from GPU ones.
+// This only depends on the standard library.
+namespace EnvmapFilter
+{
+	constexpr uint32_t FaceCount = 6;
+	constexpr uint32_t ShCoefficientCount = 9;
+
+	// Same as the GPU passes
+	constexpr uint32_t DefaultSampleCount = 1024;
+
+	// RGBA32F texels, with rows tightly packed
+	struct FImage
+	{
+		uint32_t m_width;
+		uint32_t m_height;
+		std::vector<float> m_texels;
+	};
+
+	// The mips of each face in turn, which is the subresource order of a cubemap
+	struct FCubemap
+	{
+		uint32_t m_size;
+		uint32_t m_mipCount;
+		std::vector<FImage> m_images;
+
+		const FImage& GetImage(uint32_t face, uint32_t mip) const { return m_images[face * m_mipCount + mip]; }
+	};
+
+	// RGBA of each coefficient, like the 9x1 texture that the renderer reads
+	using FShCoefficients = std::array<float, 4 * ShCoefficientCount>;
+
+	bool HasAvx2();
+
+	// Each mip of the cubemap is resampled from the same mip of the latlong, with bilinear filtering that wraps in both directions
+	void ConvertLatlongToCubemap(const std::vector<FImage>& latlongMips, uint32_t cubemapSize, uint32_t mipCount, FCubemap& outCubemap, size_t threadCount = 0);
+	void ConvertLatlongToCubemapReference(const std::vector<FImage>& latlongMips, uint32_t cubemapSize, uint32_t mipCount, FCubemap& outCubemap);
+
+	// Mip m is the source convolved with a GGX lobe of roughness m / mipCount, from importance samples that each read the source
+	// mip whose texels cover about the solid angle of the sample. As on the GPU, that solid angle is taken from the output size.
+	// The AVX2 version copies the source for mip 0, which has a roughness of 0 and so takes every sample in the same direction.
+	void PrefilterCubemap(const FCubemap& source, uint32_t size, uint32_t mipCount, uint32_t sampleCount, FCubemap& outCubemap, size_t threadCount = 0);
+	void PrefilterCubemapReference(const FCubemap& source, uint32_t size, uint32_t mipCount, uint32_t sampleCount, FCubemap& outCubemap);
+
+	// L2 projection of the radiance of every texel, weighted by its solid angle. The GPU sums 2x2 blocks, so it covers every texel
+	// only when the latlong is a power of 2 with an aspect ratio of 2.
+	void ProjectSH(const FImage& latlong, FShCoefficients& outSh, size_t threadCount = 0);
+	void ProjectSHReference(const FImage& latlong, FShCoefficients& outSh);
+}
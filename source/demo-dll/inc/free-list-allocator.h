@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+// Offset allocator over a fixed range. It does not own any memory, so it can sub-allocate GPU buffers.
+// Policy: best fit, i.e. the smallest free range that fits the aligned size, with ties going to the lowest offset.
+// Freed ranges are merged with free neighbours right away, so free ranges are never adjacent.
+struct FFreeListAllocator
+{
+	static constexpr size_t InvalidOffset = ~0ull;
+
+	FFreeListAllocator() = default;
+	explicit FFreeListAllocator(size_t capacity);
+
+	// Returns InvalidOffset if no free range fits. Alignment must be a power of 2.
+	size_t Allocate(size_t size, size_t alignment = 1);
+	void Free(size_t offset);
+
+	size_t GetCapacity() const { return m_capacity; }
+	size_t GetUsedSize() const { return m_usedSize; }
+	size_t GetAllocationCount() const { return m_allocations.size(); }
+	size_t GetFreeRangeCount() const { return m_freeRangesByOffset.size(); }
+	size_t GetLargestFreeRange() const;
+
+	// 0 when all the free space is in one range, and close to 1 when it is split into many small ones
+	float GetFragmentation() const;
+
+	// Checks that the free ranges and allocations tile the whole range without overlaps, and that no two free ranges touch
+	bool Validate() const;
+
+private:
+	void AddFreeRange(size_t offset, size_t size);
+	void RemoveFreeRange(size_t offset, size_t size);
+
+	size_t m_capacity = 0;
+	size_t m_usedSize = 0;
+	std::map<size_t, size_t> m_freeRangesByOffset;				// Offset to size
+	std::set<std::pair<size_t, size_t>> m_freeRangesBySize;		// (size, offset), for the best fit search
+	std::unordered_map<size_t, size_t> m_allocations;			// Offset to size. Alignment padding stays in the free ranges.
+};
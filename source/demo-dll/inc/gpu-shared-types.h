@@ -63,18 +63,34 @@ struct FMeshBufferView
 	uint32_t m_byteLength;
 };
 
+// Element encoding of a vertex stream. See inc/vertex-quantization.h for the CPU encoders and MeshMaterial::GetFloat*() for decoding.
+namespace VertexFormat
+{
+	enum Type
+	{
+		Float,
+		Unorm16Position,		// 16-bit xyz + padding, dequantized with the accessor offset and scale
+		Octahedral16Normal,		// 2x snorm16 octahedral
+		Octahedral16Tangent,	// snorm16 + snorm15 octahedral, with the bitangent sign in the lowest bit
+		Half2Texcoord
+	};
+}
+
 // Corresponds to GLTF Accessor
 struct FMeshAccessor
 {
 	int m_bufferViewIndex;
 	uint32_t m_byteOffset;
 	uint32_t m_byteStride;
+	uint32_t m_format;
+	Vector3 m_quantizationOffset;
+	Vector3 m_quantizationScale;
 };
 
 struct FGpuPrimitive
 {
 	Vector4 m_boundingSphere;
-	int m_meshIndex;
+	int m_meshIndex;				// Mesh instance, for its transform and visibility
 	int m_indexAccessor;
 	int m_positionAccessor;
 	int m_uvAccessor;
@@ -87,18 +103,30 @@ struct FGpuPrimitive
 
 struct FGpuMeshlet
 {
-	uint32_t m_vertexBegin;
+	uint32_t m_vertexBegin;			// Byte offset into the packed meshlet vertex index buffer
 	uint32_t m_vertexCount;
 	uint32_t m_triangleBegin;
 	uint32_t m_triangleCount;
+	uint32_t m_vertexBase;			// Vertex indices are stored as deltas from this base
+	uint32_t m_vertexDeltaSize;		// 1, 2 or 4 bytes per delta
 
 	Vector4 m_boundingSphere;
-	int m_meshIndex;
 	int m_positionAccessor;
 	int m_uvAccessor;
 	int m_normalAccessor;
 	int m_tangentAccessor;
 	int m_materialIndex;
+	uint32_t m_normalCone;
+};
+
+// Meshlets are stored once per mesh asset. Each mesh instance refers to the meshlets of its asset with one of these, indexed by its
+// mesh index. The meshlets of all instances are numbered one after the other, and the culling pass dispatches one thread for each.
+struct FGpuMeshletInstance
+{
+	int m_assetIndex;
+	uint32_t m_meshletBegin;		// First meshlet of the asset in the packed meshlets
+	uint32_t m_meshletCount;
+	uint32_t m_instanceMeshletBegin;	// Number of the first meshlet of this instance
 };
 
 struct FMaterial
@@ -151,6 +179,8 @@ struct FSceneConstants
 	uint32_t m_packedMeshletVertexIndexBufferIndex;
 	uint32_t m_packedMeshletPrimitiveIndexBufferIndex;
 	uint32_t m_packedSceneMeshletsBufferIndex;
+	uint32_t m_packedSceneMeshletInstancesBufferIndex;
+	uint32_t m_meshInstanceCount;
 	uint32_t m_sceneMaterialBufferIndex;
 	uint32_t m_lightCount;
 	uint32_t m_packedLightIndicesBufferIndex;
@@ -190,6 +220,8 @@ struct FViewConstants
 	uint32_t m_mouseX;
 	uint32_t m_mouseY;
 	uint32_t m_viewmode;
+	Vector3 m_cullEyePos;
+	float __padding3;
 };
 
 namespace Light
@@ -229,22 +261,8 @@ struct FIndirectDrawWithRootConstants
 	FDrawInstanced m_drawArguments;
 
 #ifdef __cplusplus
-	static D3DCommandSignature_t* GetCommandSignature(D3DRootSignature_t* rootsig)
-	{
-		D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
-		argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
-		argumentDescs[0].Constant.RootParameterIndex = 0;
-		argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
-		argumentDescs[0].Constant.Num32BitValuesToSet = 32;
-		argumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
-
-		D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
-		commandSignatureDesc.pArgumentDescs = argumentDescs;
-		commandSignatureDesc.NumArgumentDescs = 2;
-		commandSignatureDesc.ByteStride = sizeof(FIndirectDrawWithRootConstants);
-
-		return RenderBackend12::CacheCommandSignature(commandSignatureDesc, rootsig);
-	}
+	// Defined in renderer.cpp, so that the tools that share this header don't depend on the D3D12 backend
+	static struct ID3D12CommandSignature* GetCommandSignature(struct ID3D12RootSignature* rootsig);
 #endif
 };
 
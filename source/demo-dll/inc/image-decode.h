@@ -0,0 +1,13 @@
+#pragma once
+#include <tiny_gltf.h>
+#include <cstdint>
+#include <vector>
+
+// Decoding of the GLTF images that the loaders keep encoded, for the texture pipeline and the content cooker, so that both compress 
+// the same pixels. This only depends on tinygltf and stb_image.
+namespace ImageDecode
+{
+	// RGBA8 pixels of a source image that was loaded with its decoding deferred. Missing channels are 0 and a missing alpha is opaque.
+	// Returns false if the image can't be decoded, or doesn't have the size that was read from its header.
+	bool DecodeRgba8(const tinygltf::Image& image, std::vector<uint8_t>& pixels);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <tiny_gltf.h>
 #include <SimpleMath.h>
+#include <parallel.h>
 using namespace DirectX;
 
 struct FInlineMeshlet
@@ -21,15 +22,230 @@ struct FInlineMeshlet
 	std::vector<FPackedTriangle> m_primitiveIndices;
 
 	DirectX::BoundingSphere m_boundingSphere;
+
+	// Cone around the outward facing triangle normals, packed as s8 axis (xyz) and s8 sine of the half-angle (w)
+	uint32_t m_normalCone;
+};
+
+struct FVertexCacheStats
+{
+	float m_acmr;	// Transformed vertices per triangle
+	float m_atvr;	// Transformed vertices per referenced vertex
+};
+
+struct FMeshletFetchStats
+{
+	float m_linesPerMeshlet;		// Distinct cache lines of the vertex stream that a meshlet reads
+	float m_idealLinesPerMeshlet;	// Cache lines a meshlet would read if its vertices were contiguous
+};
+
+struct FMeshletVertexEncoding
+{
+	uint32_t m_byteOffset;	// 4 byte aligned offset of the meshlet's deltas in the packed buffer
+	uint32_t m_base;		// Smallest vertex index referenced by the meshlet
+	uint32_t m_deltaSize;	// 1, 2 or 4 bytes per delta
+};
+
+// Primitive after MeshUtils::RemapPrimitiveVertices and the draw order optimization, so that loading it again is a copy
+struct FRemappedPrimitive
+{
+	std::vector<FInlineMeshlet> m_meshlets;		// Index the remapped vertices
+	std::vector<uint8_t> m_vertices;			// Every vertex attribute stream tightly packed, in attribute name order. Empty if only the triangles were reordered.
+	std::vector<uint32_t> m_drawIndices;		// Index buffer in draw order
+};
+
+// Output of the expensive per-primitive processing that is persisted between runs. Entries are keyed by a content hash of the 
+// accessors they were generated from, so editing a model only invalidates the primitives that changed.
+struct FModelCache
+{
+	// Entries are looked up and added through Find() and Insert(), which mark them as used by the current load. Only the used
+	// entries are saved, so that the entries of edited or removed primitives don't pile up in the file.
+	template<typename Value>
+	const Value* Find(const TConcurrentMap<uint64_t, Value>& entries, uint64_t key)
+	{
+		const Value* value = entries.Find(key);
+		if (value)
+		{
+			m_usedKeys.Insert(key, true);
+		}
+
+		return value;
+	}
+
+	template<typename Value>
+	void Insert(TConcurrentMap<uint64_t, Value>& entries, uint64_t key, Value value)
+	{
+		m_usedKeys.Insert(key, true);
+		entries.Insert(key, std::move(value));
+		m_bDirty = true;
+	}
+
+	void Clear();
+
+	// Content key of the source files of the model, see MeshUtils::HashModelFiles(). The accessor hashes are only kept while it
+	// matches, so they are reused only for the same bytes.
+	uint64_t m_sourceKey = 0;
+
+	// Content hashes by the accessor indices and seed they were computed for, so that loading an unchanged model doesn't hash its
+	// accessors again
+	TConcurrentMap<uint64_t, uint64_t> m_accessorHashes;
+
+	TConcurrentMap<uint64_t, std::vector<XMFLOAT4>> m_tangents;
+	TConcurrentMap<uint64_t, std::vector<FInlineMeshlet>> m_meshlets;
+	TConcurrentMap<uint64_t, FRemappedPrimitive> m_remappedPrimitives;
+
+	TConcurrentMap<uint64_t, bool> m_usedKeys;
+	std::atomic<bool> m_bDirty = false;
 };
 
 namespace MeshUtils
 {
-	bool FixupMeshes(tinygltf::Model& model);
+	// Bump whenever a change to Meshletize, MeshletizeParallel or SortMeshlets changes their output, to invalidate cached meshlets
+	constexpr uint32_t MeshletizerVersion = 2;
+
+	// Same for OptimizeVertexCache and OptimizeOverdraw, to invalidate cached draw order index buffers
+	constexpr uint32_t DrawOrderVersion = 2;
+
+	// Meshlet limits of the mesh shaders, and the vertex cache that the draw order of the index buffers is optimized for
+	constexpr uint32_t MeshletMaxVertices = 64;
+	constexpr uint32_t MeshletMaxPrimitives = 126;
+	constexpr uint32_t DrawOrderCacheSize = 16;
+	constexpr float DrawOrderOverdrawThreshold = 1.05f;
+
+	// Generates tangents for primitives that have a normal map but no tangents, reusing cached tangents where the primitive data 
+	// matches. Returns true if any tangents had to be generated, in which case the cache holds the new entries.
+	bool FixupMeshes(tinygltf::Model& model, FModelCache& cache);
+
+	// Content hash of the elements of the accessors, independent of how they are laid out in the buffers. Accessor indices of -1 
+	// are hashed as absent attributes. Sparse substitutions are not included.
+	uint64_t HashAccessors(const tinygltf::Model& model, std::initializer_list<int> accessors, uint64_t seed = 0);
+
+	// Same as HashAccessors, but reuses the hash that the cache holds for the same accessor indices and seed. The model must be in
+	// the same state as when the hash was computed, which holds for the deterministic processing of unchanged source files.
+	uint64_t HashAccessors(const tinygltf::Model& model, std::initializer_list<int> accessors, uint64_t seed, FModelCache& cache);
 
+	// Content key of the files in the model's directory, from their relative paths and bytes. This covers the GLTF, its buffers and
+	// its images without parsing the GLTF. Directories that start with a dot, which hold the content and model caches, are skipped,
+	// and so are mesh and scene cache files.
+	uint64_t HashModelFiles(const std::string& modelFilepath);
+
+	// Reads the entries of the file and sets the cache's source key. The accessor hashes are only read if the file was saved with 
+	// the same source key. Returns false and leaves the cache empty if the file doesn't exist, was written by a different version 
+	// or can't be read completely.
+	bool LoadModelCache(const std::string& filename, uint64_t sourceKey, FModelCache& cache);
+
+	// Writes the entries that were used since the cache was loaded, if any were added or any loaded entry wasn't used. Returns 
+	// true if the file was written.
+	bool SaveModelCache(const std::string& filename, FModelCache& cache);
+
+    // Runs MikkTSpace over flat vertex streams. Tangents are written per vertex, as xyz and the bitangent sign in w.
+    void GenerateTangents(const uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, const XMFLOAT3* normals, const XMFLOAT2* uvs, XMFLOAT4* tangents);
+
+    // The output is the same on every run of the same build. When bDeterministic is set, candidate scores are also quantized, which 
+    // makes the output robust to most floating point differences between builds and machines, but does not guarantee it.
     void Meshletize(
         uint32_t maxVerts, uint32_t maxPrims,
         const uint32_t* indices, uint32_t indexCount,
         const XMFLOAT3* positions, uint32_t vertexCount,
-        std::vector<struct FInlineMeshlet>& output);
+        std::vector<struct FInlineMeshlet>& output,
+        bool bDeterministic = true);
+
+    // Splits large primitives into spatially coherent chunks of chunkTriangleCount triangles (by Morton order of the 
+    // triangle centroids), meshletizes the chunks in parallel and concatenates the results in chunk order
+    void MeshletizeParallel(
+        uint32_t maxVerts, uint32_t maxPrims,
+        const uint32_t* indices, uint32_t indexCount,
+        const XMFLOAT3* positions, uint32_t vertexCount,
+        uint32_t chunkTriangleCount,
+        std::vector<struct FInlineMeshlet>& output,
+        bool bDeterministic = true);
+
+    // pointRep[i] is the lowest vertex index whose position is bitwise identical to that of vertex i
+    void WeldPositions(const XMFLOAT3* positions, uint32_t vertexCount, std::vector<uint32_t>& pointRep);
+
+    // pointRep[i] is the lowest vertex index with the position of vertex i and the same attributes, up to a small tolerance on
+    // normals. Tangents aren't compared.
+    void WeldVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<uint32_t>& pointRep);
+
+    // adjacency[i] is the triangle across the edge that starts at index i, or -1. Vertices at bitwise identical positions are welded.
+    void BuildAdjacency(const uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, uint32_t vertexCount, uint32_t* adjacency);
+
+    uint32_t PackNormalCone(int8_t axisX, int8_t axisY, int8_t axisZ, int8_t cutoff);
+
+    // Sign extends the packed cone with the same shifts as ConeCull() in culling/batch-culling.hlsl
+    XMINT4 UnpackNormalCone(uint32_t normalCone);
+
+    // Reference for ConeCull() in culling/batch-culling.hlsl. Returns false if every triangle in the meshlet faces away from eyePos.
+    bool ConeCull(const DirectX::BoundingSphere& bounds, uint32_t normalCone, const DirectX::SimpleMath::Matrix& localToWorld, const DirectX::SimpleMath::Vector3& eyePos);
+
+    // AABB and a tight bounding sphere of a strided float3 position stream. One SIMD pass finds the AABB and the extreme points 
+    // along 7 directions, the farthest pair seeds a Ritter sphere which is then refined. The sphere is never larger than the one 
+    // around the AABB.
+    void ComputeBounds(const uint8_t* positions, uint32_t count, uint32_t stride, DirectX::BoundingBox& outBox, DirectX::BoundingSphere& outSphere);
+
+    // Copies of accessor streams, see AccessorView::Read() for reading them in place. Indices are widened to 32-bit, and vertex 
+    // streams are converted to floats from any component type.
+    void ReadIndices(const tinygltf::Model& model, int accessorIndex, std::vector<uint32_t>& output);
+    void WriteIndices(tinygltf::Model& model, int accessorIndex, const std::vector<uint32_t>& indices);
+    void ReadPositions(const tinygltf::Model& model, int accessorIndex, std::vector<XMFLOAT3>& output);
+    void ReadTexcoords(const tinygltf::Model& model, int accessorIndex, std::vector<XMFLOAT2>& output);
+
+    // Number of primitives that reference each accessor, either as indices, vertex attributes or morph targets
+    std::vector<int> CountAccessorReferences(const tinygltf::Model& model);
+
+    // Vertex streams can only be reordered if no other primitive references them, and no other accessor or image reads their bytes
+    bool CanRemapPrimitiveVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::vector<int>& accessorRefCounts);
+
+    // Same for the index buffer alone, which is enough to reorder the triangles of a primitive that shares its vertex streams
+    bool CanReorderPrimitiveTriangles(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::vector<int>& accessorRefCounts);
+
+    // Sorts meshlets along a Morton curve through their bounding sphere centers
+    void SortMeshlets(std::vector<struct FInlineMeshlet>& meshlets);
+
+    // Renumbers the vertices of a primitive in order of first use by its meshlets, permutes all of its vertex attribute streams to 
+    // match and rewrites its index buffer in meshlet order. The accessors of the primitive must not be referenced by any other primitive.
+    void RemapPrimitiveVertices(tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<struct FInlineMeshlet>& meshlets);
+
+    // Key of a primitive's FRemappedPrimitive entry, from its indices and every vertex attribute in attribute name order, or only its 
+    // positions if bVertices is false. The seed has to change with anything else that changes the meshlets. DrawOrderVersion is added here.
+    uint64_t GetRemappedPrimitiveKey(const tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, uint64_t seed, FModelCache& cache);
+
+    // Copies the index buffer of a primitive once its triangles are in draw order, and its vertex streams if bVertices is true 
+    // because they were remapped
+    FRemappedPrimitive CaptureRemappedPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, const std::vector<struct FInlineMeshlet>& meshlets);
+
+    // Writes the captured streams back into the accessors of the primitive. Returns false without writing anything if the entry 
+    // doesn't match the sizes of the accessors.
+    bool RestoreRemappedPrimitive(tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, const FRemappedPrimitive& remapped);
+
+    // Meshlets of the primitive with the given index and position accessors. If the vertices of sourcePrimitive can be remapped, 
+    // they are also reordered for the meshlets. Its index buffer is reordered for the draw order if the primitive owns it. Results are restored from the cache when 
+    // it has them and added to it otherwise. The scene loader and the content cooker both process primitives through this, so 
+    // that they write the same entries. Returns true if anything was generated.
+    bool GeneratePrimitiveMeshlets(
+        tinygltf::Model& model,
+        const tinygltf::Primitive* sourcePrimitive,
+        int indexAccessor, int positionAccessor,
+        const std::vector<int>& accessorRefCounts,
+        uint32_t chunkSize,
+        FModelCache& cache,
+        std::vector<struct FInlineMeshlet>& meshlets);
+
+    // Reorders triangles for post-transform vertex cache reuse with Tipsify (Sander et al. 2007, "Fast Triangle Reordering for Vertex 
+    // Locality and Reduced Overdraw"). clusterStarts receives the first triangle of each run that begins with a cold cache.
+    void OptimizeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize, uint32_t* output, std::vector<uint32_t>& clusterStarts);
+
+    // Splits the clusters from OptimizeVertexCache() into smaller ones where that costs at most threshold times their ACMR, then sorts 
+    // them so that the clusters most likely to occlude the rest of the mesh are drawn first. The order is only changed if the sorted 
+    // ACMR stays within threshold times the ACMR of the input.
+    void OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, uint32_t vertexCount, const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold);
+
+    // Simulates a FIFO post-transform vertex cache of cacheSize entries
+    FVertexCacheStats AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize);
+    FMeshletFetchStats AnalyzeMeshletFetch(const std::vector<struct FInlineMeshlet>& meshlets, uint32_t vertexStride, uint32_t cacheLineSize);
+
+    // Appends the unique vertex indices of a meshlet to packedVertexIndices as deltas from the smallest index, using the narrowest of 
+    // 8, 16 or 32 bits that fits. DecodeMeshletVertex() is the reference for MeshMaterial::GetMeshletVertexIndex() in the shaders.
+    FMeshletVertexEncoding EncodeMeshletVertices(const FInlineMeshlet& meshlet, std::vector<uint8_t>& packedVertexIndices);
+    uint32_t DecodeMeshletVertex(const FMeshletVertexEncoding& encoding, const uint8_t* packedVertexIndices, uint32_t meshletVertIndex);
 }
\ No newline at end of file
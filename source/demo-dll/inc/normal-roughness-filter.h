@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// CPU version of content-pipeline/prefilter-normal-roughness.hlsl, for filtering without a GPU. Each mip of the normal map and
+// the metallic/roughness map is filtered over its footprint in the base level by fitting a von Mises-Fisher lobe to every source
+// texel and averaging the lobes, which widens the roughness where the normals diverge. This only depends on the standard library
+// and SSE2.
+namespace NormalRoughnessFilter
+{
+	// RGBA8 texels, with rows tightly packed
+	struct FMip
+	{
+		uint32_t m_width;
+		uint32_t m_height;
+		std::vector<uint8_t> m_texels;
+	};
+
+	// Largest difference of any channel of any mip between two filtered chains, and the number of channels that differ
+	struct FDifference
+	{
+		int m_maxDifference;
+		size_t m_differentChannelCount;
+	};
+
+	// Mips down to 4x4 for block compression, and at least one
+	size_t GetMipCount(uint32_t width, uint32_t height);
+
+	// Both sources are RGBA8 and the same size. The normal map outputs keep the source layout. The metallic/roughness outputs are
+	// swizzled to metalness in R and roughness in G, since they are compressed to BC5.
+	//
+	// Filters 4 texels at a time on threadCount threads, where 0 uses one per hardware thread. The lobes of each mip are averaged
+	// from the mip above instead of from the base level, which covers the same texels in a different order, so the result can differ
+	// from PrefilterReference() by 1 in the 8-bit output.
+	void Prefilter(
+		const uint8_t* normalmap, const uint8_t* metallicRoughnessmap,
+		uint32_t width, uint32_t height, size_t mipCount,
+		std::vector<FMip>& outNormalMips, std::vector<FMip>& outMetallicRoughnessMips,
+		size_t threadCount = 0);
+
+	// Line by line port of the shader, one texel at a time and every mip from the base level. The golden data is generated with this.
+	void PrefilterReference(
+		const uint8_t* normalmap, const uint8_t* metallicRoughnessmap,
+		uint32_t width, uint32_t height, size_t mipCount,
+		std::vector<FMip>& outNormalMips, std::vector<FMip>& outMetallicRoughnessMips);
+
+	// Both chains must have the same mip sizes
+	FDifference Compare(const std::vector<FMip>& a, const std::vector<FMip>& b);
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <ppl.h>
+#include <concurrent_unordered_map.h>
+#endif
+
+// Parallel loops and a thread-safe map for the code that is shared with the tools. On Windows these forward to the Parallel Patterns
+// Library, whose scheduler keeps its threads between loops. Elsewhere they fall back to threads that are started per loop, which
+// only depends on the standard library.
+namespace Parallel
+{
+	// Caps the number of threads that a loop runs on, including the calling thread, for measuring how the loops scale. 0 uses 
+	// one thread per hardware thread.
+	inline std::atomic<size_t>& GetThreadLimit()
+	{
+		static std::atomic<size_t> threadLimit = 0;
+		return threadLimit;
+	}
+
+	inline size_t GetThreadCount()
+	{
+		const size_t threadLimit = GetThreadLimit();
+		return threadLimit != 0 ? threadLimit : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	// Helper threads that are currently running a loop. Nested loops only start threads for the hardware threads that are left,
+	// so that a parallel loop inside another one doesn't multiply the thread count.
+	inline std::atomic<size_t>& GetBusyThreadCount()
+	{
+		static std::atomic<size_t> busyThreadCount = 0;
+		return busyThreadCount;
+	}
+
+	// Calls fn(i) for every i in [first, last) on the calling thread and up to one helper thread per idle hardware thread. Indices
+	// are handed out in batches from a shared counter, so that iterations of uneven cost are balanced between the threads. The first
+	// exception thrown by fn stops the loop and is rethrown once every thread has stopped, as parallel_for does.
+	template<typename Index, typename Fn>
+	void For(Index first, Index last, const Fn& fn)
+	{
+		if (!(first < last))
+			return;
+
+#ifdef _WIN32
+		// A thread limit is only set to measure how the loops scale, which needs the fallback below
+		if (GetThreadLimit() == 0)
+		{
+			concurrency::parallel_for(first, last, fn);
+			return;
+		}
+#endif
+
+		const size_t count = (size_t)(last - first);
+		const size_t threadCount = std::min(GetThreadCount(), count);
+
+		std::atomic<size_t>& busyThreadCount = GetBusyThreadCount();
+		size_t busy = busyThreadCount.load();
+		size_t helperCount = 0;
+		do
+		{
+			helperCount = std::min(threadCount - 1, GetThreadCount() > busy + 1 ? GetThreadCount() - busy - 1 : 0);
+		} while (!busyThreadCount.compare_exchange_weak(busy, busy + helperCount));
+
+		if (helperCount == 0)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				fn((Index)(first + i));
+			}
+
+			return;
+		}
+
+		const size_t batchSize = std::max<size_t>(count / ((helperCount + 1) * 16), 1);
+		std::atomic<size_t> nextIndex = 0;
+		std::exception_ptr exception;
+		std::mutex exceptionMutex;
+		auto Work = [&]()
+		{
+			try
+			{
+				for (size_t begin = nextIndex.fetch_add(batchSize); begin < count; begin = nextIndex.fetch_add(batchSize))
+				{
+					const size_t end = std::min(begin + batchSize, count);
+					for (size_t i = begin; i < end; ++i)
+					{
+						fn((Index)(first + i));
+					}
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard lock(exceptionMutex);
+				exception = exception ? exception : std::current_exception();
+				nextIndex = count;
+			}
+		};
+
+		// Joins the helpers and releases their hardware threads however this scope is left, including when starting a thread fails
+		struct FHelperGuard
+		{
+			std::vector<std::thread> m_threads;
+			size_t m_reservedCount;
+
+			~FHelperGuard()
+			{
+				for (std::thread& thread : m_threads)
+				{
+					thread.join();
+				}
+
+				GetBusyThreadCount() -= m_reservedCount;
+			}
+		};
+
+		{
+			FHelperGuard helpers{ {}, helperCount };
+			helpers.m_threads.reserve(helperCount);
+			for (size_t helperIndex = 0; helperIndex < helperCount; ++helperIndex)
+			{
+				helpers.m_threads.emplace_back(Work);
+			}
+
+			Work();
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	template<typename RandomIt, typename Fn>
+	void ForEach(RandomIt first, RandomIt last, const Fn& fn)
+	{
+		For((size_t)0, (size_t)std::distance(first, last), [&](size_t i)
+		{
+			fn(first[i]);
+		});
+	}
+
+	// Sorts runs of the range in parallel and merges them pairwise. Like std::sort, this is not stable.
+	template<typename RandomIt, typename Compare = std::less<>>
+	void Sort(RandomIt first, RandomIt last, Compare compare = {})
+	{
+#ifdef _WIN32
+		if (GetThreadLimit() == 0)
+		{
+			concurrency::parallel_sort(first, last, compare);
+			return;
+		}
+#endif
+
+		constexpr size_t MinRunLength = 4096;
+		const size_t count = (size_t)std::distance(first, last);
+		const size_t runCount = std::min(GetThreadCount(), count / MinRunLength);
+		if (runCount <= 1)
+		{
+			std::sort(first, last, compare);
+			return;
+		}
+
+		auto RunBegin = [&](size_t run) { return first + count * std::min(run, runCount) / runCount; };
+		For((size_t)0, runCount, [&](size_t run)
+		{
+			std::sort(RunBegin(run), RunBegin(run + 1), compare);
+		});
+
+		for (size_t width = 1; width < runCount; width *= 2)
+		{
+			For((size_t)0, (runCount + 2 * width - 1) / (2 * width), [&](size_t pair)
+			{
+				const size_t run = pair * 2 * width;
+				if (run + width < runCount)
+				{
+					std::inplace_merge(RunBegin(run), RunBegin(run + width), RunBegin(run + 2 * width), compare);
+				}
+			});
+		}
+	}
+}
+
+// Unordered map that can be searched and inserted into from several threads. Values are never moved once they are inserted, so the
+// pointers returned by Find() stay valid until the entry is erased. Erasing, clearing and iterating are not thread-safe.
+#ifdef _WIN32
+template<typename Key, typename Value>
+class TConcurrentMap
+{
+public:
+	const Value* Find(const Key& key) const
+	{
+		auto it = m_map.find(key);
+		return it != m_map.cend() ? &it->second : nullptr;
+	}
+
+	// Keeps the existing value if the key is already present
+	void Insert(const Key& key, Value value)
+	{
+		m_map.insert({ key, std::move(value) });
+	}
+
+	size_t Erase(const Key& key)
+	{
+		return m_map.unsafe_erase(key);
+	}
+
+	void Clear()
+	{
+		m_map.clear();
+	}
+
+	size_t Size() const
+	{
+		return m_map.size();
+	}
+
+	auto begin() const { return m_map.cbegin(); }
+	auto end() const { return m_map.cend(); }
+
+private:
+	concurrency::concurrent_unordered_map<Key, Value> m_map;
+};
+#else
+template<typename Key, typename Value>
+class TConcurrentMap
+{
+public:
+	const Value* Find(const Key& key) const
+	{
+		std::shared_lock lock(m_mutex);
+		auto it = m_map.find(key);
+		return it != m_map.cend() ? &it->second : nullptr;
+	}
+
+	// Keeps the existing value if the key is already present
+	void Insert(const Key& key, Value value)
+	{
+		std::unique_lock lock(m_mutex);
+		m_map.try_emplace(key, std::move(value));
+	}
+
+	size_t Erase(const Key& key)
+	{
+		return m_map.erase(key);
+	}
+
+	void Clear()
+	{
+		m_map.clear();
+	}
+
+	size_t Size() const
+	{
+		std::shared_lock lock(m_mutex);
+		return m_map.size();
+	}
+
+	auto begin() const { return m_map.cbegin(); }
+	auto end() const { return m_map.cend(); }
+
+private:
+	mutable std::shared_mutex m_mutex;
+	std::unordered_map<Key, Value> m_map;
+};
+#endif
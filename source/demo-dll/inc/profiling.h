@@ -1,13 +1,24 @@
 #pragma once
 
+#include <cstdint>
+
+#if defined(_WIN32)
 #include <backend-d3d12.h>
 #include <Tracy.hpp>
 #include <TracyD3D12.hpp>
+#endif
 
 #define DO_TOKEN_PASTE(a, b) a ## b
 #define TOKEN_PASTE(a, b)  DO_TOKEN_PASTE(a,b)
 
+// Only CPU events exist where the renderer isn't built, and the tools that share the mesh processing stub them out
+#if defined(_WIN32)
 #define SCOPED_CPU_EVENT(name, color) Profiling::ScopedCpuEvent TOKEN_PASTE(event_, __LINE__)("CPU", name, color); ZoneScopedN(name);
+#else
+#define SCOPED_CPU_EVENT(name, color) Profiling::ScopedCpuEvent TOKEN_PASTE(event_, __LINE__)("CPU", name, color);
+#define PIX_COLOR_DEFAULT 0
+#endif
+
 #define SCOPED_COMMAND_LIST_EVENT(cmdList, name, color) Profiling::ScopedCommandListEvent TOKEN_PASTE(event_, __LINE__)(cmdList, name, color)
 #define SCOPED_COMMAND_QUEUE_EVENT(cmdQueueType, name, color) Profiling::ScopedCommandQueueEvent TOKEN_PASTE(event_, __LINE__)(cmdQueueType, name, color)
 
@@ -20,6 +31,7 @@ namespace Profiling
 		~ScopedCpuEvent();
 	};
 
+#if defined(_WIN32)
 	struct ScopedCommandListEvent
 	{
 		FCommandList* m_cmdList;
@@ -37,4 +49,5 @@ namespace Profiling
 		ScopedCommandQueueEvent(D3D12_COMMAND_LIST_TYPE queueType, const wchar_t* eventName, uint64_t color);
 		~ScopedCommandQueueEvent();
 	};
+#endif
 }
\ No newline at end of file
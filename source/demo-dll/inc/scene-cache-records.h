@@ -0,0 +1,108 @@
+#pragma once
+#include <scene-cache.h>
+#include <gpu-shared-types.h>
+#include <DirectXCollision.h>
+#include <dxgiformat.h>
+#include <d3dcommon.h>
+#include <string>
+
+// BLAS inputs of a primitive. These are resolved from the accessors so that acceleration structures can also be built from a
+// scene cache, without the GLTF model. Padding is explicit so that the bytes written to the scene cache are always initialized.
+struct FRaytracingGeometry
+{
+	int m_vertexBufferView;
+	uint32_t __padding0 = 0;
+	uint64_t m_vertexByteOffset;	// From the start of the buffer view
+	uint32_t m_vertexStride;
+	uint32_t m_vertexCount;
+	DXGI_FORMAT m_vertexFormat;
+	int m_indexBufferView;
+	uint64_t m_indexByteOffset;
+	uint32_t m_indexCount;
+	DXGI_FORMAT m_indexFormat;
+};
+
+// Record types of the scene cache sections that only the scene loader reads, and the consistency checks of a mapped file. These
+// only depend on the types that are shared with the shaders and on DirectXMath, so that the tools can write and check scene caches.
+namespace SceneCache
+{
+	struct FMeshAssetRecord
+	{
+		uint32_t m_firstPrimitive;
+		uint32_t m_primitiveCount;
+		DirectX::BoundingBox m_bounds;
+	};
+
+	struct FPrimitiveRecord
+	{
+		int m_indexAccessor;
+		int m_positionAccessor;
+		int m_uvAccessor;
+		int m_normalAccessor;
+		int m_tangentAccessor;
+		uint32_t __padding0 = 0;
+		uint64_t m_indexCount;
+		D3D_PRIMITIVE_TOPOLOGY m_topology;
+		int m_materialIndex;
+		DirectX::BoundingSphere m_boundingSphere;
+		FRaytracingGeometry m_raytracingGeometry;
+	};
+
+	static_assert(sizeof(FRaytracingGeometry) == 48 && sizeof(FPrimitiveRecord) == 104, "Scene cache records have implicit padding");
+
+	struct FInstanceRecord
+	{
+		int m_index;
+		uint32_t m_visible;
+		Matrix m_transform;
+		DirectX::BoundingBox m_bounds;
+		FStringRecord m_name;
+	};
+
+	struct FSamplerRecord
+	{
+		int m_minFilter;
+		int m_magFilter;
+		int m_wrapS;
+		int m_wrapT;
+	};
+
+	struct FCameraRecord
+	{
+		Matrix m_viewTransform;
+		Matrix m_projectionTransform;
+		FStringRecord m_name;
+	};
+
+	// Materials in the cache reference textures and samplers by their index in the Textures and Samplers sections
+	constexpr int FMaterial::* MaterialTextureIndices[] =
+	{
+		&FMaterial::m_emissiveTextureIndex,
+		&FMaterial::m_baseColorTextureIndex,
+		&FMaterial::m_metallicRoughnessTextureIndex,
+		&FMaterial::m_normalTextureIndex,
+		&FMaterial::m_aoTextureIndex,
+		&FMaterial::m_transmissionTextureIndex,
+		&FMaterial::m_clearcoatTextureIndex,
+		&FMaterial::m_clearcoatRoughnessTextureIndex,
+		&FMaterial::m_clearcoatNormalTextureIndex
+	};
+
+	constexpr int FMaterial::* MaterialSamplerIndices[] =
+	{
+		&FMaterial::m_emissiveSamplerIndex,
+		&FMaterial::m_baseColorSamplerIndex,
+		&FMaterial::m_metallicRoughnessSamplerIndex,
+		&FMaterial::m_normalSamplerIndex,
+		&FMaterial::m_aoSamplerIndex,
+		&FMaterial::m_transmissionSamplerIndex,
+		&FMaterial::m_clearcoatSamplerIndex,
+		&FMaterial::m_clearcoatRoughnessSamplerIndex,
+		&FMaterial::m_clearcoatNormalSamplerIndex
+	};
+
+	// Checks that every section holds whole records, and that every index and range in them refers to data that exists in the file,
+	// so that a damaged or mismatched cache is rejected before the loader uses any of it. Returns false with the first problem
+	// found in error.
+	bool Validate(const FReader& reader, std::string& error);
+}
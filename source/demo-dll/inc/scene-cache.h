@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <span>
+
+// Versioned binary blob with everything that a scene needs after loading, packed into the same arrays that are uploaded to the GPU.
+// The file is memory mapped on load and the arrays are handed to the upload path in place. This only depends on the standard
+// library and the OS file mapping, so that it can be built and tested on other platforms. The record types of the sections that
+// only the scene loader reads, and the checks of their contents, are in scene-cache-records.h.
+namespace SceneCache
+{
+	constexpr uint32_t Magic = 0x454e4353; // "SCNE"
+
+	// Bump whenever the layout of a section, or of a type that is stored in one, changes
+	constexpr uint32_t Version = 4;
+
+	// Sections start at this alignment so that the arrays can be used in place
+	constexpr size_t SectionAlignment = 64;
+
+	enum class Section : uint32_t
+	{
+		BufferData,					// Bytes of the buffer views that accessors reference, packed as they are in the geometry arena
+		BufferViews,				// FMeshBufferView, with offsets into BufferData
+		Accessors,					// FMeshAccessor
+		AccessorFormats,			// FAccessorFormat
+		MeshAssets,					// FMeshAssetRecord
+		MeshPrimitives,				// FPrimitiveRecord, referenced by the assets
+		MeshInstances,				// FInstanceRecord
+		DecalInstances,				// FInstanceRecord
+		GpuPrimitives,				// FGpuPrimitive
+		GpuMeshlets,				// FGpuMeshlet per mesh asset
+		GpuMeshletInstances,		// FGpuMeshletInstance per mesh instance
+		MeshletVertexIndices,		// Packed meshlet vertex index deltas
+		MeshletTriangleIndices,		// FInlineMeshlet::FPackedTriangle
+		PrimitiveCounts,			// uint32_t per mesh instance
+		Materials,					// FMaterial, with indices into Textures and Samplers in place of descriptor indices
+		Textures,					// uint64_t per texture with its key in the texture cache. See ContentCache::FManifest.
+		Samplers,					// FSamplerRecord
+		Lights,						// FLight
+		LightInstances,				// FInstanceRecord with the light index in place of the asset index
+		Cameras,					// FCameraRecord
+		Strings,					// Null terminated names, referenced by FStringRecord
+		Count
+	};
+
+	struct FSectionEntry
+	{
+		uint64_t m_offset;
+		uint64_t m_size;
+	};
+
+	struct FHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_sourceKey;		// Identifies the source content and settings that the file was generated from
+		uint64_t m_fileSize;
+		FSectionEntry m_sections[(size_t)Section::Count];
+	};
+
+	struct FStringRecord
+	{
+		uint32_t m_offset;			// Into the Strings section
+		uint32_t m_length;
+	};
+
+	// Collects the sections in memory and writes them out in one go
+	struct FWriter
+	{
+		void Add(Section section, const void* data, size_t size);
+
+		template<typename T>
+		void Add(Section section, const std::vector<T>& elements)
+		{
+			Add(section, elements.data(), elements.size() * sizeof(T));
+		}
+
+		// Appends a string to the Strings section
+		FStringRecord AddString(const std::string& str);
+
+		// Writes to a temporary file that is then renamed over the destination, so that a reader never sees a partial file
+		bool Save(const std::string& filename, uint64_t sourceKey) const;
+
+		std::vector<uint8_t> m_sections[(size_t)Section::Count];
+	};
+
+	// Read only mapping of a scene cache file. Open() fails if the file is missing, was written by another version, or if any
+	// section lies outside of the file. The arrays returned by Get() point into the mapping and are valid until Close().
+	struct FReader
+	{
+		FReader() = default;
+		FReader(const FReader&) = delete;
+		FReader& operator=(const FReader&) = delete;
+		~FReader();
+
+		bool Open(const std::string& filename);
+		void Close();
+
+		uint64_t GetSourceKey() const { return m_header ? m_header->m_sourceKey : 0; }
+		std::span<const uint8_t> GetBytes(Section section) const;
+		std::string GetString(const FStringRecord& record) const;
+
+		// Returns an empty array if the section size is not a multiple of the element size
+		template<typename T>
+		std::span<const T> Get(Section section) const
+		{
+			const std::span<const uint8_t> bytes = GetBytes(section);
+			if (bytes.size() % sizeof(T) != 0)
+				return {};
+
+			return { (const T*)bytes.data(), bytes.size() / sizeof(T) };
+		}
+
+		const FHeader* m_header = nullptr;
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+		void* m_mapping = nullptr;	// Windows file mapping handle
+	};
+
+	const char* GetSectionName(Section section);
+}
@@ -2,6 +2,13 @@
 
 #include <tiny_gltf.h>
 #include <mesh-utils.h>
+#include <cluster-lod.h>
+#include <vertex-quantization.h>
+#include <scene-cache-records.h>
+#include <free-list-allocator.h>
+#include <texture-pipeline.h>
+#include <content-cache.h>
+#include <normal-roughness-filter.h>
 
 // Corresponds to GLTF Primitive
 struct FMeshPrimitive
@@ -15,13 +22,19 @@ struct FMeshPrimitive
 	D3D_PRIMITIVE_TOPOLOGY m_topology;
 	int m_materialIndex;
 	DirectX::BoundingSphere m_boundingSphere;
+	FRaytracingGeometry m_raytracingGeometry;
+
+	// Empty for scenes that are loaded from a scene cache, which only stores the packed GPU meshlets. Scenes that generate cluster
+	// LOD skip the scene cache.
 	std::vector<FInlineMeshlet> m_meshlets;
+	FClusterDag m_clusterDag;
 };
 
-// Corresponds to GLTF Mesh
+// Corresponds to GLTF Mesh. Loaded once and shared by every node that instances it.
 struct FMesh
 {
 	std::vector<FMeshPrimitive> m_primitives;
+	DirectX::BoundingBox m_bounds;
 };
 
 // SOA struct for scene entities
@@ -57,16 +70,92 @@ struct FLightProbe
 	int m_shTextureIndex;
 };
 
+// Arrays that are uploaded to the scene geometry buffers. They point into FPackedGpuGeometry on a cold load, and straight into the
+// mapped scene cache on a warm load.
+struct FGpuGeometryView
+{
+	std::span<const FGpuPrimitive> m_primitives;
+	std::span<const FGpuMeshlet> m_meshlets;
+	std::span<const FGpuMeshletInstance> m_meshletInstances;
+	std::span<const uint8_t> m_meshletVertexIndices;
+	std::span<const FInlineMeshlet::FPackedTriangle> m_meshletTriangleIndices;
+	std::span<const uint32_t> m_primitiveCounts;
+};
+
+struct FPackedGpuGeometry
+{
+	std::vector<FGpuPrimitive> m_primitives;
+	std::vector<FGpuMeshlet> m_meshlets;						// Per mesh asset
+	std::vector<FGpuMeshletInstance> m_meshletInstances;		// Per mesh instance, to find the meshlets of its asset
+	std::vector<uint8_t> m_meshletVertexIndices;				// Stored as deltas from a per-meshlet base
+	std::vector<FInlineMeshlet::FPackedTriangle> m_meshletTriangleIndices;
+	std::vector<uint32_t> m_primitiveCounts;					// Per mesh instance, to find its primitives in the packed primitives
+
+	FGpuGeometryView GetView() const { return { m_primitives, m_meshlets, m_meshletInstances, m_meshletVertexIndices, m_meshletTriangleIndices, m_primitiveCounts }; }
+};
+
+// Range of the geometry arena. The arena is a single raw buffer that the mesh buffers of all model loaders are packed into, so that
+// they share one descriptor. It is created with the first range, sized by FConfig::GeometryArenaSizeMB, and released with the last.
+// A range that doesn't fit in the arena gets a buffer of its own instead. Freed ranges must no longer be in use by the GPU.
+struct FGeometryArenaRange
+{
+	// A raw view can address at most 2^27 32-bit elements, which bounds both the arena and a single range
+	static constexpr size_t MaxSize = 1ull << 29;
+
+	FGeometryArenaRange() = default;
+	FGeometryArenaRange(const FGeometryArenaRange&) = delete;
+	FGeometryArenaRange& operator=(const FGeometryArenaRange&) = delete;
+	FGeometryArenaRange(FGeometryArenaRange&& other) noexcept;
+	FGeometryArenaRange& operator=(FGeometryArenaRange&& other) noexcept;
+	~FGeometryArenaRange();
+
+	static FGeometryArenaRange Allocate(size_t size);
+	void Release();
+
+	// Copies the chunks to their offsets in the range. Ranges that are not written to are left uninitialized.
+	void Upload(const std::vector<std::pair<size_t, std::span<const uint8_t>>>& chunks) const;
+
+	bool IsValid() const { return m_offset != FFreeListAllocator::InvalidOffset; }
+
+	// Of the buffer that holds the range, which m_offset is relative to
+	uint32_t GetSrvIndex() const;
+	D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress() const;
+
+	size_t m_offset = FFreeListAllocator::InvalidOffset;
+	size_t m_size = 0;
+	std::unique_ptr<FShaderBuffer> m_dedicatedBuffer;	// Set if the range didn't fit in the arena
+};
+
 struct FModelLoader
 {
-	std::vector<std::unique_ptr<FShaderBuffer>> m_meshBuffers;
+	// The packed mesh buffers are split into ranges of at most FGeometryArenaRange::MaxSize
+	std::vector<FGeometryArenaRange> m_meshBuffers;
+	std::vector<size_t> m_meshBufferPackedOffsets;		// Packed offset at which each range starts
+	std::vector<int> m_meshBufferViewRanges;			// Range of each packed view, or -1 if it is not referenced
+	std::vector<FMeshBufferView> m_meshBufferViews;		// With offsets into the buffers of their ranges
 	std::unique_ptr<FShaderBuffer> m_packedMeshBufferViews;
 	std::unique_ptr<FShaderBuffer> m_packedMeshAccessors;
 
+	// Formats of the accessors that were re-encoded by VertexQuantization::CompactVertexStreams. Empty if all are floats.
+	std::vector<FAccessorFormat> m_accessorFormats;
+
 protected:
 	void LoadMeshBuffers(const tinygltf::Model& model);
 	void LoadMeshBufferViews(const tinygltf::Model& model);
 	void LoadMeshAccessors(const tinygltf::Model& model);
+
+	// Packs the buffer views that are referenced by accessors back to back, so that bytes no accessor reads are never uploaded.
+	// Offsets are relative to the packed bytes, and keep the 16 byte alignment they had in their GLTF buffer. Views that are not
+	// referenced have -1 in m_bufferSrvIndex, which is replaced by the SRV index of the geometry arena on upload.
+	static std::vector<FMeshBufferView> PackMeshBufferViews(const tinygltf::Model& model);
+	static std::vector<std::span<const uint8_t>> GetMeshBufferViewData(const tinygltf::Model& model);
+	std::vector<FMeshAccessor> PackMeshAccessors(const tinygltf::Model& model) const;
+
+	// Allocates the packed views in geometry arena ranges, and uploads the bytes of each referenced view from viewData
+	void CreateMeshBuffers(std::span<const FMeshBufferView> views, const std::vector<std::span<const uint8_t>>& viewData);
+	void CreateMeshBufferViews(std::vector<FMeshBufferView> views);
+	D3D12_GPU_VIRTUAL_ADDRESS GetMeshBufferViewAddress(int viewIndex) const;
+	void CreateMeshAccessors(std::span<const FMeshAccessor> accessors);
 };
 
 struct FScene : public FModelLoader
@@ -88,9 +177,10 @@ struct FScene : public FModelLoader
 	std::string m_textureCachePath = {};
 	std::string m_modelCachePath = {};
 
-	// Scene entity lists
-	using FSceneMeshEntities = TSceneEntities<FMesh>;
+	// Scene entity lists. Mesh entities are instances that index into the mesh assets, and light entities index into the global light list.
+	using FSceneMeshEntities = TSceneEntities<int>;
 	using FSceneLightEntities = TSceneEntities<int>;
+	const FMesh& GetMesh(const FSceneMeshEntities& collection, int instanceIndex) const { return m_meshAssets[collection.m_entityList[instanceIndex]]; }
 	FSceneMeshEntities m_sceneMeshes;
 	FSceneMeshEntities m_sceneMeshDecals;
 	FSceneLightEntities m_sceneLights;
@@ -98,10 +188,11 @@ struct FScene : public FModelLoader
 	std::vector<FCamera> m_cameras;
 
 	// Scene geo
+	std::vector<FMesh> m_meshAssets; // Indexed by GLTF mesh
 	std::unique_ptr<FShaderBuffer> m_packedPrimitives;
 	std::unique_ptr<FShaderBuffer> m_packedPrimitiveCounts;
 	std::unique_ptr<FShaderBuffer> m_packedMeshTransforms;
-	std::unordered_map<std::string, std::unique_ptr<FShaderBuffer>> m_blasList;
+	std::vector<std::unique_ptr<FShaderBuffer>> m_blasList; // Indexed by mesh asset
 	std::unique_ptr<FShaderBuffer> m_tlas;
 	std::unique_ptr<FShaderBuffer> m_packedMaterials;
 	std::vector<FMaterial> m_materialList;
@@ -110,8 +201,9 @@ struct FScene : public FModelLoader
 	std::unique_ptr<FShaderBuffer> m_packedMeshletVertexIndexBuffer;
 	std::unique_ptr<FShaderBuffer> m_packedMeshletPrimitiveIndexBuffer;
 	std::unique_ptr<FShaderBuffer> m_packedMeshlets;
+	std::unique_ptr<FShaderBuffer> m_packedMeshletInstances;
 	size_t m_primitiveCount;
-	size_t m_meshletCount;
+	size_t m_meshletCount; // Of all instances
 
 	// Lights
 	std::vector<FLight> m_globalLightList;
@@ -143,17 +235,34 @@ struct FScene : public FModelLoader
 
 
 private:
+	void LoadGltf(const std::string& modelFilepath, uint64_t modelFilesKey, const std::string& sceneCacheFilepath, uint64_t sceneCacheKey);
+	// Expects a file that passed SceneCache::Validate(). Returns false if the cached textures fail to load.
+	bool LoadSceneCache(const SceneCache::FReader& sceneCache, std::string& error);
+	void SaveSceneCache(const tinygltf::Model& model, const FPackedGpuGeometry& geometry, const std::string& filename, uint64_t key) const;
+	void FinalizeLoad();
+	FMesh LoadMeshAsset(int meshIndex, const tinygltf::Model& model);
 	void LoadLights(const tinygltf::Model& model);
-	void CreateAccelerationStructures(const tinygltf::Model& model);
-	void GenerateMeshlets(const tinygltf::Model& model);
-	void CreateGpuGeometryBuffers();
+	void ResolveRaytracingGeometry(const tinygltf::Model& model);
+	void CreateAccelerationStructures();
+	bool GenerateMeshlets(tinygltf::Model& model, FModelCache& cache);
+	void PadBoundsForQuantization();
+	void PackGpuGeometry(FPackedGpuGeometry& output) const;
+	void CreateGpuGeometryBuffers(const FGpuGeometryView& geometry);
 	void CreateGpuLightBuffers();
+	void BeginTextureLoads();
+	void FinishTextureLoads();
 	void LoadMaterials(const tinygltf::Model& model);
+	void CreateMaterialBuffer();
 	FMaterial LoadMaterial(const tinygltf::Model& model, const int materialIndex);
-	int LoadTexture(const tinygltf::Image& image, const DXGI_FORMAT srcFormat = DXGI_FORMAT_UNKNOWN, const DXGI_FORMAT compressedFormat = DXGI_FORMAT_UNKNOWN);
+	int LoadTexture(const tinygltf::Image& image, const ContentCache::TextureSlot slot);
+	int LoadCachedTexture(const uint64_t key);
 	std::pair<int, int> PrefilterNormalRoughnessTextures(const tinygltf::Image& normalmap, const tinygltf::Image& metallicRoughnessmap);
-	void ProcessReadbackTexture(FResourceReadbackContext* context, const std::string& filename, const int width, const int height, const size_t mipCount, const DXGI_FORMAT fmt, const int bpp);
+	void CompareNormalRoughnessWithGpu(const tinygltf::Image& normalmap, const tinygltf::Image& metallicRoughnessmap, const size_t mipCount);
+	void ProcessFilteredTexture(const std::vector<NormalRoughnessFilter::FMip>& mips, const std::wstring& name, const std::string& cacheFilepath, const DXGI_FORMAT fmt);
 
 private:
 	std::vector<concurrency::task<void>> m_loadingJobs;
+	std::unique_ptr<FTexturePipeline> m_texturePipeline;
+	ContentCache::FManifest m_textureManifest;
+	std::unordered_map<int, uint64_t> m_textureKeys;		// Texture cache key of each texture descriptor that the materials reference
 };
\ No newline at end of file
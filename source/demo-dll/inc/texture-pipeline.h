@@ -0,0 +1,88 @@
+#pragma once
+#include <backend-d3d12.h>
+#include <tiny_gltf.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+
+// Loads the data of textures that were created empty. Each texture is decoded, mipmapped, block compressed and written to the texture
+// cache by one of a fixed number of workers, so that the CPU stages of different textures overlap. Textures that are in the texture
+// cache are read from their DDS file instead. A worker only starts a texture once the estimated bytes of all textures in flight fit
+// in the memory budget, and finished textures are handed to an upload thread that batches them into shared upload contexts.
+class FTexturePipeline
+{
+public:
+	struct FRequest
+	{
+		const tinygltf::Image* m_image = nullptr;		// Encoded source image, or nullptr to load m_ddsFilename
+		std::wstring m_ddsFilename;						// Written to after compression if there is a source image and this is set
+		DXGI_FORMAT m_srcFormat = DXGI_FORMAT_UNKNOWN;
+		DXGI_FORMAT m_compressedFormat = DXGI_FORMAT_UNKNOWN;
+		size_t m_mipCount = 1;
+		FResource* m_destination = nullptr;				// In the copy destination state, and transitioned to a shader resource
+	};
+
+	// Stage times are summed over all workers, so they can add up to more than the total
+	struct FStats
+	{
+		size_t m_workerCount = 0;
+		size_t m_textureCount = 0;
+		size_t m_cachedTextureCount = 0;				// Read from the texture cache instead of being compressed
+		size_t m_uploadBatchCount = 0;
+		size_t m_peakBytesInFlight = 0;
+		double m_decodeSeconds = 0.0;
+		double m_mipSeconds = 0.0;
+		double m_compressSeconds = 0.0;
+		double m_cacheWriteSeconds = 0.0;
+		double m_uploadSeconds = 0.0;
+		double m_totalSeconds = 0.0;
+	};
+
+	FTexturePipeline(size_t workerCount, size_t memoryBudget, size_t uploadBatchSize);
+	~FTexturePipeline();
+
+	void Enqueue(FRequest request);
+
+	// Blocks until all the textures are uploaded
+	FStats Finish();
+
+	// Mip count of a chain that stops at 4x4 for block compression
+	static size_t GetBlockCompressedMipCount(size_t width, size_t height);
+
+private:
+	struct FPendingTexture
+	{
+		FRequest m_request;
+		size_t m_estimatedBytes;
+	};
+
+	struct FProcessedTexture
+	{
+		DirectX::ScratchImage m_scratch;
+		FResource* m_destination;
+		size_t m_estimatedBytes;
+	};
+
+	void RunWorker();
+	void RunUploader();
+	FProcessedTexture Process(const FPendingTexture& texture, FStats& stats) const;
+
+	const size_t m_memoryBudget;
+	const size_t m_uploadBatchSize;
+	const DirectX::TEX_COMPRESS_FLAGS m_compressFlags;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<FPendingTexture> m_pending;
+	std::deque<FProcessedTexture> m_processed;
+	size_t m_bytesInFlight = 0;
+	size_t m_activeWorkers = 0;
+	bool m_bFinishing = false;
+	FStats m_stats;
+
+	std::vector<std::thread> m_workers;
+	std::thread m_uploader;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <tiny_gltf.h>
+#include <SimpleMath.h>
+#include <gpu-shared-types.h>
+
+// Decoding parameters of an accessor. Positions decode to m_offset + m_scale * q for 16-bit unsigned q.
+struct FAccessorFormat
+{
+	VertexFormat::Type m_format = VertexFormat::Float;
+	DirectX::XMFLOAT3 m_offset = { 0.f, 0.f, 0.f };
+	DirectX::XMFLOAT3 m_scale = { 1.f, 1.f, 1.f };
+};
+
+// Compact vertex formats: 8 byte positions quantized to the AABB of their accessor, 4 byte octahedral normals and tangents, and
+// 4 byte half precision UVs. The decoders are the reference for MeshMaterial::GetFloat*() in the shaders.
+namespace VertexQuantization
+{
+	// Upper bounds of the decode error. Position error is per axis. Normal and tangent errors are angles in radians, and texcoord
+	// error is relative to the magnitude of the component (or to the smallest normal half for components closer to zero).
+	constexpr float MaxNormalAngleError = 1e-4f;
+	constexpr float MaxTangentAngleError = 2e-4f;
+	constexpr float MaxTexcoordRelativeError = 1.f / 2048.f;
+	DirectX::XMFLOAT3 MaxPositionError(const FAccessorFormat& format);
+
+	FAccessorFormat ComputePositionFormat(const DirectX::XMFLOAT3* positions, uint32_t count);
+	void EncodePosition(const DirectX::XMFLOAT3& position, const FAccessorFormat& format, uint16_t output[4]);
+	DirectX::XMFLOAT3 DecodePosition(const uint16_t input[4], const FAccessorFormat& format);
+
+	uint32_t EncodeNormal(const DirectX::XMFLOAT3& normal);
+	DirectX::XMFLOAT3 DecodeNormal(uint32_t input);
+
+	// xyz is the tangent and w the bitangent sign
+	uint32_t EncodeTangent(const DirectX::XMFLOAT4& tangent);
+	DirectX::XMFLOAT4 DecodeTangent(uint32_t input);
+
+	uint32_t EncodeTexcoord(const DirectX::XMFLOAT2& uv);
+	DirectX::XMFLOAT2 DecodeTexcoord(uint32_t input);
+
+	// Re-encodes the float POSITION, NORMAL, TANGENT and TEXCOORD_0 accessors of the model in the compact formats, into a new buffer
+	// with one tightly packed buffer view per accessor. Buffer bytes that are no longer referenced by any accessor or image are then
+	// dropped, so only the compact streams are uploaded. formats receives the decoding parameters of every accessor, which take
+	// precedence over the component types of the accessors. Texcoords that don't fit in half precision are left as floats.
+	void CompactVertexStreams(tinygltf::Model& model, std::vector<FAccessorFormat>& formats);
+}
@@ -2,6 +2,21 @@
 
 namespace MeshMaterial
 {
+	// Decoders for the compact vertex formats. See VertexQuantization in inc/vertex-quantization.h for the encoders.
+	int2 UnpackSnorm16x2(uint packed)
+	{
+		return int2(asint(packed << 16) >> 16, asint(packed) >> 16);
+	}
+
+	float3 DecodeOctahedral(float2 e)
+	{
+		float3 v = float3(e.x, e.y, 1.f - abs(e.x) - abs(e.y));
+		float t = max(-v.z, 0.f);
+		v.x += v.x >= 0.f ? -t : t;
+		v.y += v.y >= 0.f ? -t : t;
+		return normalize(v);
+	}
+
 	uint GetUint(int index, int accessorIndex, int accessorBufferIndex, int viewBufferIndex)
 	{
 		if (index == -1 || accessorIndex == -1 || accessorBufferIndex == -1 || viewBufferIndex == -1)
@@ -102,6 +117,13 @@ namespace MeshMaterial
 		FMeshBufferView view = viewBuffer.Load<FMeshBufferView>(accessor.m_bufferViewIndex * sizeof(FMeshBufferView));
 		ByteAddressBuffer buffer = ResourceDescriptorHeap[view.m_bufferSrvIndex];
 
+		// Tangent with the bitangent sign in the lowest bit of y
+		if (accessor.m_format == VertexFormat::Octahedral16Tangent)
+		{
+			int2 q = UnpackSnorm16x2(buffer.Load(accessor.m_byteOffset + view.m_byteOffset + index * accessor.m_byteStride));
+			return float4(DecodeOctahedral(float2(q.x / 32767.f, (q.y >> 1) / 16383.f)), (q.y & 1) ? -1.f : 1.f);
+		}
+
 		[branch]
 		switch (accessor.m_byteStride)
 		{
@@ -125,6 +147,19 @@ namespace MeshMaterial
 		FMeshBufferView view = viewBuffer.Load<FMeshBufferView>(accessor.m_bufferViewIndex * sizeof(FMeshBufferView));
 		ByteAddressBuffer buffer = ResourceDescriptorHeap[view.m_bufferSrvIndex];
 
+		[branch]
+		if (accessor.m_format == VertexFormat::Unorm16Position)
+		{
+			uint2 packed = buffer.Load2(accessor.m_byteOffset + view.m_byteOffset + index * accessor.m_byteStride);
+			float3 q = float3(packed.x & 0xffff, packed.x >> 16, packed.y & 0xffff);
+			return accessor.m_quantizationOffset + accessor.m_quantizationScale * q;
+		}
+		else if (accessor.m_format == VertexFormat::Octahedral16Normal)
+		{
+			int2 q = UnpackSnorm16x2(buffer.Load(accessor.m_byteOffset + view.m_byteOffset + index * accessor.m_byteStride));
+			return DecodeOctahedral(q / 32767.f);
+		}
+
 		float4 temp;
 		[branch]
 		switch (accessor.m_byteStride)
@@ -152,6 +187,12 @@ namespace MeshMaterial
 		FMeshBufferView view = viewBuffer.Load<FMeshBufferView>(accessor.m_bufferViewIndex * sizeof(FMeshBufferView));
 		ByteAddressBuffer buffer = ResourceDescriptorHeap[view.m_bufferSrvIndex];
 
+		if (accessor.m_format == VertexFormat::Half2Texcoord)
+		{
+			uint packed = buffer.Load(accessor.m_byteOffset + view.m_byteOffset + index * accessor.m_byteStride);
+			return f16tof32(uint2(packed & 0xffff, packed >> 16));
+		}
+
 		float4 temp;
 		[branch]
 		switch (accessor.m_byteStride)
@@ -189,4 +230,50 @@ namespace MeshMaterial
 		ByteAddressBuffer primitivesBuffer = ResourceDescriptorHeap[primitivesBufferIndex];
 		return primitivesBuffer.Load<FGpuPrimitive>((primitiveOffset + geometryIndex) * sizeof(FGpuPrimitive));
 	}
+
+	// Meshlet vertex indices are stored as 8, 16 or 32 bit deltas from a per-meshlet base. See MeshUtils::EncodeMeshletVertices()
+	uint GetMeshletVertexIndex(FGpuMeshlet meshlet, uint meshletVertIndex, int packedVertexIndexBufferIndex)
+	{
+		ByteAddressBuffer packedVertexIndexBuffer = ResourceDescriptorHeap[packedVertexIndexBufferIndex];
+
+		// Raw address buffer addressing needs to be clamped to a 4 byte boundary. Deltas never straddle one.
+		uint byteOffset = meshlet.m_vertexBegin + meshletVertIndex * meshlet.m_vertexDeltaSize;
+		uint dwordAlignedByteOffset = byteOffset & ~3;
+		uint bufferValue = packedVertexIndexBuffer.Load(dwordAlignedByteOffset) >> ((byteOffset - dwordAlignedByteOffset) * 8);
+
+		uint deltaMask = meshlet.m_vertexDeltaSize == 4 ? 0xffffffff : (1u << (meshlet.m_vertexDeltaSize * 8)) - 1;
+		return meshlet.m_vertexBase + (bufferValue & deltaMask);
+	}
+
+	// Meshlets are stored once per mesh asset, while culling and the visibility buffer number the meshlets of all mesh instances one 
+	// after the other. Finds the instance that such a number belongs to, and returns the meshlet of its asset.
+	FGpuMeshlet GetInstanceMeshlet(uint instanceMeshletId, uint meshInstanceCount, int instancesBufferIndex, int meshletsBufferIndex, out uint meshIndex, out uint meshletIndex)
+	{
+		ByteAddressBuffer instancesBuffer = ResourceDescriptorHeap[instancesBufferIndex];
+
+		// Last instance that starts at or before the id. Instances without meshlets start where the next one does, so they are skipped.
+		uint first = 0;
+		uint count = meshInstanceCount;
+		while (count > 1)
+		{
+			const uint halfCount = count / 2;
+			const FGpuMeshletInstance instance = instancesBuffer.Load<FGpuMeshletInstance>((first + halfCount) * sizeof(FGpuMeshletInstance));
+			if (instance.m_instanceMeshletBegin <= instanceMeshletId)
+			{
+				first += halfCount;
+				count -= halfCount;
+			}
+			else
+			{
+				count = halfCount;
+			}
+		}
+
+		const FGpuMeshletInstance instance = instancesBuffer.Load<FGpuMeshletInstance>(first * sizeof(FGpuMeshletInstance));
+		meshIndex = first;
+		meshletIndex = instance.m_meshletBegin + instanceMeshletId - instance.m_instanceMeshletBegin;
+
+		ByteAddressBuffer meshletsBuffer = ResourceDescriptorHeap[meshletsBufferIndex];
+		return meshletsBuffer.Load<FGpuMeshlet>(meshletIndex * sizeof(FGpuMeshlet));
+	}
 }
\ No newline at end of file
@@ -51,6 +51,30 @@ bool FrustumCull(float4 boundingSphere, float4x4 meshTransform)
         && (dot(boundsCenter, tPlane) + boundsRadius * length(tPlane.xyz) >= 0);
 }
 
+bool ConeCull(float4 boundingSphere, uint packedCone, float4x4 meshTransform)
+{
+    // Normal cone is packed as s8 axis (xyz) and s8 sine of the cone half-angle (w)
+    const int4 cone = asint(uint4(packedCone << 24, packedCone << 16, packedCone << 8, packedCone)) >> 24;
+    const float cutoff = cone.w / 127.f;
+
+    // Bring the eye into object space so that the test holds under non-uniform scale
+    float4x4 localToWorld = mul(meshTransform, g_sceneCb.m_sceneRotation);
+    const float3 r0 = localToWorld[0].xyz;
+    const float3 r1 = localToWorld[1].xyz;
+    const float3 r2 = localToWorld[2].xyz;
+    const float3 d = g_viewCb.m_cullEyePos - localToWorld[3].xyz;
+    const float det = dot(r0, cross(r1, r2));
+    const float3 eye = float3(dot(d, cross(r1, r2)), dot(d, cross(r2, r0)), dot(d, cross(r0, r1))) / det;
+
+    // A mirroring transform flips the winding seen by the rasterizer, and with it the side that gets culled
+    float3 axis = normalize(float3(cone.xyz));
+    axis = det < 0.f ? axis : -axis;
+
+    // Visible unless the eye is behind the planes of all triangles. The test is conservative for any point within the bounding sphere.
+    const float3 view = boundingSphere.xyz - eye;
+    return dot(view, axis) < cutoff * length(view) + boundingSphere.w;
+}
+
 [numthreads(THREAD_GROUP_SIZE_X, 1, 1)]
 void cs_primitive_cull_main(uint3 dispatchThreadId : SV_DispatchThreadID)
 {
@@ -138,31 +162,39 @@ void cs_meshlet_cull_main(uint3 dispatchThreadId : SV_DispatchThreadID)
     uint meshletId = dispatchThreadId.x;
     if (meshletId < g_sceneCb.m_meshletCount)
     {
-        ByteAddressBuffer meshletsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshletsBufferIndex];
-        const FGpuMeshlet meshlet = meshletsBuffer.Load<FGpuMeshlet>(meshletId * sizeof(FGpuMeshlet));
+        // The meshlet id numbers the meshlets of all mesh instances, which share the meshlets of their asset
+        uint meshIndex, meshletIndex;
+        const FGpuMeshlet meshlet = MeshMaterial::GetInstanceMeshlet(meshletId, g_sceneCb.m_meshInstanceCount, g_sceneCb.m_packedSceneMeshletInstancesBufferIndex, g_sceneCb.m_packedSceneMeshletsBufferIndex, meshIndex, meshletIndex);
 
         // Check if the mesh is hidden by user
         ByteAddressBuffer meshVisibilityBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshVisibilityBufferIndex];
-        uint visibility = meshVisibilityBuffer.Load<uint>(meshlet.m_meshIndex * sizeof(uint));
+        uint visibility = meshVisibilityBuffer.Load<uint>(meshIndex * sizeof(uint));
         if (visibility != 0)
         {
-#if FRUSTUM_CULLING
+            FMaterial material = MeshMaterial::GetMaterial(meshlet.m_materialIndex, g_sceneCb.m_sceneMaterialBufferIndex);
             ByteAddressBuffer meshTransformsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshTransformsBufferIndex];
-            float4x4 meshTransform = meshTransformsBuffer.Load<float4x4>(meshlet.m_meshIndex * sizeof(float4x4));
-            
-            if (FrustumCull(meshlet.m_boundingSphere, meshTransform))
-#else
-            if (true)
+            float4x4 meshTransform = meshTransformsBuffer.Load<float4x4>(meshIndex * sizeof(float4x4));
+
+            bool bVisible = true;
+#if FRUSTUM_CULLING
+            bVisible = bVisible && FrustumCull(meshlet.m_boundingSphere, meshTransform);
+#endif
+#if BACKFACE_CULLING
+            // Double-sided materials are rasterized without backface culling
+            bVisible = bVisible && (material.m_doubleSided || ConeCull(meshlet.m_boundingSphere, meshlet.m_normalCone, meshTransform));
 #endif
+
+            if (bVisible)
             {
                 FIndirectDrawWithRootConstants cmd = (FIndirectDrawWithRootConstants) 0;
                 cmd.m_rootConstants[0] = meshletId;
+                cmd.m_rootConstants[1] = meshletIndex;
+                cmd.m_rootConstants[2] = meshIndex;
                 cmd.m_drawArguments.m_vertexCount = meshlet.m_triangleCount * 3;
                 cmd.m_drawArguments.m_instanceCount = 1;
                 cmd.m_drawArguments.m_startVertexLocation = 0;
                 cmd.m_drawArguments.m_startInstanceLocation = 0;
 
-                FMaterial material = MeshMaterial::GetMaterial(meshlet.m_materialIndex, g_sceneCb.m_sceneMaterialBufferIndex);
                 if (material.m_doubleSided)
                 {
                     // Append to double-sided args buffer
@@ -134,12 +134,11 @@ FTriangleData GetMeshletTriangleData(int meshletTriangleIndex, FGpuMeshlet meshl
     };
 	
 	// Compute the unique vertex index for the current meshlet vert
-    ByteAddressBuffer packedVertexIndexBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedMeshletVertexIndexBufferIndex];
     uint uniqueVertIndices[] = 
     {
-        packedVertexIndexBuffer.Load<uint>((meshlet.m_vertexBegin + meshletTriVertIndices[0]) * sizeof(uint)),
-        packedVertexIndexBuffer.Load<uint>((meshlet.m_vertexBegin + meshletTriVertIndices[1]) * sizeof(uint)),
-        packedVertexIndexBuffer.Load<uint>((meshlet.m_vertexBegin + meshletTriVertIndices[2]) * sizeof(uint))
+        MeshMaterial::GetMeshletVertexIndex(meshlet, meshletTriVertIndices[0], g_sceneCb.m_packedMeshletVertexIndexBufferIndex),
+        MeshMaterial::GetMeshletVertexIndex(meshlet, meshletTriVertIndices[1], g_sceneCb.m_packedMeshletVertexIndexBufferIndex),
+        MeshMaterial::GetMeshletVertexIndex(meshlet, meshletTriVertIndices[2], g_sceneCb.m_packedMeshletVertexIndexBufferIndex)
     };
 
     o.m_vertices[0].m_position = MeshMaterial::GetFloat3(uniqueVertIndices[0], meshlet.m_positionAccessor, g_sceneCb.m_sceneMeshAccessorsIndex, g_sceneCb.m_sceneMeshBufferViewsIndex);
@@ -182,14 +181,14 @@ void cs_main(uint3 dispatchThreadId : SV_DispatchThreadID)
             uint meshletId, triangleId;
             DecodeMeshletVisibility(visBufferValue, meshletId, triangleId);
 
-            // Use meshlet id to retrieve the meshlet info
-            ByteAddressBuffer packedMeshletsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshletsBufferIndex];
-            const FGpuMeshlet meshlet = packedMeshletsBuffer.Load<FGpuMeshlet>(meshletId * sizeof(FGpuMeshlet));
+            // Use meshlet id to retrieve the meshlet info and the mesh instance it belongs to
+            uint meshIndex, meshletIndex;
+            const FGpuMeshlet meshlet = MeshMaterial::GetInstanceMeshlet(meshletId, g_sceneCb.m_meshInstanceCount, g_sceneCb.m_packedSceneMeshletInstancesBufferIndex, g_sceneCb.m_packedSceneMeshletsBufferIndex, meshIndex, meshletIndex);
 
             // Fill the vertex data for the triangle
             FTriangleData tri = GetMeshletTriangleData(triangleId, meshlet);
             
-            float4x4 localToWorld = meshTransformsBuffer.Load<float4x4>(meshlet.m_meshIndex * sizeof(float4x4));
+            float4x4 localToWorld = meshTransformsBuffer.Load<float4x4>(meshIndex * sizeof(float4x4));
             FMaterial material = MeshMaterial::GetMaterial(meshlet.m_materialIndex, g_sceneCb.m_sceneMaterialBufferIndex);
             
 #else
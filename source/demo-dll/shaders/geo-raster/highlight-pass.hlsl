@@ -24,9 +24,8 @@ float4 vs_main(uint invocationIndex : SV_VertexID) : SV_POSITION
 {
 #if USING_MESHLETS
 	// Use object id to retrieve the meshlet info
-	ByteAddressBuffer meshletsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshletsBufferIndex];
-	const FGpuMeshlet meshlet = meshletsBuffer.Load<FGpuMeshlet>(g_passCb.m_objectId * sizeof(FGpuMeshlet));
-    uint meshIndex = meshlet.m_meshIndex;
+	uint meshIndex, meshletIndex;
+	const FGpuMeshlet meshlet = MeshMaterial::GetInstanceMeshlet(g_passCb.m_objectId, g_sceneCb.m_meshInstanceCount, g_sceneCb.m_packedSceneMeshletInstancesBufferIndex, g_sceneCb.m_packedSceneMeshletsBufferIndex, meshIndex, meshletIndex);
 	
     // MeshletVertIndex is the index of the vertex within the meshlet eg. 0, 1, 2, etc.
 	// The packed triangle index buffer contains one uint for every triangle packed as 10:10:10:2
@@ -38,8 +37,7 @@ float4 vs_main(uint invocationIndex : SV_VertexID) : SV_POSITION
     uint meshletVertIndex = 0xff & (packedMeshletTriangleIndex >> ((2 - triangleVertIndex) * 10));
     
     // Compute the unique vertex index for the current meshlet vert
-    ByteAddressBuffer packedVertexIndexBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedMeshletVertexIndexBufferIndex];
-    uint vertIndex = packedVertexIndexBuffer.Load<uint>((meshlet.m_vertexBegin + meshletVertIndex) * sizeof(uint));
+    uint vertIndex = MeshMaterial::GetMeshletVertexIndex(meshlet, meshletVertIndex, g_sceneCb.m_packedMeshletVertexIndexBufferIndex);
     int positionAccessor = meshlet.m_positionAccessor;
     
 #else
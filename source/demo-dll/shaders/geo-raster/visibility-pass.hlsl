@@ -14,6 +14,10 @@ struct FPassConstants
 {
 	// primitive or meshlet id
 	uint id;
+
+	// Meshlet of the mesh asset and mesh instance that the meshlet id belongs to, as found by the culling pass
+	uint meshletIndex;
+	uint meshIndex;
 };
 
 ConstantBuffer<FPassConstants> g_passCb : register(b0);
@@ -62,11 +66,11 @@ vs_to_ps vs_meshlet_main(uint invocationIndex : SV_VertexID)
 
 	// Load the meshlet from the packed meshlets buffer using the meshlet id
     ByteAddressBuffer meshletsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshletsBufferIndex];
-    FGpuMeshlet meshlet = meshletsBuffer.Load<FGpuMeshlet>(meshletId * sizeof(FGpuMeshlet));
+    FGpuMeshlet meshlet = meshletsBuffer.Load<FGpuMeshlet>(g_passCb.meshletIndex * sizeof(FGpuMeshlet));
 	
 	// Meshlet transform
     ByteAddressBuffer meshTransformsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshTransformsBufferIndex];
-    float4x4 localToWorld = meshTransformsBuffer.Load<float4x4>(meshlet.m_meshIndex * sizeof(float4x4));
+    float4x4 localToWorld = meshTransformsBuffer.Load<float4x4>(g_passCb.meshIndex * sizeof(float4x4));
     localToWorld = mul(localToWorld, g_sceneCb.m_sceneRotation);
 	
 	// MeshletVertIndex is the index of the vertex within the meshlet eg. 0, 1, 2, etc.
@@ -78,8 +82,7 @@ vs_to_ps vs_meshlet_main(uint invocationIndex : SV_VertexID)
     uint meshletVertIndex = 0xff & (packedMeshletTriangleIndex >> ((2 - triangleVertIndex) * 10));
 	
 	// Compute the unique vertex index for the current meshlet vert
-    ByteAddressBuffer packedVertexIndexBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedMeshletVertexIndexBufferIndex];
-    uint uniqueVertIndex = packedVertexIndexBuffer.Load<uint>((meshlet.m_vertexBegin + meshletVertIndex) * sizeof(uint));
+    uint uniqueVertIndex = MeshMaterial::GetMeshletVertexIndex(meshlet, meshletVertIndex, g_sceneCb.m_packedMeshletVertexIndexBufferIndex);
 	
 	// Read vertex attributes for the vertex buffer(s)
     float3 position = MeshMaterial::GetFloat3(uniqueVertIndex, meshlet.m_positionAccessor, g_sceneCb.m_sceneMeshAccessorsIndex, g_sceneCb.m_sceneMeshBufferViewsIndex);
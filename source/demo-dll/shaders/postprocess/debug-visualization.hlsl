@@ -75,10 +75,9 @@ float4 ps_main(vs_to_ps input) : SV_Target
 		uint objectId, triangleId;
         DecodeMeshletVisibility(visbufferValue, objectId, triangleId);
 		
-		ByteAddressBuffer packedMeshletsBuffer = ResourceDescriptorHeap[g_sceneCb.m_packedSceneMeshletsBufferIndex];
-        const FGpuMeshlet meshlet = packedMeshletsBuffer.Load<FGpuMeshlet>(objectId * sizeof(FGpuMeshlet));
+		uint meshIndex, meshletIndex;
+        const FGpuMeshlet meshlet = MeshMaterial::GetInstanceMeshlet(objectId, g_sceneCb.m_meshInstanceCount, g_sceneCb.m_packedSceneMeshletInstancesBufferIndex, g_sceneCb.m_packedSceneMeshletsBufferIndex, meshIndex, meshletIndex);
 		float4 boundingSphere = meshlet.m_boundingSphere;
-		int meshIndex = meshlet.m_meshIndex;
         const uint vertCount = meshlet.m_triangleCount * 3;
 	#else
 		uint objectId, triangleId;
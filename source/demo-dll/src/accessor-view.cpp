@@ -0,0 +1,276 @@
+#include <accessor-view.h>
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	template<typename ViewType, typename ModelType>
+	ViewType GetView(ModelType& model, int accessorIndex)
+	{
+		const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+		if (accessor.bufferView == -1)
+			return {};
+
+		auto& bufferView = model.bufferViews[accessor.bufferView];
+		ViewType view = {};
+		view.m_data = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+		view.m_count = accessor.count;
+		view.m_byteStride = accessor.ByteStride(bufferView);
+		view.m_componentType = accessor.componentType;
+		view.m_componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+		view.m_normalized = accessor.normalized;
+		return view;
+	}
+
+	uint32_t LoadIndex(const uint8_t* pData, int componentType)
+	{
+		switch (componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return *pData;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, pData, sizeof(v)); return v; }
+		default: { uint32_t v; memcpy(&v, pData, sizeof(v)); return v; }
+		}
+	}
+
+	// See "Animations" in the GLTF spec for the normalized integer conversions
+	float LoadComponent(const uint8_t* pData, int componentType, bool bNormalized)
+	{
+		switch (componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+		{
+			const float v = (float)*(const int8_t*)pData;
+			return bNormalized ? std::max(v / 127.f, -1.f) : v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		{
+			const float v = (float)*pData;
+			return bNormalized ? v / 255.f : v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			int16_t v;
+			memcpy(&v, pData, sizeof(v));
+			return bNormalized ? std::max(v / 32767.f, -1.f) : (float)v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			uint16_t v;
+			memcpy(&v, pData, sizeof(v));
+			return bNormalized ? v / 65535.f : (float)v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			uint32_t v;
+			memcpy(&v, pData, sizeof(v));
+			return (float)v;
+		}
+		default:
+		{
+			float v;
+			memcpy(&v, pData, sizeof(v));
+			return v;
+		}
+		}
+	}
+
+#if defined(_XM_SSE_INTRINSICS_)
+	// Converts 8 signed or unsigned 16-bit integers, which are already widened to two vectors of 32-bit integers
+	void StoreFloats(__m128i lo, __m128i hi, __m128 scale, bool bClamp, float* output)
+	{
+		__m128 flo = _mm_mul_ps(_mm_cvtepi32_ps(lo), scale);
+		__m128 fhi = _mm_mul_ps(_mm_cvtepi32_ps(hi), scale);
+		if (bClamp)
+		{
+			const __m128 minusOne = _mm_set1_ps(-1.f);
+			flo = _mm_max_ps(flo, minusOne);
+			fhi = _mm_max_ps(fhi, minusOne);
+		}
+
+		_mm_storeu_ps(output, flo);
+		_mm_storeu_ps(output + 4, fhi);
+	}
+
+	void Widen16(__m128i v, bool bSigned, __m128i& lo, __m128i& hi)
+	{
+		if (bSigned)
+		{
+			lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+			hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		}
+		else
+		{
+			lo = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+			hi = _mm_unpackhi_epi16(v, _mm_setzero_si128());
+		}
+	}
+
+	// Converts a flat array of 8 or 16-bit integers, and returns how many were converted. The rest are left for the scalar path.
+	size_t ConvertComponentsSSE2(const uint8_t* pData, size_t count, int componentType, bool bNormalized, float* output)
+	{
+		const bool bSigned = componentType == TINYGLTF_COMPONENT_TYPE_BYTE || componentType == TINYGLTF_COMPONENT_TYPE_SHORT;
+		const bool bClamp = bSigned && bNormalized;
+		size_t i = 0;
+
+		if (componentType == TINYGLTF_COMPONENT_TYPE_BYTE || componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+		{
+			const __m128 scale = _mm_set1_ps(bNormalized ? (bSigned ? 1.f / 127.f : 1.f / 255.f) : 1.f);
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m128i v = _mm_loadu_si128((const __m128i*)(pData + i));
+				__m128i w0, w1;
+				if (bSigned)
+				{
+					w0 = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+					w1 = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+				}
+				else
+				{
+					w0 = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+					w1 = _mm_unpackhi_epi8(v, _mm_setzero_si128());
+				}
+
+				__m128i lo, hi;
+				Widen16(w0, bSigned, lo, hi);
+				StoreFloats(lo, hi, scale, bClamp, output + i);
+				Widen16(w1, bSigned, lo, hi);
+				StoreFloats(lo, hi, scale, bClamp, output + i + 8);
+			}
+		}
+		else if (componentType == TINYGLTF_COMPONENT_TYPE_SHORT || componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+		{
+			const __m128 scale = _mm_set1_ps(bNormalized ? (bSigned ? 1.f / 32767.f : 1.f / 65535.f) : 1.f);
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i lo, hi;
+				Widen16(_mm_loadu_si128((const __m128i*)(pData + i * 2)), bSigned, lo, hi);
+				StoreFloats(lo, hi, scale, bClamp, output + i);
+			}
+		}
+
+		return i;
+	}
+
+	size_t ConvertIndicesSSE2(const uint8_t* pData, size_t count, int componentType, uint32_t* output)
+	{
+		size_t i = 0;
+		const __m128i zero = _mm_setzero_si128();
+		if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+		{
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m128i v = _mm_loadu_si128((const __m128i*)(pData + i));
+				const __m128i w0 = _mm_unpacklo_epi8(v, zero);
+				const __m128i w1 = _mm_unpackhi_epi8(v, zero);
+				_mm_storeu_si128((__m128i*)(output + i), _mm_unpacklo_epi16(w0, zero));
+				_mm_storeu_si128((__m128i*)(output + i + 4), _mm_unpackhi_epi16(w0, zero));
+				_mm_storeu_si128((__m128i*)(output + i + 8), _mm_unpacklo_epi16(w1, zero));
+				_mm_storeu_si128((__m128i*)(output + i + 12), _mm_unpackhi_epi16(w1, zero));
+			}
+		}
+		else if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i v = _mm_loadu_si128((const __m128i*)(pData + i * 2));
+				_mm_storeu_si128((__m128i*)(output + i), _mm_unpacklo_epi16(v, zero));
+				_mm_storeu_si128((__m128i*)(output + i + 4), _mm_unpackhi_epi16(v, zero));
+			}
+		}
+
+		return i;
+	}
+#else
+	size_t ConvertComponentsSSE2(const uint8_t*, size_t, int, bool, float*) { return 0; }
+	size_t ConvertIndicesSSE2(const uint8_t*, size_t, int, uint32_t*) { return 0; }
+#endif
+}
+
+FAccessorView AccessorView::Get(const tinygltf::Model& model, int accessorIndex)
+{
+	return GetView<FAccessorView>(model, accessorIndex);
+}
+
+FMutableAccessorView AccessorView::GetMutable(tinygltf::Model& model, int accessorIndex)
+{
+	return GetView<FMutableAccessorView>(model, accessorIndex);
+}
+
+void AccessorView::ConvertIndices(const FAccessorView& view, uint32_t* output)
+{
+	const size_t componentSize = view.GetComponentSize();
+	if (view.m_byteStride == componentSize && componentSize == sizeof(uint32_t))
+	{
+		memcpy(output, view.m_data, view.m_count * sizeof(uint32_t));
+		return;
+	}
+
+	size_t i = view.m_byteStride == componentSize ? ConvertIndicesSSE2(view.m_data, view.m_count, view.m_componentType, output) : 0;
+	for (; i < view.m_count; ++i)
+	{
+		output[i] = LoadIndex(view.GetElement(i), view.m_componentType);
+	}
+}
+
+void AccessorView::WriteIndices(const FMutableAccessorView& view, const uint32_t* indices)
+{
+	for (size_t i = 0; i < view.m_count; ++i)
+	{
+		uint8_t* pData = view.GetElement(i);
+		switch (view.m_componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: *pData = (uint8_t)indices[i]; break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { const uint16_t v = (uint16_t)indices[i]; memcpy(pData, &v, sizeof(v)); break; }
+		default: memcpy(pData, &indices[i], sizeof(uint32_t)); break;
+		}
+	}
+}
+
+void AccessorView::ConvertFloats(const FAccessorView& view, uint32_t outputComponents, float* output)
+{
+	const size_t componentSize = view.GetComponentSize();
+	const uint32_t copyComponents = std::min(outputComponents, (uint32_t)view.m_componentCount);
+	const bool bPacked = view.m_byteStride == view.GetElementSize() && outputComponents == (uint32_t)view.m_componentCount;
+
+	// Tightly packed streams are a flat array of components
+	if (bPacked)
+	{
+		const size_t componentCount = view.m_count * outputComponents;
+		if (view.m_componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		{
+			memcpy(output, view.m_data, componentCount * sizeof(float));
+			return;
+		}
+
+		const size_t converted = ConvertComponentsSSE2(view.m_data, componentCount, view.m_componentType, view.m_normalized, output);
+		for (size_t c = converted; c < componentCount; ++c)
+		{
+			output[c] = LoadComponent(view.m_data + c * componentSize, view.m_componentType, view.m_normalized);
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < view.m_count; ++i)
+	{
+		const uint8_t* pElement = view.GetElement(i);
+		float* pOutput = output + i * outputComponents;
+		if (view.m_componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		{
+			memcpy(pOutput, pElement, copyComponents * sizeof(float));
+		}
+		else
+		{
+			for (uint32_t c = 0; c < copyComponents; ++c)
+			{
+				pOutput[c] = LoadComponent(pElement + c * componentSize, view.m_componentType, view.m_normalized);
+			}
+		}
+
+		for (uint32_t c = copyComponents; c < outputComponents; ++c)
+		{
+			pOutput[c] = 0.f;
+		}
+	}
+}
@@ -796,7 +796,7 @@ FResourceUploadContext::FResourceUploadContext(const size_t uploadBufferSizeInBy
 	// Round up to power of 2
 	unsigned long n;
 	_BitScanReverse64(&n, uploadBufferSizeInBytes);
-	m_sizeInBytes = (1 << (n + 1));
+	m_sizeInBytes = (1ull << (n + 1));
 	m_sizeInBytes = std::max<size_t>(m_sizeInBytes, 256);
 
 	m_copyCommandlist = FetchCommandlist(L"upload_copy_cl", D3D12_COMMAND_LIST_TYPE_COPY);
@@ -841,6 +841,9 @@ void FResourceUploadContext::UpdateSubresources(
 		std::vector<UINT> numRows(srcData.size());
 
 		D3D12_RESOURCE_DESC destinationDesc = destinationResource->m_d3dResource->GetDesc();
+
+		// Placed footprints must be aligned, which matters when several textures share the upload buffer
+		m_currentOffset = (m_currentOffset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(UINT64)(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
 		GetDevice()->GetCopyableFootprints(&destinationDesc, 0, srcData.size(), m_currentOffset, layouts.data(), numRows.data(), rowSizeInBytes.data(), &totalBytes);
 
 		// Copy CPU data to mapped upload resource
@@ -947,13 +950,16 @@ FFenceMarker FResourceReadbackContext::StageSubresources(const FFenceMarker sour
 {
 	D3D12_RESOURCE_DESC desc = m_source->m_d3dResource->GetDesc();
 
+	// Every mip of every array slice, such as the faces of a cubemap. Subresources are ordered by slice and then by mip.
+	const UINT subresourceCount = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D ? desc.MipLevels * desc.DepthOrArraySize : desc.MipLevels;
+
 	// NOTE layout.Footprint.RowPitch is the D3D12 aligned pitch whereas rowSizeInBytes is the unaligned pitch
 	UINT64 totalBytes = 0;
-	m_layouts.resize(desc.MipLevels);
-	std::vector<UINT64> rowSizeInBytes(desc.MipLevels);
-	std::vector<UINT> numRows(desc.MipLevels);
+	m_layouts.resize(subresourceCount);
+	std::vector<UINT64> rowSizeInBytes(subresourceCount);
+	std::vector<UINT> numRows(subresourceCount);
 
-	GetDevice()->GetCopyableFootprints(&desc, 0, desc.MipLevels, 0, m_layouts.data(), numRows.data(), rowSizeInBytes.data(), &totalBytes);
+	GetDevice()->GetCopyableFootprints(&desc, 0, subresourceCount, 0, m_layouts.data(), numRows.data(), rowSizeInBytes.data(), &totalBytes);
 
 	// Make the copy queue wait until the source resource is ready
 	sourceReadyMarker.Wait(GetCopyQueue());
@@ -969,7 +975,7 @@ FFenceMarker FResourceReadbackContext::StageSubresources(const FFenceMarker sour
 	}
 	else
 	{
-		for (UINT i = 0; i < desc.MipLevels; ++i)
+		for (UINT i = 0; i < subresourceCount; ++i)
 		{
 			D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
 			srcLocation.pResource = m_source->m_d3dResource;
@@ -1097,7 +1103,8 @@ size_t FResource::GetSizeBytes() const
 {
 	size_t totalBytes;
 	D3D12_RESOURCE_DESC desc = m_d3dResource->GetDesc();
-	GetDevice()->GetCopyableFootprints(&desc, 0, desc.MipLevels, 0, nullptr, nullptr, nullptr, &totalBytes);
+	const UINT subresourceCount = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D ? desc.MipLevels * desc.DepthOrArraySize : desc.MipLevels;
+	GetDevice()->GetCopyableFootprints(&desc, 0, subresourceCount, 0, nullptr, nullptr, nullptr, &totalBytes);
 	return totalBytes;
 }
 
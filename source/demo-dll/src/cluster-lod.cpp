@@ -0,0 +1,765 @@
+// Cluster LOD generation in the style of https://advances.realtimerendering.com/s2021/Karis_Nanite_SIGGRAPH_Advances_2021_final.pdf
+// Simplification uses the quadric error metric from https://www.cs.cmu.edu/~./garland/Papers/quadrics.pdf
+
+#include <cluster-lod.h>
+#include <profiling.h>
+#include <common.h>
+#include <parallel.h>
+#include <algorithm>
+#include <queue>
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+namespace
+{
+    constexpr uint32_t k_groupSize = 4;
+    constexpr uint32_t k_maxLevels = 16;
+
+    // A group has to lose at least this fraction of its triangles to be worth a new level
+    constexpr float k_minReduction = 0.15f;
+
+    struct FQuadric
+    {
+        double m_aa, m_ab, m_ac, m_ad;
+        double m_bb, m_bc, m_bd;
+        double m_cc, m_cd;
+        double m_dd;
+
+        void AddPlane(double a, double b, double c, double d)
+        {
+            m_aa += a * a; m_ab += a * b; m_ac += a * c; m_ad += a * d;
+            m_bb += b * b; m_bc += b * c; m_bd += b * d;
+            m_cc += c * c; m_cd += c * d;
+            m_dd += d * d;
+        }
+
+        void Add(const FQuadric& q)
+        {
+            m_aa += q.m_aa; m_ab += q.m_ab; m_ac += q.m_ac; m_ad += q.m_ad;
+            m_bb += q.m_bb; m_bc += q.m_bc; m_bd += q.m_bd;
+            m_cc += q.m_cc; m_cd += q.m_cd;
+            m_dd += q.m_dd;
+        }
+
+        // Sum of squared distances from p to the accumulated planes
+        double Evaluate(const XMFLOAT3& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double error = x * x * m_aa + 2 * x * y * m_ab + 2 * x * z * m_ac + 2 * x * m_ad
+                + y * y * m_bb + 2 * y * z * m_bc + 2 * y * m_bd
+                + z * z * m_cc + 2 * z * m_cd
+                + m_dd;
+            return std::max(error, 0.0);
+        }
+    };
+
+    struct FCollapse
+    {
+        double m_cost;
+        uint32_t m_from;
+        uint32_t m_to;
+        uint32_t m_fromVersion;
+        uint32_t m_toVersion;
+
+        // Min-heap ordering. Ties are broken by vertex index so that the result is deterministic.
+        bool operator<(const FCollapse& other) const
+        {
+            if (m_cost != other.m_cost) return m_cost > other.m_cost;
+            if (m_from != other.m_from) return m_from > other.m_from;
+            return m_to > other.m_to;
+        }
+    };
+
+    XMVECTOR TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+    {
+        XMVECTOR a = XMLoadFloat3(&p0);
+        return XMVector3Cross(XMLoadFloat3(&p1) - a, XMLoadFloat3(&p2) - a);
+    }
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // Marks welded vertices on open or non-manifold edges. Simplifying them would open holes along the mesh boundary.
+    void LockMeshBorder(const std::vector<std::vector<uint32_t>>& clusterTriangles, const std::vector<uint32_t>& canonical, std::vector<uint8_t>& locked)
+    {
+        std::vector<uint64_t> edges;
+        for (const std::vector<uint32_t>& triangles : clusterTriangles)
+        {
+            for (size_t t = 0; t < triangles.size(); t += 3)
+            {
+                const uint32_t tri[3] = { canonical[triangles[t]], canonical[triangles[t + 1]], canonical[triangles[t + 2]] };
+                edges.push_back(EdgeKey(tri[0], tri[1]));
+                edges.push_back(EdgeKey(tri[1], tri[2]));
+                edges.push_back(EdgeKey(tri[2], tri[0]));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        for (size_t begin = 0; begin < edges.size();)
+        {
+            size_t end = begin + 1;
+            while (end < edges.size() && edges[end] == edges[begin])
+            {
+                ++end;
+            }
+
+            if (end - begin != 2)
+            {
+                locked[edges[begin] >> 32] = 1;
+                locked[edges[begin] & 0xFFFFFFFF] = 1;
+            }
+
+            begin = end;
+        }
+    }
+
+    // Greedily grows groups of up to k_groupSize clusters, adding the neighbour that shares the most vertices with the group.
+    // Clusters are visited in order, which is spatially coherent since meshlets are Morton sorted and new clusters are emitted per group.
+    std::vector<std::vector<uint32_t>> GroupClusters(const std::vector<uint32_t>& clusters, const std::vector<std::vector<uint32_t>>& clusterTriangles, const std::vector<uint32_t>& canonical)
+    {
+        // Pairs of (welded vertex, cluster) to find clusters that share a vertex
+        std::vector<uint64_t> vertexClusters;
+        for (uint32_t i = 0; i < clusters.size(); ++i)
+        {
+            for (uint32_t v : clusterTriangles[clusters[i]])
+            {
+                vertexClusters.push_back(((uint64_t)canonical[v] << 32) | i);
+            }
+        }
+
+        std::sort(vertexClusters.begin(), vertexClusters.end());
+        vertexClusters.erase(std::unique(vertexClusters.begin(), vertexClusters.end()), vertexClusters.end());
+
+        std::vector<uint64_t> pairs;
+        for (size_t begin = 0; begin < vertexClusters.size();)
+        {
+            size_t end = begin + 1;
+            while (end < vertexClusters.size() && (vertexClusters[end] >> 32) == (vertexClusters[begin] >> 32))
+            {
+                ++end;
+            }
+
+            for (size_t a = begin; a < end; ++a)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    if (a != b)
+                    {
+                        pairs.push_back(((vertexClusters[a] & 0xFFFFFFFF) << 32) | (vertexClusters[b] & 0xFFFFFFFF));
+                    }
+                }
+            }
+
+            begin = end;
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+
+        // Adjacency list of (neighbour, shared vertex count)
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> adjacency(clusters.size());
+        for (size_t begin = 0; begin < pairs.size();)
+        {
+            size_t end = begin + 1;
+            while (end < pairs.size() && pairs[end] == pairs[begin])
+            {
+                ++end;
+            }
+
+            adjacency[pairs[begin] >> 32].push_back({ (uint32_t)(pairs[begin] & 0xFFFFFFFF), (uint32_t)(end - begin) });
+            begin = end;
+        }
+
+        std::vector<std::vector<uint32_t>> groups;
+        std::vector<uint8_t> grouped(clusters.size(), 0);
+        std::vector<uint32_t> affinity(clusters.size(), 0);
+        for (uint32_t seed = 0; seed < clusters.size(); ++seed)
+        {
+            if (grouped[seed])
+                continue;
+
+            std::vector<uint32_t> group = { seed };
+            std::vector<uint32_t> candidates;
+            grouped[seed] = 1;
+
+            while (group.size() < k_groupSize)
+            {
+                for (auto [neighbour, sharedCount] : adjacency[group.back()])
+                {
+                    if (!grouped[neighbour])
+                    {
+                        if (affinity[neighbour] == 0)
+                        {
+                            candidates.push_back(neighbour);
+                        }
+
+                        affinity[neighbour] += sharedCount;
+                    }
+                }
+
+                uint32_t best = UINT32_MAX;
+                for (uint32_t candidate : candidates)
+                {
+                    if (!grouped[candidate] && (best == UINT32_MAX || affinity[candidate] > affinity[best] || (affinity[candidate] == affinity[best] && candidate < best)))
+                    {
+                        best = candidate;
+                    }
+                }
+
+                if (best == UINT32_MAX)
+                    break;
+
+                grouped[best] = 1;
+                group.push_back(best);
+            }
+
+            for (uint32_t candidate : candidates)
+            {
+                affinity[candidate] = 0;
+            }
+
+            for (uint32_t& member : group)
+            {
+                member = clusters[member];
+            }
+
+            groups.push_back(std::move(group));
+        }
+
+        return groups;
+    }
+
+    // Collapses edges of the lowest quadric error into one of their endpoints until the triangle count reaches the target. Locked
+    // vertices never move, and collapses that would flip a triangle or make the surface non-manifold are rejected. Returns the
+    // object space error of the simplified triangles.
+    // The topology is that of the welded vertices, and locked is indexed by welded vertex. Each corner keeps a vertex of the
+    // primitive, so the output refers to the same vertices as corners, and collapses that would split or merge an attribute
+    // seam are rejected.
+    float Simplify(
+        const std::vector<uint32_t>& corners,
+        const std::vector<uint32_t>& canonical,
+        const XMFLOAT3* positions,
+        const std::vector<uint8_t>& locked,
+        uint32_t targetTriangleCount,
+        std::vector<uint32_t>& output)
+    {
+        std::vector<uint32_t> cornerVertices = corners;
+        std::vector<uint32_t> indices(corners.size());
+        for (size_t i = 0; i < corners.size(); ++i)
+        {
+            indices[i] = canonical[corners[i]];
+        }
+
+        // Compact the referenced vertices
+        std::vector<uint32_t> vertices = indices;
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+        const uint32_t vertexCount = (uint32_t)vertices.size();
+        const uint32_t triCount = (uint32_t)indices.size() / 3;
+
+        std::vector<uint32_t> triangles(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            triangles[i] = (uint32_t)(std::lower_bound(vertices.cbegin(), vertices.cend(), indices[i]) - vertices.cbegin());
+        }
+
+        std::vector<XMFLOAT3> p(vertexCount);
+        std::vector<uint8_t> isLocked(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            p[v] = positions[vertices[v]];
+            isLocked[v] = locked[vertices[v]];
+        }
+
+        // Vertex quadrics and vertex to triangle adjacency
+        std::vector<FQuadric> quadrics(vertexCount, FQuadric{});
+        std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            const uint32_t* tri = &triangles[t * 3];
+            XMVECTOR n = TriangleNormal(p[tri[0]], p[tri[1]], p[tri[2]]);
+            if (XMVectorGetX(XMVector3LengthSq(n)) > 0.f)
+            {
+                XMFLOAT3 plane;
+                XMStoreFloat3(&plane, XMVector3Normalize(n));
+                const double d = -(plane.x * (double)p[tri[0]].x + plane.y * (double)p[tri[0]].y + plane.z * (double)p[tri[0]].z);
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    quadrics[tri[corner]].AddPlane(plane.x, plane.y, plane.z, d);
+                }
+            }
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                vertexTriangles[tri[corner]].push_back(t);
+            }
+        }
+
+        std::vector<uint8_t> triAlive(triCount, 1);
+        std::vector<uint8_t> vertexAlive(vertexCount, 1);
+        std::vector<uint32_t> version(vertexCount, 0);
+        std::priority_queue<FCollapse> heap;
+
+        auto PushCollapse = [&](uint32_t from, uint32_t to)
+        {
+            if (!isLocked[from])
+            {
+                FQuadric q = quadrics[from];
+                q.Add(quadrics[to]);
+                heap.push({ q.Evaluate(p[to]), from, to, version[from], version[to] });
+            }
+        };
+
+        auto GatherNeighbours = [&](uint32_t v, std::vector<uint32_t>& neighbours)
+        {
+            neighbours.clear();
+            for (uint32_t t : vertexTriangles[v])
+            {
+                if (triAlive[t])
+                {
+                    for (int corner = 0; corner < 3; ++corner)
+                    {
+                        if (triangles[t * 3 + corner] != v)
+                        {
+                            neighbours.push_back(triangles[t * 3 + corner]);
+                        }
+                    }
+                }
+            }
+
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        };
+
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = triangles[t * 3 + corner];
+                const uint32_t b = triangles[t * 3 + (corner + 1) % 3];
+                PushCollapse(a, b);
+                PushCollapse(b, a);
+            }
+        }
+
+        uint32_t liveTriCount = triCount;
+        double maxCost = 0.0;
+        std::vector<uint32_t> fromNeighbours, toNeighbours;
+        std::vector<std::pair<uint32_t, uint32_t>> moves;
+        while (liveTriCount > targetTriangleCount && !heap.empty())
+        {
+            const FCollapse collapse = heap.top();
+            heap.pop();
+
+            const uint32_t from = collapse.m_from;
+            const uint32_t to = collapse.m_to;
+            if (!vertexAlive[from] || !vertexAlive[to] || version[from] != collapse.m_fromVersion || version[to] != collapse.m_toVersion)
+                continue;
+
+            // Link condition. The vertices adjacent to both endpoints must be exactly the ones opposite to the edge.
+            GatherNeighbours(from, fromNeighbours);
+            GatherNeighbours(to, toNeighbours);
+            if (!std::binary_search(fromNeighbours.cbegin(), fromNeighbours.cend(), to))
+                continue;
+
+            uint32_t sharedTriCount = 0;
+            bool bFlips = false;
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (!triAlive[t])
+                    continue;
+
+                uint32_t* tri = &triangles[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to)
+                {
+                    ++sharedTriCount;
+                    continue;
+                }
+
+                XMFLOAT3 moved[3] = { p[tri[0]], p[tri[1]], p[tri[2]] };
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    if (tri[corner] == from)
+                    {
+                        moved[corner] = p[to];
+                    }
+                }
+
+                // Triangles that are already degenerate can't flip
+                XMVECTOR before = TriangleNormal(p[tri[0]], p[tri[1]], p[tri[2]]);
+                XMVECTOR after = TriangleNormal(moved[0], moved[1], moved[2]);
+                if (XMVectorGetX(XMVector3LengthSq(before)) > 0.f && XMVectorGetX(XMVector3Dot(before, after)) <= 0.f)
+                {
+                    bFlips = true;
+                    break;
+                }
+            }
+
+            std::vector<uint32_t> commonNeighbours;
+            std::set_intersection(fromNeighbours.cbegin(), fromNeighbours.cend(), toNeighbours.cbegin(), toNeighbours.cend(), std::back_inserter(commonNeighbours));
+            if (bFlips || commonNeighbours.size() != sharedTriCount)
+                continue;
+
+            // Each vertex of the primitive at from moves to the vertex that to has in the collapsed triangles on the same side of
+            // any attribute seam. On a seam, this only works along the seam, where every side of from has a collapsed triangle.
+            // Elsewhere the seam would have to be split or merged, so the collapse is rejected.
+            bool bSeamMatches = true;
+            moves.clear();
+            for (uint32_t t : vertexTriangles[from])
+            {
+                const uint32_t* tri = &triangles[t * 3];
+                if (!triAlive[t] || (tri[0] != to && tri[1] != to && tri[2] != to))
+                    continue;
+
+                uint32_t fromVertex = 0, toVertex = 0;
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    fromVertex = tri[corner] == from ? cornerVertices[t * 3 + corner] : fromVertex;
+                    toVertex = tri[corner] == to ? cornerVertices[t * 3 + corner] : toVertex;
+                }
+
+                auto move = std::find_if(moves.cbegin(), moves.cend(), [fromVertex](const auto& m) { return m.first == fromVertex; });
+                bSeamMatches &= move == moves.cend() || move->second == toVertex;
+                moves.push_back({ fromVertex, toVertex });
+            }
+
+            auto FindMove = [&moves](uint32_t fromVertex)
+            {
+                auto move = std::find_if(moves.cbegin(), moves.cend(), [fromVertex](const auto& m) { return m.first == fromVertex; });
+                return move != moves.cend() ? move->second : ~0u;
+            };
+
+            for (uint32_t t : vertexTriangles[from])
+            {
+                for (int corner = 0; corner < 3 && triAlive[t]; ++corner)
+                {
+                    bSeamMatches &= triangles[t * 3 + corner] != from || FindMove(cornerVertices[t * 3 + corner]) != ~0u;
+                }
+            }
+
+            if (!bSeamMatches)
+                continue;
+
+            // Collapse from into to
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (!triAlive[t])
+                    continue;
+
+                uint32_t* tri = &triangles[t * 3];
+                if (tri[0] == to || tri[1] == to || tri[2] == to)
+                {
+                    triAlive[t] = 0;
+                    --liveTriCount;
+                }
+                else
+                {
+                    for (int corner = 0; corner < 3; ++corner)
+                    {
+                        if (tri[corner] == from)
+                        {
+                            tri[corner] = to;
+                            cornerVertices[t * 3 + corner] = FindMove(cornerVertices[t * 3 + corner]);
+                        }
+                    }
+
+                    vertexTriangles[to].push_back(t);
+                }
+            }
+
+            vertexAlive[from] = 0;
+            quadrics[to].Add(quadrics[from]);
+            maxCost = std::max(maxCost, collapse.m_cost);
+            ++version[from];
+            ++version[to];
+
+            // The quadric of to has changed, so reprice all of its edges
+            GatherNeighbours(to, toNeighbours);
+            for (uint32_t neighbour : toNeighbours)
+            {
+                PushCollapse(neighbour, to);
+                PushCollapse(to, neighbour);
+            }
+        }
+
+        output.clear();
+        for (uint32_t t = 0; t < triCount; ++t)
+        {
+            if (triAlive[t])
+            {
+                output.push_back(cornerVertices[t * 3]);
+                output.push_back(cornerVertices[t * 3 + 1]);
+                output.push_back(cornerVertices[t * 3 + 2]);
+            }
+        }
+
+        return (float)std::sqrt(maxCost);
+    }
+
+    // Meshletizes a subset of the primitive's triangles over compacted vertices and maps the result back to the primitive's vertex indices
+    void MeshletizeTriangles(uint32_t maxVerts, uint32_t maxPrims, const std::vector<uint32_t>& indices, const XMFLOAT3* positions, std::vector<FInlineMeshlet>& output)
+    {
+        std::vector<uint32_t> vertices = indices;
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+        std::vector<XMFLOAT3> localPositions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            localPositions[i] = positions[vertices[i]];
+        }
+
+        std::vector<uint32_t> localIndices(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            localIndices[i] = (uint32_t)(std::lower_bound(vertices.cbegin(), vertices.cend(), indices[i]) - vertices.cbegin());
+        }
+
+        MeshUtils::Meshletize(
+            maxVerts, maxPrims,
+            localIndices.data(), (uint32_t)localIndices.size(),
+            localPositions.data(), (uint32_t)localPositions.size(),
+            output);
+
+        for (FInlineMeshlet& meshlet : output)
+        {
+            for (uint32_t& vertexIndex : meshlet.m_uniqueVertexIndices)
+            {
+                vertexIndex = vertices[vertexIndex];
+            }
+        }
+    }
+
+    // Sphere that encloses all of the spheres. Inflated by the distance to each of them rather than relying on
+    // BoundingSphere::CreateMerged to be exact, because a parent's bounds must never be smaller than its children's.
+    BoundingSphere EnclosingSphere(const std::vector<BoundingSphere>& spheres)
+    {
+        BoundingSphere result = spheres.front();
+        for (size_t i = 1; i < spheres.size(); ++i)
+        {
+            BoundingSphere::CreateMerged(result, result, spheres[i]);
+        }
+
+        for (const BoundingSphere& sphere : spheres)
+        {
+            const float distance = Vector3::Distance(Vector3{ result.Center }, Vector3{ sphere.Center });
+            result.Radius = std::max(result.Radius, (distance + sphere.Radius) * 1.0001f);
+        }
+
+        return result;
+    }
+}
+
+void ClusterLod::BuildDag(
+    uint32_t maxVerts, uint32_t maxPrims,
+    const std::vector<FInlineMeshlet>& meshlets,
+    const XMFLOAT3* positions, uint32_t vertexCount,
+    const std::vector<uint32_t>& vertexReps,
+    FClusterDag& output)
+{
+    SCOPED_CPU_EVENT("build_cluster_dag", PIX_COLOR_DEFAULT);
+
+    output.m_clusters.clear();
+    output.m_groups.clear();
+    output.m_levelCount = meshlets.empty() ? 0 : 1;
+
+    // Triangles of each cluster in the original winding. Clusters are grouped and simplified over welded vertices, so that
+    // attribute seams don't split the topology, but their triangles keep the vertices of the primitive. Vertices with identical
+    // attributes are replaced by one of them, so that only real seams constrain the simplification.
+    std::vector<uint32_t> canonical;
+    MeshUtils::WeldPositions(positions, vertexCount, canonical);
+    std::vector<std::vector<uint32_t>> clusterTriangles;
+
+    auto AddCluster = [&](const FInlineMeshlet& meshlet, uint32_t level, int childGroup, const BoundingSphere& lodBounds, float error)
+    {
+        std::vector<uint32_t> triangles;
+        triangles.reserve(meshlet.m_primitiveIndices.size() * 3);
+        for (const FInlineMeshlet::FPackedTriangle& tri : meshlet.m_primitiveIndices)
+        {
+            // Meshletize stores triangles with reversed winding
+            for (uint32_t vertex : { tri.i2, tri.i1, tri.i0 })
+            {
+                const uint32_t v = meshlet.m_uniqueVertexIndices[vertex];
+                triangles.push_back(vertexReps.empty() ? v : vertexReps[v]);
+            }
+        }
+
+        clusterTriangles.push_back(std::move(triangles));
+
+        FLodCluster cluster = {};
+        cluster.m_meshlet = meshlet;
+        cluster.m_level = level;
+        cluster.m_childGroup = childGroup;
+        cluster.m_parentGroup = -1;
+        cluster.m_lodBounds = lodBounds;
+        cluster.m_error = error;
+        cluster.m_parentLodBounds = lodBounds;
+        cluster.m_parentError = FLT_MAX;
+        output.m_clusters.push_back(cluster);
+        return (uint32_t)output.m_clusters.size() - 1;
+    };
+
+    std::vector<uint32_t> pending;
+    for (const FInlineMeshlet& meshlet : meshlets)
+    {
+        pending.push_back(AddCluster(meshlet, 0, -1, meshlet.m_boundingSphere, 0.f));
+    }
+
+    std::vector<uint8_t> borderLocked(vertexCount, 0);
+    LockMeshBorder(clusterTriangles, canonical, borderLocked);
+
+    // Clusters whose group could not be simplified any further. They stay roots, but their borders still have to be locked.
+    std::vector<uint32_t> retired;
+
+    for (uint32_t level = 0; pending.size() > 1 && level + 1 < k_maxLevels; ++level)
+    {
+        const std::vector<std::vector<uint32_t>> groups = GroupClusters(pending, clusterTriangles, canonical);
+
+        // Lock the vertices that are shared between groups, so that each group simplifies independently without cracks
+        std::vector<uint8_t> locked = borderLocked;
+        std::vector<int> vertexOwner(vertexCount, -1);
+        auto ClaimVertices = [&](uint32_t cluster, int owner)
+        {
+            for (uint32_t vertex : clusterTriangles[cluster])
+            {
+                const uint32_t v = canonical[vertex];
+                if (vertexOwner[v] == -1)
+                {
+                    vertexOwner[v] = owner;
+                }
+                else if (vertexOwner[v] != owner)
+                {
+                    locked[v] = 1;
+                }
+            }
+        };
+
+        for (int groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+        {
+            for (uint32_t cluster : groups[groupIndex])
+            {
+                ClaimVertices(cluster, groupIndex);
+            }
+        }
+
+        for (int i = 0; i < retired.size(); ++i)
+        {
+            ClaimVertices(retired[i], (int)groups.size() + i);
+        }
+
+        // Simplify and meshletize groups in parallel
+        struct FGroupResult
+        {
+            std::vector<FInlineMeshlet> m_meshlets;
+            float m_simplifyError;
+            bool m_bReduced;
+        };
+
+        std::vector<FGroupResult> results(groups.size());
+        Parallel::For(0, (int)groups.size(), [&](int groupIndex)
+        {
+            std::vector<uint32_t> merged;
+            for (uint32_t cluster : groups[groupIndex])
+            {
+                merged.insert(merged.end(), clusterTriangles[cluster].cbegin(), clusterTriangles[cluster].cend());
+            }
+
+            const uint32_t triCount = (uint32_t)merged.size() / 3;
+            std::vector<uint32_t> simplified;
+            FGroupResult& result = results[groupIndex];
+            result.m_simplifyError = Simplify(merged, canonical, positions, locked, triCount / 2, simplified);
+            result.m_bReduced = !simplified.empty() && simplified.size() / 3 <= triCount * (1.f - k_minReduction);
+            if (result.m_bReduced)
+            {
+                MeshletizeTriangles(maxVerts, maxPrims, simplified, positions, result.m_meshlets);
+            }
+        });
+
+        // Append the new level in group order so that the DAG doesn't depend on scheduling
+        std::vector<uint32_t> next;
+        for (int groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+        {
+            const std::vector<uint32_t>& children = groups[groupIndex];
+            const FGroupResult& result = results[groupIndex];
+            if (!result.m_bReduced)
+            {
+                retired.insert(retired.end(), children.cbegin(), children.cend());
+                continue;
+            }
+
+            FLodClusterGroup group = {};
+            group.m_children = children;
+
+            std::vector<BoundingSphere> childBounds;
+            float maxChildError = 0.f;
+            for (uint32_t child : children)
+            {
+                childBounds.push_back(output.m_clusters[child].m_lodBounds);
+                maxChildError = std::max(maxChildError, output.m_clusters[child].m_error);
+            }
+
+            group.m_lodBounds = EnclosingSphere(childBounds);
+            group.m_error = maxChildError + result.m_simplifyError;
+
+            const int newGroupIndex = (int)output.m_groups.size();
+            for (uint32_t child : children)
+            {
+                FLodCluster& cluster = output.m_clusters[child];
+                cluster.m_parentGroup = newGroupIndex;
+                cluster.m_parentLodBounds = group.m_lodBounds;
+                cluster.m_parentError = group.m_error;
+            }
+
+            for (const FInlineMeshlet& meshlet : result.m_meshlets)
+            {
+                const uint32_t parent = AddCluster(meshlet, level + 1, newGroupIndex, group.m_lodBounds, group.m_error);
+                group.m_parents.push_back(parent);
+                next.push_back(parent);
+            }
+
+            output.m_groups.push_back(std::move(group));
+        }
+
+        if (next.empty())
+            break;
+
+        output.m_levelCount = level + 2;
+        pending = std::move(next);
+    }
+}
+
+float ClusterLod::ProjectError(const BoundingSphere& lodBounds, float error, const Matrix& localToWorld, const FClusterLodView& view)
+{
+    if (error == FLT_MAX)
+        return FLT_MAX;
+
+    // Scale by the largest axis so that the error and bounds stay conservative under non-uniform scale
+    const float scale = std::sqrt(std::max({
+        Vector3{ localToWorld._11, localToWorld._12, localToWorld._13 }.LengthSquared(),
+        Vector3{ localToWorld._21, localToWorld._22, localToWorld._23 }.LengthSquared(),
+        Vector3{ localToWorld._31, localToWorld._32, localToWorld._33 }.LengthSquared() }));
+
+    const Vector3 center = Vector3::Transform(Vector3{ lodBounds.Center }, localToWorld);
+    const float distance = Vector3::Distance(center, view.m_eyePosition) - lodBounds.Radius * scale;
+    return error * scale * view.m_projectionScale / std::max(distance, view.m_nearPlane);
+}
+
+void ClusterLod::SelectCut(const FClusterDag& dag, const Matrix& localToWorld, const FClusterLodView& view, std::vector<uint32_t>& output)
+{
+    SCOPED_CPU_EVENT("select_cluster_cut", PIX_COLOR_DEFAULT);
+
+    output.clear();
+    for (uint32_t i = 0; i < dag.m_clusters.size(); ++i)
+    {
+        const FLodCluster& cluster = dag.m_clusters[i];
+        const bool bFineEnough = ProjectError(cluster.m_lodBounds, cluster.m_error, localToWorld, view) <= view.m_errorThreshold;
+        const bool bParentTooCoarse = ProjectError(cluster.m_parentLodBounds, cluster.m_parentError, localToWorld, view) > view.m_errorThreshold;
+        if (bFineEnough && bParentTooCoarse)
+        {
+            output.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+#include <content-cache.h>
+#include <spookyhash_api.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+namespace
+{
+	constexpr const char* ManifestFilename = "manifest.bin";
+
+	struct FManifestRecord
+	{
+		uint64_t m_key;
+		ContentCache::FEntry m_entry;
+	};
+
+	static_assert(sizeof(FManifestRecord) == 24);
+
+	struct FEnvmapHeader
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_key;
+		uint32_t m_format;
+		uint32_t m_size;
+		uint32_t m_mipCount;
+		uint32_t m_shCoefficientCount;
+		ContentCache::EnvmapProducer m_producer;
+		uint32_t m_padding;
+		uint64_t m_payloadHash;			// Of the SH and the texels, to catch files that were cut short or damaged
+	};
+
+	static_assert(sizeof(FEnvmapHeader) == 48);
+
+	uint64_t HashEnvmapPayload(const ContentCache::FEnvmap& envmap)
+	{
+		uint64_t seed1 = 0, seed2 = 0;
+		spookyhash_context context;
+		spookyhash_context_init(&context, seed1, seed2);
+		spookyhash_update(&context, envmap.m_sh.data(), sizeof(envmap.m_sh));
+		spookyhash_update(&context, envmap.m_texels.data(), envmap.m_texels.size() * sizeof(uint32_t));
+		spookyhash_final(&context, &seed1, &seed2);
+		return seed1 ^ (seed2 << 1);
+	}
+}
+
+uint64_t ContentCache::HashSource(std::span<const uint8_t> data)
+{
+	uint64_t seed1 = 0, seed2 = 0;
+	spookyhash_context context;
+	spookyhash_context_init(&context, seed1, seed2);
+	spookyhash_update(&context, data.data(), data.size());
+	spookyhash_final(&context, &seed1, &seed2);
+	return seed1 ^ (seed2 << 1);
+}
+
+uint64_t ContentCache::GetTextureKey(std::initializer_list<uint64_t> sourceHashes, const FTextureSettings& settings)
+{
+	uint64_t seed1 = PipelineVersion, seed2 = 0;
+	spookyhash_context context;
+	spookyhash_context_init(&context, seed1, seed2);
+	for (const uint64_t sourceHash : sourceHashes)
+	{
+		spookyhash_update(&context, &sourceHash, sizeof(sourceHash));
+	}
+
+	const uint32_t fields[] = { (uint32_t)settings.m_encoder, settings.m_srcFormat, settings.m_compressedFormat };
+	spookyhash_update(&context, fields, sizeof(fields));
+	spookyhash_final(&context, &seed1, &seed2);
+	return seed1 ^ (seed2 << 1);
+}
+
+ContentCache::FTextureSettings ContentCache::GetTextureSettings(TextureSlot slot)
+{
+	switch (slot)
+	{
+	case TextureSlot::Emissive:
+	case TextureSlot::BaseColor:
+		return { Encoder::MipsAndCompress, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_BC3_UNORM_SRGB };
+	case TextureSlot::MetallicRoughness:
+	case TextureSlot::ClearcoatRoughness:
+		// Swizzled, so that the G and B channels are compressed
+		return { Encoder::MipsAndCompress, DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_BC5_UNORM };
+	case TextureSlot::Normal:
+	case TextureSlot::ClearcoatNormal:
+		return { Encoder::MipsAndCompress, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC5_SNORM };
+	case TextureSlot::Occlusion:
+	case TextureSlot::Transmission:
+	case TextureSlot::Clearcoat:
+	default:
+		return { Encoder::MipsAndCompress, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC4_UNORM };
+	}
+}
+
+uint64_t ContentCache::GetTextureKey(uint64_t sourceHash, TextureSlot slot)
+{
+	return GetTextureKey({ sourceHash }, GetTextureSettings(slot));
+}
+
+std::pair<uint64_t, uint64_t> ContentCache::GetPrefilteredTextureKeys(uint64_t normalmapHash, uint64_t metallicRoughnessHash)
+{
+	return {
+		GetTextureKey({ normalmapHash, metallicRoughnessHash }, PrefilteredNormalSettings),
+		GetTextureKey({ normalmapHash, metallicRoughnessHash }, PrefilteredRoughnessSettings) };
+}
+
+std::string ContentCache::GetFilename(uint64_t key)
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "%016llx.dds", (unsigned long long)key);
+	return filename;
+}
+
+bool ContentCache::FManifest::Open(const std::string& directory)
+{
+	m_directory = directory;
+	m_entries.clear();
+	m_bDirty = false;
+
+	const std::filesystem::path filepath = std::filesystem::path{ directory } / ManifestFilename;
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file)
+		return false;
+
+	uint32_t header[2] = {};
+	uint64_t recordCount = 0;
+	file.read((char*)header, sizeof(header));
+	file.read((char*)&recordCount, sizeof(recordCount));
+	if (!file || header[0] != ManifestMagic || header[1] != ManifestVersion)
+		return false;
+
+	// The records have to fit in the rest of the file, so that a damaged count can't ask for an unbounded allocation
+	std::error_code error;
+	const uint64_t fileSize = std::filesystem::file_size(filepath, error);
+	const uint64_t headerSize = sizeof(header) + sizeof(recordCount);
+	if (error || fileSize < headerSize || recordCount > (fileSize - headerSize) / sizeof(FManifestRecord))
+		return false;
+
+	std::vector<FManifestRecord> records(recordCount);
+	if (!file.read((char*)records.data(), recordCount * sizeof(FManifestRecord)))
+		return false;
+
+	m_entries.reserve(records.size());
+	for (const FManifestRecord& record : records)
+	{
+		m_entries[record.m_key] = record.m_entry;
+	}
+
+	return true;
+}
+
+bool ContentCache::FManifest::Save()
+{
+	if (!m_bDirty)
+		return true;
+
+	std::vector<FManifestRecord> records;
+	records.reserve(m_entries.size());
+	for (const auto& [key, entry] : m_entries)
+	{
+		records.push_back({ key, entry });
+	}
+
+	// Written next to the manifest and then swapped in, so that an interrupted save leaves the previous manifest
+	const std::filesystem::path filepath = std::filesystem::path{ m_directory } / ManifestFilename;
+	std::filesystem::path tempFilepath = filepath;
+	tempFilepath += ".tmp";
+	{
+		std::ofstream file(tempFilepath, std::ios::binary | std::ios::trunc);
+		const uint32_t header[2] = { ManifestMagic, ManifestVersion };
+		const uint64_t recordCount = records.size();
+		file.write((const char*)header, sizeof(header));
+		file.write((const char*)&recordCount, sizeof(recordCount));
+		file.write((const char*)records.data(), records.size() * sizeof(FManifestRecord));
+		if (!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempFilepath, filepath, error);
+	if (error)
+		return false;
+
+	m_bDirty = false;
+	return true;
+}
+
+const ContentCache::FEntry* ContentCache::FManifest::Find(uint64_t key) const
+{
+	auto search = m_entries.find(key);
+	return search != m_entries.cend() ? &search->second : nullptr;
+}
+
+void ContentCache::FManifest::Add(uint64_t key, const FEntry& entry)
+{
+	m_entries[key] = entry;
+	m_bDirty = true;
+}
+
+std::string ContentCache::FManifest::GetFilepath(uint64_t key) const
+{
+	return (std::filesystem::path{ m_directory } / GetFilename(key)).string();
+}
+
+size_t ContentCache::FEnvmap::GetTexelCount() const
+{
+	return EnvmapFaceCount * GetMipOffset(1, 0);
+}
+
+size_t ContentCache::FEnvmap::GetMipOffset(uint32_t face, uint32_t mip) const
+{
+	size_t faceTexelCount = 0, mipOffset = 0;
+	for (uint32_t mipIndex = 0; mipIndex < m_mipCount; ++mipIndex)
+	{
+		const size_t mipSize = std::max(m_size >> mipIndex, 1u);
+		mipOffset += mipIndex < mip ? mipSize * mipSize : 0;
+		faceTexelCount += mipSize * mipSize;
+	}
+
+	return face * faceTexelCount + mipOffset;
+}
+
+uint64_t ContentCache::GetEnvmapKey(uint64_t sourceHash, uint32_t resolution, EnvmapProducer producer)
+{
+	uint64_t seed1 = EnvmapFilterVersion, seed2 = 0;
+	spookyhash_context context;
+	spookyhash_context_init(&context, seed1, seed2);
+	spookyhash_update(&context, &sourceHash, sizeof(sourceHash));
+	spookyhash_update(&context, &resolution, sizeof(resolution));
+	spookyhash_update(&context, &producer, sizeof(producer));
+	spookyhash_final(&context, &seed1, &seed2);
+	return seed1 ^ (seed2 << 1);
+}
+
+std::string ContentCache::GetEnvmapFilename(uint64_t key)
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "%016llx.envmap", (unsigned long long)key);
+	return filename;
+}
+
+bool ContentCache::SaveEnvmap(const std::string& filepath, uint64_t key, const FEnvmap& envmap)
+{
+	if (envmap.m_texels.size() != envmap.GetTexelCount())
+		return false;
+
+	// Written next to the file and then swapped in, so that an interrupted save never leaves a file that looks complete
+	std::filesystem::path tempFilepath = filepath;
+	tempFilepath += ".tmp";
+	{
+		std::ofstream file(tempFilepath, std::ios::binary | std::ios::trunc);
+		const FEnvmapHeader header = { EnvmapMagic, EnvmapFileVersion, key, envmap.m_format, envmap.m_size, envmap.m_mipCount, ShCoefficientCount, envmap.m_producer, 0, HashEnvmapPayload(envmap) };
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)envmap.m_sh.data(), sizeof(envmap.m_sh));
+		file.write((const char*)envmap.m_texels.data(), envmap.m_texels.size() * sizeof(uint32_t));
+		if (!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempFilepath, filepath, error);
+	return !error;
+}
+
+bool ContentCache::LoadEnvmap(const std::string& filepath, uint64_t key, FEnvmap& outEnvmap)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file)
+		return false;
+
+	FEnvmapHeader header = {};
+	if (!file.read((char*)&header, sizeof(header)) ||
+		header.m_magic != EnvmapMagic ||
+		header.m_version != EnvmapFileVersion ||
+		header.m_key != key ||
+		header.m_shCoefficientCount != ShCoefficientCount ||
+		header.m_producer >= EnvmapProducer::Count)
+	{
+		return false;
+	}
+
+	// The mip count is bounded by the size, so a damaged header can't ask for an unbounded allocation
+	if (header.m_size == 0 || header.m_size > 16384 || header.m_mipCount == 0 || header.m_mipCount > 15 || (header.m_size >> (header.m_mipCount - 1)) == 0)
+		return false;
+
+	FEnvmap envmap{};
+	envmap.m_format = header.m_format;
+	envmap.m_size = header.m_size;
+	envmap.m_mipCount = header.m_mipCount;
+	envmap.m_producer = header.m_producer;
+	envmap.m_texels.resize(envmap.GetTexelCount());
+	if (!file.read((char*)envmap.m_sh.data(), sizeof(envmap.m_sh)) ||
+		!file.read((char*)envmap.m_texels.data(), envmap.m_texels.size() * sizeof(uint32_t)) ||
+		file.peek() != std::ifstream::traits_type::eof() ||
+		HashEnvmapPayload(envmap) != header.m_payloadHash)
+	{
+		return false;
+	}
+
+	outEnvmap = std::move(envmap);
+	return true;
+}
@@ -0,0 +1,421 @@
+#include <content-index.h>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <mutex>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace
+{
+	// Not indexed itself, so that saving the index doesn't change the write time of the root
+	constexpr const char* IndexDirname = ".content-index";
+	constexpr const char* IndexFilename = "index.bin";
+
+	int64_t GetWriteTime(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+		return error ? -1 : (int64_t)writeTime.time_since_epoch().count();
+	}
+
+	bool IsCacheDirectory(const std::filesystem::path& relativePath)
+	{
+		for (const std::filesystem::path& component : relativePath)
+		{
+			if (component.native().starts_with(std::filesystem::path::value_type('.')) && component != ".")
+				return true;
+		}
+
+		return false;
+	}
+
+	void WritePath(std::ofstream& file, const std::filesystem::path& path)
+	{
+		const std::u8string str = path.generic_u8string();
+		const uint32_t length = (uint32_t)str.size();
+		file.write((const char*)&length, sizeof(length));
+		file.write((const char*)str.data(), length);
+	}
+
+	// Lengths and counts are bounded by the bytes left in the file, so that a damaged index can't ask for an unbounded allocation
+	uint64_t GetRemainingBytes(std::ifstream& file, uint64_t fileSize)
+	{
+		const std::streamoff position = file.tellg();
+		return position >= 0 && (uint64_t)position <= fileSize ? fileSize - (uint64_t)position : 0;
+	}
+
+	bool ReadPath(std::ifstream& file, uint64_t fileSize, std::filesystem::path& path)
+	{
+		uint32_t length = 0;
+		if (!file.read((char*)&length, sizeof(length)) || length > GetRemainingBytes(file, fileSize))
+			return false;
+
+		std::u8string str(length, u8'\0');
+		if (!file.read((char*)str.data(), length))
+			return false;
+
+		path = std::filesystem::path{ str };
+		return true;
+	}
+
+	void WritePaths(std::ofstream& file, const std::vector<std::filesystem::path>& paths)
+	{
+		const uint32_t count = (uint32_t)paths.size();
+		file.write((const char*)&count, sizeof(count));
+		for (const std::filesystem::path& path : paths)
+		{
+			WritePath(file, path);
+		}
+	}
+
+	bool ReadPaths(std::ifstream& file, uint64_t fileSize, std::vector<std::filesystem::path>& paths)
+	{
+		// Each path takes at least its length
+		uint32_t count = 0;
+		if (!file.read((char*)&count, sizeof(count)) || count > GetRemainingBytes(file, fileSize) / sizeof(uint32_t))
+			return false;
+
+		paths.resize(count);
+		for (std::filesystem::path& path : paths)
+		{
+			if (!ReadPath(file, fileSize, path))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+FContentIndex::~FContentIndex()
+{
+	StopWatching();
+}
+
+size_t FContentIndex::Open(const std::filesystem::path& root)
+{
+	{
+		std::unique_lock<std::shared_mutex> lock{ m_mutex };
+		m_root = root;
+		m_directories.clear();
+		Load();
+	}
+
+	return Refresh();
+}
+
+size_t FContentIndex::Refresh()
+{
+	std::unique_lock<std::shared_mutex> lock{ m_mutex };
+	return UpdateAndSave();
+}
+
+std::filesystem::path FContentIndex::Find(const std::filesystem::path& filename, bool bIncludeCache)
+{
+	auto FindFile = [&]() -> std::filesystem::path
+	{
+		std::shared_lock<std::shared_mutex> lock{ m_mutex };
+		auto search = m_filesByName.find(filename.wstring());
+		if (search != m_filesByName.cend())
+		{
+			for (const FFile& file : search->second)
+			{
+				if (bIncludeCache || !file.m_bCache)
+					return m_root / file.m_path;
+			}
+		}
+
+		return {};
+	};
+
+	std::filesystem::path filepath = FindFile();
+	if (!filepath.empty() || m_bWatching)
+		return filepath;
+
+	// A file that was added since the last refresh is picked up by refreshing once more. Each refresh visits every directory, so 
+	// looking up missing files in a loop only refreshes once per interval.
+	size_t changedCount = 0;
+	{
+		std::unique_lock<std::shared_mutex> lock{ m_mutex };
+		if (std::chrono::steady_clock::now() - m_lastRefreshTime >= RefreshInterval)
+		{
+			changedCount = UpdateAndSave();
+		}
+	}
+
+	return changedCount > 0 ? FindFile() : filepath;
+}
+
+std::vector<std::filesystem::path> FContentIndex::List(const std::filesystem::path& extension, bool bIncludeCache) const
+{
+	std::shared_lock<std::shared_mutex> lock{ m_mutex };
+	std::vector<std::filesystem::path> files;
+	auto search = m_filesByExtension.find(extension.wstring());
+	if (search != m_filesByExtension.cend())
+	{
+		for (const FFile& file : search->second)
+		{
+			if (bIncludeCache || !file.m_bCache)
+			{
+				files.push_back(m_root / file.m_path);
+			}
+		}
+	}
+
+	return files;
+}
+
+size_t FContentIndex::GetFileCount() const
+{
+	std::shared_lock<std::shared_mutex> lock{ m_mutex };
+	size_t count = 0;
+	for (const auto& [path, directory] : m_directories)
+	{
+		count += directory.m_files.size();
+	}
+
+	return count;
+}
+
+size_t FContentIndex::GetDirectoryCount() const
+{
+	std::shared_lock<std::shared_mutex> lock{ m_mutex };
+	return m_directories.size();
+}
+
+size_t FContentIndex::UpdateAndSave()
+{
+	const size_t changedCount = Update();
+	m_lastRefreshTime = std::chrono::steady_clock::now();
+	if (changedCount > 0)
+	{
+		RebuildLookups();
+		Save();
+	}
+
+	return changedCount;
+}
+
+// Visits every indexed directory, but only lists the ones whose write time changed. Directories that are gone are dropped.
+// Returns the number of directories that were listed or dropped.
+size_t FContentIndex::Update()
+{
+	size_t changedCount = 0;
+	std::set<std::filesystem::path> visited;
+	std::vector<std::filesystem::path> stack = { std::filesystem::path{} };
+	while (!stack.empty())
+	{
+		const std::filesystem::path relativePath = std::move(stack.back());
+		stack.pop_back();
+
+		const std::filesystem::path path = relativePath.empty() ? m_root : m_root / relativePath;
+		const int64_t writeTime = GetWriteTime(path);
+		if (writeTime == -1)
+			continue;
+
+		FDirectory& directory = m_directories[relativePath];
+		if (directory.m_writeTime != writeTime)
+		{
+			directory = FDirectory{};
+			directory.m_writeTime = writeTime;
+			std::error_code error;
+			for (auto it = std::filesystem::directory_iterator{ path, error }; it != std::filesystem::directory_iterator{}; it.increment(error))
+			{
+				if (it->is_directory(error))
+				{
+					if (!(relativePath.empty() && it->path().filename() == IndexDirname))
+					{
+						directory.m_subdirectories.push_back(it->path().filename());
+					}
+				}
+				else if (it->is_regular_file(error))
+				{
+					directory.m_files.push_back(it->path().filename());
+				}
+			}
+
+			std::sort(directory.m_files.begin(), directory.m_files.end());
+			std::sort(directory.m_subdirectories.begin(), directory.m_subdirectories.end());
+			changedCount++;
+		}
+
+		visited.insert(relativePath);
+		for (const std::filesystem::path& subdirectory : directory.m_subdirectories)
+		{
+			stack.push_back(relativePath / subdirectory);
+		}
+	}
+
+	for (auto it = m_directories.begin(); it != m_directories.end();)
+	{
+		if (!visited.contains(it->first))
+		{
+			it = m_directories.erase(it);
+			changedCount++;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	return changedCount;
+}
+
+void FContentIndex::RebuildLookups()
+{
+	m_filesByName.clear();
+	m_filesByExtension.clear();
+
+	// Directories are visited in path order, so the lists are too
+	for (const auto& [relativePath, directory] : m_directories)
+	{
+		const bool bCache = IsCacheDirectory(relativePath);
+		for (const std::filesystem::path& filename : directory.m_files)
+		{
+			const FFile file = { relativePath / filename, bCache };
+			m_filesByName[filename.wstring()].push_back(file);
+			m_filesByExtension[filename.extension().wstring()].push_back(file);
+		}
+	}
+}
+
+std::filesystem::path FContentIndex::GetIndexFilepath() const
+{
+	return m_root / IndexDirname / IndexFilename;
+}
+
+bool FContentIndex::Load()
+{
+	const std::filesystem::path filepath = GetIndexFilepath();
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::error_code error;
+	const uint64_t fileSize = std::filesystem::file_size(filepath, error);
+	if (error)
+		return false;
+
+	uint32_t header[2] = {};
+	uint64_t directoryCount = 0;
+	file.read((char*)header, sizeof(header));
+	file.read((char*)&directoryCount, sizeof(directoryCount));
+	if (!file || header[0] != Magic || header[1] != Version)
+		return false;
+
+	// Directories are only added once they are read completely. The rest are listed by the next update.
+	for (uint64_t i = 0; i < directoryCount; ++i)
+	{
+		std::filesystem::path relativePath;
+		FDirectory directory;
+		if (!ReadPath(file, fileSize, relativePath) ||
+			!file.read((char*)&directory.m_writeTime, sizeof(directory.m_writeTime)) ||
+			!ReadPaths(file, fileSize, directory.m_files) ||
+			!ReadPaths(file, fileSize, directory.m_subdirectories))
+		{
+			break;
+		}
+
+		m_directories[relativePath] = std::move(directory);
+	}
+
+	RebuildLookups();
+	return true;
+}
+
+bool FContentIndex::Save()
+{
+	std::error_code error;
+	const std::filesystem::path filepath = GetIndexFilepath();
+	if (std::filesystem::create_directories(filepath.parent_path(), error))
+	{
+		// Creating the index directory changes the root, whose listing is still valid since the directory is skipped
+		m_directories[{}].m_writeTime = GetWriteTime(m_root);
+	}
+
+	// Written next to the index and then swapped in, since other processes may read the same index
+	std::filesystem::path tempFilepath = filepath;
+	tempFilepath += ".tmp";
+	{
+		std::ofstream file(tempFilepath, std::ios::binary | std::ios::trunc);
+		const uint32_t header[2] = { Magic, Version };
+		const uint64_t directoryCount = m_directories.size();
+		file.write((const char*)header, sizeof(header));
+		file.write((const char*)&directoryCount, sizeof(directoryCount));
+		for (const auto& [relativePath, directory] : m_directories)
+		{
+			WritePath(file, relativePath);
+			file.write((const char*)&directory.m_writeTime, sizeof(directory.m_writeTime));
+			WritePaths(file, directory.m_files);
+			WritePaths(file, directory.m_subdirectories);
+		}
+
+		if (!file)
+			return false;
+	}
+
+	std::filesystem::rename(tempFilepath, filepath, error);
+	return !error;
+}
+
+#if defined(_WIN32)
+void FContentIndex::StartWatching()
+{
+	if (m_watcher.joinable())
+		return;
+
+	HANDLE changeHandle = FindFirstChangeNotificationW(m_root.wstring().c_str(), TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+	if (changeHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	m_watcher = std::thread{ [this, changeHandle]()
+	{
+		const HANDLE handles[] = { (HANDLE)m_stopEvent, changeHandle };
+		while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+		{
+			// Wait for a burst of changes, such as a cache being written, to settle before refreshing
+			if (WaitForSingleObject((HANDLE)m_stopEvent, (DWORD)RefreshInterval.count()) == WAIT_OBJECT_0)
+				break;
+
+			FindNextChangeNotification(changeHandle);
+			Refresh();
+		}
+
+		FindCloseChangeNotification(changeHandle);
+	} };
+
+	m_bWatching = true;
+}
+
+void FContentIndex::StopWatching()
+{
+	m_bWatching = false;
+	if (m_watcher.joinable())
+	{
+		SetEvent((HANDLE)m_stopEvent);
+		m_watcher.join();
+	}
+
+	if (m_stopEvent)
+	{
+		CloseHandle((HANDLE)m_stopEvent);
+		m_stopEvent = nullptr;
+	}
+}
+#else
+void FContentIndex::StartWatching() {}
+void FContentIndex::StopWatching() {}
+#endif
+
+#if defined(CONTENT_DIR)
+FContentIndex& GetContentIndex()
+{
+	static FContentIndex s_index;
+	static std::once_flag s_opened;
+	std::call_once(s_opened, [] { s_index.Open(CONTENT_DIR); });
+	return s_index;
+}
+#endif
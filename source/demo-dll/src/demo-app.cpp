@@ -16,24 +16,17 @@ bool Demo::App::Initialize(const HWND& windowHandle, const uint32_t resX, const
 	Renderer::Initialize(resX, resY);
 	UI::Initialize(windowHandle);
 
-	// List of models
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
+	// Lists of models and HDRIs. The content index is kept up to date while the demo runs, so later lookups find files added since.
+	FContentIndex& contentIndex = GetContentIndex();
+	contentIndex.StartWatching();
+	for (const std::filesystem::path& filepath : contentIndex.List(".gltf"))
 	{
-		if (entry.is_regular_file() &&
-			entry.path().extension().string() == ".gltf" &&
-			!entry.path().parent_path().string().ends_with(".model-cache"))
-		{
-			m_modelList.push_back(entry.path().filename().wstring());
-		}
+		m_modelList.push_back(filepath.filename().wstring());
 	}
 
-	// List of HDRIs
-	for (auto& entry : std::filesystem::recursive_directory_iterator(CONTENT_DIR))
+	for (const std::filesystem::path& filepath : contentIndex.List(".hdr"))
 	{
-		if (entry.is_regular_file() && entry.path().extension().string() == ".hdr")
-		{
-			m_hdriList.push_back(entry.path().filename().wstring());
-		}
+		m_hdriList.push_back(filepath.filename().wstring());
 	}
 
 	return ok;
@@ -42,6 +35,7 @@ bool Demo::App::Initialize(const HWND& windowHandle, const uint32_t resX, const
 void Demo::App::Teardown(HWND& windowHandle)
 {
 	Renderer::Status::Pause();
+	GetContentIndex().StopWatching();
 
 	m_scene.Clear();
 
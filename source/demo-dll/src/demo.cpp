@@ -6,10 +6,12 @@
 #include <renderer.h>
 #include <ui.h>
 #include <mesh-utils.h>
+#include <content-cache.h>
 #include <gpu-shared-types.h>
 #include <concurrent_unordered_map.h>
 #include <ppltasks.h>
 #include <ppl.h>
+#include <fstream>
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------
 //														Demo
@@ -307,15 +309,60 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 	}
 	else
 	{
-		// Read HDR sphere map from file
+		// Read the HDR sphere map once, to key the content cache and to decode it
+		const std::filesystem::path hdrFilepath = GetFilepathW(name);
+		std::vector<uint8_t> hdrFile;
+		{
+			std::ifstream file(hdrFilepath, std::ios::binary);
+			hdrFile.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		}
+
 		DirectX::TexMetadata metadata;
-		DirectX::ScratchImage scratch;
-		AssertIfFailed(DirectX::LoadFromHDRFile(GetFilepathW(name).c_str(), &metadata, scratch));
+		AssertIfFailed(DirectX::GetMetadataFromHDRMemory(hdrFile.data(), hdrFile.size(), metadata));
 
 		// Calculate mips upto 4x4 for block compression
 		size_t width = metadata.width, height = metadata.height;
 		size_t numMips = RenderUtils12::CalcMipCount(metadata.width, metadata.height, true);
 
+		const size_t cubemapSize = metadata.height;
+		constexpr DXGI_FORMAT radianceFormat = DXGI_FORMAT_R11G11B10_FLOAT;
+		const size_t filteredEnvmapSize = cubemapSize >> 1;
+		const int filteredEnvmapMips = numMips - 1;
+
+		// The prefiltered cubemap and the SH only depend on the source, the resolution and the filters, so a previous run may have
+		// cached them already. A result of these passes is preferred over one that the content cooker baked on the CPU.
+		std::string cacheFilepath;
+		uint64_t cacheKey = 0;
+		if (Demo::GetConfig().UseContentCache)
+		{
+			const std::filesystem::path cacheDirectory = hdrFilepath.parent_path() / L".content-cache";
+			std::error_code error;
+			std::filesystem::create_directories(cacheDirectory, error);
+
+			const uint64_t sourceHash = ContentCache::HashSource(hdrFile);
+			for (const ContentCache::EnvmapProducer producer : { ContentCache::EnvmapProducer::Gpu, ContentCache::EnvmapProducer::Cpu })
+			{
+				const uint64_t key = ContentCache::GetEnvmapKey(sourceHash, (uint32_t)filteredEnvmapSize, producer);
+				const std::string filepath = (cacheDirectory / ContentCache::GetEnvmapFilename(key)).string();
+
+				ContentCache::FEnvmap envmap;
+				if (ContentCache::LoadEnvmap(filepath, key, envmap) && envmap.m_producer == producer &&
+					envmap.m_format == radianceFormat && envmap.m_size == filteredEnvmapSize && envmap.m_mipCount == (uint32_t)filteredEnvmapMips)
+				{
+					return CacheEnvmap(envmapTextureName, shTextureName, envmap);
+				}
+
+				if (producer == ContentCache::EnvmapProducer::Gpu)
+				{
+					cacheKey = key;
+					cacheFilepath = filepath;
+				}
+			}
+		}
+
+		DirectX::ScratchImage scratch;
+		AssertIfFailed(DirectX::LoadFromHDRMemory(hdrFile.data(), hdrFile.size(), &metadata, scratch));
+
 		// Generate mips
 		DirectX::ScratchImage mipchain = {};
 		AssertIfFailed(DirectX::GenerateMipMaps(*scratch.GetImage(0,0,0), DirectX::TEX_FILTER_LINEAR, numMips, mipchain));
@@ -349,8 +396,6 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 		// ---------------------------------------------------------------------------------------------------------
 		// Generate environment cubemap
 		// ---------------------------------------------------------------------------------------------------------
-		const size_t cubemapSize = metadata.height;
-		constexpr DXGI_FORMAT radianceFormat = DXGI_FORMAT_R11G11B10_FLOAT;
 		std::unique_ptr<FShaderSurface> texCubeUav{ RenderBackend12::CreateNewShaderSurface({
 			.name = L"src_cubemap",
 			.type = FShaderSurface::Type::UAV,
@@ -365,8 +410,6 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 		// ---------------------------------------------------------------------------------------------------------
 		// Prefilter Environment map
 		// ---------------------------------------------------------------------------------------------------------
-		const size_t filteredEnvmapSize = cubemapSize >> 1;
-		const int filteredEnvmapMips = numMips - 1;
 		std::unique_ptr<FShaderSurface> texFilteredEnvmapUav{ RenderBackend12::CreateNewShaderSurface({
 			.name = L"filtered_envmap",
 			.type = FShaderSurface::Type::UAV,
@@ -393,6 +436,7 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 			.numSlices = 6,
 			.resourceState = D3D12_RESOURCE_STATE_COPY_DEST })};
 		d3dCmdList->CopyResource(filteredEnvmapTex->m_resource->m_d3dResource, texFilteredEnvmapUav->m_resource->m_d3dResource);
+		texFilteredEnvmapUav->m_resource->Transition(cmdList, texFilteredEnvmapUav->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COMMON);
 		filteredEnvmapTex->m_resource->Transition(cmdList, filteredEnvmapTex->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 		m_cachedTextures[envmapTextureName] = std::move(filteredEnvmapTex);
 
@@ -421,11 +465,50 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 			.height = 1,
 			.resourceState = D3D12_RESOURCE_STATE_COPY_DEST })};
 		d3dCmdList->CopyResource(shTex->m_resource->m_d3dResource, shExportTexureUav->m_resource->m_d3dResource);
+		shExportTexureUav->m_resource->Transition(cmdList, shExportTexureUav->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COMMON);
 		shTex->m_resource->Transition(cmdList, shTex->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 		m_cachedTextures[shTextureName] = std::move(shTex);
 
 		RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
 
+		// Read back the results for later runs. This stalls on the GPU, but only the first time that an HDRI is used. The
+		// transient surfaces are still alive here, so they can't be reused before the copies are done.
+		if (!cacheFilepath.empty())
+		{
+			const FFenceMarker completionFence = cmdList->GetFence(FCommandList::SyncPoint::GpuFinish);
+			FResourceReadbackContext envmapReadback{ texFilteredEnvmapUav->m_resource };
+			FResourceReadbackContext shReadback{ shExportTexureUav->m_resource };
+			envmapReadback.StageSubresources(completionFence).Wait();
+			shReadback.StageSubresources(completionFence).Wait();
+
+			ContentCache::FEnvmap envmap{};
+			envmap.m_format = (uint32_t)radianceFormat;
+			envmap.m_size = (uint32_t)filteredEnvmapSize;
+			envmap.m_mipCount = (uint32_t)filteredEnvmapMips;
+			envmap.m_producer = ContentCache::EnvmapProducer::Gpu;
+			envmap.m_texels.resize(envmap.GetTexelCount());
+			for (uint32_t face = 0; face < ContentCache::EnvmapFaceCount; ++face)
+			{
+				for (uint32_t mip = 0; mip < envmap.m_mipCount; ++mip)
+				{
+					// Rows are padded in the readback buffer
+					const D3D12_SUBRESOURCE_DATA data = envmapReadback.GetTextureData(face * envmap.m_mipCount + mip);
+					const size_t mipSize = std::max<size_t>(envmap.m_size >> mip, 1);
+					uint32_t* dest = &envmap.m_texels[envmap.GetMipOffset(face, mip)];
+					for (size_t row = 0; row < mipSize; ++row)
+					{
+						memcpy(dest + row * mipSize, (const uint8_t*)data.pData + row * data.RowPitch, mipSize * sizeof(uint32_t));
+					}
+				}
+			}
+
+			memcpy(envmap.m_sh.data(), shReadback.GetTextureData(0).pData, sizeof(envmap.m_sh));
+			if (!ContentCache::SaveEnvmap(cacheFilepath, cacheKey, envmap))
+			{
+				Print("Failed to save %s\n", cacheFilepath.c_str());
+			}
+		}
+
 		return FLightProbe{
 			(int)m_cachedTextures[envmapTextureName]->m_srvIndex,
 			(int)m_cachedTextures[shTextureName]->m_srvIndex,
@@ -433,6 +516,75 @@ FLightProbe FTextureCache::CacheHDRI(const std::wstring& name)
 	}
 }
 
+FLightProbe FTextureCache::CacheEnvmap(const std::wstring& envmapName, const std::wstring& shName, const ContentCache::FEnvmap& envmap)
+{
+	SCOPED_CPU_EVENT("cache_envmap", PIX_COLOR_DEFAULT);
+
+	std::unique_ptr<FTexture> envmapTex{ RenderBackend12::CreateNewTexture({
+		.name = envmapName,
+		.type = FTexture::Type::TexCube,
+		.alloc = FResource::Allocation::Persistent(),
+		.format = (DXGI_FORMAT)envmap.m_format,
+		.width = envmap.m_size,
+		.height = envmap.m_size,
+		.numMips = envmap.m_mipCount,
+		.numSlices = ContentCache::EnvmapFaceCount,
+		.resourceState = D3D12_RESOURCE_STATE_COPY_DEST })};
+
+	std::unique_ptr<FTexture> shTex{ RenderBackend12::CreateNewTexture({
+		.name = shName,
+		.type = FTexture::Type::Tex2D,
+		.alloc = FResource::Allocation::Persistent(),
+		.format = DXGI_FORMAT_R32G32B32A32_FLOAT,
+		.width = ContentCache::ShCoefficientCount,
+		.height = 1,
+		.resourceState = D3D12_RESOURCE_STATE_COPY_DEST })};
+
+	// Subresources are ordered by face and then by mip, like the cached texels
+	std::vector<D3D12_SUBRESOURCE_DATA> envmapData(ContentCache::EnvmapFaceCount * envmap.m_mipCount);
+	for (uint32_t face = 0; face < ContentCache::EnvmapFaceCount; ++face)
+	{
+		for (uint32_t mip = 0; mip < envmap.m_mipCount; ++mip)
+		{
+			const size_t mipSize = std::max<size_t>(envmap.m_size >> mip, 1);
+			D3D12_SUBRESOURCE_DATA& data = envmapData[face * envmap.m_mipCount + mip];
+			data.pData = &envmap.m_texels[envmap.GetMipOffset(face, mip)];
+			data.RowPitch = mipSize * sizeof(uint32_t);
+			data.SlicePitch = data.RowPitch * mipSize;
+		}
+	}
+
+	const std::vector<D3D12_SUBRESOURCE_DATA> shData = { { envmap.m_sh.data(), sizeof(envmap.m_sh), sizeof(envmap.m_sh) } };
+
+	// The second texture is placed at the next aligned offset
+	FResourceUploadContext uploader{ envmapTex->m_resource->GetSizeBytes() + shTex->m_resource->GetSizeBytes() + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT };
+	auto UploadTexture = [&uploader](FResource* resource, const std::vector<D3D12_SUBRESOURCE_DATA>& data)
+	{
+		uploader.UpdateSubresources(
+			resource,
+			data,
+			[resource](FCommandList* cmdList)
+			{
+				resource->Transition(cmdList, resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			});
+	};
+
+	UploadTexture(envmapTex->m_resource, envmapData);
+	UploadTexture(shTex->m_resource, shData);
+
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_envmap", D3D12_COMMAND_LIST_TYPE_DIRECT);
+	uploader.SubmitUploads(cmdList);
+	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+
+	m_cachedTextures[envmapName] = std::move(envmapTex);
+	m_cachedTextures[shName] = std::move(shTex);
+
+	return FLightProbe{
+		(int)m_cachedTextures[envmapName]->m_srvIndex,
+		(int)m_cachedTextures[shName]->m_srvIndex,
+	};
+}
+
 void FTextureCache::Clear()
 {
 	m_cachedTextures.clear();
@@ -0,0 +1,1106 @@
+#include <envmap-filter.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#endif
+
+namespace
+{
+	constexpr float Pi = 3.14159265358979323846f;
+	constexpr float InvPi = 0.31830988618379067154f;
+	constexpr float PiOver2 = 1.57079632679489661923f;
+	constexpr float PiOver4 = 0.78539816339744830961f;
+
+	// SH normalization factors K(l, m), from spherical-harmonics/common.hlsli
+	constexpr float ShK[EnvmapFilter::ShCoefficientCount] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+
+	struct FVector3
+	{
+		float x, y, z;
+	};
+
+	FVector3 operator+(const FVector3& a, const FVector3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	FVector3 operator-(const FVector3& a, const FVector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	FVector3 operator*(const FVector3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	float Dot(const FVector3& a, const FVector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	FVector3 Cross(const FVector3& a, const FVector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	FVector3 Normalize(const FVector3& a) { return a * (1.f / std::sqrt(Dot(a, a))); }
+
+	EnvmapFilter::FImage CreateImage(uint32_t width, uint32_t height)
+	{
+		return { width, height, std::vector<float>((size_t)width * height * 4) };
+	}
+
+	EnvmapFilter::FCubemap CreateCubemap(uint32_t size, uint32_t mipCount)
+	{
+		EnvmapFilter::FCubemap cubemap = { size, mipCount, {} };
+		for (uint32_t face = 0; face < EnvmapFilter::FaceCount; ++face)
+		{
+			for (uint32_t mip = 0; mip < mipCount; ++mip)
+			{
+				const uint32_t mipSize = std::max(size >> mip, 1u);
+				cubemap.m_images.push_back(CreateImage(mipSize, mipSize));
+			}
+		}
+
+		return cubemap;
+	}
+
+	// Rows of all faces and mips are handed out one at a time, since rows of different mips take very different times
+	template<class Fn>
+	void ForEachRow(size_t rowCount, size_t threadCount, const Fn& fn)
+	{
+		threadCount = std::min(threadCount, rowCount);
+		if (threadCount <= 1)
+		{
+			for (size_t row = 0; row < rowCount; ++row)
+			{
+				fn(row);
+			}
+
+			return;
+		}
+
+		std::atomic<size_t> nextRow = 0;
+		std::vector<std::thread> threads;
+		for (size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+		{
+			threads.emplace_back([&]()
+				{
+					for (size_t row = nextRow++; row < rowCount; row = nextRow++)
+					{
+						fn(row);
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t GetThreadCount(size_t threadCount)
+	{
+		return threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	// Row of a face and mip of a cubemap
+	struct FCubemapRow
+	{
+		uint32_t m_face;
+		uint32_t m_mip;
+		uint32_t m_y;
+	};
+
+	std::vector<FCubemapRow> GetCubemapRows(const EnvmapFilter::FCubemap& cubemap, uint32_t faceCount)
+	{
+		std::vector<FCubemapRow> rows;
+		for (uint32_t mip = 0; mip < cubemap.m_mipCount; ++mip)
+		{
+			for (uint32_t face = 0; face < faceCount; ++face)
+			{
+				for (uint32_t y = 0; y < cubemap.GetImage(face, mip).m_height; ++y)
+				{
+					rows.push_back({ face, mip, y });
+				}
+			}
+		}
+
+		return rows;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------------------------
+	//														Reference
+	//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+	// Bilinear filtering with the WRAP address mode in both directions
+	void SampleBilinearWrap(const EnvmapFilter::FImage& image, float u, float v, float* outRgba)
+	{
+		const float s = u * image.m_width - 0.5f;
+		const float t = v * image.m_height - 0.5f;
+		const float x0f = std::floor(s);
+		const float y0f = std::floor(t);
+		const float fx = s - x0f;
+		const float fy = t - y0f;
+
+		auto Wrap = [](int i, uint32_t size) { return (uint32_t)(((i % (int)size) + (int)size) % (int)size); };
+		const uint32_t x0 = Wrap((int)x0f, image.m_width), x1 = Wrap((int)x0f + 1, image.m_width);
+		const uint32_t y0 = Wrap((int)y0f, image.m_height), y1 = Wrap((int)y0f + 1, image.m_height);
+
+		const float* t00 = &image.m_texels[((size_t)y0 * image.m_width + x0) * 4];
+		const float* t10 = &image.m_texels[((size_t)y0 * image.m_width + x1) * 4];
+		const float* t01 = &image.m_texels[((size_t)y1 * image.m_width + x0) * 4];
+		const float* t11 = &image.m_texels[((size_t)y1 * image.m_width + x1) * 4];
+		for (int c = 0; c < 4; ++c)
+		{
+			const float top = t00[c] + (t10[c] - t00[c]) * fx;
+			const float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+			outRgba[c] = top + (bottom - top) * fy;
+		}
+	}
+
+	// Face and texture coordinates of a direction, with the face selection of D3D
+	void GetCubeCoordinates(const FVector3& dir, uint32_t& outFace, float& outU, float& outV)
+	{
+		const float ax = std::abs(dir.x), ay = std::abs(dir.y), az = std::abs(dir.z);
+		float sc, tc, ma;
+		if (ax >= ay && ax >= az)
+		{
+			outFace = dir.x >= 0.f ? 0 : 1;
+			ma = ax;
+			sc = dir.x >= 0.f ? -dir.z : dir.z;
+			tc = -dir.y;
+		}
+		else if (ay >= az)
+		{
+			outFace = dir.y >= 0.f ? 2 : 3;
+			ma = ay;
+			sc = dir.x;
+			tc = dir.y >= 0.f ? dir.z : -dir.z;
+		}
+		else
+		{
+			outFace = dir.z >= 0.f ? 4 : 5;
+			ma = az;
+			sc = dir.z >= 0.f ? dir.x : -dir.x;
+			tc = -dir.y;
+		}
+
+		outU = 0.5f * (sc / ma + 1.f);
+		outV = 0.5f * (tc / ma + 1.f);
+	}
+
+	// Bilinear filtering that clamps at the edges of the face
+	void SampleBilinearClamp(const EnvmapFilter::FImage& image, float u, float v, float* outRgb)
+	{
+		const float s = u * image.m_width - 0.5f;
+		const float t = v * image.m_height - 0.5f;
+		const float x0f = std::floor(s);
+		const float y0f = std::floor(t);
+		const float fx = s - x0f;
+		const float fy = t - y0f;
+
+		auto Clamp = [](int i, uint32_t size) { return (uint32_t)std::clamp(i, 0, (int)size - 1); };
+		const uint32_t x0 = Clamp((int)x0f, image.m_width), x1 = Clamp((int)x0f + 1, image.m_width);
+		const uint32_t y0 = Clamp((int)y0f, image.m_height), y1 = Clamp((int)y0f + 1, image.m_height);
+
+		const float* t00 = &image.m_texels[((size_t)y0 * image.m_width + x0) * 4];
+		const float* t10 = &image.m_texels[((size_t)y0 * image.m_width + x1) * 4];
+		const float* t01 = &image.m_texels[((size_t)y1 * image.m_width + x0) * 4];
+		const float* t11 = &image.m_texels[((size_t)y1 * image.m_width + x1) * 4];
+		for (int c = 0; c < 3; ++c)
+		{
+			const float top = t00[c] + (t10[c] - t00[c]) * fx;
+			const float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+			outRgb[c] = top + (bottom - top) * fy;
+		}
+	}
+
+	// Trilinear filtering, with the level clamped to the mip chain like SampleLevel()
+	void SampleCubeTrilinear(const EnvmapFilter::FCubemap& cubemap, const FVector3& dir, float level, float* outRgb)
+	{
+		uint32_t face;
+		float u, v;
+		GetCubeCoordinates(dir, face, u, v);
+
+		level = level > 0.f ? std::min(level, (float)(cubemap.m_mipCount - 1)) : 0.f;
+		const uint32_t mip0 = (uint32_t)level;
+		const uint32_t mip1 = std::min(mip0 + 1, cubemap.m_mipCount - 1);
+		const float fraction = level - (float)mip0;
+
+		float rgb0[3], rgb1[3];
+		SampleBilinearClamp(cubemap.GetImage(face, mip0), u, v, rgb0);
+		SampleBilinearClamp(cubemap.GetImage(face, mip1), u, v, rgb1);
+		for (int c = 0; c < 3; ++c)
+		{
+			outRgb[c] = rgb0[c] + (rgb1[c] - rgb0[c]) * fraction;
+		}
+	}
+
+	// GetEnvDir() in prefilter.hlsl
+	FVector3 GetEnvDir(uint32_t face, float u, float v)
+	{
+		const float vx = 2.f * u - 1.f;
+		const float vy = -2.f * v + 1.f;
+		switch (face)
+		{
+		case 0: return Normalize({ 1.f, vy, -vx });		// +X
+		case 1: return Normalize({ -1.f, vy, vx });		// -X
+		case 2: return Normalize({ vx, 1.f, -vy });		// +Y
+		case 3: return Normalize({ vx, -1.f, vy });		// -Y
+		case 4: return Normalize({ vx, vy, 1.f });		// +Z
+		default: return Normalize({ -vx, vy, -1.f });	// -Z
+		}
+	}
+
+	// Hammersley() in uniform-sampling.hlsli
+	void Hammersley(uint32_t i, uint32_t sampleCount, float& outX, float& outY)
+	{
+		uint32_t bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		outX = (float)i / (float)sampleCount;
+		outY = (float)bits / 4294967296.f;
+	}
+
+	// SampleGGX() in bxdf-sampling.hlsli, in tangent space
+	FVector3 SampleGGX(float ux, float uy, float roughness)
+	{
+		const float a = roughness * roughness;
+		const float phi = 2.f * Pi * ux;
+		const float cosTheta = std::sqrt((1.f - uy) / (1.f + (a * a - 1.f) * uy));
+		const float sinTheta = std::sqrt(1.f - cosTheta * cosTheta);
+		return { sinTheta * std::sin(phi), sinTheta * std::cos(phi), cosTheta };
+	}
+
+	// GGX() in bxdf-sampling.hlsli
+	float GGX(float NoH, float roughness)
+	{
+		const float a = roughness * roughness;
+		const float a2 = a * a;
+		NoH = std::max(NoH, 0.f);
+		const float NoH2 = NoH * NoH;
+		float denom = NoH2 * (a2 - 1.f) + 1.f;
+		denom = Pi * denom * denom;
+		return a2 / std::max(denom, 0.0001f);
+	}
+
+	// Source mip that prefilter.hlsl reads a sample from
+	float GetSampleLevel(float NoH, float VoH, float roughness, uint32_t sampleCount, float resolution)
+	{
+		const float D = GGX(NoH, roughness);
+		const float pdf = (D * NoH / (4.f * VoH)) + 0.0001f;
+		const float saTexel = 4.f * Pi / (6.f * resolution * resolution);
+		const float saSample = 1.f / ((float)sampleCount * pdf + 0.0001f);
+		return roughness == 0.f ? 0.f : 0.5f * std::log2(saSample / saTexel);
+	}
+
+	// One texel of every face of cubemapgen.hlsl
+	void ConvertTexel(const EnvmapFilter::FImage& latlong, uint32_t mipSize, uint32_t x, uint32_t y, float (*outRgba)[4])
+	{
+		const float faceTransform[EnvmapFilter::FaceCount][2] = {
+			{ PiOver2, 0.f },		// +X
+			{ -PiOver2, 0.f },		// -X
+			{ 0.f, PiOver2 },		// +Y
+			{ 0.f, -PiOver2 },		// -Y
+			{ 0.f, 0.f },			// +Z
+			{ Pi, 0.f }				// -Z
+		};
+
+		// Adjacent (ak) and opposite (an) of the triangle that is spanned from the sphere center to the cube face
+		const float an = std::sin(PiOver4);
+		const float ak = std::cos(PiOver4);
+
+		float nx = ((float)x + 0.5f) / (float)mipSize;
+		float ny = ((float)y + 0.5f) / (float)mipSize;
+		nx = (2.f * nx - 1.f) * an;
+		ny = (2.f * ny - 1.f) * an;
+
+		for (uint32_t face = 0; face < EnvmapFilter::FaceCount; ++face)
+		{
+			float u, v;
+			if (faceTransform[face][1] == 0.f)
+			{
+				// Center faces
+				u = std::atan2(nx, ak);
+				v = std::atan2(ny * std::cos(u), ak);
+				u += faceTransform[face][0];
+			}
+			else if (faceTransform[face][1] < 0.f)
+			{
+				// Bottom face
+				const float d = std::sqrt(nx * nx + ny * ny);
+				v = PiOver2 - std::atan2(d, ak);
+				u = PiOver2 + std::atan2(ny, nx);
+			}
+			else
+			{
+				// Top face
+				const float d = std::sqrt(nx * nx + ny * ny);
+				v = -PiOver2 + std::atan2(d, ak);
+				u = std::atan2(nx, ny);
+			}
+
+			// Map from angular coordinates to [-1, 1] and wrap around
+			u = u * InvPi;
+			v = v / PiOver2;
+			while (v < -1.f) { v += 2.f; u += 1.f; }
+			while (v > 1.f) { v -= 2.f; u += 1.f; }
+			while (u < -1.f) { u += 2.f; }
+			while (u > 1.f) { u -= 2.f; }
+
+			SampleBilinearWrap(latlong, 0.5f * u + 0.5f, 0.5f * v + 0.5f, outRgba[face]);
+		}
+	}
+
+	// Real SH basis of the L2 bands, ShEvaluate() in spherical-harmonics/common.hlsli
+	void EvaluateSH(const FVector3& dir, float* outBasis)
+	{
+		outBasis[0] = ShK[0];
+		outBasis[1] = ShK[1] * dir.y;
+		outBasis[2] = ShK[2] * dir.z;
+		outBasis[3] = ShK[3] * dir.x;
+		outBasis[4] = ShK[4] * dir.x * dir.y;
+		outBasis[5] = ShK[5] * dir.y * dir.z;
+		outBasis[6] = ShK[6] * (3.f * dir.z * dir.z - 1.f);
+		outBasis[7] = ShK[7] * dir.x * dir.z;
+		outBasis[8] = ShK[8] * (dir.x * dir.x - dir.y * dir.y);
+	}
+
+	// Adds the projection of a latlong texel
+	void ProjectTexel(const EnvmapFilter::FImage& latlong, uint32_t x, uint32_t y, double* sums)
+	{
+		const float u = ((float)x + 0.5f) / (float)latlong.m_width;
+		const float v = ((float)y + 0.5f) / (float)latlong.m_height;
+		const float theta = Pi * v;
+		const float phi = Pi * (u * 2.f - 1.f);
+
+		// Polar2Cartesian() in world space, which is y-up
+		const float sinTheta = std::sin(theta);
+		const FVector3 dir = { sinTheta * std::sin(phi), std::cos(theta), sinTheta * std::cos(phi) };
+
+		float basis[EnvmapFilter::ShCoefficientCount];
+		EvaluateSH(dir, basis);
+
+		const float dTheta = Pi / (float)latlong.m_height;
+		const float dPhi = 2.f * Pi / (float)latlong.m_width;
+		const float* radiance = &latlong.m_texels[((size_t)y * latlong.m_width + x) * 4];
+		for (uint32_t i = 0; i < EnvmapFilter::ShCoefficientCount; ++i)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				sums[i * 4 + c] += radiance[c] * basis[i] * sinTheta * dTheta * dPhi;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------------------------
+	//														AVX2
+	//-----------------------------------------------------------------------------------------------------------------------------------------------
+
+	// Cephes atanf, accurate to about 1 ulp
+	AVX2_FUNCTION __m256 Atan(__m256 x)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 sign = _mm256_and_ps(x, signMask);
+		const __m256 ax = _mm256_andnot_ps(signMask, x);
+
+		// Reduced to [0, tan(pi / 8)]
+		const __m256 bLarge = _mm256_cmp_ps(ax, _mm256_set1_ps(2.414213562373095f), _CMP_GT_OQ);
+		const __m256 bMedium = _mm256_andnot_ps(bLarge, _mm256_cmp_ps(ax, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ));
+		__m256 offset = _mm256_and_ps(bMedium, _mm256_set1_ps(PiOver4));
+		offset = _mm256_blendv_ps(offset, _mm256_set1_ps(PiOver2), bLarge);
+		__m256 reduced = _mm256_blendv_ps(ax, _mm256_div_ps(_mm256_sub_ps(ax, one), _mm256_add_ps(ax, one)), bMedium);
+		reduced = _mm256_blendv_ps(reduced, _mm256_div_ps(_mm256_set1_ps(-1.f), ax), bLarge);
+
+		const __m256 z = _mm256_mul_ps(reduced, reduced);
+		__m256 poly = _mm256_fmadd_ps(_mm256_set1_ps(8.05374449538e-2f), z, _mm256_set1_ps(-1.38776856032e-1f));
+		poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(1.99777106478e-1f));
+		poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(-3.33329491539e-1f));
+		const __m256 result = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(poly, z), reduced, reduced), offset);
+		return _mm256_xor_ps(result, sign);
+	}
+
+	AVX2_FUNCTION __m256 Atan2(__m256 y, __m256 x)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		__m256 result = Atan(_mm256_div_ps(y, x));
+
+		// Left half plane, and 0 for the origin instead of NaN
+		const __m256 bNegativeX = _mm256_cmp_ps(x, zero, _CMP_LT_OQ);
+		const __m256 halfTurn = _mm256_blendv_ps(_mm256_set1_ps(Pi), _mm256_set1_ps(-Pi), _mm256_cmp_ps(y, zero, _CMP_LT_OQ));
+		result = _mm256_add_ps(result, _mm256_and_ps(bNegativeX, halfTurn));
+		const __m256 bOrigin = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_EQ_OQ), _mm256_cmp_ps(y, zero, _CMP_EQ_OQ));
+		return _mm256_andnot_ps(bOrigin, result);
+	}
+
+	// Cephes cosf without range reduction, so only for [-pi / 4, pi / 4]
+	AVX2_FUNCTION __m256 CosQuarterTurn(__m256 x)
+	{
+		const __m256 z = _mm256_mul_ps(x, x);
+		__m256 poly = _mm256_fmadd_ps(_mm256_set1_ps(2.443315711809948e-5f), z, _mm256_set1_ps(-1.388731625493765e-3f));
+		poly = _mm256_fmadd_ps(poly, z, _mm256_set1_ps(4.166664568298827e-2f));
+		return _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, _mm256_set1_ps(1.f)), _mm256_mul_ps(_mm256_mul_ps(poly, z), z));
+	}
+
+	AVX2_FUNCTION __m256 Select(__m256 mask, __m256 a, __m256 b)
+	{
+		return _mm256_blendv_ps(b, a, mask);
+	}
+
+	struct FVector3x8
+	{
+		__m256 x, y, z;
+	};
+
+	AVX2_FUNCTION __m256 Dot(const FVector3x8& a, const FVector3x8& b)
+	{
+		return _mm256_fmadd_ps(a.x, b.x, _mm256_fmadd_ps(a.y, b.y, _mm256_mul_ps(a.z, b.z)));
+	}
+
+	AVX2_FUNCTION FVector3x8 Normalize(const FVector3x8& a)
+	{
+		const __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(Dot(a, a)));
+		return { _mm256_mul_ps(a.x, invLength), _mm256_mul_ps(a.y, invLength), _mm256_mul_ps(a.z, invLength) };
+	}
+
+	// Interleaves 8 texels into RGBA and stores the first count of them
+	AVX2_FUNCTION void StoreTexels(float* dest, __m256 r, __m256 g, __m256 b, __m256 a, uint32_t count)
+	{
+		alignas(32) float channels[4][8];
+		_mm256_store_ps(channels[0], r);
+		_mm256_store_ps(channels[1], g);
+		_mm256_store_ps(channels[2], b);
+		_mm256_store_ps(channels[3], a);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			dest[i * 4 + 0] = channels[0][i];
+			dest[i * 4 + 1] = channels[1][i];
+			dest[i * 4 + 2] = channels[2][i];
+			dest[i * 4 + 3] = channels[3][i];
+		}
+	}
+
+	// Wraps indices that are at most one size out of range
+	AVX2_FUNCTION __m256i WrapIndex(__m256i i, __m256i size)
+	{
+		i = _mm256_add_epi32(i, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), i), size));
+		return _mm256_sub_epi32(i, _mm256_andnot_si256(_mm256_cmpgt_epi32(size, i), size));
+	}
+
+	AVX2_FUNCTION __m256i ClampIndex(__m256i i, __m256i maxIndex)
+	{
+		return _mm256_min_epi32(_mm256_max_epi32(i, _mm256_setzero_si256()), maxIndex);
+	}
+
+	// Same as SampleBilinearWrap() for coordinates in [0, 1]
+	AVX2_FUNCTION void SampleBilinearWrap8(const EnvmapFilter::FImage& image, __m256 u, __m256 v, __m256* outRgba)
+	{
+		const __m256 s = _mm256_sub_ps(_mm256_mul_ps(u, _mm256_set1_ps((float)image.m_width)), _mm256_set1_ps(0.5f));
+		const __m256 t = _mm256_sub_ps(_mm256_mul_ps(v, _mm256_set1_ps((float)image.m_height)), _mm256_set1_ps(0.5f));
+		const __m256 x0f = _mm256_floor_ps(s);
+		const __m256 y0f = _mm256_floor_ps(t);
+		const __m256 fx = _mm256_sub_ps(s, x0f);
+		const __m256 fy = _mm256_sub_ps(t, y0f);
+
+		const __m256i width = _mm256_set1_epi32((int)image.m_width);
+		const __m256i height = _mm256_set1_epi32((int)image.m_height);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i x0i = _mm256_cvtps_epi32(x0f);
+		const __m256i y0i = _mm256_cvtps_epi32(y0f);
+		const __m256i x0 = WrapIndex(x0i, width), x1 = WrapIndex(_mm256_add_epi32(x0i, one), width);
+		const __m256i y0 = WrapIndex(y0i, height), y1 = WrapIndex(_mm256_add_epi32(y0i, one), height);
+
+		const __m256i row0 = _mm256_mullo_epi32(y0, width);
+		const __m256i row1 = _mm256_mullo_epi32(y1, width);
+		const __m256i i00 = _mm256_slli_epi32(_mm256_add_epi32(row0, x0), 2);
+		const __m256i i10 = _mm256_slli_epi32(_mm256_add_epi32(row0, x1), 2);
+		const __m256i i01 = _mm256_slli_epi32(_mm256_add_epi32(row1, x0), 2);
+		const __m256i i11 = _mm256_slli_epi32(_mm256_add_epi32(row1, x1), 2);
+		for (int c = 0; c < 4; ++c)
+		{
+			const float* base = image.m_texels.data() + c;
+			const __m256 t00 = _mm256_i32gather_ps(base, i00, 4);
+			const __m256 t10 = _mm256_i32gather_ps(base, i10, 4);
+			const __m256 t01 = _mm256_i32gather_ps(base, i01, 4);
+			const __m256 t11 = _mm256_i32gather_ps(base, i11, 4);
+			const __m256 top = _mm256_fmadd_ps(_mm256_sub_ps(t10, t00), fx, t00);
+			const __m256 bottom = _mm256_fmadd_ps(_mm256_sub_ps(t11, t01), fx, t01);
+			outRgba[c] = _mm256_fmadd_ps(_mm256_sub_ps(bottom, top), fy, top);
+		}
+	}
+
+	// Maps angular coordinates to [0, 1] like ConvertTexel(). The angles are never more than one turn out of range.
+	AVX2_FUNCTION void GetLatlongUV(__m256 u, __m256 v, __m256& outU, __m256& outV)
+	{
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 minusOne = _mm256_set1_ps(-1.f);
+		const __m256 two = _mm256_set1_ps(2.f);
+		u = _mm256_mul_ps(u, _mm256_set1_ps(InvPi));
+		v = _mm256_div_ps(v, _mm256_set1_ps(PiOver2));
+
+		const __m256 bBelow = _mm256_cmp_ps(v, minusOne, _CMP_LT_OQ);
+		const __m256 bAbove = _mm256_cmp_ps(v, one, _CMP_GT_OQ);
+		v = _mm256_add_ps(v, _mm256_and_ps(bBelow, two));
+		v = _mm256_sub_ps(v, _mm256_and_ps(bAbove, two));
+		u = _mm256_add_ps(u, _mm256_and_ps(_mm256_or_ps(bBelow, bAbove), one));
+		for (int i = 0; i < 2; ++i)
+		{
+			u = _mm256_add_ps(u, _mm256_and_ps(_mm256_cmp_ps(u, minusOne, _CMP_LT_OQ), two));
+			u = _mm256_sub_ps(u, _mm256_and_ps(_mm256_cmp_ps(u, one, _CMP_GT_OQ), two));
+		}
+
+		const __m256 half = _mm256_set1_ps(0.5f);
+		outU = _mm256_fmadd_ps(half, u, half);
+		outV = _mm256_fmadd_ps(half, v, half);
+	}
+
+	// 8 texels of a row of every face. The angles are shared by the faces and only offset per face.
+	AVX2_FUNCTION void ConvertTexels8(const EnvmapFilter::FImage& latlong, uint32_t mipSize, uint32_t x, uint32_t y, EnvmapFilter::FCubemap& cubemap, uint32_t mip)
+	{
+		const float an = std::sin(PiOver4);
+		const float ak = std::cos(PiOver4);
+		const __m256 akv = _mm256_set1_ps(ak);
+
+		const __m256 lane = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+		__m256 nx = _mm256_div_ps(_mm256_add_ps(_mm256_add_ps(_mm256_set1_ps((float)x), lane), _mm256_set1_ps(0.5f)), _mm256_set1_ps((float)mipSize));
+		nx = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(2.f), nx), _mm256_set1_ps(1.f)), _mm256_set1_ps(an));
+		float nyScalar = ((float)y + 0.5f) / (float)mipSize;
+		nyScalar = (2.f * nyScalar - 1.f) * an;
+		const __m256 ny = _mm256_set1_ps(nyScalar);
+
+		// Center faces. atan2(n, ak) is atan(n / ak), since ak is positive.
+		const __m256 centerU = Atan(_mm256_div_ps(nx, akv));
+		const __m256 centerV = Atan(_mm256_div_ps(_mm256_mul_ps(ny, CosQuarterTurn(centerU)), akv));
+
+		// Top and bottom faces
+		const __m256 d = _mm256_sqrt_ps(_mm256_fmadd_ps(nx, nx, _mm256_mul_ps(ny, ny)));
+		const __m256 elevation = Atan(_mm256_div_ps(d, akv));
+		const __m256 bottomU = _mm256_add_ps(_mm256_set1_ps(PiOver2), Atan2(ny, nx));
+		const __m256 bottomV = _mm256_sub_ps(_mm256_set1_ps(PiOver2), elevation);
+		const __m256 topU = Atan2(nx, ny);
+		const __m256 topV = _mm256_add_ps(_mm256_set1_ps(-PiOver2), elevation);
+
+		const float centerOffsets[EnvmapFilter::FaceCount] = { PiOver2, -PiOver2, 0.f, 0.f, 0.f, Pi };
+		const uint32_t count = std::min(8u, mipSize - x);
+		for (uint32_t face = 0; face < EnvmapFilter::FaceCount; ++face)
+		{
+			__m256 u, v;
+			if (face == 2)
+			{
+				GetLatlongUV(topU, topV, u, v);
+			}
+			else if (face == 3)
+			{
+				GetLatlongUV(bottomU, bottomV, u, v);
+			}
+			else
+			{
+				GetLatlongUV(_mm256_add_ps(centerU, _mm256_set1_ps(centerOffsets[face])), centerV, u, v);
+			}
+
+			__m256 rgba[4];
+			SampleBilinearWrap8(latlong, u, v, rgba);
+
+			EnvmapFilter::FImage& image = cubemap.m_images[face * cubemap.m_mipCount + mip];
+			StoreTexels(&image.m_texels[((size_t)y * mipSize + x) * 4], rgba[0], rgba[1], rgba[2], rgba[3], count);
+		}
+	}
+
+	// All faces of a mip in one array, so that texels of any face can be gathered
+	struct FPackedMip
+	{
+		uint32_t m_size;
+		std::vector<float> m_texels;
+	};
+
+	std::vector<FPackedMip> PackCubemap(const EnvmapFilter::FCubemap& cubemap)
+	{
+		std::vector<FPackedMip> mips(cubemap.m_mipCount);
+		for (uint32_t mip = 0; mip < cubemap.m_mipCount; ++mip)
+		{
+			mips[mip].m_size = cubemap.GetImage(0, mip).m_width;
+			for (uint32_t face = 0; face < EnvmapFilter::FaceCount; ++face)
+			{
+				const std::vector<float>& texels = cubemap.GetImage(face, mip).m_texels;
+				mips[mip].m_texels.insert(mips[mip].m_texels.end(), texels.cbegin(), texels.cend());
+			}
+		}
+
+		return mips;
+	}
+
+	// Same as GetCubeCoordinates(), with the face as an integer
+	AVX2_FUNCTION void GetCubeCoordinates8(const FVector3x8& dir, __m256i& outFace, __m256& outU, __m256& outV)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+		const __m256 ax = _mm256_andnot_ps(signMask, dir.x);
+		const __m256 ay = _mm256_andnot_ps(signMask, dir.y);
+		const __m256 az = _mm256_andnot_ps(signMask, dir.z);
+		const __m256 bMajorX = _mm256_and_ps(_mm256_cmp_ps(ax, ay, _CMP_GE_OQ), _mm256_cmp_ps(ax, az, _CMP_GE_OQ));
+		const __m256 bMajorY = _mm256_andnot_ps(bMajorX, _mm256_cmp_ps(ay, az, _CMP_GE_OQ));
+		const __m256 bPositiveX = _mm256_cmp_ps(dir.x, zero, _CMP_GE_OQ);
+		const __m256 bPositiveY = _mm256_cmp_ps(dir.y, zero, _CMP_GE_OQ);
+		const __m256 bPositiveZ = _mm256_cmp_ps(dir.z, zero, _CMP_GE_OQ);
+		const __m256 negX = _mm256_xor_ps(dir.x, signMask);
+		const __m256 negY = _mm256_xor_ps(dir.y, signMask);
+		const __m256 negZ = _mm256_xor_ps(dir.z, signMask);
+
+		const __m256 ma = Select(bMajorX, ax, Select(bMajorY, ay, az));
+		const __m256 sc = Select(bMajorX, Select(bPositiveX, negZ, dir.z), Select(bMajorY, dir.x, Select(bPositiveZ, dir.x, negX)));
+		const __m256 tc = Select(bMajorX, negY, Select(bMajorY, Select(bPositiveY, dir.z, negZ), negY));
+
+		// 0 or 1 for X, 2 or 3 for Y and 4 or 5 for Z
+		const __m256 axisFace = Select(bMajorX, zero, Select(bMajorY, _mm256_set1_ps(2.f), _mm256_set1_ps(4.f)));
+		const __m256 bPositive = Select(bMajorX, bPositiveX, Select(bMajorY, bPositiveY, bPositiveZ));
+		outFace = _mm256_cvtps_epi32(_mm256_add_ps(axisFace, _mm256_andnot_ps(bPositive, _mm256_set1_ps(1.f))));
+
+		const __m256 half = _mm256_set1_ps(0.5f);
+		outU = _mm256_mul_ps(half, _mm256_add_ps(_mm256_div_ps(sc, ma), _mm256_set1_ps(1.f)));
+		outV = _mm256_mul_ps(half, _mm256_add_ps(_mm256_div_ps(tc, ma), _mm256_set1_ps(1.f)));
+	}
+
+	// Same as SampleBilinearClamp(), for RGB
+	AVX2_FUNCTION void SampleBilinearClamp8(const FPackedMip& mip, __m256i face, __m256 u, __m256 v, __m256* outRgb)
+	{
+		const __m256 size = _mm256_set1_ps((float)mip.m_size);
+		const __m256 s = _mm256_fmsub_ps(u, size, _mm256_set1_ps(0.5f));
+		const __m256 t = _mm256_fmsub_ps(v, size, _mm256_set1_ps(0.5f));
+		const __m256 x0f = _mm256_floor_ps(s);
+		const __m256 y0f = _mm256_floor_ps(t);
+		const __m256 fx = _mm256_sub_ps(s, x0f);
+		const __m256 fy = _mm256_sub_ps(t, y0f);
+
+		const __m256i maxIndex = _mm256_set1_epi32((int)mip.m_size - 1);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i x0i = _mm256_cvtps_epi32(x0f);
+		const __m256i y0i = _mm256_cvtps_epi32(y0f);
+		const __m256i x0 = ClampIndex(x0i, maxIndex), x1 = ClampIndex(_mm256_add_epi32(x0i, one), maxIndex);
+		const __m256i y0 = ClampIndex(y0i, maxIndex), y1 = ClampIndex(_mm256_add_epi32(y0i, one), maxIndex);
+
+		const __m256i width = _mm256_set1_epi32((int)mip.m_size);
+		const __m256i faceOffset = _mm256_mullo_epi32(face, _mm256_set1_epi32((int)(mip.m_size * mip.m_size)));
+		const __m256i row0 = _mm256_add_epi32(faceOffset, _mm256_mullo_epi32(y0, width));
+		const __m256i row1 = _mm256_add_epi32(faceOffset, _mm256_mullo_epi32(y1, width));
+		const __m256i i00 = _mm256_slli_epi32(_mm256_add_epi32(row0, x0), 2);
+		const __m256i i10 = _mm256_slli_epi32(_mm256_add_epi32(row0, x1), 2);
+		const __m256i i01 = _mm256_slli_epi32(_mm256_add_epi32(row1, x0), 2);
+		const __m256i i11 = _mm256_slli_epi32(_mm256_add_epi32(row1, x1), 2);
+		for (int c = 0; c < 3; ++c)
+		{
+			const float* base = mip.m_texels.data() + c;
+			const __m256 t00 = _mm256_i32gather_ps(base, i00, 4);
+			const __m256 t10 = _mm256_i32gather_ps(base, i10, 4);
+			const __m256 t01 = _mm256_i32gather_ps(base, i01, 4);
+			const __m256 t11 = _mm256_i32gather_ps(base, i11, 4);
+			const __m256 top = _mm256_fmadd_ps(_mm256_sub_ps(t10, t00), fx, t00);
+			const __m256 bottom = _mm256_fmadd_ps(_mm256_sub_ps(t11, t01), fx, t01);
+			outRgb[c] = _mm256_fmadd_ps(_mm256_sub_ps(bottom, top), fy, top);
+		}
+	}
+
+	// Same as GetEnvDir(), for 8 texels of a row
+	AVX2_FUNCTION FVector3x8 GetEnvDir8(uint32_t face, uint32_t x, uint32_t y, uint32_t mipSize)
+	{
+		const __m256 lane = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+		const __m256 u = _mm256_div_ps(_mm256_add_ps(_mm256_set1_ps((float)x), lane), _mm256_set1_ps((float)mipSize));
+		const __m256 vx = _mm256_fmsub_ps(_mm256_set1_ps(2.f), u, _mm256_set1_ps(1.f));
+		const __m256 vy = _mm256_set1_ps(-2.f * ((float)y / (float)mipSize) + 1.f);
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 minusOne = _mm256_set1_ps(-1.f);
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+		const __m256 negVx = _mm256_xor_ps(vx, signMask);
+		const __m256 negVy = _mm256_xor_ps(vy, signMask);
+		switch (face)
+		{
+		case 0: return Normalize({ one, vy, negVx });
+		case 1: return Normalize({ minusOne, vy, vx });
+		case 2: return Normalize({ vx, one, negVy });
+		case 3: return Normalize({ vx, minusOne, vy });
+		case 4: return Normalize({ vx, vy, one });
+		default: return Normalize({ negVx, vy, minusOne });
+		}
+	}
+
+	// Importance sample of prefilter.hlsl. With V = N, everything but the world space direction is the same for every texel.
+	struct FGgxSample
+	{
+		float m_hx, m_hy, m_hz;		// Tangent space half vector
+		float m_weight;				// NoL
+		uint32_t m_mip0;
+		uint32_t m_mip1;
+		float m_mipFraction;
+	};
+
+	std::vector<FGgxSample> GetGgxSamples(float roughness, uint32_t sampleCount, float resolution, uint32_t sourceMipCount)
+	{
+		std::vector<FGgxSample> samples;
+		for (uint32_t i = 0; i < sampleCount; ++i)
+		{
+			float ux, uy;
+			Hammersley(i, sampleCount, ux, uy);
+			const FVector3 h = SampleGGX(ux, uy, roughness);
+
+			// N.L of the reflection of N about H
+			const float NoH = std::max(h.z, 0.f);
+			const float NoL = std::clamp(2.f * h.z * h.z - 1.f, 0.f, 1.f);
+			if (NoL > 0.f)
+			{
+				float level = GetSampleLevel(NoH, NoH, roughness, sampleCount, resolution);
+				level = level > 0.f ? std::min(level, (float)(sourceMipCount - 1)) : 0.f;
+				const uint32_t mip0 = (uint32_t)level;
+				samples.push_back({ h.x, h.y, h.z, NoL, mip0, std::min(mip0 + 1, sourceMipCount - 1), level - (float)mip0 });
+			}
+		}
+
+		return samples;
+	}
+
+	AVX2_FUNCTION void PrefilterTexels8(const std::vector<FPackedMip>& source, const std::vector<FGgxSample>& samples, uint32_t face, uint32_t x, uint32_t y, uint32_t mipSize, float* dest)
+	{
+		const FVector3x8 N = GetEnvDir8(face, x, y, mipSize);
+		const uint32_t count = std::min(8u, mipSize - x);
+		const __m256 one = _mm256_set1_ps(1.f);
+		if (samples.empty())
+		{
+			// Every sample is in the direction of the normal when the roughness is 0
+			__m256i faces;
+			__m256 u, v, rgb[3];
+			GetCubeCoordinates8(N, faces, u, v);
+			SampleBilinearClamp8(source[0], faces, u, v, rgb);
+			StoreTexels(dest, rgb[0], rgb[1], rgb[2], one, count);
+			return;
+		}
+
+		// TangentToWorld() in math.hlsli
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 signMask = _mm256_set1_ps(-0.f);
+		const __m256 bUpZ = _mm256_cmp_ps(_mm256_andnot_ps(signMask, N.z), _mm256_set1_ps(0.999f), _CMP_LT_OQ);
+		const FVector3x8 T = Normalize({
+			Select(bUpZ, _mm256_xor_ps(N.y, signMask), zero),
+			Select(bUpZ, N.x, _mm256_xor_ps(N.z, signMask)),
+			Select(bUpZ, zero, N.y) });
+		const FVector3x8 B = {
+			_mm256_fmsub_ps(N.y, T.z, _mm256_mul_ps(N.z, T.y)),
+			_mm256_fmsub_ps(N.z, T.x, _mm256_mul_ps(N.x, T.z)),
+			_mm256_fmsub_ps(N.x, T.y, _mm256_mul_ps(N.y, T.x)) };
+
+		__m256 color[3] = { zero, zero, zero };
+		__m256 totalWeight = zero;
+		for (const FGgxSample& sample : samples)
+		{
+			const __m256 hx = _mm256_set1_ps(sample.m_hx), hy = _mm256_set1_ps(sample.m_hy), hz = _mm256_set1_ps(sample.m_hz);
+			const FVector3x8 H = Normalize({
+				_mm256_fmadd_ps(hx, T.x, _mm256_fmadd_ps(hy, B.x, _mm256_mul_ps(hz, N.x))),
+				_mm256_fmadd_ps(hx, T.y, _mm256_fmadd_ps(hy, B.y, _mm256_mul_ps(hz, N.y))),
+				_mm256_fmadd_ps(hx, T.z, _mm256_fmadd_ps(hy, B.z, _mm256_mul_ps(hz, N.z))) });
+
+			// reflect(-V, H) with V = N
+			const __m256 twoVoH = _mm256_mul_ps(_mm256_set1_ps(2.f), Dot(N, H));
+			const FVector3x8 L = Normalize({
+				_mm256_fmsub_ps(twoVoH, H.x, N.x),
+				_mm256_fmsub_ps(twoVoH, H.y, N.y),
+				_mm256_fmsub_ps(twoVoH, H.z, N.z) });
+
+			__m256i faces;
+			__m256 u, v, rgb0[3];
+			GetCubeCoordinates8(L, faces, u, v);
+			SampleBilinearClamp8(source[sample.m_mip0], faces, u, v, rgb0);
+
+			const __m256 weight = _mm256_set1_ps(sample.m_weight);
+			if (sample.m_mip1 != sample.m_mip0)
+			{
+				__m256 rgb1[3];
+				SampleBilinearClamp8(source[sample.m_mip1], faces, u, v, rgb1);
+				const __m256 fraction = _mm256_set1_ps(sample.m_mipFraction);
+				for (int c = 0; c < 3; ++c)
+				{
+					rgb0[c] = _mm256_fmadd_ps(_mm256_sub_ps(rgb1[c], rgb0[c]), fraction, rgb0[c]);
+				}
+			}
+
+			for (int c = 0; c < 3; ++c)
+			{
+				color[c] = _mm256_fmadd_ps(rgb0[c], weight, color[c]);
+			}
+
+			totalWeight = _mm256_add_ps(totalWeight, weight);
+		}
+
+		StoreTexels(dest, _mm256_div_ps(color[0], totalWeight), _mm256_div_ps(color[1], totalWeight), _mm256_div_ps(color[2], totalWeight), one, count);
+	}
+
+	// Projects a row, 8 texels at a time. Texels are transposed to planar RGBA in the order 0 2 4 6 1 3 5 7, which the
+	// column tables are stored in as well.
+	AVX2_FUNCTION void ProjectRow8(const float* texels, const float* sinPhi, const float* cosPhi, uint32_t blockCount, float sinTheta, float cosTheta, float weight, double* sums)
+	{
+		__m256 accumulators[4 * EnvmapFilter::ShCoefficientCount];
+		std::fill(std::begin(accumulators), std::end(accumulators), _mm256_setzero_ps());
+
+		const __m256 sinThetaV = _mm256_set1_ps(sinTheta);
+		const __m256 y = _mm256_set1_ps(cosTheta);
+		const __m256 weightV = _mm256_set1_ps(weight);
+		for (uint32_t block = 0; block < blockCount; ++block)
+		{
+			const float* p = texels + (size_t)block * 32;
+			const __m256 t0 = _mm256_loadu_ps(p), t1 = _mm256_loadu_ps(p + 8), t2 = _mm256_loadu_ps(p + 16), t3 = _mm256_loadu_ps(p + 24);
+			const __m256 lo01 = _mm256_unpacklo_ps(t0, t1), hi01 = _mm256_unpackhi_ps(t0, t1);
+			const __m256 lo23 = _mm256_unpacklo_ps(t2, t3), hi23 = _mm256_unpackhi_ps(t2, t3);
+			const __m256 radiance[4] = {
+				_mm256_shuffle_ps(lo01, lo23, _MM_SHUFFLE(1, 0, 1, 0)),
+				_mm256_shuffle_ps(lo01, lo23, _MM_SHUFFLE(3, 2, 3, 2)),
+				_mm256_shuffle_ps(hi01, hi23, _MM_SHUFFLE(1, 0, 1, 0)),
+				_mm256_shuffle_ps(hi01, hi23, _MM_SHUFFLE(3, 2, 3, 2)) };
+
+			const __m256 x = _mm256_mul_ps(sinThetaV, _mm256_loadu_ps(sinPhi + (size_t)block * 8));
+			const __m256 z = _mm256_mul_ps(sinThetaV, _mm256_loadu_ps(cosPhi + (size_t)block * 8));
+			const __m256 basis[EnvmapFilter::ShCoefficientCount] = {
+				_mm256_set1_ps(ShK[0]),
+				_mm256_mul_ps(_mm256_set1_ps(ShK[1]), y),
+				_mm256_mul_ps(_mm256_set1_ps(ShK[2]), z),
+				_mm256_mul_ps(_mm256_set1_ps(ShK[3]), x),
+				_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(ShK[4]), x), y),
+				_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(ShK[5]), y), z),
+				_mm256_mul_ps(_mm256_set1_ps(ShK[6]), _mm256_fmsub_ps(_mm256_set1_ps(3.f), _mm256_mul_ps(z, z), _mm256_set1_ps(1.f))),
+				_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(ShK[7]), x), z),
+				_mm256_mul_ps(_mm256_set1_ps(ShK[8]), _mm256_fmsub_ps(x, x, _mm256_mul_ps(y, y))) };
+
+			for (uint32_t i = 0; i < EnvmapFilter::ShCoefficientCount; ++i)
+			{
+				const __m256 weightedBasis = _mm256_mul_ps(basis[i], weightV);
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					accumulators[i * 4 + c] = _mm256_fmadd_ps(radiance[c], weightedBasis, accumulators[i * 4 + c]);
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < 4 * EnvmapFilter::ShCoefficientCount; ++i)
+		{
+			alignas(32) float lanes[8];
+			_mm256_store_ps(lanes, accumulators[i]);
+			for (float lane : lanes)
+			{
+				sums[i] += lane;
+			}
+		}
+	}
+}
+
+bool EnvmapFilter::HasAvx2()
+{
+	static const bool s_bHasAvx2 = []()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// AVX and FMA with OS support for the YMM registers, then AVX2
+		__cpuid(info, 1);
+		const int avxFmaOsxsave = (1 << 28) | (1 << 12) | (1 << 27);
+		if ((info[2] & avxFmaOsxsave) != avxFmaOsxsave || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}();
+
+	return s_bHasAvx2;
+}
+
+void EnvmapFilter::ConvertLatlongToCubemapReference(const std::vector<FImage>& latlongMips, uint32_t cubemapSize, uint32_t mipCount, FCubemap& outCubemap)
+{
+	outCubemap = CreateCubemap(cubemapSize, mipCount);
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const uint32_t mipSize = std::max(cubemapSize >> mip, 1u);
+		for (uint32_t y = 0; y < mipSize; ++y)
+		{
+			for (uint32_t x = 0; x < mipSize; ++x)
+			{
+				float rgba[FaceCount][4];
+				ConvertTexel(latlongMips[mip], mipSize, x, y, rgba);
+				for (uint32_t face = 0; face < FaceCount; ++face)
+				{
+					std::copy_n(rgba[face], 4, &outCubemap.m_images[face * mipCount + mip].m_texels[((size_t)y * mipSize + x) * 4]);
+				}
+			}
+		}
+	}
+}
+
+void EnvmapFilter::ConvertLatlongToCubemap(const std::vector<FImage>& latlongMips, uint32_t cubemapSize, uint32_t mipCount, FCubemap& outCubemap, size_t threadCount)
+{
+	if (!HasAvx2())
+	{
+		ConvertLatlongToCubemapReference(latlongMips, cubemapSize, mipCount, outCubemap);
+		return;
+	}
+
+	// The angles of a texel are shared by every face, so each row is handed out once for all faces
+	outCubemap = CreateCubemap(cubemapSize, mipCount);
+	const std::vector<FCubemapRow> rows = GetCubemapRows(outCubemap, 1);
+	ForEachRow(rows.size(), GetThreadCount(threadCount), [&](size_t rowIndex)
+		{
+			const FCubemapRow& row = rows[rowIndex];
+			const uint32_t mipSize = outCubemap.GetImage(0, row.m_mip).m_width;
+			for (uint32_t x = 0; x < mipSize; x += 8)
+			{
+				ConvertTexels8(latlongMips[row.m_mip], mipSize, x, row.m_y, outCubemap, row.m_mip);
+			}
+		});
+}
+
+void EnvmapFilter::PrefilterCubemapReference(const FCubemap& source, uint32_t size, uint32_t mipCount, uint32_t sampleCount, FCubemap& outCubemap)
+{
+	outCubemap = CreateCubemap(size, mipCount);
+	const float resolution = (float)size;
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		const uint32_t mipSize = std::max(size >> mip, 1u);
+		const float roughness = mip / (float)mipCount;
+		for (uint32_t face = 0; face < FaceCount; ++face)
+		{
+			for (uint32_t y = 0; y < mipSize; ++y)
+			{
+				for (uint32_t x = 0; x < mipSize; ++x)
+				{
+					const FVector3 R = GetEnvDir(face, x / (float)mipSize, y / (float)mipSize);
+					const FVector3 N = R;
+					const FVector3 V = R;
+
+					// TangentToWorld() in math.hlsli
+					const FVector3 up = std::abs(N.z) < 0.999f ? FVector3{ 0.f, 0.f, 1.f } : FVector3{ 1.f, 0.f, 0.f };
+					const FVector3 T = Normalize(Cross(up, N));
+					const FVector3 B = Cross(N, T);
+
+					float color[3] = {};
+					float totalWeight = 0.f;
+					for (uint32_t i = 0; i < sampleCount; ++i)
+					{
+						float ux, uy;
+						Hammersley(i, sampleCount, ux, uy);
+						const FVector3 h = SampleGGX(ux, uy, roughness);
+						const FVector3 H = Normalize(T * h.x + B * h.y + N * h.z);
+						const FVector3 L = Normalize(H * (2.f * Dot(V, H)) - V);
+						const float NoL = std::clamp(Dot(N, L), 0.f, 1.f);
+						if (NoL > 0.f)
+						{
+							const float NoH = std::max(Dot(N, H), 0.f);
+							const float VoH = std::max(Dot(V, H), 0.f);
+							float rgb[3];
+							SampleCubeTrilinear(source, L, GetSampleLevel(NoH, VoH, roughness, sampleCount, resolution), rgb);
+							for (int c = 0; c < 3; ++c)
+							{
+								color[c] += rgb[c] * NoL;
+							}
+
+							totalWeight += NoL;
+						}
+					}
+
+					float* dest = &outCubemap.m_images[face * mipCount + mip].m_texels[((size_t)y * mipSize + x) * 4];
+					dest[0] = color[0] / totalWeight;
+					dest[1] = color[1] / totalWeight;
+					dest[2] = color[2] / totalWeight;
+					dest[3] = 1.f;
+				}
+			}
+		}
+	}
+}
+
+void EnvmapFilter::PrefilterCubemap(const FCubemap& source, uint32_t size, uint32_t mipCount, uint32_t sampleCount, FCubemap& outCubemap, size_t threadCount)
+{
+	if (!HasAvx2())
+	{
+		PrefilterCubemapReference(source, size, mipCount, sampleCount, outCubemap);
+		return;
+	}
+
+	// The samples only depend on the roughness, which is the same for every texel of a mip. Mip 0 has no samples, since it is a
+	// copy of the source.
+	std::vector<std::vector<FGgxSample>> mipSamples(mipCount);
+	for (uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		mipSamples[mip] = GetGgxSamples(mip / (float)mipCount, sampleCount, (float)size, source.m_mipCount);
+	}
+
+	const std::vector<FPackedMip> packedSource = PackCubemap(source);
+	outCubemap = CreateCubemap(size, mipCount);
+	const std::vector<FCubemapRow> rows = GetCubemapRows(outCubemap, FaceCount);
+	ForEachRow(rows.size(), GetThreadCount(threadCount), [&](size_t rowIndex)
+		{
+			const FCubemapRow& row = rows[rowIndex];
+			FImage& image = outCubemap.m_images[row.m_face * mipCount + row.m_mip];
+			for (uint32_t x = 0; x < image.m_width; x += 8)
+			{
+				PrefilterTexels8(packedSource, mipSamples[row.m_mip], row.m_face, x, row.m_y, image.m_width, &image.m_texels[((size_t)row.m_y * image.m_width + x) * 4]);
+			}
+		});
+}
+
+void EnvmapFilter::ProjectSHReference(const FImage& latlong, FShCoefficients& outSh)
+{
+	double sums[4 * ShCoefficientCount] = {};
+	for (uint32_t y = 0; y < latlong.m_height; ++y)
+	{
+		for (uint32_t x = 0; x < latlong.m_width; ++x)
+		{
+			ProjectTexel(latlong, x, y, sums);
+		}
+	}
+
+	std::copy(std::begin(sums), std::end(sums), outSh.begin());
+}
+
+void EnvmapFilter::ProjectSH(const FImage& latlong, FShCoefficients& outSh, size_t threadCount)
+{
+	if (!HasAvx2())
+	{
+		ProjectSHReference(latlong, outSh);
+		return;
+	}
+
+	// The azimuth only depends on the column, so its sine and cosine are looked up, in the order that ProjectRow8() reads them
+	const uint32_t blockCount = latlong.m_width / 8;
+	std::vector<float> sinPhi(blockCount * 8), cosPhi(blockCount * 8);
+	constexpr uint32_t LaneColumns[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+	for (uint32_t i = 0; i < blockCount * 8; ++i)
+	{
+		const uint32_t x = (i & ~7u) + LaneColumns[i & 7];
+		const float u = ((float)x + 0.5f) / (float)latlong.m_width;
+		const float phi = Pi * (u * 2.f - 1.f);
+		sinPhi[i] = std::sin(phi);
+		cosPhi[i] = std::cos(phi);
+	}
+
+	// Rows are summed separately and then in order, so that the result doesn't depend on the thread count
+	std::vector<std::array<double, 4 * ShCoefficientCount>> rowSums(latlong.m_height);
+	const float dTheta = Pi / (float)latlong.m_height;
+	const float dPhi = 2.f * Pi / (float)latlong.m_width;
+	ForEachRow(latlong.m_height, GetThreadCount(threadCount), [&](size_t y)
+		{
+			double* sums = rowSums[y].data();
+			std::fill_n(sums, 4 * ShCoefficientCount, 0.0);
+
+			const float v = ((float)y + 0.5f) / (float)latlong.m_height;
+			const float theta = Pi * v;
+			const float sinTheta = std::sin(theta);
+			const float* row = &latlong.m_texels[y * latlong.m_width * 4];
+			ProjectRow8(row, sinPhi.data(), cosPhi.data(), blockCount, sinTheta, std::cos(theta), sinTheta * dTheta * dPhi, sums);
+			for (uint32_t x = blockCount * 8; x < latlong.m_width; ++x)
+			{
+				ProjectTexel(latlong, x, (uint32_t)y, sums);
+			}
+		});
+
+	double sums[4 * ShCoefficientCount] = {};
+	for (const auto& row : rowSums)
+	{
+		for (uint32_t i = 0; i < 4 * ShCoefficientCount; ++i)
+		{
+			sums[i] += row[i];
+		}
+	}
+
+	std::copy(std::begin(sums), std::end(sums), outSh.begin());
+}
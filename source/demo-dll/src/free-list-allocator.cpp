@@ -0,0 +1,141 @@
+#include <free-list-allocator.h>
+#include <algorithm>
+
+FFreeListAllocator::FFreeListAllocator(size_t capacity) :
+	m_capacity{ capacity }
+{
+	if (capacity > 0)
+	{
+		AddFreeRange(0, capacity);
+	}
+}
+
+size_t FFreeListAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0)
+		return InvalidOffset;
+
+	// Ranges are visited from the smallest that could fit, since alignment padding can make the first candidates too small
+	for (auto it = m_freeRangesBySize.lower_bound({ size, 0 }); it != m_freeRangesBySize.cend(); ++it)
+	{
+		const auto [rangeSize, rangeOffset] = *it;
+		const size_t offset = (rangeOffset + alignment - 1) & ~(alignment - 1);
+		if (offset + size > rangeOffset + rangeSize)
+			continue;
+
+		RemoveFreeRange(rangeOffset, rangeSize);
+		if (offset > rangeOffset)
+		{
+			AddFreeRange(rangeOffset, offset - rangeOffset);
+		}
+
+		if (offset + size < rangeOffset + rangeSize)
+		{
+			AddFreeRange(offset + size, rangeOffset + rangeSize - (offset + size));
+		}
+
+		m_allocations[offset] = size;
+		m_usedSize += size;
+		return offset;
+	}
+
+	return InvalidOffset;
+}
+
+void FFreeListAllocator::Free(size_t offset)
+{
+	auto allocation = m_allocations.find(offset);
+	if (allocation == m_allocations.cend())
+		return;
+
+	size_t begin = offset;
+	size_t end = offset + allocation->second;
+	m_usedSize -= allocation->second;
+	m_allocations.erase(allocation);
+
+	// Merge with the free ranges on either side
+	auto next = m_freeRangesByOffset.lower_bound(begin);
+	if (next != m_freeRangesByOffset.cbegin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == begin)
+		{
+			begin = prev->first;
+			RemoveFreeRange(prev->first, prev->second);
+		}
+	}
+
+	next = m_freeRangesByOffset.lower_bound(end);
+	if (next != m_freeRangesByOffset.cend() && next->first == end)
+	{
+		end += next->second;
+		RemoveFreeRange(next->first, next->second);
+	}
+
+	AddFreeRange(begin, end - begin);
+}
+
+size_t FFreeListAllocator::GetLargestFreeRange() const
+{
+	return m_freeRangesBySize.empty() ? 0 : m_freeRangesBySize.crbegin()->first;
+}
+
+float FFreeListAllocator::GetFragmentation() const
+{
+	const size_t freeSize = m_capacity - m_usedSize;
+	return freeSize == 0 ? 0.f : 1.f - (float)GetLargestFreeRange() / (float)freeSize;
+}
+
+bool FFreeListAllocator::Validate() const
+{
+	if (m_freeRangesByOffset.size() != m_freeRangesBySize.size())
+		return false;
+
+	std::map<size_t, std::pair<size_t, bool>> ranges;	// Offset to (size, free)
+	for (const auto& [offset, size] : m_freeRangesByOffset)
+	{
+		if (size == 0 || !m_freeRangesBySize.contains({ size, offset }))
+			return false;
+
+		ranges[offset] = { size, true };
+	}
+
+	size_t usedSize = 0;
+	for (const auto& [offset, size] : m_allocations)
+	{
+		if (size == 0 || !ranges.insert({ offset, { size, false } }).second)
+			return false;
+
+		usedSize += size;
+	}
+
+	if (usedSize != m_usedSize)
+		return false;
+
+	// Together they must cover the whole range, in order
+	size_t end = 0;
+	bool bPrevFree = false;
+	for (const auto& [offset, range] : ranges)
+	{
+		const auto [size, bFree] = range;
+		if (offset != end || (bFree && bPrevFree))
+			return false;
+
+		end = offset + size;
+		bPrevFree = bFree;
+	}
+
+	return end == m_capacity;
+}
+
+void FFreeListAllocator::AddFreeRange(size_t offset, size_t size)
+{
+	m_freeRangesByOffset[offset] = size;
+	m_freeRangesBySize.insert({ size, offset });
+}
+
+void FFreeListAllocator::RemoveFreeRange(size_t offset, size_t size)
+{
+	m_freeRangesByOffset.erase(offset);
+	m_freeRangesBySize.erase({ size, offset });
+}
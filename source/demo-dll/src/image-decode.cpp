@@ -0,0 +1,28 @@
+#include <image-decode.h>
+#include <stb_image.h>
+
+bool ImageDecode::DecodeRgba8(const tinygltf::Image& image, std::vector<uint8_t>& pixels)
+{
+	int width, height, component;
+	uint8_t* data = stbi_load_from_memory(image.image.data(), (int)image.image.size(), &width, &height, &component, 0);
+	if (!data || width != image.width || height != image.height)
+	{
+		stbi_image_free(data);
+		return false;
+	}
+
+	const size_t pixelCount = (size_t)width * height;
+	pixels.resize(pixelCount * 4);
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		const uint8_t* src = data + i * component;
+		uint8_t* dest = pixels.data() + i * 4;
+		dest[0] = src[0];
+		dest[1] = component > 1 ? src[1] : 0;
+		dest[2] = component > 2 ? src[2] : 0;
+		dest[3] = component > 3 ? src[3] : 255;
+	}
+
+	stbi_image_free(data);
+	return true;
+}
@@ -4,14 +4,21 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <mesh-utils.h>
+#include <accessor-view.h>
 #include <MikkTSpace/mikktspace.h>
-#include <ppl.h>
+#include <parallel.h>
 #include <profiling.h>
 #include <common.h>
 #include <SimpleMath.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <memory>
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+#include <numeric>
+#include <fstream>
+#include <filesystem>
+#include <spookyhash_api.h>
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
@@ -25,53 +32,26 @@ namespace
         int m_primitiveIndex;
     };
 
-    float* GetAttributeData(std::string attributeName, const SMikkTSpaceContext* context, const int face, const int vert)
+    // Vertex streams of a primitive, resolved once up front so that the MikkTSpace callbacks are plain array lookups
+    struct FTangentSpaceStreams
     {
-        const size_t indexBufferIdx = face * 3 + vert;
-
-        PrimitiveIdentifier* primId = (PrimitiveIdentifier*)context->m_pUserData;
-        tinygltf::Model* model = primId->m_model;
-        tinygltf::Mesh& mesh = model->meshes[primId->m_meshIndex];
-        tinygltf::Primitive& primitive = mesh.primitives[primId->m_primitiveIndex];
-
-        tinygltf::Accessor& indexAccessor = model->accessors[primitive.indices];
-        tinygltf::BufferView& indexBufferView = model->bufferViews[indexAccessor.bufferView];
-        tinygltf::Buffer& indexBuffer = model->buffers[indexBufferView.buffer];
-
-        auto vertexIt = primitive.attributes.find(attributeName);
-        tinygltf::Accessor& vertexAccessor = model->accessors[vertexIt->second];
-        tinygltf::BufferView& vertexBufferView = model->bufferViews[vertexAccessor.bufferView];
-        tinygltf::Buffer& vertexBuffer = model->buffers[vertexBufferView.buffer];
-
-        size_t indexSize = tinygltf::GetComponentSizeInBytes(indexAccessor.componentType) * tinygltf::GetNumComponentsInType(indexAccessor.type);
-        uint32_t index;
-        if (indexSize == sizeof(uint16_t))
-        {
-            uint16_t* indices = (uint16_t*)(indexBuffer.data.data() + indexBufferView.byteOffset + indexAccessor.byteOffset);
-            index = (uint32_t)indices[indexBufferIdx];
-        }
-        else
-        {
-            DebugAssert(indexSize == sizeof(uint32_t));
-            uint32_t* indices = (uint32_t*)(indexBuffer.data.data() + indexBufferView.byteOffset + indexAccessor.byteOffset);
-            index = indices[indexBufferIdx];
-        }
+        const uint32_t* m_indices;
+        uint32_t m_faceCount;
+        const XMFLOAT3* m_positions;
+        const XMFLOAT3* m_normals;
+        const XMFLOAT2* m_uvs;
+        XMFLOAT4* m_tangents;
+    };
 
-        float* verts = (float*)(vertexBuffer.data.data() + vertexBufferView.byteOffset + vertexAccessor.byteOffset);
-        return &verts[index * tinygltf::GetNumComponentsInType(vertexAccessor.type)];
+    uint32_t GetVertexIndex(const SMikkTSpaceContext* context, const int face, const int vert)
+    {
+        const FTangentSpaceStreams* streams = (const FTangentSpaceStreams*)context->m_pUserData;
+        return streams->m_indices[face * 3 + vert];
     }
 
     int GetNumFaces(const SMikkTSpaceContext* context)
     {
-        PrimitiveIdentifier* primId = (PrimitiveIdentifier*)context->m_pUserData;
-
-        const tinygltf::Model* model = primId->m_model;
-        const tinygltf::Mesh& mesh = model->meshes[primId->m_meshIndex];
-        const tinygltf::Primitive& primitive = mesh.primitives[primId->m_primitiveIndex];
-
-        const tinygltf::Accessor& indexAccessor = model->accessors[primitive.indices];
-        DebugAssert(indexAccessor.count % 3 == 0);
-        return indexAccessor.count / 3;
+        return ((const FTangentSpaceStreams*)context->m_pUserData)->m_faceCount;
     }
 
     int GetNumVerticesOfFace(const SMikkTSpaceContext* context, const int face)
@@ -81,36 +61,34 @@ namespace
 
     void GetPosition(const SMikkTSpaceContext* context, float posOut[], const int face, const int vert)
     {
-        float* pData = GetAttributeData("POSITION", context, face, vert);
-        posOut[0] = pData[0];
-        posOut[1] = pData[1];
-        posOut[2] = pData[2];
+        const XMFLOAT3& position = ((const FTangentSpaceStreams*)context->m_pUserData)->m_positions[GetVertexIndex(context, face, vert)];
+        posOut[0] = position.x;
+        posOut[1] = position.y;
+        posOut[2] = position.z;
     }
 
     void GetNormal(const SMikkTSpaceContext* context, float normalOut[], const int face, const int vert)
     {
-        float* pData = GetAttributeData("NORMAL", context, face, vert);
-        normalOut[0] = pData[0];
-        normalOut[1] = pData[1];
-        normalOut[2] = pData[2];
+        const XMFLOAT3& normal = ((const FTangentSpaceStreams*)context->m_pUserData)->m_normals[GetVertexIndex(context, face, vert)];
+        normalOut[0] = normal.x;
+        normalOut[1] = normal.y;
+        normalOut[2] = normal.z;
     }
 
     void GetUV(const SMikkTSpaceContext* context, float uvOut[], const int face, const int vert)
     {
-        float* pData = GetAttributeData("TEXCOORD_0", context, face, vert);
-        uvOut[0] = pData[0];
-        uvOut[1] = pData[1];
+        const XMFLOAT2& uv = ((const FTangentSpaceStreams*)context->m_pUserData)->m_uvs[GetVertexIndex(context, face, vert)];
+        uvOut[0] = uv.x;
+        uvOut[1] = uv.y;
     }
 
     void SetTSpaceBasic(const SMikkTSpaceContext* context, const float tangent[], const float sign, const int face, const int vert)
     {
-        float* pData = GetAttributeData("TANGENT", context, face, vert);
-        pData[0] = tangent[0];
-        pData[1] = tangent[1];
-        pData[2] = tangent[2];
-        pData[3] = sign;
+        const FTangentSpaceStreams* streams = (const FTangentSpaceStreams*)context->m_pUserData;
+        streams->m_tangents[GetVertexIndex(context, face, vert)] = XMFLOAT4{ tangent[0], tangent[1], tangent[2], sign };
     }
 
+    // Ritter's approximate enclosing sphere. Despite the name this is usually somewhat larger than the minimal sphere.
     XMVECTOR MinimumBoundingSphere(XMFLOAT3* points, uint32_t count)
     {
         assert(points != nullptr && count != 0);
@@ -171,6 +149,7 @@ namespace
 
                 center = center * k + point * (g_XMOne - k);
                 radius = (radius + dist) * 0.5f;
+                radiusSq = radius * radius;
             }
         }
 
@@ -179,60 +158,227 @@ namespace
         return XMVectorSelect(center, radius, select0001);
     }
 
-    struct EdgeEntry
+    // Expands a sphere (xyz center, w radius) so that it contains the point, using the same update as MinimumBoundingSphere
+    XMVECTOR GrowBoundingSphere(XMVECTOR sphere, XMVECTOR point)
     {
-        uint32_t   i0;
-        uint32_t   i1;
-        uint32_t   i2;
+        XMVECTOR center = sphere;
+        XMVECTOR radius = XMVectorSplatW(sphere);
+        XMVECTOR distSq = XMVector3LengthSq(point - center);
+
+        if (XMVector3Greater(distSq, radius * radius))
+        {
+            XMVECTOR dist = XMVectorSqrt(distSq);
+            XMVECTOR k = (radius / dist) * 0.5f + XMVectorReplicate(0.5f);
+
+            center = center * k + point * (g_XMOne - k);
+            radius = (radius + dist) * 0.5f;
+        }
+
+        XMVECTOR select0001 = XMVectorSelectControl(0, 0, 0, 1);
+        return XMVectorSelect(center, radius, select0001);
+    }
 
-        uint32_t   Face;
-        EdgeEntry* Next;
+    // Extreme points of a position stream along the three axes and the four diagonals (1,1,1), (1,1,-1), (1,-1,1) and (1,-1,-1).
+    // The axis extremes also give the AABB. The w lane of the axis indices is unused.
+    struct FExtremePoints
+    {
+        XMFLOAT3 m_min;
+        XMFLOAT3 m_max;
+        uint32_t m_axisMin[4];
+        uint32_t m_axisMax[4];
+        uint32_t m_diagonalMin[4];
+        uint32_t m_diagonalMax[4];
     };
 
-    template <typename T>
-    inline size_t Hash(const T& val)
+    XMVECTOR LoadPosition(const uint8_t* positions, uint32_t stride, uint32_t index)
+    {
+        return XMLoadFloat3((const XMFLOAT3*)(positions + (size_t)index * stride));
+    }
+
+    // Single pass over a strided position stream. The axis and diagonal projections are each one SIMD register, and the index 
+    // of the point that set each extreme is tracked per lane with a compare and select, so the loop has no branches.
+    FExtremePoints FindExtremePoints(const uint8_t* positions, uint32_t count, uint32_t stride)
     {
-        return std::hash<T>()(val);
+        const XMVECTOR diagonalY = XMVectorSet(1.f, 1.f, -1.f, -1.f);
+        const XMVECTOR diagonalZ = XMVectorSet(1.f, -1.f, 1.f, -1.f);
+
+        XMVECTOR p = LoadPosition(positions, stride, 0);
+        XMVECTOR d = XMVectorMultiplyAdd(XMVectorSplatZ(p), diagonalZ, XMVectorMultiplyAdd(XMVectorSplatY(p), diagonalY, XMVectorSplatX(p)));
+        XMVECTOR axisMin = p, axisMax = p, diagonalMin = d, diagonalMax = d;
+        XMVECTOR axisMinIndex = XMVectorZero(), axisMaxIndex = XMVectorZero(), diagonalMinIndex = XMVectorZero(), diagonalMaxIndex = XMVectorZero();
+
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            p = LoadPosition(positions, stride, i);
+            d = XMVectorMultiplyAdd(XMVectorSplatZ(p), diagonalZ, XMVectorMultiplyAdd(XMVectorSplatY(p), diagonalY, XMVectorSplatX(p)));
+
+            const XMVECTOR index = XMVectorReplicateInt(i);
+            axisMinIndex = XMVectorSelect(axisMinIndex, index, XMVectorLess(p, axisMin));
+            axisMaxIndex = XMVectorSelect(axisMaxIndex, index, XMVectorGreater(p, axisMax));
+            diagonalMinIndex = XMVectorSelect(diagonalMinIndex, index, XMVectorLess(d, diagonalMin));
+            diagonalMaxIndex = XMVectorSelect(diagonalMaxIndex, index, XMVectorGreater(d, diagonalMax));
+
+            axisMin = XMVectorMin(axisMin, p);
+            axisMax = XMVectorMax(axisMax, p);
+            diagonalMin = XMVectorMin(diagonalMin, d);
+            diagonalMax = XMVectorMax(diagonalMax, d);
+        }
+
+        FExtremePoints result;
+        XMStoreFloat3(&result.m_min, axisMin);
+        XMStoreFloat3(&result.m_max, axisMax);
+        XMStoreInt4(result.m_axisMin, axisMinIndex);
+        XMStoreInt4(result.m_axisMax, axisMaxIndex);
+        XMStoreInt4(result.m_diagonalMin, diagonalMinIndex);
+        XMStoreInt4(result.m_diagonalMax, diagonalMaxIndex);
+        return result;
     }
 
-    size_t CRCHash(const uint32_t* dwords, uint32_t dwordCount)
+    // Ritter pass over all points, starting at firstPoint and wrapping around. Every update produces a sphere that contains the 
+    // previous one, so the result contains all points regardless of the starting sphere.
+    XMVECTOR GrowBoundingSphere(XMVECTOR sphere, const uint8_t* positions, uint32_t count, uint32_t stride, uint32_t firstPoint)
     {
-        size_t h = 0;
+        for (uint32_t i = firstPoint; i < count; ++i)
+        {
+            sphere = GrowBoundingSphere(sphere, LoadPosition(positions, stride, i));
+        }
 
-        for (uint32_t i = 0; i < dwordCount; ++i)
+        for (uint32_t i = 0; i < firstPoint; ++i)
         {
-            uint32_t highOrd = h & 0xf8000000;
-            h = h << 5;
-            h = h ^ (highOrd >> 27);
-            h = h ^ size_t(dwords[i]);
+            sphere = GrowBoundingSphere(sphere, LoadPosition(positions, stride, i));
         }
 
-        return h;
+        return sphere;
+    }
+
+    // Entry in the candidate heap. A triangle can have several entries; only the one matching its live version is valid.
+    struct FCandidate
+    {
+        float m_score;
+        uint32_t m_triIndex;
+        uint32_t m_version;
+    };
+
+    // Heap ordering that puts the lowest score on top. Ties are broken on the triangle index so that the order is total.
+    bool CompareCandidates(const FCandidate& a, const FCandidate& b)
+    {
+        return a.m_score > b.m_score || (a.m_score == b.m_score && a.m_triIndex > b.m_triIndex);
     }
 
-    // Sort in reverse order to use vector as a queue with pop_back.
-    bool CompareScores(const std::pair<uint32_t, float>& a, const std::pair<uint32_t, float>& b)
+    // In deterministic mode, scores are snapped to a fixed grid so that last-bit differences in the floating point math (e.g. FMA 
+    // contraction or a different instruction set) rarely change the order in which candidates are picked. This is not a guarantee: 
+    // a score that lands next to a grid boundary can still round to different sides on different builds.
+    float QuantizeScore(float score, bool bDeterministic)
     {
-        return a.second > b.second;
+        // Degenerate triangles can produce a NaN score, which would break the heap ordering
+        if (std::isnan(score))
+            return FLT_MAX;
+
+        return bDeterministic ? std::round(score * 4096.f) / 4096.f : score;
     }
 
-    // Compute number of triangle vertices already exist in the meshlet
-    uint32_t ComputeReuse(const FInlineMeshlet& meshlet, uint32_t(&triIndices)[3])
+    // Tracks the meshlet that is currently being built so that candidate scoring and insertion
+    // don't have to rescan the meshlet contents or recompute its bounds from scratch.
+    struct FMeshletBuilder
     {
-        uint32_t count = 0;
+        static constexpr uint32_t Undef = uint32_t(-1);
+
+        // Generation-stamped vertex to meshlet-local slot table. A slot is only valid if the vertex 
+        // generation matches the current one, so starting a new meshlet doesn't require clearing the table.
+        std::vector<uint32_t> m_vertexGeneration;
+        std::vector<uint32_t> m_vertexSlot;
+        uint32_t m_generation = 0;
+
+        // Incrementally grown bounding sphere of the meshlet positions and of the triangle normals
+        XMVECTOR m_positionSphere = g_XMZero;
+        XMVECTOR m_normalSphere = g_XMZero;
+        bool m_bEmpty = true;
+
+        explicit FMeshletBuilder(uint32_t vertexCount) :
+            m_vertexGeneration(vertexCount, 0),
+            m_vertexSlot(vertexCount, Undef)
+        {
+            Reset();
+        }
+
+        void Reset()
+        {
+            // Generation 0 is never current, which marks all vertices as absent on the first meshlet
+            ++m_generation;
+            m_positionSphere = g_XMZero;
+            m_normalSphere = g_XMZero;
+            m_bEmpty = true;
+        }
+
+        uint32_t FindSlot(uint32_t vertexIndex) const
+        {
+            return m_vertexGeneration[vertexIndex] == m_generation ? m_vertexSlot[vertexIndex] : Undef;
+        }
+
+        void SetSlot(uint32_t vertexIndex, uint32_t slot)
+        {
+            m_vertexGeneration[vertexIndex] = m_generation;
+            m_vertexSlot[vertexIndex] = slot;
+        }
 
-        for (uint32_t i = 0; i < static_cast<uint32_t>(meshlet.m_uniqueVertexIndices.size()); ++i)
+        // Compute number of triangle vertices already exist in the meshlet
+        uint32_t ComputeReuse(const uint32_t(&triIndices)[3]) const
         {
+            uint32_t count = 0;
+
             for (uint32_t j = 0; j < 3u; ++j)
             {
-                if (meshlet.m_uniqueVertexIndices[i] == triIndices[j])
+                if (FindSlot(triIndices[j]) != Undef)
                 {
                     ++count;
                 }
             }
+
+            return count;
+        }
+
+        // Grow the bounds to include a newly added triangle
+        void AddTriangle(const XMFLOAT3(&points)[3], XMVECTOR normal)
+        {
+            if (m_bEmpty)
+            {
+                m_positionSphere = MinimumBoundingSphere((XMFLOAT3*)points, 3);
+                m_normalSphere = XMVectorSelect(normal, g_XMZero, XMVectorSelectControl(0, 0, 0, 1));
+                m_bEmpty = false;
+                return;
+            }
+
+            for (uint32_t i = 0; i < 3u; ++i)
+            {
+                m_positionSphere = GrowBoundingSphere(m_positionSphere, XMLoadFloat3(&points[i]));
+            }
+
+            m_normalSphere = GrowBoundingSphere(m_normalSphere, normal);
         }
 
-        return count;
+        XMVECTOR GetNormalAxis() const
+        {
+            return XMVector3Normalize(m_normalSphere);
+        }
+    };
+
+    // Spreads the lower 10 bits of v so that there are two zero bits between each of them
+    uint32_t ExpandBits(uint32_t v)
+    {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+
+    // 30-bit Morton code for a point that is normalized to the unit cube
+    uint32_t MortonCode3D(float x, float y, float z)
+    {
+        x = std::clamp(x * 1024.f, 0.f, 1023.f);
+        y = std::clamp(y * 1024.f, 0.f, 1023.f);
+        z = std::clamp(z * 1024.f, 0.f, 1023.f);
+        return (ExpandBits((uint32_t)x) << 2) | (ExpandBits((uint32_t)y) << 1) | ExpandBits((uint32_t)z);
     }
 
     XMVECTOR ComputeNormal(XMFLOAT3* tri)
@@ -247,15 +393,74 @@ namespace
         return XMVector3Normalize(XMVector3Cross(v01, v02));
     }
 
+    int8_t QuantizeSnorm8(float v)
+    {
+        return (int8_t)std::clamp(std::round(v * 127.f), -127.f, 127.f);
+    }
+
+    // Fits a cone around the outward facing normals of the meshlet triangles and packs it as s8 axis (xyz) and s8 cutoff (w). 
+    // The cutoff is the sine of the cone half-angle, and is widened to stay conservative with respect to the quantized axis. 
+    // Meshlets whose normals span a hemisphere or more get a cutoff of 1, which never culls.
+    uint32_t ComputeNormalCone(const FInlineMeshlet& meshlet, const XMFLOAT3* positions)
+    {
+        std::vector<XMFLOAT3> normals;
+        normals.reserve(meshlet.m_primitiveIndices.size());
+        for (const FInlineMeshlet::FPackedTriangle& prim : meshlet.m_primitiveIndices)
+        {
+            XMFLOAT3 points[3] =
+            {
+                positions[meshlet.m_uniqueVertexIndices[prim.i0]],
+                positions[meshlet.m_uniqueVertexIndices[prim.i1]],
+                positions[meshlet.m_uniqueVertexIndices[prim.i2]],
+            };
+
+            // Meshlet triangles have reversed winding, so negate to get the normal of the source triangle
+            XMVECTOR n = -ComputeNormal(points);
+            if (XMVector3Equal(n, n) && XMVectorGetX(XMVector3LengthSq(n)) > 0.5f)
+            {
+                XMStoreFloat3(&normals.emplace_back(), n);
+            }
+        }
+
+        const uint32_t noCull = MeshUtils::PackNormalCone(0, 0, 127, 127);
+        if (normals.empty())
+            return noCull;
+
+        XMVECTOR axis = XMVector3Normalize(MinimumBoundingSphere(normals.data(), static_cast<uint32_t>(normals.size())));
+        if (!XMVector3Equal(axis, axis))
+            return noCull;
+
+        XMFLOAT3 unquantizedAxis;
+        XMStoreFloat3(&unquantizedAxis, axis);
+        const int8_t qx = QuantizeSnorm8(unquantizedAxis.x);
+        const int8_t qy = QuantizeSnorm8(unquantizedAxis.y);
+        const int8_t qz = QuantizeSnorm8(unquantizedAxis.z);
+
+        // Evaluate the spread against the axis that the culling test will actually see
+        axis = XMVector3Normalize(XMVectorSet(qx, qy, qz, 0.f));
+        float minDot = 1.f;
+        for (const XMFLOAT3& n : normals)
+        {
+            minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(XMLoadFloat3(&n), axis)));
+        }
+
+        if (minDot <= 0.f)
+            return noCull;
+
+        const float cutoff = std::sqrt(1.f - minDot * minDot);
+        const int8_t qcutoff = (int8_t)std::min(127.f, std::ceil(cutoff * 127.f + 0.01f));
+        return MeshUtils::PackNormalCone(qx, qy, qz, qcutoff);
+    }
+
     // Computes a candidacy score based on spatial locality, orientational coherence, and vertex re-use within a meshlet.
-    float ComputeScore(const FInlineMeshlet& meshlet, XMVECTOR sphere, XMVECTOR normal, uint32_t(&triIndices)[3], XMFLOAT3* triVerts)
+    float ComputeScore(const FMeshletBuilder& builder, XMVECTOR sphere, XMVECTOR normal, uint32_t(&triIndices)[3], XMFLOAT3* triVerts)
     {
         const float reuseWeight = 0.334f;
         const float locWeight = 0.333f;
         const float oriWeight = 0.333f;
 
         // Vertex reuse
-        uint32_t reuse = ComputeReuse(meshlet, triIndices);
+        uint32_t reuse = builder.ComputeReuse(triIndices);
         XMVECTOR reuseScore = g_XMOne - (XMVectorReplicate(float(reuse)) / 3.0f);
 
         // Distance from center point
@@ -279,211 +484,225 @@ namespace
         return XMVectorGetX(b);
     }
 
+    // Maps every vertex to the lowest vertex index with a bitwise identical position
+    template <typename T>
+    void WeldPositions(const XMFLOAT3* positions, uint32_t vertexCount, std::vector<T>& pointRep)
+    {
+        struct FWeldKey
+        {
+            uint32_t m_bits[3];
+            uint32_t m_vertex;
+        };
+
+        std::vector<FWeldKey> keys(vertexCount);
+        Parallel::For(0u, vertexCount, [&](uint32_t i)
+        {
+            memcpy(keys[i].m_bits, &positions[i], sizeof(XMFLOAT3));
+            keys[i].m_vertex = i;
+        });
+
+        Parallel::Sort(keys.begin(), keys.end(), [](const FWeldKey& a, const FWeldKey& b)
+        {
+            return std::tie(a.m_bits[0], a.m_bits[1], a.m_bits[2], a.m_vertex) < std::tie(b.m_bits[0], b.m_bits[1], b.m_bits[2], b.m_vertex);
+        });
+
+        auto SamePosition = [&](uint32_t a, uint32_t b)
+        {
+            return memcmp(keys[a].m_bits, keys[b].m_bits, sizeof(XMFLOAT3)) == 0;
+        };
+
+        // Each run of equal positions starts with its lowest vertex index
+        pointRep.resize(vertexCount);
+        Parallel::For(0u, vertexCount, [&](uint32_t i)
+        {
+            if (i == 0 || !SamePosition(i, i - 1))
+            {
+                for (uint32_t j = i; j < vertexCount && SamePosition(j, i); ++j)
+                {
+                    pointRep[keys[j].m_vertex] = static_cast<T>(keys[i].m_vertex);
+                }
+            }
+        });
+    }
+
+    // Edge i is the directed edge of triangle i / 3 that starts at corner i % 3. Adjacent triangles are matched through the
+    // reversed edge over welded positions. Where an edge is shared by more than two triangles, the candidate whose normal is 
+    // closest is picked, visiting the most recently added edges first.
     template <typename T>
     void BuildAdjacencyList(
         const T* indices, uint32_t indexCount,
         const XMFLOAT3* positions, uint32_t vertexCount,
         uint32_t* adjacency)
     {
+        SCOPED_CPU_EVENT("build_adjacency", PIX_COLOR_DEFAULT);
+
         const uint32_t triCount = indexCount / 3;
-        // Find point reps (unique positions) in the position stream
-        // Create a mapping of non-unique vertex indices to point reps
+        indexCount = triCount * 3;
+
         std::vector<T> pointRep;
-        pointRep.resize(vertexCount);
+        WeldPositions(positions, vertexCount, pointRep);
 
-        std::unordered_map<size_t, T> uniquePositionMap;
-        uniquePositionMap.reserve(vertexCount);
+        auto Rep = [&](uint32_t edge, uint32_t offset)
+        {
+            return pointRep[indices[(edge / 3) * 3 + (edge % 3 + offset) % 3]];
+        };
 
-        for (uint32_t i = 0; i < vertexCount; ++i)
+        auto IsDegenerate = [&](uint32_t tri)
         {
-            XMFLOAT3 position = *(positions + i);
-            size_t hash = Hash(position);
+            const T r0 = pointRep[indices[tri * 3]];
+            const T r1 = pointRep[indices[tri * 3 + 1]];
+            const T r2 = pointRep[indices[tri * 3 + 2]];
+            return r0 == r1 || r1 == r2 || r2 == r0;
+        };
+
+        // Bucket the edges by start point with a counting sort, then sort each bucket by end point and by descending edge index
+        struct FEdge
+        {
+            T m_end;
+            uint32_t m_edge;
+        };
 
-            auto it = uniquePositionMap.find(hash);
-            if (it != uniquePositionMap.end())
+        std::vector<uint32_t> bucketBegin(vertexCount + 1, 0);
+        std::vector<FEdge> edges(indexCount);
+        {
+            std::vector<std::atomic<uint32_t>> cursors(vertexCount);
+            Parallel::For(0u, indexCount, [&](uint32_t edge)
             {
-                // Position already encountered - reference previous index
-                pointRep[i] = it->second;
-            }
-            else
+                cursors[Rep(edge, 0)].fetch_add(1, std::memory_order_relaxed);
+            });
+
+            for (uint32_t v = 0; v < vertexCount; ++v)
             {
-                // New position found - add to hash table and LUT
-                uniquePositionMap.insert(std::make_pair(hash, static_cast<T>(i)));
-                pointRep[i] = static_cast<T>(i);
+                bucketBegin[v + 1] = bucketBegin[v] + cursors[v].load(std::memory_order_relaxed);
+                cursors[v].store(bucketBegin[v], std::memory_order_relaxed);
             }
-        }
-
-        // Create a linked list of edges for each vertex to determine adjacency
-        const uint32_t hashSize = vertexCount / 3;
 
-        std::unique_ptr<EdgeEntry* []> hashTable(new EdgeEntry * [hashSize]);
-        std::unique_ptr<EdgeEntry[]> entries(new EdgeEntry[triCount * 3]);
+            Parallel::For(0u, indexCount, [&](uint32_t edge)
+            {
+                edges[cursors[Rep(edge, 0)].fetch_add(1, std::memory_order_relaxed)] = { Rep(edge, 1), edge };
+            });
+        }
 
-        std::memset(hashTable.get(), 0, sizeof(EdgeEntry*) * hashSize);
-        uint32_t entryIndex = 0;
+        Parallel::For(0u, vertexCount, [&](uint32_t v)
+        {
+            std::sort(edges.begin() + bucketBegin[v], edges.begin() + bucketBegin[v + 1], [](const FEdge& a, const FEdge& b)
+            {
+                return a.m_end != b.m_end ? a.m_end < b.m_end : a.m_edge > b.m_edge;
+            });
+        });
 
-        for (uint32_t iFace = 0; iFace < triCount; ++iFace)
+        // Range of the edges that go from point rep a to point rep b
+        auto FindEdges = [&](T a, T b)
         {
-            uint32_t index = iFace * 3;
+            auto first = edges.cbegin() + bucketBegin[a];
+            auto last = edges.cbegin() + bucketBegin[a + 1];
+            first = std::lower_bound(first, last, b, [](const FEdge& edge, T value) { return edge.m_end < value; });
+            last = std::upper_bound(first, last, b, [](T value, const FEdge& edge) { return value < edge.m_end; });
+            return std::make_pair(first, last);
+        };
 
-            // Create a hash entry in the hash table for each each.
-            for (uint32_t iEdge = 0; iEdge < 3; ++iEdge)
+        // A manifold edge between two triangles that share nothing else can be matched independently of all other edges. Two 
+        // triangles on either side of an edge share another edge only if their third corners are welded together as well.
+        // The remaining edges are matched in triangle order afterwards, since the outcome depends on the order in which 
+        // candidates are taken.
+        std::vector<uint8_t> bMatchInOrder(indexCount, 1);
+        Parallel::For(0u, vertexCount, [&](uint32_t v)
+        {
+            for (uint32_t i = bucketBegin[v]; i < bucketBegin[v + 1]; ++i)
             {
-                T i0 = pointRep[indices[index + (iEdge % 3)]];
-                T i1 = pointRep[indices[index + ((iEdge + 1) % 3)]];
-                T i2 = pointRep[indices[index + ((iEdge + 2) % 3)]];
+                const FEdge& edge = edges[i];
+                adjacency[edge.m_edge] = uint32_t(-1);
 
-                auto& entry = entries[entryIndex++];
-                entry.i0 = i0;
-                entry.i1 = i1;
-                entry.i2 = i2;
+                const bool bUnique = (i == bucketBegin[v] || edges[i - 1].m_end != edge.m_end) && (i + 1 == bucketBegin[v + 1] || edges[i + 1].m_end != edge.m_end);
+                const uint32_t tri = edge.m_edge / 3;
+                if (!bUnique || IsDegenerate(tri))
+                    continue;
 
-                uint32_t key = entry.i0 % hashSize;
+                auto [first, last] = FindEdges(edge.m_end, static_cast<T>(v));
+                if (last - first != 1)
+                    continue;
 
-                entry.Next = hashTable[key];
-                entry.Face = iFace;
+                const uint32_t otherTri = first->m_edge / 3;
+                if (otherTri == tri || IsDegenerate(otherTri) || Rep(edge.m_edge, 2) == Rep(first->m_edge, 2))
+                    continue;
 
-                hashTable[key] = &entry;
+                adjacency[edge.m_edge] = otherTri;
+                bMatchInOrder[edge.m_edge] = 0;
             }
-        }
+        });
 
-
-        // Initialize the adjacency list
-        std::memset(adjacency, uint32_t(-1), indexCount * sizeof(uint32_t));
-
-        for (uint32_t iFace = 0; iFace < triCount; ++iFace)
+        auto ComputeNormal = [&](T p0, T p1, T p2)
         {
-            uint32_t index = iFace * 3;
+            XMVECTOR e0 = XMLoadFloat3(&positions[p0]) - XMLoadFloat3(&positions[p1]);
+            XMVECTOR e1 = XMLoadFloat3(&positions[p1]) - XMLoadFloat3(&positions[p2]);
+            return XMVector3Normalize(XMVector3Cross(e0, e1));
+        };
 
-            for (uint32_t point = 0; point < 3; ++point)
+        std::vector<uint8_t> bTaken(indexCount, 0);
+        for (uint32_t edge = 0; edge < indexCount; ++edge)
+        {
+            if (!bMatchInOrder[edge] || adjacency[edge] != uint32_t(-1))
+                continue;
+
+            const uint32_t tri = edge / 3;
+            const T i0 = Rep(edge, 1);
+            const T i1 = Rep(edge, 0);
+            const T i2 = Rep(edge, 2);
+
+            // Look for edges directed in the opposite direction, and pick the candidate whose normal is closest to this triangle's
+            auto [first, last] = FindEdges(i0, i1);
+            auto found = last;
+            float bestDot = -2.f;
+            const XMVECTOR n0 = ComputeNormal(i1, i0, i2);
+            for (auto it = first; it != last; ++it)
             {
-                if (adjacency[iFace * 3 + point] != uint32_t(-1))
-                    continue;
-
-                // Look for edges directed in the opposite direction.
-                T i0 = pointRep[indices[index + ((point + 1) % 3)]];
-                T i1 = pointRep[indices[index + (point % 3)]];
-                T i2 = pointRep[indices[index + ((point + 2) % 3)]];
-
-                // Find a face sharing this edge
-                uint32_t key = i0 % hashSize;
-
-                EdgeEntry* found = nullptr;
-                EdgeEntry* foundPrev = nullptr;
-
-                for (EdgeEntry* current = hashTable[key], *prev = nullptr; current != nullptr; prev = current, current = current->Next)
+                if (!bTaken[it->m_edge])
                 {
-                    if (current->i1 == i1 && current->i0 == i0)
+                    XMVECTOR n1 = ComputeNormal(Rep(it->m_edge, 0), Rep(it->m_edge, 1), Rep(it->m_edge, 2));
+                    float dot = XMVectorGetX(XMVector3Dot(n0, n1));
+                    if (found == last || dot > bestDot)
                     {
-                        found = current;
-                        foundPrev = prev;
-                        break;
+                        found = it;
+                        bestDot = dot;
                     }
                 }
+            }
 
-                // Cache this face's normal
-                XMVECTOR n0;
-                {
-                    XMVECTOR p0 = XMLoadFloat3(&positions[i1]);
-                    XMVECTOR p1 = XMLoadFloat3(&positions[i0]);
-                    XMVECTOR p2 = XMLoadFloat3(&positions[i2]);
+            if (found == last)
+                continue;
 
-                    XMVECTOR e0 = p0 - p1;
-                    XMVECTOR e1 = p1 - p2;
+            const uint32_t foundTri = found->m_edge / 3;
+            bTaken[found->m_edge] = 1;
+            adjacency[edge] = foundTri;
 
-                    n0 = XMVector3Normalize(XMVector3Cross(e0, e1));
-                }
+            // Take this triangle's own edge
+            auto [ownFirst, ownLast] = FindEdges(i1, i0);
+            auto own = std::find_if(ownFirst, ownLast, [&](const FEdge& e) { return !bTaken[e.m_edge] && e.m_edge / 3 == tri; });
+            if (own != ownLast)
+            {
+                bTaken[own->m_edge] = 1;
+            }
 
-                // Use face normal dot product to determine best edge-sharing candidate.
-                float bestDot = -2.0f;
-                for (EdgeEntry* current = found, *prev = foundPrev; current != nullptr; prev = current, current = current->Next)
+            // Triangles are only linked once, even if they share several edges
+            bool bLinked = false;
+            for (uint32_t corner = 0; corner < edge % 3; ++corner)
+            {
+                if (adjacency[tri * 3 + corner] == foundTri)
                 {
-                    if (bestDot == -2.0f || (current->i1 == i1 && current->i0 == i0))
-                    {
-                        XMVECTOR p0 = XMLoadFloat3(&positions[current->i0]);
-                        XMVECTOR p1 = XMLoadFloat3(&positions[current->i1]);
-                        XMVECTOR p2 = XMLoadFloat3(&positions[current->i2]);
-
-                        XMVECTOR e0 = p0 - p1;
-                        XMVECTOR e1 = p1 - p2;
-
-                        XMVECTOR n1 = XMVector3Normalize(XMVector3Cross(e0, e1));
-
-                        float dot = XMVectorGetX(XMVector3Dot(n0, n1));
-
-                        if (dot > bestDot)
-                        {
-                            found = current;
-                            foundPrev = prev;
-                            bestDot = dot;
-                        }
-                    }
+                    bLinked = true;
+                    adjacency[edge] = uint32_t(-1);
+                    break;
                 }
+            }
 
-                // Update hash table and adjacency list
-                if (found && found->Face != uint32_t(-1))
+            if (!bLinked)
+            {
+                for (uint32_t corner = 0; corner < 3; ++corner)
                 {
-                    // Erase the found from the hash table linked list.
-                    if (foundPrev != nullptr)
-                    {
-                        foundPrev->Next = found->Next;
-                    }
-                    else
-                    {
-                        hashTable[key] = found->Next;
-                    }
-
-                    // Update adjacency information
-                    adjacency[iFace * 3 + point] = found->Face;
-
-                    // Search & remove this face from the table linked list
-                    uint32_t key2 = i1 % hashSize;
-
-                    for (EdgeEntry* current = hashTable[key2], *prev = nullptr; current != nullptr; prev = current, current = current->Next)
-                    {
-                        if (current->Face == iFace && current->i1 == i0 && current->i0 == i1)
-                        {
-                            if (prev != nullptr)
-                            {
-                                prev->Next = current->Next;
-                            }
-                            else
-                            {
-                                hashTable[key2] = current->Next;
-                            }
-
-                            break;
-                        }
-                    }
-
-                    bool linked = false;
-                    for (uint32_t point2 = 0; point2 < point; ++point2)
-                    {
-                        if (found->Face == adjacency[iFace * 3 + point2])
-                        {
-                            linked = true;
-                            adjacency[iFace * 3 + point] = uint32_t(-1);
-                            break;
-                        }
-                    }
-
-                    if (!linked)
+                    if (pointRep[indices[foundTri * 3 + corner]] == i0)
                     {
-                        uint32_t edge2 = 0;
-                        for (; edge2 < 3; ++edge2)
-                        {
-                            T k = indices[found->Face * 3 + edge2];
-                            if (k == uint32_t(-1))
-                                continue;
-
-                            if (pointRep[k] == i0)
-                                break;
-                        }
-
-                        if (edge2 < 3)
-                        {
-                            adjacency[found->Face * 3 + edge2] = iFace;
-                        }
+                        adjacency[foundTri * 3 + corner] = tri;
+                        break;
                     }
                 }
             }
@@ -491,7 +710,7 @@ namespace
     }
 
     // Determines whether a candidate triangle can be added to a specific meshlet; if it can, does so.
-    bool AddToMeshlet(uint32_t maxVerts, uint32_t maxPrims, FInlineMeshlet& meshlet, uint32_t(&tri)[3])
+    bool AddToMeshlet(uint32_t maxVerts, uint32_t maxPrims, FInlineMeshlet& meshlet, FMeshletBuilder& builder, uint32_t(&tri)[3])
     {
         // Are we already full of vertices?
         if (meshlet.m_uniqueVertexIndices.size() == maxVerts)
@@ -501,19 +720,18 @@ namespace
         if (meshlet.m_primitiveIndices.size() == maxPrims)
             return false;
 
-        static const uint32_t Undef = uint32_t(-1);
+        static const uint32_t Undef = FMeshletBuilder::Undef;
         uint32_t indices[3] = { Undef, Undef, Undef };
-        uint32_t newCount = 3;
+        uint32_t newCount = 0;
 
-        for (uint32_t i = 0; i < meshlet.m_uniqueVertexIndices.size(); ++i)
+        for (uint32_t j = 0; j < 3; ++j)
         {
-            for (uint32_t j = 0; j < 3; ++j)
+            indices[j] = builder.FindSlot(tri[j]);
+
+            // Count new vertices once, even if the triangle is degenerate and references the same vertex more than once
+            if (indices[j] == Undef && (j == 0 || tri[j] != tri[0]) && (j < 2 || tri[j] != tri[1]))
             {
-                if (meshlet.m_uniqueVertexIndices[i] == tri[j])
-                {
-                    indices[j] = i;
-                    --newCount;
-                }
+                ++newCount;
             }
         }
 
@@ -524,10 +742,12 @@ namespace
         // Add unique vertex indices to unique vertex index list
         for (uint32_t j = 0; j < 3; ++j)
         {
+            indices[j] = builder.FindSlot(tri[j]);
             if (indices[j] == Undef)
             {
                 indices[j] = static_cast<uint32_t>(meshlet.m_uniqueVertexIndices.size());
                 meshlet.m_uniqueVertexIndices.push_back(tri[j]);
+                builder.SetSlot(tri[j], indices[j]);
             }
         }
 
@@ -550,18 +770,190 @@ namespace
         return meshlet.m_uniqueVertexIndices.size() == maxVerts
             || meshlet.m_primitiveIndices.size() == maxPrims;
     }
+
+    constexpr uint32_t ModelCacheMagic = 0x434c444d;    // "MDLC"
+    constexpr uint32_t ModelCacheVersion = 3;
+
+    template<typename T>
+    void WriteVector(std::ofstream& file, const std::vector<T>& data)
+    {
+        const uint64_t count = data.size();
+        file.write((const char*)&count, sizeof(count));
+        file.write((const char*)data.data(), count * sizeof(T));
+    }
+
+    // Fails instead of allocating if the count is more than what is left of the file, which only happens in damaged files
+    template<typename T>
+    bool ReadVector(std::ifstream& file, uint64_t fileSize, std::vector<T>& data)
+    {
+        uint64_t count = 0;
+        if (!file.read((char*)&count, sizeof(count)) || count > (fileSize - (uint64_t)file.tellg()) / sizeof(T))
+            return false;
+
+        data.resize(count);
+        return (bool)file.read((char*)data.data(), count * sizeof(T));
+    }
+
+    uint64_t HashAccessorList(const tinygltf::Model& model, std::span<const int> accessors, uint64_t seed)
+    {
+        uint64_t hash1 = seed, hash2 = seed;
+        spookyhash_context context;
+        spookyhash_context_init(&context, hash1, hash2);
+
+        for (int accessorIndex : accessors)
+        {
+            const int32_t absent = -1;
+            if (accessorIndex == -1)
+            {
+                spookyhash_update(&context, &absent, sizeof(absent));
+                continue;
+            }
+
+            const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+            const uint64_t layout[] = { (uint64_t)accessor.componentType, (uint64_t)accessor.type, (uint64_t)accessor.normalized, (uint64_t)accessor.count };
+            spookyhash_update(&context, layout, sizeof(layout));
+
+            // Accessors without a buffer view are all zeros
+            if (accessor.bufferView == -1)
+                continue;
+
+            const FAccessorView view = AccessorView::Get(model, accessorIndex);
+            const size_t elementSize = view.GetElementSize();
+            if (view.m_byteStride == elementSize)
+            {
+                spookyhash_update(&context, view.m_data, view.m_count * elementSize);
+            }
+            else
+            {
+                for (size_t i = 0; i < view.m_count; ++i)
+                {
+                    spookyhash_update(&context, view.GetElement(i), elementSize);
+                }
+            }
+        }
+
+        spookyhash_final(&context, &hash1, &hash2);
+        return hash1;
+    }
+
+    uint64_t HashAccessorList(const tinygltf::Model& model, std::span<const int> accessors, uint64_t seed, FModelCache& cache)
+    {
+        // The hash is remembered by the accessor indices and the seed
+        uint64_t hash1 = seed, hash2 = ModelCacheVersion;
+        spookyhash_context context;
+        spookyhash_context_init(&context, hash1, hash2);
+        spookyhash_update(&context, accessors.data(), accessors.size() * sizeof(int));
+        spookyhash_final(&context, &hash1, &hash2);
+
+        const uint64_t indicesKey = hash1;
+        if (const uint64_t* hash = cache.Find(cache.m_accessorHashes, indicesKey))
+            return *hash;
+
+        const uint64_t hash = HashAccessorList(model, accessors, seed);
+        cache.Insert(cache.m_accessorHashes, indicesKey, hash);
+        return hash;
+    }
+
+    // Bytes of a buffer that an accessor reads, from the first byte of its first element to the last byte of its last element
+    struct FAccessorBytes
+    {
+        const uint8_t* m_buffer = nullptr;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+        size_t m_byteStride = 0;
+        size_t m_elementSize = 0;
+    };
+
+    FAccessorBytes GetAccessorBytes(const tinygltf::Model& model, int accessorIndex)
+    {
+        const FAccessorView view = AccessorView::Get(model, accessorIndex);
+        if (view.IsEmpty())
+            return {};
+
+        const tinygltf::Buffer& buffer = model.buffers[model.bufferViews[model.accessors[accessorIndex].bufferView].buffer];
+        const size_t begin = (size_t)(view.m_data - buffer.data.data());
+        return { buffer.data.data(), begin, begin + (view.m_count - 1) * view.m_byteStride + view.GetElementSize(), view.m_byteStride, view.GetElementSize() };
+    }
+
+    bool Overlap(const FAccessorBytes& a, const FAccessorBytes& b)
+    {
+        return a.m_buffer != nullptr && a.m_buffer == b.m_buffer && a.m_begin < b.m_end && b.m_begin < a.m_end;
+    }
+
+    // Interleaved streams overlap, but each element of one falls between the elements of the other
+    bool Interleaved(const FAccessorBytes& a, const FAccessorBytes& b)
+    {
+        if (a.m_byteStride != b.m_byteStride || a.m_elementSize + b.m_elementSize > a.m_byteStride)
+            return false;
+
+        const size_t offset = (b.m_begin + a.m_byteStride - a.m_begin % a.m_byteStride) % a.m_byteStride;
+        return offset >= a.m_elementSize && offset + b.m_elementSize <= a.m_byteStride;
+    }
+
+    // Distinct accessors can still read the same bytes. Streams that are rewritten in place must not share their bytes with any 
+    // other accessor or image, and must not alias each other except by interleaving.
+    bool OwnsAccessorBytes(const tinygltf::Model& model, const std::vector<int>& accessors)
+    {
+        std::vector<FAccessorBytes> bytes;
+        for (int accessorIndex : accessors)
+        {
+            bytes.push_back(GetAccessorBytes(model, accessorIndex));
+        }
+
+        for (size_t i = 0; i < bytes.size(); ++i)
+        {
+            for (size_t j = i + 1; j < bytes.size(); ++j)
+            {
+                if (Overlap(bytes[i], bytes[j]) && !Interleaved(bytes[i], bytes[j]))
+                    return false;
+            }
+        }
+
+        for (int accessorIndex = 0; accessorIndex < (int)model.accessors.size(); ++accessorIndex)
+        {
+            if (std::find(accessors.cbegin(), accessors.cend(), accessorIndex) != accessors.cend())
+                continue;
+
+            const FAccessorBytes other = GetAccessorBytes(model, accessorIndex);
+            for (const FAccessorBytes& stream : bytes)
+            {
+                if (Overlap(stream, other))
+                    return false;
+            }
+        }
+
+        for (const tinygltf::Image& image : model.images)
+        {
+            if (image.bufferView == -1)
+                continue;
+
+            const tinygltf::BufferView& view = model.bufferViews[image.bufferView];
+            const FAccessorBytes imageBytes = { model.buffers[view.buffer].data.data(), view.byteOffset, view.byteOffset + view.byteLength };
+            for (const FAccessorBytes& stream : bytes)
+            {
+                if (Overlap(stream, imageBytes))
+                    return false;
+            }
+        }
+
+        return true;
+    }
 }
 
-namespace std
+void FModelCache::Clear()
 {
-    template <> struct hash<XMFLOAT3> { size_t operator()(const XMFLOAT3& v) const { return CRCHash(reinterpret_cast<const uint32_t*>(&v), sizeof(v) / 4); } };
+    m_accessorHashes.Clear();
+    m_tangents.Clear();
+    m_meshlets.Clear();
+    m_remappedPrimitives.Clear();
+    m_usedKeys.Clear();
+    m_bDirty = false;
 }
 
-bool MeshUtils::FixupMeshes(tinygltf::Model& model)
+bool MeshUtils::FixupMeshes(tinygltf::Model& model, FModelCache& cache)
 {
 	SCOPED_CPU_EVENT("fixup_meshes", PIX_COLOR_DEFAULT);
 
-	bool requiresResave = false;
 	std::vector<PrimitiveIdentifier> fixupPrimitives;
 
 	for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
@@ -572,7 +964,7 @@ bool MeshUtils::FixupMeshes(tinygltf::Model& model)
 		{
 			// Generate tangents if the material requires a normal map and the mesh doesn't include tangents
 			tinygltf::Primitive& primitive = mesh.primitives[primitiveIndex];
-			tinygltf::Material material = model.materials[primitive.material];
+			const tinygltf::Material& material = model.materials[primitive.material];
 			if (material.normalTexture.index != -1 && primitive.attributes.find("TANGENT") == primitive.attributes.cend())
 			{
 				// Get vert count based on the POSITION accessor
@@ -608,40 +1000,98 @@ bool MeshUtils::FixupMeshes(tinygltf::Model& model)
 				primId.m_meshIndex = meshIndex;
 				primId.m_primitiveIndex = primitiveIndex;
 				fixupPrimitives.push_back(primId);
-
-				requiresResave |= true;
 			}
 		}
 	}
 
-	concurrency::parallel_for_each(fixupPrimitives.begin(), fixupPrimitives.end(), [](PrimitiveIdentifier& primitive)
+	std::atomic<bool> requiresResave = false;
+	Parallel::ForEach(fixupPrimitives.begin(), fixupPrimitives.end(), [&cache, &requiresResave](PrimitiveIdentifier& primitive)
 	{
-		// Initialize MikkTSpace
-		SMikkTSpaceInterface tspaceInterface = {};
-		tspaceInterface.m_getNumFaces = &GetNumFaces;
-		tspaceInterface.m_getNumVerticesOfFace = &GetNumVerticesOfFace;
-		tspaceInterface.m_getPosition = &GetPosition;
-		tspaceInterface.m_getNormal = &GetNormal;
-		tspaceInterface.m_getTexCoord = &GetUV;
-		tspaceInterface.m_setTSpaceBasic = &SetTSpaceBasic;
-
-		SMikkTSpaceContext tspaceContext = {};
-		tspaceContext.m_pInterface = &tspaceInterface;
-		tspaceContext.m_pUserData = &primitive;
-
-		// Generate TSpace
-		genTangSpaceDefault(&tspaceContext);
-	});
+		const tinygltf::Model& model = *primitive.m_model;
+		const tinygltf::Primitive& source = model.meshes[primitive.m_meshIndex].primitives[primitive.m_primitiveIndex];
+		auto AttributeAccessor = [&source](const char* name)
+		{
+			auto it = source.attributes.find(name);
+			return it != source.attributes.cend() ? it->second : -1;
+		};
 
+		// Tangents depend on the normals and UVs as well as the triangles
+		const int tangentAccessor = AttributeAccessor("TANGENT");
+		const uint64_t cacheKey = HashAccessors(model, { source.indices, AttributeAccessor("POSITION"), AttributeAccessor("NORMAL"), AttributeAccessor("TEXCOORD_0") }, 0, cache);
+		std::vector<uint8_t>& tangentData = primitive.m_model->buffers[model.bufferViews[model.accessors[tangentAccessor].bufferView].buffer].data;
+
+		const std::vector<XMFLOAT4>* cachedTangents = cache.Find(cache.m_tangents, cacheKey);
+		if (cachedTangents && cachedTangents->size() * sizeof(XMFLOAT4) == tangentData.size())
+		{
+			memcpy(tangentData.data(), cachedTangents->data(), tangentData.size());
+			return;
+		}
+
+		// Streams are read in place where they are already tightly packed floats and 32-bit indices
+		std::vector<uint32_t> indexScratch;
+		std::span<const uint32_t> indices;
+		if (source.indices != -1)
+		{
+			indices = AccessorView::Read(AccessorView::Get(model, source.indices), indexScratch);
+		}
+		else
+		{
+			indexScratch.resize(model.accessors[AttributeAccessor("POSITION")].count);
+			std::iota(indexScratch.begin(), indexScratch.end(), 0);
+			indices = indexScratch;
+		}
+
+		std::vector<XMFLOAT3> positionScratch, normalScratch;
+		std::vector<XMFLOAT2> uvScratch;
+		const std::span<const XMFLOAT3> positions = AccessorView::Read(AccessorView::Get(model, AttributeAccessor("POSITION")), positionScratch);
+		const std::span<const XMFLOAT3> normals = AccessorView::Read(AccessorView::Get(model, AttributeAccessor("NORMAL")), normalScratch);
+		const std::span<const XMFLOAT2> uvs = AccessorView::Read(AccessorView::Get(model, AttributeAccessor("TEXCOORD_0")), uvScratch);
+
+		std::vector<XMFLOAT4> tangents(tangentData.size() / sizeof(XMFLOAT4));
+		GenerateTangents(indices.data(), indices.size(), positions.data(), normals.data(), uvs.data(), tangents.data());
+		memcpy(tangentData.data(), tangents.data(), tangentData.size());
+		cache.Insert(cache.m_tangents, cacheKey, std::move(tangents));
+		requiresResave = true;
+	});
 
 	return requiresResave;
 }
 
+void MeshUtils::GenerateTangents(const uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, const XMFLOAT3* normals, const XMFLOAT2* uvs, XMFLOAT4* tangents)
+{
+	DebugAssert(indexCount % 3 == 0);
+
+	FTangentSpaceStreams streams = {};
+	streams.m_indices = indices;
+	streams.m_faceCount = indexCount / 3;
+	streams.m_positions = positions;
+	streams.m_normals = normals;
+	streams.m_uvs = uvs;
+	streams.m_tangents = tangents;
+
+	// Initialize MikkTSpace
+	SMikkTSpaceInterface tspaceInterface = {};
+	tspaceInterface.m_getNumFaces = &GetNumFaces;
+	tspaceInterface.m_getNumVerticesOfFace = &GetNumVerticesOfFace;
+	tspaceInterface.m_getPosition = &GetPosition;
+	tspaceInterface.m_getNormal = &GetNormal;
+	tspaceInterface.m_getTexCoord = &GetUV;
+	tspaceInterface.m_setTSpaceBasic = &SetTSpaceBasic;
+
+	SMikkTSpaceContext tspaceContext = {};
+	tspaceContext.m_pInterface = &tspaceInterface;
+	tspaceContext.m_pUserData = &streams;
+
+	// Generate TSpace
+	genTangSpaceDefault(&tspaceContext);
+}
+
 void MeshUtils::Meshletize(
     uint32_t maxVerts, uint32_t maxPrims,
     const uint32_t* indices, uint32_t indexCount,
     const XMFLOAT3* positions, uint32_t vertexCount,
-    std::vector<FInlineMeshlet>& output
+    std::vector<FInlineMeshlet>& output,
+    bool bDeterministic
 )
 {
     const uint32_t triCount = indexCount / 3;
@@ -661,24 +1111,120 @@ void MeshUtils::Meshletize(
     std::vector<bool> checklist;
     checklist.resize(triCount);
 
-    std::vector<XMFLOAT3> m_positions;
-    std::vector<XMFLOAT3> normals;
-    std::vector<std::pair<uint32_t, float>> candidates;
-    std::unordered_set<uint32_t> candidateCheck;
+    FMeshletBuilder builder{ vertexCount };
+
+    // Candidate triangles are kept in a min-heap. Entries of triangles that were added to a meshlet, or that were popped and 
+    // rejected, no longer match the live version of their triangle. They are skipped when popped and dropped on the next rescore.
+    std::vector<FCandidate> candidates;
+    std::vector<uint32_t> liveVersion(triCount, 0);         // 0 if the triangle is not in the heap
+    std::vector<uint32_t> candidateGeneration(triCount, 0); // Builder generation in which the triangle last entered the heap
+    uint32_t versionCounter = 0;
+
+    XMVECTOR normalAxis = g_XMZero;
+    auto ScoreCandidate = [&](uint32_t tri)
+    {
+        uint32_t triIndices[3] =
+        {
+            indices[tri * 3],
+            indices[tri * 3 + 1],
+            indices[tri * 3 + 2],
+        };
+
+        assert(triIndices[0] < vertexCount);
+        assert(triIndices[1] < vertexCount);
+        assert(triIndices[2] < vertexCount);
+
+        XMFLOAT3 triVerts[3] =
+        {
+            positions[triIndices[0]],
+            positions[triIndices[1]],
+            positions[triIndices[2]],
+        };
+
+        return QuantizeScore(ComputeScore(builder, builder.m_positionSphere, normalAxis, triIndices, triVerts), bDeterministic);
+    };
+
+    auto PushCandidate = [&](uint32_t tri, float score)
+    {
+        liveVersion[tri] = ++versionCounter;
+        candidateGeneration[tri] = builder.m_generation;
+        candidates.push_back({ score, tri, liveVersion[tri] });
+        std::push_heap(candidates.begin(), candidates.end(), &CompareCandidates);
+    };
+
+    // Drop stale entries from the top of the heap, so that an empty heap means there are no live candidates left
+    auto PruneStaleCandidates = [&]()
+    {
+        while (!candidates.empty() && (checklist[candidates.front().m_triIndex] || liveVersion[candidates.front().m_triIndex] != candidates.front().m_version))
+        {
+            std::pop_heap(candidates.begin(), candidates.end(), &CompareCandidates);
+            candidates.pop_back();
+        }
+    };
+
+    auto PopCandidate = [&](uint32_t& tri) -> bool
+    {
+        PruneStaleCandidates();
+        if (candidates.empty())
+            return false;
+
+        std::pop_heap(candidates.begin(), candidates.end(), &CompareCandidates);
+        tri = candidates.back().m_triIndex;
+        candidates.pop_back();
+        liveVersion[tri] = 0;
+        return true;
+    };
+
+    // Every score depends on the meshlet bounds and normal axis, and on which of the candidate's vertices are in the meshlet. After 
+    // an insertion, the live entries whose inputs changed are rescored in place and the heap is rebuilt, which also drops the stale 
+    // entries. When the bounds didn't grow, only the candidates that share one of the newly added vertices are affected.
+    auto RescoreCandidates = [&](bool bBoundsChanged, const uint32_t(&newVertices)[3], uint32_t newVertexCount)
+    {
+        auto IsAffected = [&](uint32_t tri)
+        {
+            for (uint32_t i = 0; i < newVertexCount; ++i)
+            {
+                if (indices[tri * 3] == newVertices[i] || indices[tri * 3 + 1] == newVertices[i] || indices[tri * 3 + 2] == newVertices[i])
+                    return true;
+            }
+
+            return false;
+        };
+
+        size_t liveCount = 0;
+        for (const FCandidate& candidate : candidates)
+        {
+            if (checklist[candidate.m_triIndex] || liveVersion[candidate.m_triIndex] != candidate.m_version)
+                continue;
+
+            FCandidate& live = candidates[liveCount++];
+            live = candidate;
+            if (bBoundsChanged || IsAffected(live.m_triIndex))
+            {
+                live.m_score = ScoreCandidate(live.m_triIndex);
+            }
+        }
+
+        candidates.resize(liveCount);
+        std::make_heap(candidates.begin(), candidates.end(), &CompareCandidates);
+    };
 
-    XMVECTOR psphere, normal;
+    auto StartNewMeshlet = [&]()
+    {
+        builder.Reset();
+        candidates.clear();
+        output.emplace_back();
+        curr = &output.back();
+    };
 
     // Arbitrarily start at triangle zero.
     uint32_t triIndex = 0;
-    candidates.push_back(std::make_pair(triIndex, 0.0f));
-    candidateCheck.insert(triIndex);
+    PushCandidate(triIndex, 0.0f);
 
     // Continue adding triangles until 
-    while (!candidates.empty())
+    uint32_t index;
+    while (PopCandidate(index))
     {
-        uint32_t index = candidates.back().first;
-        candidates.pop_back();
-
         uint32_t tri[3] =
         {
             indices[index * 3 + 2],
@@ -690,13 +1236,24 @@ void MeshUtils::Meshletize(
         assert(tri[1] < vertexCount);
         assert(tri[2] < vertexCount);
 
+        // Vertices that the triangle adds to the meshlet, if it fits
+        uint32_t newVertices[3];
+        uint32_t newVertexCount = 0;
+        for (uint32_t i = 0; i < 3u; ++i)
+        {
+            if (builder.FindSlot(tri[i]) == FMeshletBuilder::Undef && std::find(newVertices, newVertices + newVertexCount, tri[i]) == newVertices + newVertexCount)
+            {
+                newVertices[newVertexCount++] = tri[i];
+            }
+        }
+
         // Try to add triangle to meshlet
-        if (AddToMeshlet(maxVerts, maxPrims, *curr, tri))
+        if (AddToMeshlet(maxVerts, maxPrims, *curr, builder, tri))
         {
             // Success! Mark as added.
             checklist[index] = true;
 
-            // Add m_positions & normal to list
+            // Grow the meshlet bounding sphere & normal axis
             XMFLOAT3 points[3] =
             {
                 positions[tri[0]],
@@ -704,116 +1261,68 @@ void MeshUtils::Meshletize(
                 positions[tri[2]],
             };
 
-            m_positions.push_back(points[0]);
-            m_positions.push_back(points[1]);
-            m_positions.push_back(points[2]);
-
-            XMFLOAT3 Normal;
-            XMStoreFloat3(&Normal, ComputeNormal(points));
-            normals.push_back(Normal);
-
-            // Compute new bounding sphere & normal axis
-            psphere = MinimumBoundingSphere(m_positions.data(), static_cast<uint32_t>(m_positions.size()));
-            
-            // SRS - Cache the bounding sphere for visibility checks
-            XMFLOAT4 currBounds;
-            XMStoreFloat4(&currBounds, psphere);
-            curr->m_boundingSphere = BoundingSphere(XMFLOAT3{ currBounds.x, currBounds.y, currBounds.z }, currBounds.w);
-
-            XMVECTOR nsphere = MinimumBoundingSphere(normals.data(), static_cast<uint32_t>(normals.size()));
-            normal = XMVector3Normalize(nsphere);
-
-            // Find and add all applicable adjacent triangles to candidate list
-            const uint32_t adjIndex = index * 3;
-
-            uint32_t adj[3] =
-            {
-                adjacency[adjIndex],
-                adjacency[adjIndex + 1],
-                adjacency[adjIndex + 2],
-            };
+            const XMVECTOR previousPositionSphere = builder.m_positionSphere;
+            const XMVECTOR previousNormalSphere = builder.m_normalSphere;
+            builder.AddTriangle(points, ComputeNormal(points));
+            const bool bBoundsChanged = !XMVector4Equal(previousPositionSphere, builder.m_positionSphere) || !XMVector4Equal(previousNormalSphere, builder.m_normalSphere);
+            normalAxis = builder.GetNormalAxis();
+            RescoreCandidates(bBoundsChanged, newVertices, newVertexCount);
 
-            for (uint32_t i = 0; i < 3u; ++i)
+            // Determine whether we need to move to the next meshlet.
+            if (IsMeshletFull(maxVerts, maxPrims, *curr))
             {
-                // Invalid triangle in adjacency slot
-                if (adj[i] == -1)
-                    continue;
-
-                // Already processed triangle
-                if (checklist[adj[i]])
-                    continue;
+                // Use the best remaining candidate as the next meshlet seed.
+                uint32_t seed;
+                const bool bHasSeed = PopCandidate(seed);
 
-                // Triangle already in the candidate list
-                if (candidateCheck.count(adj[i]))
-                    continue;
+                StartNewMeshlet();
 
-                candidates.push_back(std::make_pair(adj[i], FLT_MAX));
-                candidateCheck.insert(adj[i]);
+                if (bHasSeed)
+                {
+                    PushCandidate(seed, 0.0f);
+                }
             }
-
-            // Re-score remaining candidate triangles
-            for (uint32_t i = 0; i < static_cast<uint32_t>(candidates.size()); ++i)
+            else
             {
-                uint32_t candidate = candidates[i].first;
+                // Add the adjacent triangles to the candidate heap. Those that are already in it were rescored above.
+                const uint32_t adjIndex = index * 3;
 
-                uint32_t triIndices[3] =
+                uint32_t adj[3] =
                 {
-                    indices[candidate * 3],
-                    indices[candidate * 3 + 1],
-                    indices[candidate * 3 + 2],
+                    adjacency[adjIndex],
+                    adjacency[adjIndex + 1],
+                    adjacency[adjIndex + 2],
                 };
 
-                assert(triIndices[0] < vertexCount);
-                assert(triIndices[1] < vertexCount);
-                assert(triIndices[2] < vertexCount);
-
-                XMFLOAT3 triVerts[3] =
+                for (uint32_t i = 0; i < 3u; ++i)
                 {
-                    positions[triIndices[0]],
-                    positions[triIndices[1]],
-                    positions[triIndices[2]],
-                };
+                    // Invalid triangle in adjacency slot
+                    if (adj[i] == -1)
+                        continue;
 
-                candidates[i].second = ComputeScore(*curr, psphere, normal, triIndices, triVerts);
-            }
+                    // Already processed triangle
+                    if (checklist[adj[i]])
+                        continue;
 
-            // Determine whether we need to move to the next meshlet.
-            if (IsMeshletFull(maxVerts, maxPrims, *curr))
-            {
-                m_positions.clear();
-                normals.clear();
-                candidateCheck.clear();
+                    // Triangle was already tried and rejected for this meshlet, or is a live candidate
+                    if (candidateGeneration[adj[i]] == builder.m_generation)
+                        continue;
 
-                // Use one of our existing candidates as the next meshlet seed.
-                if (!candidates.empty())
-                {
-                    candidates[0] = candidates.back();
-                    candidates.resize(1);
-                    candidateCheck.insert(candidates[0].first);
+                    PushCandidate(adj[i], ScoreCandidate(adj[i]));
                 }
-
-                output.emplace_back();
-                curr = &output.back();
-            }
-            else
-            {
-                std::sort(candidates.begin(), candidates.end(), &CompareScores);
             }
         }
         else
         {
+            PruneStaleCandidates();
             if (candidates.empty())
             {
-                m_positions.clear();
-                normals.clear();
-                candidateCheck.clear();
-
-                output.emplace_back();
-                curr = &output.back();
+                StartNewMeshlet();
             }
         }
 
         // Ran out of candidates; add a new seed candidate to start the next meshlet.
+        PruneStaleCandidates();
         if (candidates.empty())
         {
             while (triIndex < triCount && checklist[triIndex])
@@ -822,8 +1331,7 @@ void MeshUtils::Meshletize(
             if (triIndex == triCount)
                 break;
 
-            candidates.push_back(std::make_pair(triIndex, 0.0f));
-            candidateCheck.insert(triIndex);
+            PushCandidate(triIndex, 0.0f);
         }
     }
 
@@ -832,4 +1340,1321 @@ void MeshUtils::Meshletize(
     {
         output.pop_back();
     }
-}
\ No newline at end of file
+
+    // The incrementally grown spheres are only used for scoring. Fit the final bounds once per meshlet over its unique vertices. 
+    // Every triangle corner is one of them, so the sphere encloses the whole meshlet, but like any Ritter sphere it is only an 
+    // approximation of the smallest one and depends on the order of the points.
+    std::vector<XMFLOAT3> meshletPositions;
+    meshletPositions.reserve(maxVerts);
+    for (FInlineMeshlet& meshlet : output)
+    {
+        meshletPositions.clear();
+        for (uint32_t vertexIndex : meshlet.m_uniqueVertexIndices)
+        {
+            meshletPositions.push_back(positions[vertexIndex]);
+        }
+
+        XMFLOAT4 bounds;
+        XMStoreFloat4(&bounds, MinimumBoundingSphere(meshletPositions.data(), static_cast<uint32_t>(meshletPositions.size())));
+        meshlet.m_boundingSphere = BoundingSphere(XMFLOAT3{ bounds.x, bounds.y, bounds.z }, bounds.w);
+        meshlet.m_normalCone = ComputeNormalCone(meshlet, positions);
+    }
+}
+
+void MeshUtils::MeshletizeParallel(
+    uint32_t maxVerts, uint32_t maxPrims,
+    const uint32_t* indices, uint32_t indexCount,
+    const XMFLOAT3* positions, uint32_t vertexCount,
+    uint32_t chunkTriangleCount,
+    std::vector<FInlineMeshlet>& output,
+    bool bDeterministic
+)
+{
+    const uint32_t triCount = indexCount / 3;
+    if (chunkTriangleCount == 0 || triCount <= chunkTriangleCount)
+    {
+        Meshletize(maxVerts, maxPrims, indices, indexCount, positions, vertexCount, output, bDeterministic);
+        return;
+    }
+
+    SCOPED_CPU_EVENT("meshletize_parallel", PIX_COLOR_DEFAULT);
+
+    // Triangle centroids and their bounds
+    std::vector<XMFLOAT3> centroids(triCount);
+    Parallel::For(0u, triCount, [&](uint32_t triIndex)
+    {
+        XMVECTOR p0 = XMLoadFloat3(&positions[indices[triIndex * 3]]);
+        XMVECTOR p1 = XMLoadFloat3(&positions[indices[triIndex * 3 + 1]]);
+        XMVECTOR p2 = XMLoadFloat3(&positions[indices[triIndex * 3 + 2]]);
+        XMStoreFloat3(&centroids[triIndex], (p0 + p1 + p2) / 3.f);
+    });
+
+    XMVECTOR boundsMin = g_XMFltMax;
+    XMVECTOR boundsMax = -g_XMFltMax;
+    for (const XMFLOAT3& centroid : centroids)
+    {
+        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&centroid));
+        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&centroid));
+    }
+
+    // Scale all axes by the largest extent, so that the curve keeps the mesh's proportions. Normalizing each axis on its own
+    // would give the noise across a thin, flat mesh as much weight as its length.
+    XMFLOAT3 origin, extent;
+    XMStoreFloat3(&origin, boundsMin);
+    XMStoreFloat3(&extent, boundsMax - boundsMin);
+    const float maxExtent = std::max({ extent.x, extent.y, extent.z });
+    const float invExtent = maxExtent > 0.f ? 1.f / maxExtent : 0.f;
+
+    // Sort triangles along a Morton curve. The triangle index is in the low bits of the key, which makes the order unique.
+    std::vector<uint64_t> sortKeys(triCount);
+    Parallel::For(0u, triCount, [&](uint32_t triIndex)
+    {
+        const XMFLOAT3& c = centroids[triIndex];
+        uint32_t code = MortonCode3D((c.x - origin.x) * invExtent, (c.y - origin.y) * invExtent, (c.z - origin.z) * invExtent);
+        sortKeys[triIndex] = ((uint64_t)code << 32) | triIndex;
+    });
+
+    Parallel::Sort(sortKeys.begin(), sortKeys.end());
+
+    // Meshletize spatially coherent runs of triangles independently
+    const uint32_t chunkCount = (triCount + chunkTriangleCount - 1) / chunkTriangleCount;
+    std::vector<std::vector<FInlineMeshlet>> chunkMeshlets(chunkCount);
+    Parallel::For(0u, chunkCount, [&](uint32_t chunkIndex)
+    {
+        const uint32_t triBegin = chunkIndex * chunkTriangleCount;
+        const uint32_t triEnd = std::min(triBegin + chunkTriangleCount, triCount);
+
+        std::vector<uint32_t> chunkIndices;
+        chunkIndices.reserve((triEnd - triBegin) * 3);
+        for (uint32_t i = triBegin; i < triEnd; ++i)
+        {
+            const uint32_t triIndex = (uint32_t)(sortKeys[i] & 0xFFFFFFFF);
+            chunkIndices.push_back(indices[triIndex * 3]);
+            chunkIndices.push_back(indices[triIndex * 3 + 1]);
+            chunkIndices.push_back(indices[triIndex * 3 + 2]);
+        }
+
+        // Compact the referenced vertices so that the per-chunk working set doesn't scale with the full vertex count
+        std::vector<uint32_t> chunkVertices = chunkIndices;
+        std::sort(chunkVertices.begin(), chunkVertices.end());
+        chunkVertices.erase(std::unique(chunkVertices.begin(), chunkVertices.end()), chunkVertices.end());
+
+        std::vector<XMFLOAT3> chunkPositions(chunkVertices.size());
+        for (size_t i = 0; i < chunkVertices.size(); ++i)
+        {
+            chunkPositions[i] = positions[chunkVertices[i]];
+        }
+
+        for (uint32_t& index : chunkIndices)
+        {
+            index = (uint32_t)(std::lower_bound(chunkVertices.cbegin(), chunkVertices.cend(), index) - chunkVertices.cbegin());
+        }
+
+        std::vector<FInlineMeshlet>& meshlets = chunkMeshlets[chunkIndex];
+        Meshletize(
+            maxVerts, maxPrims,
+            chunkIndices.data(), (uint32_t)chunkIndices.size(),
+            chunkPositions.data(), (uint32_t)chunkPositions.size(),
+            meshlets,
+            bDeterministic);
+
+        // Map back to the primitive's vertex indices
+        for (FInlineMeshlet& meshlet : meshlets)
+        {
+            for (uint32_t& vertexIndex : meshlet.m_uniqueVertexIndices)
+            {
+                vertexIndex = chunkVertices[vertexIndex];
+            }
+        }
+    });
+
+    // Stitch the chunks together in chunk order so that the result doesn't depend on scheduling
+    size_t meshletCount = 0;
+    for (const auto& meshlets : chunkMeshlets)
+    {
+        meshletCount += meshlets.size();
+    }
+
+    output.clear();
+    output.reserve(meshletCount);
+    for (auto& meshlets : chunkMeshlets)
+    {
+        std::move(meshlets.begin(), meshlets.end(), std::back_inserter(output));
+    }
+}
+
+void MeshUtils::WeldPositions(const XMFLOAT3* positions, uint32_t vertexCount, std::vector<uint32_t>& pointRep)
+{
+    ::WeldPositions(positions, vertexCount, pointRep);
+}
+
+void MeshUtils::WeldVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<uint32_t>& pointRep)
+{
+    auto posIt = primitive.attributes.find("POSITION");
+    if (posIt == primitive.attributes.cend())
+    {
+        pointRep.clear();
+        return;
+    }
+
+    std::vector<XMFLOAT3> positionScratch;
+    const std::span<const XMFLOAT3> positions = AccessorView::Read(AccessorView::Get(model, posIt->second), positionScratch);
+    const uint32_t vertexCount = (uint32_t)positions.size();
+
+    // Exporters write normals with float noise between the corners of a smooth vertex, and per-face tangents even where the
+    // normal and uv are shared. Normals are compared with a tolerance, and tangents are left out since they follow from both.
+    constexpr float NormalTolerance = 1.f / 64.f;
+    std::vector<std::pair<std::vector<XMFLOAT4>, float>> streams;
+    for (const auto& [name, accessorIndex] : primitive.attributes)
+    {
+        const FAccessorView view = AccessorView::Get(model, accessorIndex);
+        if (name == "POSITION" || name == "TANGENT" || view.m_count < vertexCount)
+            continue;
+
+        std::vector<XMFLOAT4> values(view.m_count);
+        AccessorView::ConvertFloats(view, 4, (float*)values.data());
+        streams.emplace_back(std::move(values), name == "NORMAL" ? NormalTolerance : 0.f);
+    }
+
+    auto Matches = [&streams](uint32_t a, uint32_t b)
+    {
+        return std::all_of(streams.cbegin(), streams.cend(), [a, b](const auto& stream)
+            {
+                const auto& [values, tolerance] = stream;
+                return std::abs(values[a].x - values[b].x) <= tolerance &&
+                    std::abs(values[a].y - values[b].y) <= tolerance &&
+                    std::abs(values[a].z - values[b].z) <= tolerance &&
+                    std::abs(values[a].w - values[b].w) <= tolerance;
+            });
+    };
+
+    // Compare each vertex against the reps found so far among the vertices at its position
+    std::vector<uint32_t> positionRep;
+    ::WeldPositions(positions.data(), vertexCount, positionRep);
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> repsAtPosition;
+    pointRep.resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        std::vector<uint32_t>& reps = repsAtPosition[positionRep[v]];
+        auto repIt = std::find_if(reps.cbegin(), reps.cend(), [&](uint32_t rep) { return Matches(v, rep); });
+        if (repIt != reps.cend())
+        {
+            pointRep[v] = *repIt;
+        }
+        else
+        {
+            pointRep[v] = v;
+            reps.push_back(v);
+        }
+    }
+}
+
+void MeshUtils::BuildAdjacency(const uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, uint32_t vertexCount, uint32_t* adjacency)
+{
+    BuildAdjacencyList(indices, indexCount, positions, vertexCount, adjacency);
+}
+
+uint32_t MeshUtils::PackNormalCone(int8_t axisX, int8_t axisY, int8_t axisZ, int8_t cutoff)
+{
+    return (uint32_t)(uint8_t)axisX | ((uint32_t)(uint8_t)axisY << 8) | ((uint32_t)(uint8_t)axisZ << 16) | ((uint32_t)(uint8_t)cutoff << 24);
+}
+
+XMINT4 MeshUtils::UnpackNormalCone(uint32_t normalCone)
+{
+    // asint(uint4(packedCone << 24, packedCone << 16, packedCone << 8, packedCone)) >> 24
+    return XMINT4{
+        (int32_t)(normalCone << 24) >> 24,
+        (int32_t)(normalCone << 16) >> 24,
+        (int32_t)(normalCone << 8) >> 24,
+        (int32_t)normalCone >> 24 };
+}
+
+bool MeshUtils::ConeCull(const DirectX::BoundingSphere& bounds, uint32_t normalCone, const Matrix& localToWorld, const Vector3& eyePos)
+{
+    const XMINT4 cone = UnpackNormalCone(normalCone);
+    const float cutoff = cone.w / 127.f;
+
+    // Bring the eye into object space so that the test holds under non-uniform scale
+    const Vector3 r0 = { localToWorld._11, localToWorld._12, localToWorld._13 };
+    const Vector3 r1 = { localToWorld._21, localToWorld._22, localToWorld._23 };
+    const Vector3 r2 = { localToWorld._31, localToWorld._32, localToWorld._33 };
+    const Vector3 d = eyePos - localToWorld.Translation();
+    const float det = r0.Dot(r1.Cross(r2));
+    const Vector3 eye = Vector3{ d.Dot(r1.Cross(r2)), d.Dot(r2.Cross(r0)), d.Dot(r0.Cross(r1)) } / det;
+
+    // A mirroring transform flips the winding seen by the rasterizer, and with it the side that gets culled.
+    // The RH to LH root transform is a mirror, so that is the common case.
+    Vector3 axis = Vector3{ (float)cone.x, (float)cone.y, (float)cone.z };
+    axis.Normalize();
+    axis = det < 0.f ? axis : -axis;
+
+    const Vector3 center = bounds.Center;
+    const Vector3 view = center - eye;
+    return view.Dot(axis) < cutoff * view.Length() + bounds.Radius;
+}
+void MeshUtils::ComputeBounds(const uint8_t* positions, uint32_t count, uint32_t stride, DirectX::BoundingBox& outBox, DirectX::BoundingSphere& outSphere)
+{
+    if (count == 0)
+    {
+        outBox = {};
+        outSphere = {};
+        return;
+    }
+
+    const FExtremePoints extremes = FindExtremePoints(positions, count, stride);
+
+    // Seed with the most distant pair of extreme points
+    XMVECTOR p1 = g_XMZero, p2 = g_XMZero;
+    float maxDistSq = -1.f;
+    auto TrySeed = [&](uint32_t i1, uint32_t i2)
+    {
+        const XMVECTOR a = LoadPosition(positions, stride, i1);
+        const XMVECTOR b = LoadPosition(positions, stride, i2);
+        const float distSq = XMVectorGetX(XMVector3LengthSq(b - a));
+        if (distSq > maxDistSq)
+        {
+            maxDistSq = distSq;
+            p1 = a;
+            p2 = b;
+        }
+    };
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        TrySeed(extremes.m_axisMin[i], extremes.m_axisMax[i]);
+    }
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        TrySeed(extremes.m_diagonalMin[i], extremes.m_diagonalMax[i]);
+    }
+
+    const XMVECTOR select0001 = XMVectorSelectControl(0, 0, 0, 1);
+    XMVECTOR sphere = XMVectorSelect((p1 + p2) * 0.5f, XMVector3Length(p2 - p1) * 0.5f, select0001);
+    sphere = GrowBoundingSphere(sphere, positions, count, stride, 0);
+
+    // Iterative refinement (Larsson 2008, "Fast and Tight Fitting Bounding Spheres"). Shrink the best sphere and let it regrow 
+    // over the points from a different starting point each time, which pulls the center towards the points that Ritter's 
+    // pass overshot. The result is kept only if it is smaller.
+    constexpr uint32_t refinementPasses = 4;
+    for (uint32_t pass = 0; pass < refinementPasses; ++pass)
+    {
+        const float shrink = 1.f - 0.05f / (pass + 1);
+        const XMVECTOR candidate = GrowBoundingSphere(sphere * XMVectorSet(1.f, 1.f, 1.f, shrink), positions, count, stride, (uint32_t)((uint64_t)count * (pass + 1) / (refinementPasses + 1)));
+        sphere = XMVectorGetW(candidate) < XMVectorGetW(sphere) ? candidate : sphere;
+    }
+
+    outBox = {};
+    BoundingBox::CreateFromPoints(outBox, XMLoadFloat3(&extremes.m_min), XMLoadFloat3(&extremes.m_max));
+
+    // Never looser than the sphere around the AABB, which is what the bounds used to be
+    XMFLOAT4 fit;
+    XMStoreFloat4(&fit, sphere);
+    const float boxRadius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&outBox.Extents)));
+    if (boxRadius <= fit.w)
+    {
+        fit = XMFLOAT4{ outBox.Center.x, outBox.Center.y, outBox.Center.z, boxRadius };
+    }
+
+    // Pad by a few ulps of the coordinate magnitude to absorb rounding in the Ritter updates
+    const float magnitude = XMVectorGetX(XMVector3Length(XMVectorSet(fit.x, fit.y, fit.z, 0.f))) + fit.w;
+    outSphere = BoundingSphere(XMFLOAT3{ fit.x, fit.y, fit.z }, fit.w + 4.f * FLT_EPSILON * magnitude);
+}
+
+void MeshUtils::ReadIndices(const tinygltf::Model& model, int accessorIndex, std::vector<uint32_t>& output)
+{
+    const FAccessorView view = AccessorView::Get(model, accessorIndex);
+    output.resize(view.m_count);
+    AccessorView::ConvertIndices(view, output.data());
+}
+
+void MeshUtils::WriteIndices(tinygltf::Model& model, int accessorIndex, const std::vector<uint32_t>& indices)
+{
+    const FMutableAccessorView view = AccessorView::GetMutable(model, accessorIndex);
+    DebugAssert(indices.size() == view.m_count, "Index count mismatch");
+    AccessorView::WriteIndices(view, indices.data());
+}
+
+void MeshUtils::ReadPositions(const tinygltf::Model& model, int accessorIndex, std::vector<XMFLOAT3>& output)
+{
+    const FAccessorView view = AccessorView::Get(model, accessorIndex);
+    output.resize(view.m_count);
+    AccessorView::ConvertFloats(view, 3, &output.data()->x);
+}
+
+void MeshUtils::ReadTexcoords(const tinygltf::Model& model, int accessorIndex, std::vector<XMFLOAT2>& output)
+{
+    const FAccessorView view = AccessorView::Get(model, accessorIndex);
+    output.resize(view.m_count);
+    AccessorView::ConvertFloats(view, 2, &output.data()->x);
+}
+
+std::vector<int> MeshUtils::CountAccessorReferences(const tinygltf::Model& model)
+{
+    std::vector<int> refCounts(model.accessors.size(), 0);
+    for (const tinygltf::Mesh& mesh : model.meshes)
+    {
+        for (const tinygltf::Primitive& primitive : mesh.primitives)
+        {
+            if (primitive.indices != -1)
+            {
+                refCounts[primitive.indices]++;
+            }
+
+            for (const auto& [name, accessorIndex] : primitive.attributes)
+            {
+                refCounts[accessorIndex]++;
+            }
+
+            for (const auto& target : primitive.targets)
+            {
+                for (const auto& [name, accessorIndex] : target)
+                {
+                    refCounts[accessorIndex]++;
+                }
+            }
+        }
+    }
+
+    return refCounts;
+}
+
+bool MeshUtils::CanRemapPrimitiveVertices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::vector<int>& accessorRefCounts)
+{
+    if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || !primitive.targets.empty())
+        return false;
+
+    bool bExclusive = accessorRefCounts[primitive.indices] == 1;
+    std::vector<int> accessors = { primitive.indices };
+    for (const auto& [name, accessorIndex] : primitive.attributes)
+    {
+        bExclusive &= accessorRefCounts[accessorIndex] == 1 && !model.accessors[accessorIndex].sparse.isSparse;
+        accessors.push_back(accessorIndex);
+    }
+
+    return bExclusive && OwnsAccessorBytes(model, accessors);
+}
+
+bool MeshUtils::CanReorderPrimitiveTriangles(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::vector<int>& accessorRefCounts)
+{
+    if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || primitive.attributes.count("POSITION") == 0)
+        return false;
+
+    return accessorRefCounts[primitive.indices] == 1 && 
+        !model.accessors[primitive.indices].sparse.isSparse && 
+        OwnsAccessorBytes(model, { primitive.indices });
+}
+
+void MeshUtils::SortMeshlets(std::vector<FInlineMeshlet>& meshlets)
+{
+    if (meshlets.size() < 2)
+        return;
+
+    XMVECTOR boundsMin = g_XMFltMax;
+    XMVECTOR boundsMax = -g_XMFltMax;
+    for (const FInlineMeshlet& meshlet : meshlets)
+    {
+        boundsMin = XMVectorMin(boundsMin, XMLoadFloat3(&meshlet.m_boundingSphere.Center));
+        boundsMax = XMVectorMax(boundsMax, XMLoadFloat3(&meshlet.m_boundingSphere.Center));
+    }
+
+    // Scale all axes by the largest extent, so that the curve keeps the mesh's proportions. Normalizing each axis on its own
+    // would give the noise across a thin, flat mesh as much weight as its length.
+    XMFLOAT3 origin, extent;
+    XMStoreFloat3(&origin, boundsMin);
+    XMStoreFloat3(&extent, boundsMax - boundsMin);
+    const float maxExtent = std::max({ extent.x, extent.y, extent.z });
+    const float invExtent = maxExtent > 0.f ? 1.f / maxExtent : 0.f;
+
+    // The meshlet index in the low bits keeps the order stable for meshlets that share a code
+    std::vector<uint64_t> sortKeys(meshlets.size());
+    for (size_t i = 0; i < meshlets.size(); ++i)
+    {
+        const XMFLOAT3& c = meshlets[i].m_boundingSphere.Center;
+        uint32_t code = MortonCode3D((c.x - origin.x) * invExtent, (c.y - origin.y) * invExtent, (c.z - origin.z) * invExtent);
+        sortKeys[i] = ((uint64_t)code << 32) | i;
+    }
+
+    std::sort(sortKeys.begin(), sortKeys.end());
+
+    std::vector<FInlineMeshlet> sorted;
+    sorted.reserve(meshlets.size());
+    for (uint64_t key : sortKeys)
+    {
+        sorted.push_back(std::move(meshlets[key & 0xFFFFFFFF]));
+    }
+
+    meshlets = std::move(sorted);
+}
+
+void MeshUtils::RemapPrimitiveVertices(tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<FInlineMeshlet>& meshlets)
+{
+    SCOPED_CPU_EVENT("remap_primitive_vertices", PIX_COLOR_DEFAULT);
+
+    auto posIt = primitive.attributes.find("POSITION");
+    DebugAssert(posIt != primitive.attributes.cend());
+    const uint32_t vertexCount = (uint32_t)model.accessors[posIt->second].count;
+
+    // Assign new vertex indices in order of first use. Vertices that no meshlet references keep their relative order at the end.
+    const uint32_t Undef = ~0u;
+    std::vector<uint32_t> remap(vertexCount, Undef);
+    uint32_t nextIndex = 0;
+    for (const FInlineMeshlet& meshlet : meshlets)
+    {
+        for (uint32_t vertexIndex : meshlet.m_uniqueVertexIndices)
+        {
+            if (remap[vertexIndex] == Undef)
+            {
+                remap[vertexIndex] = nextIndex++;
+            }
+        }
+    }
+
+    for (uint32_t& newIndex : remap)
+    {
+        if (newIndex == Undef)
+        {
+            newIndex = nextIndex++;
+        }
+    }
+
+    // Permute each vertex attribute stream in place
+    std::vector<uint8_t> scratch;
+    for (const auto& [name, accessorIndex] : primitive.attributes)
+    {
+        const FMutableAccessorView view = AccessorView::GetMutable(model, accessorIndex);
+        DebugAssert(view.m_count == vertexCount, "Vertex attribute count mismatch");
+
+        const size_t elementSize = view.GetElementSize();
+        scratch.resize(vertexCount * elementSize);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            memcpy(&scratch[remap[i] * elementSize], view.GetElement(i), elementSize);
+        }
+
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            memcpy(view.GetElement(i), &scratch[i * elementSize], elementSize);
+        }
+    }
+
+    // Rewrite the index buffer in meshlet order. Meshlets store triangles with reversed winding.
+    std::vector<uint32_t> indices;
+    indices.reserve(model.accessors[primitive.indices].count);
+    for (FInlineMeshlet& meshlet : meshlets)
+    {
+        for (uint32_t& vertexIndex : meshlet.m_uniqueVertexIndices)
+        {
+            vertexIndex = remap[vertexIndex];
+        }
+
+        for (const FInlineMeshlet::FPackedTriangle& prim : meshlet.m_primitiveIndices)
+        {
+            indices.push_back(meshlet.m_uniqueVertexIndices[prim.i2]);
+            indices.push_back(meshlet.m_uniqueVertexIndices[prim.i1]);
+            indices.push_back(meshlet.m_uniqueVertexIndices[prim.i0]);
+        }
+    }
+
+    DebugAssert(indices.size() == model.accessors[primitive.indices].count, "Meshlets don't cover the index buffer");
+    WriteIndices(model, primitive.indices, indices);
+}
+
+uint64_t MeshUtils::GetRemappedPrimitiveKey(const tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, uint64_t seed, FModelCache& cache)
+{
+    // The draw order only depends on the positions, the vertex remap on every stream
+    std::vector<int> accessors = { primitive.indices };
+    for (const auto& [name, accessorIndex] : primitive.attributes)
+    {
+        if (bVertices || name == "POSITION")
+        {
+            accessors.push_back(accessorIndex);
+        }
+    }
+
+    // Every stream gets the same permutation, so the entry only depends on the stream contents in this order and not on their names. 
+    // The seed tells entries with and without vertices apart, since a primitive with only positions hashes the same accessors.
+    return HashAccessorList(model, accessors, (seed * 31 + DrawOrderVersion) * 2 + (bVertices ? 1 : 0), cache);
+}
+
+FRemappedPrimitive MeshUtils::CaptureRemappedPrimitive(const tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, const std::vector<FInlineMeshlet>& meshlets)
+{
+    FRemappedPrimitive remapped;
+    remapped.m_meshlets = meshlets;
+
+    const std::map<std::string, int> noStreams;
+    for (const auto& [name, accessorIndex] : bVertices ? primitive.attributes : noStreams)
+    {
+        const FAccessorView view = AccessorView::Get(model, accessorIndex);
+        const size_t elementSize = view.GetElementSize();
+        const size_t offset = remapped.m_vertices.size();
+        remapped.m_vertices.resize(offset + view.m_count * elementSize);
+        for (size_t i = 0; i < view.m_count; ++i)
+        {
+            memcpy(&remapped.m_vertices[offset + i * elementSize], view.GetElement(i), elementSize);
+        }
+    }
+
+    ReadIndices(model, primitive.indices, remapped.m_drawIndices);
+    return remapped;
+}
+
+bool MeshUtils::RestoreRemappedPrimitive(tinygltf::Model& model, const tinygltf::Primitive& primitive, bool bVertices, const FRemappedPrimitive& remapped)
+{
+    SCOPED_CPU_EVENT("restore_remapped_primitive", PIX_COLOR_DEFAULT);
+
+    const std::map<std::string, int> noStreams;
+    const std::map<std::string, int>& streams = bVertices ? primitive.attributes : noStreams;
+
+    size_t vertexBytes = 0;
+    for (const auto& [name, accessorIndex] : streams)
+    {
+        const FAccessorView view = AccessorView::Get(model, accessorIndex);
+        vertexBytes += view.m_count * view.GetElementSize();
+    }
+
+    if (vertexBytes != remapped.m_vertices.size() || remapped.m_drawIndices.size() != model.accessors[primitive.indices].count)
+        return false;
+
+    size_t offset = 0;
+    for (const auto& [name, accessorIndex] : streams)
+    {
+        const FMutableAccessorView view = AccessorView::GetMutable(model, accessorIndex);
+        const size_t elementSize = view.GetElementSize();
+        for (size_t i = 0; i < view.m_count; ++i)
+        {
+            memcpy(view.GetElement(i), &remapped.m_vertices[offset + i * elementSize], elementSize);
+        }
+
+        offset += view.m_count * elementSize;
+    }
+
+    WriteIndices(model, primitive.indices, remapped.m_drawIndices);
+    return true;
+}
+
+bool MeshUtils::GeneratePrimitiveMeshlets(
+    tinygltf::Model& model,
+    const tinygltf::Primitive* sourcePrimitive,
+    int indexAccessor, int positionAccessor,
+    const std::vector<int>& accessorRefCounts,
+    uint32_t chunkSize,
+    FModelCache& cache,
+    std::vector<FInlineMeshlet>& meshlets)
+{
+    SCOPED_CPU_EVENT("meshletize", PIX_COLOR_DEFAULT);
+
+    // Tightly packed float positions and 32-bit indices are read in place, other layouts are converted into the scratch 
+    // buffers. The views see the streams as they are remapped, but converted positions have to be read again after that.
+    std::vector<XMFLOAT3> positionScratch;
+    std::vector<uint32_t> indexScratch;
+    auto ReadPositions = [&]() { return AccessorView::Read(AccessorView::Get(model, positionAccessor), positionScratch); };
+    auto ReadIndices = [&]() { return AccessorView::Read(AccessorView::Get(model, indexAccessor), indexScratch); };
+
+    // The chunk size changes how large primitives are split, and with it the meshlets
+    const uint64_t cacheSeed = ((uint64_t)MeshletizerVersion << 32) | chunkSize;
+
+    // Primitives whose vertices are remapped or whose triangles are reordered are restored from their final streams, so a warm 
+    // load only copies them. A primitive that shares its vertex streams can still have its own index buffer reordered.
+    const bool bRemap = sourcePrimitive && CanRemapPrimitiveVertices(model, *sourcePrimitive, accessorRefCounts);
+    const bool bReorder = sourcePrimitive && (bRemap || CanReorderPrimitiveTriangles(model, *sourcePrimitive, accessorRefCounts));
+    const uint64_t remapKey = bReorder ? GetRemappedPrimitiveKey(model, *sourcePrimitive, bRemap, cacheSeed, cache) : 0;
+    const FRemappedPrimitive* remapped = bReorder ? cache.Find(cache.m_remappedPrimitives, remapKey) : nullptr;
+    if (remapped && RestoreRemappedPrimitive(model, *sourcePrimitive, bRemap, *remapped))
+    {
+        meshlets = remapped->m_meshlets;
+        return false;
+    }
+
+    bool bGenerated = false;
+    const uint64_t cacheKey = HashAccessors(model, { indexAccessor, positionAccessor }, cacheSeed, cache);
+    if (const std::vector<FInlineMeshlet>* cachedMeshlets = cache.Find(cache.m_meshlets, cacheKey))
+    {
+        meshlets = *cachedMeshlets;
+    }
+    else
+    {
+        const std::span<const uint32_t> indices = ReadIndices();
+        const std::span<const XMFLOAT3> positions = ReadPositions();
+        MeshletizeParallel(
+            MeshletMaxVertices, MeshletMaxPrimitives,
+            indices.data(), indices.size(),
+            positions.data(), positions.size(),
+            chunkSize,
+            meshlets);
+
+        SortMeshlets(meshlets);
+        cache.Insert(cache.m_meshlets, cacheKey, meshlets);
+        bGenerated = true;
+    }
+
+    if (!bReorder)
+        return bGenerated;
+
+    // Improve the locality of vertex fetches
+    if (bRemap)
+    {
+        RemapPrimitiveVertices(model, *sourcePrimitive, meshlets);
+    }
+
+    // Reorder the triangles of the index buffer, which the non-meshlet path draws, for vertex reuse and then for overdraw. This 
+    // doesn't affect the meshlets. That path fetches the indices by SV_VertexID in non-indexed draws, so it gets no post-transform 
+    // cache reuse and only benefits from the overdraw order and the locality of the index fetches. The reuse pays off for indexed 
+    // consumers of the buffer.
+    const std::span<const uint32_t> indices = ReadIndices();
+    const std::span<const XMFLOAT3> positions = ReadPositions();
+    std::vector<uint32_t> drawIndices(indices.size());
+    std::vector<uint32_t> clusterStarts;
+    OptimizeVertexCache(indices.data(), indices.size(), positions.size(), DrawOrderCacheSize, drawIndices.data(), clusterStarts);
+    OptimizeOverdraw(drawIndices.data(), drawIndices.size(), positions.data(), positions.size(), clusterStarts, DrawOrderCacheSize, DrawOrderOverdrawThreshold);
+    WriteIndices(model, indexAccessor, drawIndices);
+    cache.Insert(cache.m_remappedPrimitives, remapKey, CaptureRemappedPrimitive(model, *sourcePrimitive, bRemap, meshlets));
+    return true;
+}
+
+void MeshUtils::OptimizeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize, uint32_t* output, std::vector<uint32_t>& clusterStarts)
+{
+    SCOPED_CPU_EVENT("optimize_vertex_cache", PIX_COLOR_DEFAULT);
+
+    const uint32_t triCount = indexCount / 3;
+    clusterStarts.clear();
+    if (triCount == 0)
+        return;
+
+    // Triangles that use each vertex, and the number of those that haven't been emitted yet
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (uint32_t i = 0; i < triCount * 3; ++i)
+    {
+        liveCount[indices[i]]++;
+    }
+
+    std::vector<uint32_t> adjacencyBegin(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyBegin[v + 1] = adjacencyBegin[v] + liveCount[v];
+    }
+
+    std::vector<uint32_t> adjacency(triCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyBegin.cbegin(), adjacencyBegin.cend() - 1);
+        for (uint32_t i = 0; i < triCount * 3; ++i)
+        {
+            adjacency[cursor[indices[i]]++] = i / 3;
+        }
+    }
+
+    // A vertex is in the cache if it was inserted less than cacheSize misses ago
+    std::vector<uint32_t> cacheTimestamp(vertexCount, 0);
+    std::vector<bool> emitted(triCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t inputCursor = 0;
+    uint32_t outputCount = 0;
+
+    // Dead ends are recently used vertices that still have triangles left. When those run out, continue in input order, 
+    // which starts a new cluster since nothing of it is in the cache.
+    auto SkipDeadEnd = [&]() -> int64_t
+    {
+        while (!deadEnds.empty())
+        {
+            const uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveCount[v] > 0)
+                return v;
+        }
+
+        for (; inputCursor < triCount * 3; ++inputCursor)
+        {
+            if (liveCount[indices[inputCursor]] > 0)
+            {
+                clusterStarts.push_back(outputCount / 3);
+                return indices[inputCursor];
+            }
+        }
+
+        return -1;
+    };
+
+    // Prefer the candidate that stays in the cache while all of its triangles are emitted and that entered the cache earliest
+    auto NextVertex = [&]() -> int64_t
+    {
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates)
+        {
+            if (liveCount[v] == 0)
+                continue;
+
+            int64_t priority = 0;
+            if (timestamp - cacheTimestamp[v] + 2 * liveCount[v] <= cacheSize)
+            {
+                priority = timestamp - cacheTimestamp[v];
+            }
+
+            if (priority > bestPriority)
+            {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+
+        return best != -1 ? best : SkipDeadEnd();
+    };
+
+    clusterStarts.push_back(0);
+    int64_t fanningVertex = indices[0];
+    while (fanningVertex >= 0)
+    {
+        candidates.clear();
+        for (uint32_t i = adjacencyBegin[fanningVertex]; i < adjacencyBegin[fanningVertex + 1]; ++i)
+        {
+            const uint32_t tri = adjacency[i];
+            if (emitted[tri])
+                continue;
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t v = indices[tri * 3 + corner];
+                output[outputCount++] = v;
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveCount[v]--;
+
+                if (timestamp - cacheTimestamp[v] > cacheSize)
+                {
+                    cacheTimestamp[v] = timestamp++;
+                }
+            }
+
+            emitted[tri] = true;
+        }
+
+        fanningVertex = NextVertex();
+    }
+
+    DebugAssert(outputCount == triCount * 3, "Not all triangles were emitted");
+}
+
+void MeshUtils::OptimizeOverdraw(uint32_t* indices, uint32_t indexCount, const XMFLOAT3* positions, uint32_t vertexCount, const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold)
+{
+    SCOPED_CPU_EVENT("optimize_overdraw", PIX_COLOR_DEFAULT);
+
+    const uint32_t triCount = indexCount / 3;
+    if (triCount == 0)
+        return;
+
+    // Split the clusters further wherever the ACMR of the triangles since the last split drops within the threshold of the cluster 
+    // as a whole. Splits restart with a cold cache, so reordering the resulting clusters costs little cache efficiency.
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> cacheTimestamp(vertexCount, 0);
+    uint32_t timestamp = 0;
+    auto IsMiss = [&](uint32_t v)
+    {
+        if (cacheTimestamp[v] == 0 || timestamp - cacheTimestamp[v] + 1 > cacheSize)
+        {
+            cacheTimestamp[v] = ++timestamp;
+            return 1u;
+        }
+
+        return 0u;
+    };
+
+    for (size_t cluster = 0; cluster < clusterStarts.size(); ++cluster)
+    {
+        const uint32_t begin = clusterStarts[cluster];
+        const uint32_t end = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triCount;
+        if (begin == end)
+            continue;
+
+        timestamp += cacheSize + 1;
+        uint32_t clusterMissCount = 0;
+        for (uint32_t i = begin * 3; i < end * 3; ++i)
+        {
+            clusterMissCount += IsMiss(indices[i]);
+        }
+
+        const float targetAcmr = threshold * clusterMissCount / (end - begin);
+
+        timestamp += cacheSize + 1;
+        uint32_t missCount = 0;
+        clusters.push_back(begin);
+        for (uint32_t tri = begin; tri < end; ++tri)
+        {
+            missCount += IsMiss(indices[tri * 3]) + IsMiss(indices[tri * 3 + 1]) + IsMiss(indices[tri * 3 + 2]);
+            if (tri + 1 < end && missCount <= targetAcmr * (tri + 1 - clusters.back()))
+            {
+                clusters.push_back(tri + 1);
+                timestamp += cacheSize + 1;
+                missCount = 0;
+            }
+        }
+    }
+
+    // Clusters that face away from the center of the mesh are more likely to occlude others, so draw them first
+    auto SortClusters = [&](const std::vector<uint32_t>& clusters, std::vector<uint32_t>& sorted)
+    {
+        XMVECTOR meshCentroid = XMVectorZero();
+        float meshArea = 0.f;
+        std::vector<std::pair<float, uint32_t>> sortKeys(clusters.size());
+        std::vector<XMFLOAT3> clusterCentroids(clusters.size()), clusterNormals(clusters.size());
+        for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            const uint32_t begin = clusters[cluster];
+            const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triCount;
+
+            XMVECTOR centroid = XMVectorZero();
+            XMVECTOR normal = XMVectorZero();
+            float area = 0.f;
+            for (uint32_t tri = begin; tri < end; ++tri)
+            {
+                const XMVECTOR p0 = XMLoadFloat3(&positions[indices[tri * 3]]);
+                const XMVECTOR p1 = XMLoadFloat3(&positions[indices[tri * 3 + 1]]);
+                const XMVECTOR p2 = XMLoadFloat3(&positions[indices[tri * 3 + 2]]);
+
+                // Area weighted, so that degenerate triangles don't contribute
+                const XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+                const float triArea = XMVectorGetX(XMVector3Length(n));
+                centroid += (p0 + p1 + p2) * (triArea / 3.f);
+                normal += n;
+                area += triArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+            XMStoreFloat3(&clusterCentroids[cluster], area > 0.f ? centroid / area : XMVectorZero());
+            XMStoreFloat3(&clusterNormals[cluster], XMVector3Normalize(normal));
+        }
+
+        meshCentroid = meshArea > 0.f ? meshCentroid / meshArea : XMVectorZero();
+        for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            const XMVECTOR offset = XMLoadFloat3(&clusterCentroids[cluster]) - meshCentroid;
+            const float dot = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&clusterNormals[cluster])));
+            sortKeys[cluster] = { dot == dot ? -dot : 0.f, (uint32_t)cluster };
+        }
+
+        // Stable, so that the result only depends on the input
+        std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        sorted.clear();
+        sorted.reserve(triCount * 3);
+        for (const auto& [key, cluster] : sortKeys)
+        {
+            const uint32_t begin = clusters[cluster];
+            const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triCount;
+            sorted.insert(sorted.end(), indices + begin * 3, indices + end * 3);
+        }
+    };
+
+    // The split estimate assumes that every split restarts with a cold cache, while the Tipsify order often still has part of the
+    // next cluster in the cache. So the sorted order is measured, and if it costs more than the threshold allows, only the Tipsify 
+    // clusters are sorted instead. If that is still too expensive, the Tipsify order is kept.
+    const float maxAcmr = threshold * AnalyzeVertexCache(indices, triCount * 3, vertexCount, cacheSize).m_acmr;
+    std::vector<uint32_t> sorted;
+    SortClusters(clusters, sorted);
+    if (AnalyzeVertexCache(sorted.data(), triCount * 3, vertexCount, cacheSize).m_acmr > maxAcmr)
+    {
+        SortClusters(clusterStarts, sorted);
+        if (AnalyzeVertexCache(sorted.data(), triCount * 3, vertexCount, cacheSize).m_acmr > maxAcmr)
+            return;
+    }
+
+    std::copy(sorted.cbegin(), sorted.cend(), indices);
+}
+
+FVertexCacheStats MeshUtils::AnalyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+    // A vertex is in the cache if it was inserted less than cacheSize misses ago
+    std::vector<uint32_t> insertTimestamp(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t missCount = 0;
+    uint32_t referencedCount = 0;
+
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        const uint32_t v = indices[i];
+        if (!referenced[v])
+        {
+            referenced[v] = true;
+            referencedCount++;
+        }
+
+        if (insertTimestamp[v] == 0 || missCount - insertTimestamp[v] + 1 > cacheSize)
+        {
+            insertTimestamp[v] = ++missCount;
+        }
+    }
+
+    FVertexCacheStats stats = {};
+    stats.m_acmr = indexCount >= 3 ? missCount / (float)(indexCount / 3) : 0.f;
+    stats.m_atvr = referencedCount > 0 ? missCount / (float)referencedCount : 0.f;
+    return stats;
+}
+
+FMeshletFetchStats MeshUtils::AnalyzeMeshletFetch(const std::vector<FInlineMeshlet>& meshlets, uint32_t vertexStride, uint32_t cacheLineSize)
+{
+    size_t lineCount = 0;
+    size_t idealLineCount = 0;
+    std::vector<size_t> lines;
+    for (const FInlineMeshlet& meshlet : meshlets)
+    {
+        lines.clear();
+        for (uint32_t vertexIndex : meshlet.m_uniqueVertexIndices)
+        {
+            const size_t begin = (size_t)vertexIndex * vertexStride;
+            const size_t end = begin + vertexStride - 1;
+            for (size_t line = begin / cacheLineSize; line <= end / cacheLineSize; ++line)
+            {
+                lines.push_back(line);
+            }
+        }
+
+        std::sort(lines.begin(), lines.end());
+        lineCount += std::unique(lines.begin(), lines.end()) - lines.begin();
+        idealLineCount += (meshlet.m_uniqueVertexIndices.size() * vertexStride + cacheLineSize - 1) / cacheLineSize;
+    }
+
+    FMeshletFetchStats stats = {};
+    stats.m_linesPerMeshlet = meshlets.empty() ? 0.f : lineCount / (float)meshlets.size();
+    stats.m_idealLinesPerMeshlet = meshlets.empty() ? 0.f : idealLineCount / (float)meshlets.size();
+    return stats;
+}
+
+FMeshletVertexEncoding MeshUtils::EncodeMeshletVertices(const FInlineMeshlet& meshlet, std::vector<uint8_t>& packedVertexIndices)
+{
+    // Keep every meshlet dword aligned so that the shader can read a delta with a single 4 byte load
+    packedVertexIndices.resize(GetAlignedSize(4, packedVertexIndices.size()));
+
+    FMeshletVertexEncoding encoding = {};
+    encoding.m_byteOffset = (uint32_t)packedVertexIndices.size();
+
+    if (meshlet.m_uniqueVertexIndices.empty())
+    {
+        encoding.m_deltaSize = 4;
+        return encoding;
+    }
+
+    const auto [minIt, maxIt] = std::minmax_element(meshlet.m_uniqueVertexIndices.cbegin(), meshlet.m_uniqueVertexIndices.cend());
+    const uint32_t range = *maxIt - *minIt;
+    encoding.m_base = *minIt;
+    encoding.m_deltaSize = range <= 0xff ? 1 : (range <= 0xffff ? 2 : 4);
+
+    const size_t count = meshlet.m_uniqueVertexIndices.size();
+    packedVertexIndices.resize(encoding.m_byteOffset + GetAlignedSize(4, count * encoding.m_deltaSize));
+    uint8_t* dest = packedVertexIndices.data() + encoding.m_byteOffset;
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Little-endian, to match ByteAddressBuffer loads
+        const uint32_t delta = meshlet.m_uniqueVertexIndices[i] - encoding.m_base;
+        for (uint32_t byte = 0; byte < encoding.m_deltaSize; ++byte)
+        {
+            dest[i * encoding.m_deltaSize + byte] = (uint8_t)(delta >> (8 * byte));
+        }
+    }
+
+    return encoding;
+}
+
+uint32_t MeshUtils::DecodeMeshletVertex(const FMeshletVertexEncoding& encoding, const uint8_t* packedVertexIndices, uint32_t meshletVertIndex)
+{
+    const uint32_t byteOffset = encoding.m_byteOffset + meshletVertIndex * encoding.m_deltaSize;
+    const uint32_t dwordAlignedByteOffset = byteOffset & ~3u;
+
+    uint32_t bufferValue;
+    memcpy(&bufferValue, packedVertexIndices + dwordAlignedByteOffset, sizeof(uint32_t));
+    bufferValue >>= (byteOffset - dwordAlignedByteOffset) * 8;
+
+    const uint32_t deltaMask = encoding.m_deltaSize == 4 ? 0xffffffff : (1u << (encoding.m_deltaSize * 8)) - 1;
+    return encoding.m_base + (bufferValue & deltaMask);
+}
+
+uint64_t MeshUtils::HashAccessors(const tinygltf::Model& model, std::initializer_list<int> accessors, uint64_t seed)
+{
+    return HashAccessorList(model, std::span{ accessors.begin(), accessors.size() }, seed);
+}
+
+uint64_t MeshUtils::HashAccessors(const tinygltf::Model& model, std::initializer_list<int> accessors, uint64_t seed, FModelCache& cache)
+{
+    return HashAccessorList(model, std::span{ accessors.begin(), accessors.size() }, seed, cache);
+}
+
+uint64_t MeshUtils::HashModelFiles(const std::string& modelFilepath)
+{
+    SCOPED_CPU_EVENT("hash_model_files", PIX_COLOR_DEFAULT);
+
+    uint64_t seed1 = 0, seed2 = 0;
+    spookyhash_context context;
+    spookyhash_context_init(&context, seed1, seed2);
+
+    // Sorted by path, since the directory iteration order is unspecified
+    const std::filesystem::path modelDir = std::filesystem::path{ modelFilepath }.parent_path();
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator{ modelDir, error }; it != std::filesystem::recursive_directory_iterator{}; it.increment(error))
+    {
+        // Skip the content and model caches
+        if (it->is_directory() && it->path().filename().string().starts_with("."))
+        {
+            it.disable_recursion_pending();
+            continue;
+        }
+
+        // Also skip the caches that are written next to a model in the model cache, which would otherwise change its key every time
+        // they are saved
+        const std::filesystem::path extension = it->path().extension();
+        if (it->is_regular_file() && extension != ".mesh-cache" && extension != ".scene-cache")
+        {
+            files.push_back(it->path());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+
+    std::vector<char> chunk(1 << 20);
+    for (const std::filesystem::path& filepath : files)
+    {
+        const std::string relativePath = std::filesystem::relative(filepath, modelDir).generic_string();
+        spookyhash_update(&context, relativePath.data(), relativePath.size() + 1);
+
+        // Files that can't be read are hashed as empty, which still changes the key if they could be read before
+        std::ifstream file(filepath, std::ios::binary);
+        uint64_t fileSize = 0;
+        while (file)
+        {
+            file.read(chunk.data(), chunk.size());
+            const size_t readSize = (size_t)file.gcount();
+            spookyhash_update(&context, chunk.data(), readSize);
+            fileSize += readSize;
+        }
+
+        spookyhash_update(&context, &fileSize, sizeof(fileSize));
+    }
+
+    spookyhash_final(&context, &seed1, &seed2);
+    return seed1;
+}
+
+bool MeshUtils::LoadModelCache(const std::string& filename, uint64_t sourceKey, FModelCache& cache)
+{
+    SCOPED_CPU_EVENT("load_model_cache", PIX_COLOR_DEFAULT);
+
+    cache.Clear();
+    cache.m_sourceKey = sourceKey;
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    const uint64_t fileSize = (uint64_t)file.tellg();
+    file.seekg(0);
+
+    uint32_t header[2] = {};
+    uint64_t fileSourceKey = 0;
+    file.read((char*)header, sizeof(header));
+    file.read((char*)&fileSourceKey, sizeof(fileSourceKey));
+    if (!file || header[0] != ModelCacheMagic || header[1] != ModelCacheVersion)
+    {
+        // Rewrite the outdated file on save
+        cache.m_bDirty = true;
+        return false;
+    }
+
+    auto ReadCount = [&](uint64_t& count)
+    {
+        return file.read((char*)&count, sizeof(count)) && count <= fileSize - (uint64_t)file.tellg();
+    };
+
+    // Hashes are only valid for the source files they were computed from, but are still read past
+    auto ReadAccessorHashes = [&]()
+    {
+        uint64_t entryCount = 0;
+        if (!ReadCount(entryCount))
+            return false;
+
+        for (uint64_t entry = 0; entry < entryCount; ++entry)
+        {
+            uint64_t entryData[2] = {};
+            if (!file.read((char*)entryData, sizeof(entryData)))
+                return false;
+
+            if (fileSourceKey == sourceKey)
+            {
+                cache.m_accessorHashes.Insert(entryData[0], entryData[1]);
+            }
+        }
+
+        return true;
+    };
+
+    auto ReadTangents = [&]()
+    {
+        uint64_t entryCount = 0;
+        if (!ReadCount(entryCount))
+            return false;
+
+        for (uint64_t entry = 0; entry < entryCount; ++entry)
+        {
+            uint64_t key = 0;
+            std::vector<XMFLOAT4> tangents;
+            if (!file.read((char*)&key, sizeof(key)) || !ReadVector(file, fileSize, tangents))
+                return false;
+
+            cache.m_tangents.Insert(key, std::move(tangents));
+        }
+
+        return (bool)file;
+    };
+
+    auto ReadMeshlets = [&](std::vector<FInlineMeshlet>& meshlets)
+    {
+        uint64_t meshletCount = 0;
+        if (!ReadCount(meshletCount))
+            return false;
+
+        meshlets.resize(meshletCount);
+        for (FInlineMeshlet& meshlet : meshlets)
+        {
+            if (!ReadVector(file, fileSize, meshlet.m_uniqueVertexIndices) || !ReadVector(file, fileSize, meshlet.m_primitiveIndices))
+                return false;
+
+            file.read((char*)&meshlet.m_boundingSphere, sizeof(meshlet.m_boundingSphere));
+            file.read((char*)&meshlet.m_normalCone, sizeof(meshlet.m_normalCone));
+        }
+
+        return (bool)file;
+    };
+
+    auto ReadMeshletEntries = [&]()
+    {
+        uint64_t entryCount = 0;
+        if (!ReadCount(entryCount))
+            return false;
+
+        for (uint64_t entry = 0; entry < entryCount; ++entry)
+        {
+            uint64_t key = 0;
+            std::vector<FInlineMeshlet> meshlets;
+            if (!file.read((char*)&key, sizeof(key)) || !ReadMeshlets(meshlets))
+                return false;
+
+            cache.m_meshlets.Insert(key, std::move(meshlets));
+        }
+
+        return (bool)file;
+    };
+
+    auto ReadRemappedPrimitives = [&]()
+    {
+        uint64_t entryCount = 0;
+        if (!ReadCount(entryCount))
+            return false;
+
+        for (uint64_t entry = 0; entry < entryCount; ++entry)
+        {
+            uint64_t key = 0;
+            FRemappedPrimitive remapped;
+            if (!file.read((char*)&key, sizeof(key)) || 
+                !ReadMeshlets(remapped.m_meshlets) || 
+                !ReadVector(file, fileSize, remapped.m_vertices) || 
+                !ReadVector(file, fileSize, remapped.m_drawIndices))
+                return false;
+
+            cache.m_remappedPrimitives.Insert(key, std::move(remapped));
+        }
+
+        return (bool)file;
+    };
+
+    // Entries of a damaged file can't be trusted, so a read error drops the ones that were read before it as well
+    if (!ReadAccessorHashes() || !ReadTangents() || !ReadMeshletEntries() || !ReadRemappedPrimitives() || (uint64_t)file.tellg() != fileSize)
+    {
+        cache.Clear();
+        cache.m_bDirty = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshUtils::SaveModelCache(const std::string& filename, FModelCache& cache)
+{
+    SCOPED_CPU_EVENT("save_model_cache", PIX_COLOR_DEFAULT);
+
+    auto IsUsed = [&cache](uint64_t key) { return cache.m_usedKeys.Find(key) != nullptr; };
+    auto CountUsed = [&](const auto& entries)
+    {
+        return (uint64_t)std::count_if(entries.begin(), entries.end(), [&](const auto& entry) { return IsUsed(entry.first); });
+    };
+
+    const uint64_t usedCounts[] = { CountUsed(cache.m_accessorHashes), CountUsed(cache.m_tangents), CountUsed(cache.m_meshlets), CountUsed(cache.m_remappedPrimitives) };
+    const uint64_t entryCounts[] = { cache.m_accessorHashes.Size(), cache.m_tangents.Size(), cache.m_meshlets.Size(), cache.m_remappedPrimitives.Size() };
+    if (!cache.m_bDirty && std::equal(std::begin(usedCounts), std::end(usedCounts), std::begin(entryCounts)))
+        return false;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    DebugAssert((bool)file, "Failed to create model cache");
+
+    const uint32_t header[2] = { ModelCacheMagic, ModelCacheVersion };
+    file.write((const char*)header, sizeof(header));
+    file.write((const char*)&cache.m_sourceKey, sizeof(cache.m_sourceKey));
+
+    file.write((const char*)&usedCounts[0], sizeof(uint64_t));
+    for (const auto& [key, hash] : cache.m_accessorHashes)
+    {
+        if (IsUsed(key))
+        {
+            const uint64_t entryData[2] = { key, hash };
+            file.write((const char*)entryData, sizeof(entryData));
+        }
+    }
+
+    file.write((const char*)&usedCounts[1], sizeof(uint64_t));
+    for (const auto& [key, tangents] : cache.m_tangents)
+    {
+        if (IsUsed(key))
+        {
+            file.write((const char*)&key, sizeof(key));
+            WriteVector(file, tangents);
+        }
+    }
+
+    auto WriteMeshlets = [&file](const std::vector<FInlineMeshlet>& meshlets)
+    {
+        const uint64_t meshletCount = meshlets.size();
+        file.write((const char*)&meshletCount, sizeof(meshletCount));
+        for (const FInlineMeshlet& meshlet : meshlets)
+        {
+            WriteVector(file, meshlet.m_uniqueVertexIndices);
+            WriteVector(file, meshlet.m_primitiveIndices);
+            file.write((const char*)&meshlet.m_boundingSphere, sizeof(meshlet.m_boundingSphere));
+            file.write((const char*)&meshlet.m_normalCone, sizeof(meshlet.m_normalCone));
+        }
+    };
+
+    file.write((const char*)&usedCounts[2], sizeof(uint64_t));
+    for (const auto& [key, meshlets] : cache.m_meshlets)
+    {
+        if (IsUsed(key))
+        {
+            file.write((const char*)&key, sizeof(key));
+            WriteMeshlets(meshlets);
+        }
+    }
+
+    file.write((const char*)&usedCounts[3], sizeof(uint64_t));
+    for (const auto& [key, remapped] : cache.m_remappedPrimitives)
+    {
+        if (IsUsed(key))
+        {
+            file.write((const char*)&key, sizeof(key));
+            WriteMeshlets(remapped.m_meshlets);
+            WriteVector(file, remapped.m_vertices);
+            WriteVector(file, remapped.m_drawIndices);
+        }
+    }
+
+    cache.m_bDirty = false;
+    return true;
+}
@@ -0,0 +1,457 @@
+#include <normal-roughness-filter.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <cmath>
+
+namespace
+{
+	float UnormToFloat(uint8_t value)
+	{
+		return value / 255.f;
+	}
+
+	// Same conversion as a UAV store to a UNORM format, which rounds to nearest even and stores NaN as 0
+	uint8_t FloatToUnorm(float value)
+	{
+		if (!(value > 0.f))
+			return 0;
+
+		return (uint8_t)std::lrint(std::min(value, 1.f) * 255.f);
+	}
+
+	// Fits a vMF lobe to the NDF of a texel, and returns the length of its mean vector r, which is in the direction of the normal.
+	// See https://graphicrants.blogspot.com/2018/05/normal-map-filtering-using-vmf-part-3.html
+	float GetLobeLength(float roughnessAlpha)
+	{
+		const float invLambda = 0.5f * roughnessAlpha * roughnessAlpha;
+		const float exp2L = std::exp(-2.f / invLambda);
+		const float cothLambda = invLambda > 0.1f ? (1.f + exp2L) / (1.f - exp2L) : 1.f;
+		return cothLambda - invLambda;
+	}
+
+	// The roughness is 8-bit, so the lobe lengths are looked up instead of evaluating an exp per texel
+	const std::array<float, 256>& GetLobeLengths()
+	{
+		static const std::array<float, 256> s_lengths = []()
+		{
+			std::array<float, 256> lengths;
+			for (int i = 0; i < 256; ++i)
+			{
+				lengths[i] = GetLobeLength(UnormToFloat((uint8_t)i));
+			}
+
+			return lengths;
+		}();
+
+		return s_lengths;
+	}
+
+	// Converts an averaged lobe back to a normal and roughness
+	void StoreFilteredTexel(float rx, float ry, float rz, float metalness, uint8_t* normal, uint8_t* metallicRoughness)
+	{
+		const float rLengthSq = rx * rx + ry * ry + rz * rz;
+		const float r2 = std::clamp(rLengthSq, 1e-8f, 1.f);
+		const float invLambda = (1.f - r2) / (std::sqrt(r2) * (3.f - r2));
+		const float roughnessAlpha = std::sqrt(2.f * invLambda);
+		const float invLength = 1.f / std::sqrt(rLengthSq);
+
+		normal[0] = FloatToUnorm(0.5f * rx * invLength + 0.5f);
+		normal[1] = FloatToUnorm(0.5f * ry * invLength + 0.5f);
+		normal[2] = FloatToUnorm(0.5f * rz * invLength + 0.5f);
+		normal[3] = 0;
+
+		metallicRoughness[0] = FloatToUnorm(metalness);
+		metallicRoughness[1] = FloatToUnorm(roughnessAlpha);
+		metallicRoughness[2] = 0;
+		metallicRoughness[3] = 0;
+	}
+
+	// The base level is copied, with metal/roughness swizzled from B/G to R/G
+	void CopyBaseLevel(const uint8_t* normalmap, const uint8_t* metallicRoughnessmap, uint32_t width, uint32_t height, NormalRoughnessFilter::FMip& outNormal, NormalRoughnessFilter::FMip& outMetallicRoughness)
+	{
+		const size_t texelCount = (size_t)width * height;
+		outNormal = { width, height, std::vector<uint8_t>(normalmap, normalmap + texelCount * 4) };
+		outMetallicRoughness = { width, height, std::vector<uint8_t>(texelCount * 4) };
+
+		uint8_t* dest = outMetallicRoughness.m_texels.data();
+		size_t i = 0;
+		for (; i + 4 <= texelCount; i += 4)
+		{
+			const __m128i texels = _mm_loadu_si128((const __m128i*)(metallicRoughnessmap + i * 4));
+			const __m128i ga = _mm_and_si128(texels, _mm_set1_epi32(0xff00ff00));
+			const __m128i r = _mm_slli_epi32(_mm_and_si128(texels, _mm_set1_epi32(0xff)), 16);
+			const __m128i b = _mm_and_si128(_mm_srli_epi32(texels, 16), _mm_set1_epi32(0xff));
+			_mm_storeu_si128((__m128i*)(dest + i * 4), _mm_or_si128(ga, _mm_or_si128(r, b)));
+		}
+
+		for (; i < texelCount; ++i)
+		{
+			const uint8_t* src = metallicRoughnessmap + i * 4;
+			dest[i * 4 + 0] = src[2];
+			dest[i * 4 + 1] = src[1];
+			dest[i * 4 + 2] = src[0];
+			dest[i * 4 + 3] = src[3];
+		}
+	}
+
+	// Mean vectors of the vMF lobes and the metalness of a mip, averaged over each texel's footprint, as separate streams
+	struct FLobes
+	{
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		std::vector<float> m_x, m_y, m_z, m_metalness;
+
+		void Resize(uint32_t width, uint32_t height)
+		{
+			const size_t count = (size_t)width * height;
+			m_width = width;
+			m_height = height;
+			m_x.resize(count);
+			m_y.resize(count);
+			m_z.resize(count);
+			m_metalness.resize(count);
+		}
+	};
+
+	struct FLobes4
+	{
+		__m128 m_x, m_y, m_z, m_metalness;
+	};
+
+	__m128i GetChannel(__m128i texels, int channel)
+	{
+		return _mm_and_si128(_mm_srli_epi32(texels, channel * 8), _mm_set1_epi32(0xff));
+	}
+
+	// Lobes of 4 consecutive base level texels
+	FLobes4 LoadBaseLobes(const uint8_t* normals, const uint8_t* metallicRoughness)
+	{
+		const __m128 unormScale = _mm_set1_ps(255.f);
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 two = _mm_set1_ps(2.f);
+
+		const __m128i normalTexels = _mm_loadu_si128((const __m128i*)normals);
+		const __m128 nx = _mm_sub_ps(_mm_mul_ps(two, _mm_div_ps(_mm_cvtepi32_ps(GetChannel(normalTexels, 0)), unormScale)), one);
+		const __m128 ny = _mm_sub_ps(_mm_mul_ps(two, _mm_div_ps(_mm_cvtepi32_ps(GetChannel(normalTexels, 1)), unormScale)), one);
+		const __m128 nz = _mm_sub_ps(_mm_mul_ps(two, _mm_div_ps(_mm_cvtepi32_ps(GetChannel(normalTexels, 2)), unormScale)), one);
+		const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz))));
+
+		const __m128i metallicRoughnessTexels = _mm_loadu_si128((const __m128i*)metallicRoughness);
+		const std::array<float, 256>& lobeLengths = GetLobeLengths();
+		alignas(16) uint32_t roughness[4];
+		_mm_store_si128((__m128i*)roughness, GetChannel(metallicRoughnessTexels, 1));
+		const __m128 lobeLength = _mm_setr_ps(lobeLengths[roughness[0]], lobeLengths[roughness[1]], lobeLengths[roughness[2]], lobeLengths[roughness[3]]);
+
+		const __m128 scale = _mm_mul_ps(lobeLength, invLength);
+		return {
+			_mm_mul_ps(scale, nx),
+			_mm_mul_ps(scale, ny),
+			_mm_mul_ps(scale, nz),
+			_mm_div_ps(_mm_cvtepi32_ps(GetChannel(metallicRoughnessTexels, 2)), unormScale) };
+	}
+
+	// Sums neighbouring pairs of 8 consecutive values, { a0 + a1, a2 + a3, b0 + b1, b2 + b3 }
+	__m128 AddPairs(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	// Average of the 2x2 footprints of 4 texels, from the 8 texels above and below
+	FLobes4 Average(const FLobes4& top0, const FLobes4& top1, const FLobes4& bottom0, const FLobes4& bottom1)
+	{
+		const __m128 quarter = _mm_set1_ps(0.25f);
+		return {
+			_mm_mul_ps(_mm_add_ps(AddPairs(top0.m_x, top1.m_x), AddPairs(bottom0.m_x, bottom1.m_x)), quarter),
+			_mm_mul_ps(_mm_add_ps(AddPairs(top0.m_y, top1.m_y), AddPairs(bottom0.m_y, bottom1.m_y)), quarter),
+			_mm_mul_ps(_mm_add_ps(AddPairs(top0.m_z, top1.m_z), AddPairs(bottom0.m_z, bottom1.m_z)), quarter),
+			_mm_mul_ps(_mm_add_ps(AddPairs(top0.m_metalness, top1.m_metalness), AddPairs(bottom0.m_metalness, bottom1.m_metalness)), quarter) };
+	}
+
+	FLobes4 LoadLobes(const FLobes& lobes, size_t index)
+	{
+		return { _mm_loadu_ps(&lobes.m_x[index]), _mm_loadu_ps(&lobes.m_y[index]), _mm_loadu_ps(&lobes.m_z[index]), _mm_loadu_ps(&lobes.m_metalness[index]) };
+	}
+
+	void StoreLobes(const FLobes4& value, FLobes& lobes, size_t index)
+	{
+		_mm_storeu_ps(&lobes.m_x[index], value.m_x);
+		_mm_storeu_ps(&lobes.m_y[index], value.m_y);
+		_mm_storeu_ps(&lobes.m_z[index], value.m_z);
+		_mm_storeu_ps(&lobes.m_metalness[index], value.m_metalness);
+	}
+
+	// Same as FloatToUnorm for 4 values. MAXPS returns its second operand if either is NaN.
+	__m128i FloatToUnorm4(__m128 value)
+	{
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.f)));
+	}
+
+	__m128i PackTexels(__m128i r, __m128i g, __m128i b)
+	{
+		return _mm_or_si128(r, _mm_or_si128(_mm_slli_epi32(g, 8), _mm_slli_epi32(b, 16)));
+	}
+
+	// Same as StoreFilteredTexel for 4 texels
+	void StoreFilteredTexels(const FLobes4& lobes, uint8_t* normals, uint8_t* metallicRoughness)
+	{
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 rLengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lobes.m_x, lobes.m_x), _mm_mul_ps(lobes.m_y, lobes.m_y)), _mm_mul_ps(lobes.m_z, lobes.m_z));
+		const __m128 r2 = _mm_min_ps(_mm_max_ps(rLengthSq, _mm_set1_ps(1e-8f)), one);
+		const __m128 invLambda = _mm_div_ps(_mm_sub_ps(one, r2), _mm_mul_ps(_mm_sqrt_ps(r2), _mm_sub_ps(_mm_set1_ps(3.f), r2)));
+		const __m128 roughnessAlpha = _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(2.f), invLambda));
+		const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(rLengthSq));
+
+		const __m128i nx = FloatToUnorm4(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(half, lobes.m_x), invLength), half));
+		const __m128i ny = FloatToUnorm4(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(half, lobes.m_y), invLength), half));
+		const __m128i nz = FloatToUnorm4(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(half, lobes.m_z), invLength), half));
+		_mm_storeu_si128((__m128i*)normals, PackTexels(nx, ny, nz));
+
+		const __m128i metalness = FloatToUnorm4(lobes.m_metalness);
+		const __m128i roughness = FloatToUnorm4(roughnessAlpha);
+		_mm_storeu_si128((__m128i*)metallicRoughness, PackTexels(metalness, roughness, _mm_setzero_si128()));
+	}
+
+	// Calls fn(firstRow, endRow) for one range of rows per thread. Mips that are too small to be worth starting threads for are
+	// filtered on the calling thread.
+	template<typename Fn>
+	void ForEachRowRange(uint32_t rowCount, uint32_t rowWidth, size_t threadCount, const Fn& fn)
+	{
+		constexpr size_t MinTexelsPerThread = 16384;
+		threadCount = std::min({ threadCount, std::max<size_t>((size_t)rowCount * rowWidth / MinTexelsPerThread, 1), (size_t)rowCount });
+		if (threadCount <= 1)
+		{
+			fn(0u, rowCount);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		for (size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+		{
+			const uint32_t firstRow = (uint32_t)(rowCount * threadIndex / threadCount);
+			const uint32_t endRow = (uint32_t)(rowCount * (threadIndex + 1) / threadCount);
+			threads.emplace_back(fn, firstRow, endRow);
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// First filtered mip, from the base level
+	void FilterFirstMip(const uint8_t* normalmap, const uint8_t* metallicRoughnessmap, uint32_t width, FLobes& lobes, NormalRoughnessFilter::FMip& outNormal, NormalRoughnessFilter::FMip& outMetallicRoughness, uint32_t firstRow, uint32_t endRow)
+	{
+		const std::array<float, 256>& lobeLengths = GetLobeLengths();
+		for (uint32_t y = firstRow; y < endRow; ++y)
+		{
+			const size_t top = (size_t)(2 * y) * width;
+			const size_t bottom = top + width;
+			uint32_t x = 0;
+			for (; x + 4 <= lobes.m_width; x += 4)
+			{
+				const size_t topOffset = (top + 2 * x) * 4;
+				const size_t bottomOffset = (bottom + 2 * x) * 4;
+				const FLobes4 average = Average(
+					LoadBaseLobes(normalmap + topOffset, metallicRoughnessmap + topOffset),
+					LoadBaseLobes(normalmap + topOffset + 16, metallicRoughnessmap + topOffset + 16),
+					LoadBaseLobes(normalmap + bottomOffset, metallicRoughnessmap + bottomOffset),
+					LoadBaseLobes(normalmap + bottomOffset + 16, metallicRoughnessmap + bottomOffset + 16));
+
+				const size_t index = (size_t)y * lobes.m_width + x;
+				StoreLobes(average, lobes, index);
+				StoreFilteredTexels(average, &outNormal.m_texels[index * 4], &outMetallicRoughness.m_texels[index * 4]);
+			}
+
+			for (; x < lobes.m_width; ++x)
+			{
+				float r[4] = {};
+				for (const size_t srcIndex : { top + 2 * x, top + 2 * x + 1, bottom + 2 * x, bottom + 2 * x + 1 })
+				{
+					const uint8_t* normal = normalmap + srcIndex * 4;
+					const uint8_t* metallicRoughness = metallicRoughnessmap + srcIndex * 4;
+					const float n[3] = { 2.f * UnormToFloat(normal[0]) - 1.f, 2.f * UnormToFloat(normal[1]) - 1.f, 2.f * UnormToFloat(normal[2]) - 1.f };
+					const float scale = lobeLengths[metallicRoughness[1]] * (1.f / std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+					r[0] += scale * n[0];
+					r[1] += scale * n[1];
+					r[2] += scale * n[2];
+					r[3] += UnormToFloat(metallicRoughness[2]);
+				}
+
+				const size_t index = (size_t)y * lobes.m_width + x;
+				lobes.m_x[index] = 0.25f * r[0];
+				lobes.m_y[index] = 0.25f * r[1];
+				lobes.m_z[index] = 0.25f * r[2];
+				lobes.m_metalness[index] = 0.25f * r[3];
+				StoreFilteredTexel(lobes.m_x[index], lobes.m_y[index], lobes.m_z[index], lobes.m_metalness[index], &outNormal.m_texels[index * 4], &outMetallicRoughness.m_texels[index * 4]);
+			}
+		}
+	}
+
+	// Every following mip averages the lobes of the mip above
+	void FilterNextMip(const FLobes& src, FLobes& lobes, NormalRoughnessFilter::FMip& outNormal, NormalRoughnessFilter::FMip& outMetallicRoughness, uint32_t firstRow, uint32_t endRow)
+	{
+		for (uint32_t y = firstRow; y < endRow; ++y)
+		{
+			const size_t top = (size_t)(2 * y) * src.m_width;
+			const size_t bottom = top + src.m_width;
+			uint32_t x = 0;
+			for (; x + 4 <= lobes.m_width; x += 4)
+			{
+				const FLobes4 average = Average(
+					LoadLobes(src, top + 2 * x),
+					LoadLobes(src, top + 2 * x + 4),
+					LoadLobes(src, bottom + 2 * x),
+					LoadLobes(src, bottom + 2 * x + 4));
+
+				const size_t index = (size_t)y * lobes.m_width + x;
+				StoreLobes(average, lobes, index);
+				StoreFilteredTexels(average, &outNormal.m_texels[index * 4], &outMetallicRoughness.m_texels[index * 4]);
+			}
+
+			for (; x < lobes.m_width; ++x)
+			{
+				auto Sum = [&](const std::vector<float>& values)
+				{
+					return ((values[top + 2 * x] + values[top + 2 * x + 1]) + (values[bottom + 2 * x] + values[bottom + 2 * x + 1])) * 0.25f;
+				};
+
+				const size_t index = (size_t)y * lobes.m_width + x;
+				lobes.m_x[index] = Sum(src.m_x);
+				lobes.m_y[index] = Sum(src.m_y);
+				lobes.m_z[index] = Sum(src.m_z);
+				lobes.m_metalness[index] = Sum(src.m_metalness);
+				StoreFilteredTexel(lobes.m_x[index], lobes.m_y[index], lobes.m_z[index], lobes.m_metalness[index], &outNormal.m_texels[index * 4], &outMetallicRoughness.m_texels[index * 4]);
+			}
+		}
+	}
+}
+
+size_t NormalRoughnessFilter::GetMipCount(uint32_t width, uint32_t height)
+{
+	size_t mipCount = 0;
+	while (width >= 4 && height >= 4)
+	{
+		mipCount++;
+		width = width >> 1;
+		height = height >> 1;
+	}
+
+	return std::max<size_t>(mipCount, 1);
+}
+
+void NormalRoughnessFilter::Prefilter(
+	const uint8_t* normalmap, const uint8_t* metallicRoughnessmap,
+	uint32_t width, uint32_t height, size_t mipCount,
+	std::vector<FMip>& outNormalMips, std::vector<FMip>& outMetallicRoughnessMips,
+	size_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	outNormalMips.resize(mipCount);
+	outMetallicRoughnessMips.resize(mipCount);
+	CopyBaseLevel(normalmap, metallicRoughnessmap, width, height, outNormalMips[0], outMetallicRoughnessMips[0]);
+
+	// Only the lobes of the previous mip are kept
+	FLobes srcLobes, lobes;
+	for (size_t mipIndex = 1; mipIndex < mipCount; ++mipIndex)
+	{
+		const uint32_t mipWidth = width >> mipIndex;
+		const uint32_t mipHeight = height >> mipIndex;
+		FMip& normalMip = outNormalMips[mipIndex];
+		FMip& metallicRoughnessMip = outMetallicRoughnessMips[mipIndex];
+		normalMip = { mipWidth, mipHeight, std::vector<uint8_t>((size_t)mipWidth * mipHeight * 4) };
+		metallicRoughnessMip = { mipWidth, mipHeight, std::vector<uint8_t>((size_t)mipWidth * mipHeight * 4) };
+
+		std::swap(srcLobes, lobes);
+		lobes.Resize(mipWidth, mipHeight);
+		ForEachRowRange(mipHeight, mipWidth, threadCount, [&](uint32_t firstRow, uint32_t endRow)
+			{
+				if (mipIndex == 1)
+				{
+					FilterFirstMip(normalmap, metallicRoughnessmap, width, lobes, normalMip, metallicRoughnessMip, firstRow, endRow);
+				}
+				else
+				{
+					FilterNextMip(srcLobes, lobes, normalMip, metallicRoughnessMip, firstRow, endRow);
+				}
+			});
+	}
+}
+
+void NormalRoughnessFilter::PrefilterReference(
+	const uint8_t* normalmap, const uint8_t* metallicRoughnessmap,
+	uint32_t width, uint32_t height, size_t mipCount,
+	std::vector<FMip>& outNormalMips, std::vector<FMip>& outMetallicRoughnessMips)
+{
+	outNormalMips.resize(mipCount);
+	outMetallicRoughnessMips.resize(mipCount);
+	CopyBaseLevel(normalmap, metallicRoughnessmap, width, height, outNormalMips[0], outMetallicRoughnessMips[0]);
+
+	for (size_t mipIndex = 1; mipIndex < mipCount; ++mipIndex)
+	{
+		const uint32_t mipWidth = width >> mipIndex;
+		const uint32_t mipHeight = height >> mipIndex;
+		FMip& normalMip = outNormalMips[mipIndex];
+		FMip& metallicRoughnessMip = outMetallicRoughnessMips[mipIndex];
+		normalMip = { mipWidth, mipHeight, std::vector<uint8_t>((size_t)mipWidth * mipHeight * 4) };
+		metallicRoughnessMip = { mipWidth, mipHeight, std::vector<uint8_t>((size_t)mipWidth * mipHeight * 4) };
+
+		// Every texel of the mip covers a square footprint of base level texels
+		const uint32_t footprint = 1u << mipIndex;
+		const float invSampleCount = 1.f / (footprint * footprint);
+		for (uint32_t y = 0; y < mipHeight; ++y)
+		{
+			for (uint32_t x = 0; x < mipWidth; ++x)
+			{
+				float rAvg[3] = {};
+				float metalnessAvg = 0.f;
+				for (uint32_t sy = y * footprint; sy < (y + 1) * footprint; ++sy)
+				{
+					for (uint32_t sx = x * footprint; sx < (x + 1) * footprint; ++sx)
+					{
+						const size_t srcOffset = ((size_t)sy * width + sx) * 4;
+						const float n[3] = {
+							2.f * UnormToFloat(normalmap[srcOffset + 0]) - 1.f,
+							2.f * UnormToFloat(normalmap[srcOffset + 1]) - 1.f,
+							2.f * UnormToFloat(normalmap[srcOffset + 2]) - 1.f };
+						const float invLength = 1.f / std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+						const float roughnessAlpha = UnormToFloat(metallicRoughnessmap[srcOffset + 1]);
+						metalnessAvg += UnormToFloat(metallicRoughnessmap[srcOffset + 2]);
+
+						// Average the lobes as mean vectors r
+						const float scale = GetLobeLength(roughnessAlpha) * invLength;
+						rAvg[0] += scale * n[0];
+						rAvg[1] += scale * n[1];
+						rAvg[2] += scale * n[2];
+					}
+				}
+
+				const size_t index = (size_t)y * mipWidth + x;
+				StoreFilteredTexel(rAvg[0] * invSampleCount, rAvg[1] * invSampleCount, rAvg[2] * invSampleCount, metalnessAvg * invSampleCount, &normalMip.m_texels[index * 4], &metallicRoughnessMip.m_texels[index * 4]);
+			}
+		}
+	}
+}
+
+NormalRoughnessFilter::FDifference NormalRoughnessFilter::Compare(const std::vector<FMip>& a, const std::vector<FMip>& b)
+{
+	FDifference result = {};
+	for (size_t mipIndex = 0; mipIndex < a.size(); ++mipIndex)
+	{
+		for (size_t i = 0; i < a[mipIndex].m_texels.size(); ++i)
+		{
+			const int difference = std::abs((int)a[mipIndex].m_texels[i] - (int)b[mipIndex].m_texels[i]);
+			result.m_maxDifference = std::max(result.m_maxDifference, difference);
+			result.m_differentChannelCount += difference > 0 ? 1 : 0;
+		}
+	}
+
+	return result;
+}
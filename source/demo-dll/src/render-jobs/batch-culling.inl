@@ -45,8 +45,9 @@ namespace RenderJob::BatchCullingPass
 			d3dCmdList->SetComputeRootSignature(rootsig->m_rootsig);
 
 			std::wstring shaderMacros = PrintString(
-				L"THREAD_GROUP_SIZE_X=128 FRUSTUM_CULLING=%d",
-				passDesc.renderConfig.FrustumCulling ? 1 : 0);
+				L"THREAD_GROUP_SIZE_X=128 FRUSTUM_CULLING=%d BACKFACE_CULLING=%d",
+				passDesc.renderConfig.FrustumCulling ? 1 : 0,
+				passDesc.renderConfig.BackfaceCulling ? 1 : 0);
 
 			std::wstring shaderEntryPoint = passDesc.renderConfig.UseMeshlets ? L"cs_meshlet_cull_main" : L"cs_primitive_cull_main";
 
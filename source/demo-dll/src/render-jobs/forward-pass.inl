@@ -73,7 +73,7 @@ namespace RenderJob::ForwardLightingPass
 					continue;
 				}
 
-				const FMesh& mesh = passDesc.scene->m_sceneMeshes.m_entityList[meshIndex];
+				const FMesh& mesh = passDesc.scene->GetMesh(passDesc.scene->m_sceneMeshes, meshIndex);
 				SCOPED_COMMAND_LIST_EVENT(cmdList, passDesc.scene->m_sceneMeshes.m_entityNames[meshIndex].c_str(), 0);
 
 				for (const FMeshPrimitive& primitive : mesh.m_primitives)
@@ -72,7 +72,7 @@ namespace RenderJob::GBufferRasterPass
 			// Issue decal draws
 			for (int meshIndex = 0; meshIndex < passDesc.scene->m_sceneMeshDecals.GetCount(); ++meshIndex)
 			{
-				const FMesh& mesh = passDesc.scene->m_sceneMeshDecals.m_entityList[meshIndex];
+				const FMesh& mesh = passDesc.scene->GetMesh(passDesc.scene->m_sceneMeshDecals, meshIndex);
 				SCOPED_COMMAND_LIST_EVENT(cmdList, passDesc.scene->m_sceneMeshDecals.m_entityNames[meshIndex].c_str(), 0);
 
 				for (const FMeshPrimitive& primitive : mesh.m_primitives)
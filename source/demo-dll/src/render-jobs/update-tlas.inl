@@ -19,22 +19,19 @@ namespace RenderJob::UpdateTLASPass
 
 			for (int meshIndex = 0; meshIndex < scene->m_sceneMeshes.GetCount(); ++meshIndex)
 			{
-				const FMesh& mesh = scene->m_sceneMeshes.m_entityList[meshIndex];
-
 				const bool bVisible = scene->m_sceneMeshes.m_visibleList[meshIndex];
 				if (bVisible)
 				{
-					const std::string& meshName = scene->m_sceneMeshes.m_entityNames[meshIndex];
-
-					const auto& search = scene->m_blasList.find(meshName);
-					DebugAssert(search != scene->m_blasList.end());
+					const int assetIndex = scene->m_sceneMeshes.m_entityList[meshIndex];
+					const FShaderBuffer* blas = scene->m_blasList[assetIndex].get();
+					DebugAssert(blas != nullptr);
 
 					D3D12_RAYTRACING_INSTANCE_DESC instance = {};
 					instance.InstanceID = 0;
 					instance.InstanceContributionToHitGroupIndex = 0; // specify 0 because we will use InstanceIndex() in shader directly
 					instance.InstanceMask = 1;
 					instance.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-					instance.AccelerationStructure = search->second->m_resource->m_d3dResource->GetGPUVirtualAddress();
+					instance.AccelerationStructure = blas->m_resource->m_d3dResource->GetGPUVirtualAddress();
 
 					// Transpose and convert to 3x4 matrix
 					const Matrix& localToWorld = scene->m_sceneMeshes.m_transformList[meshIndex] * scene->m_rootTransform;
@@ -26,6 +26,23 @@ namespace Renderer
 	FCommandList::Sync s_renderPassSync[AnnotatedPassCount];	
 }
 
+D3DCommandSignature_t* FIndirectDrawWithRootConstants::GetCommandSignature(D3DRootSignature_t* rootsig)
+{
+	D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
+	argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	argumentDescs[0].Constant.RootParameterIndex = 0;
+	argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
+	argumentDescs[0].Constant.Num32BitValuesToSet = 32;
+	argumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+	commandSignatureDesc.pArgumentDescs = argumentDescs;
+	commandSignatureDesc.NumArgumentDescs = 2;
+	commandSignatureDesc.ByteStride = sizeof(FIndirectDrawWithRootConstants);
+
+	return RenderBackend12::CacheCommandSignature(commandSignatureDesc, rootsig);
+}
+
 // Render Jobs
 #include "render-jobs/environmentmap.inl"
 #include "render-jobs/msaa-resolve.inl"
@@ -1615,6 +1632,8 @@ void Renderer::Render(const FRenderState& renderState)
 				cb->m_packedMeshletVertexIndexBufferIndex = scene->m_packedMeshletVertexIndexBuffer->m_descriptorIndices.SRV;
 				cb->m_packedMeshletPrimitiveIndexBufferIndex = scene->m_packedMeshletPrimitiveIndexBuffer->m_descriptorIndices.SRV;
 				cb->m_packedSceneMeshletsBufferIndex = scene->m_packedMeshlets->m_descriptorIndices.SRV;
+				cb->m_packedSceneMeshletInstancesBufferIndex = scene->m_packedMeshletInstances->m_descriptorIndices.SRV;
+				cb->m_meshInstanceCount = scene->m_sceneMeshes.GetCount();
 				cb->m_sceneMaterialBufferIndex = scene->m_packedMaterials->m_descriptorIndices.SRV;
 				cb->m_lightCount = scene->m_sceneLights.GetCount();
 				cb->m_packedLightIndicesBufferIndex = lightCount > 0 ? scene->m_packedLightIndices->m_descriptorIndices.SRV : -1;
@@ -1668,6 +1687,7 @@ void Renderer::Render(const FRenderState& renderState)
 				cb->m_mouseX = renderState.m_mouseX;
 				cb->m_mouseY = renderState.m_mouseY;
 				cb->m_viewmode = config.Viewmode;
+				cb->m_cullEyePos = renderState.m_cullingView.m_position;
 			}
 		})};
 
@@ -0,0 +1,232 @@
+#include <scene-cache-records.h>
+#include <mesh-utils.h>
+#include <vertex-quantization.h>
+#include <string>
+#include <tuple>
+
+namespace
+{
+	using namespace SceneCache;
+
+	// Collects the arrays of a mapped file. A section whose size is not a whole number of records fails the check.
+	struct FSections
+	{
+		template<typename T>
+		std::span<const T> Get(Section section)
+		{
+			const std::span<const T> records = m_reader.Get<T>(section);
+			if (records.empty() && !m_reader.GetBytes(section).empty())
+			{
+				Fail(std::string{ GetSectionName(section) } + " does not hold whole records");
+			}
+
+			return records;
+		}
+
+		void Fail(const std::string& error)
+		{
+			if (m_error.empty())
+			{
+				m_error = error;
+			}
+		}
+
+		const FReader& m_reader;
+		std::string m_error;
+	};
+
+	// Either -1 or the index of an element
+	bool IsOptionalIndex(int index, size_t count)
+	{
+		return index == -1 || (index >= 0 && (size_t)index < count);
+	}
+
+	bool IsIndex(int index, size_t count)
+	{
+		return index >= 0 && (size_t)index < count;
+	}
+
+	bool IsRange(uint64_t begin, uint64_t length, size_t count)
+	{
+		return begin <= count && length <= count - begin;
+	}
+}
+
+bool SceneCache::Validate(const FReader& reader, std::string& error)
+{
+	FSections sections{ reader, {} };
+
+	const std::span<const uint8_t> bufferData = reader.GetBytes(Section::BufferData);
+	const std::span<const FMeshBufferView> views = sections.Get<FMeshBufferView>(Section::BufferViews);
+	const std::span<const FMeshAccessor> accessors = sections.Get<FMeshAccessor>(Section::Accessors);
+	const std::span<const FAccessorFormat> accessorFormats = sections.Get<FAccessorFormat>(Section::AccessorFormats);
+	const std::span<const FMeshAssetRecord> assets = sections.Get<FMeshAssetRecord>(Section::MeshAssets);
+	const std::span<const FPrimitiveRecord> primitives = sections.Get<FPrimitiveRecord>(Section::MeshPrimitives);
+	const std::span<const FInstanceRecord> meshInstances = sections.Get<FInstanceRecord>(Section::MeshInstances);
+	const std::span<const FInstanceRecord> decalInstances = sections.Get<FInstanceRecord>(Section::DecalInstances);
+	const std::span<const FGpuPrimitive> gpuPrimitives = sections.Get<FGpuPrimitive>(Section::GpuPrimitives);
+	const std::span<const FGpuMeshlet> gpuMeshlets = sections.Get<FGpuMeshlet>(Section::GpuMeshlets);
+	const std::span<const FGpuMeshletInstance> meshletInstances = sections.Get<FGpuMeshletInstance>(Section::GpuMeshletInstances);
+	const std::span<const uint8_t> meshletVertexIndices = reader.GetBytes(Section::MeshletVertexIndices);
+	const std::span<const FInlineMeshlet::FPackedTriangle> meshletTriangleIndices = sections.Get<FInlineMeshlet::FPackedTriangle>(Section::MeshletTriangleIndices);
+	const std::span<const uint32_t> primitiveCounts = sections.Get<uint32_t>(Section::PrimitiveCounts);
+	const std::span<const FMaterial> materials = sections.Get<FMaterial>(Section::Materials);
+	const std::span<const uint64_t> textures = sections.Get<uint64_t>(Section::Textures);
+	const std::span<const FSamplerRecord> samplers = sections.Get<FSamplerRecord>(Section::Samplers);
+	const std::span<const FLight> lights = sections.Get<FLight>(Section::Lights);
+	const std::span<const FInstanceRecord> lightInstances = sections.Get<FInstanceRecord>(Section::LightInstances);
+	sections.Get<FCameraRecord>(Section::Cameras);
+
+	// Mesh buffers
+	for (const FMeshBufferView& view : views)
+	{
+		if (view.m_bufferSrvIndex != -1 && !IsRange(view.m_byteOffset, view.m_byteLength, bufferData.size()))
+		{
+			sections.Fail("Buffer view outside of the buffer data");
+		}
+	}
+
+	for (const FMeshAccessor& accessor : accessors)
+	{
+		if (!IsOptionalIndex(accessor.m_bufferViewIndex, views.size()) ||
+			(accessor.m_bufferViewIndex != -1 && accessor.m_byteOffset > views[accessor.m_bufferViewIndex].m_byteLength))
+		{
+			sections.Fail("Accessor outside of the buffer views");
+		}
+	}
+
+	if (accessorFormats.size() != accessors.size())
+	{
+		sections.Fail("Accessor format count does not match the accessors");
+	}
+
+	for (const FAccessorFormat& format : accessorFormats)
+	{
+		if (format.m_format < VertexFormat::Float || format.m_format > VertexFormat::Half2Texcoord)
+		{
+			sections.Fail("Unknown accessor format");
+		}
+	}
+
+	// Mesh assets and instances
+	auto IsAccessor = [&accessors](int index) { return IsOptionalIndex(index, accessors.size()); };
+	for (const FMeshAssetRecord& asset : assets)
+	{
+		if (!IsRange(asset.m_firstPrimitive, asset.m_primitiveCount, primitives.size()))
+		{
+			sections.Fail("Mesh asset primitives outside of the primitives");
+		}
+	}
+
+	for (const FPrimitiveRecord& primitive : primitives)
+	{
+		const FRaytracingGeometry& geometry = primitive.m_raytracingGeometry;
+		if (!IsAccessor(primitive.m_indexAccessor) || !IsAccessor(primitive.m_positionAccessor) || !IsAccessor(primitive.m_uvAccessor) ||
+			!IsAccessor(primitive.m_normalAccessor) || !IsAccessor(primitive.m_tangentAccessor))
+		{
+			sections.Fail("Primitive accessor out of range");
+		}
+
+		if (!IsOptionalIndex(primitive.m_materialIndex, materials.size()))
+		{
+			sections.Fail("Primitive material out of range");
+		}
+
+		if (!IsOptionalIndex(geometry.m_vertexBufferView, views.size()) || !IsOptionalIndex(geometry.m_indexBufferView, views.size()))
+		{
+			sections.Fail("Primitive raytracing geometry outside of the buffer views");
+		}
+	}
+
+	for (const auto& [instances, count, name] : {
+		std::tuple{ meshInstances, assets.size(), "Mesh" }, { decalInstances, assets.size(), "Decal" }, { lightInstances, lights.size(), "Light" } })
+	{
+		for (const FInstanceRecord& instance : instances)
+		{
+			if (!IsIndex(instance.m_index, count))
+			{
+				sections.Fail(std::string{ name } + " instance out of range");
+			}
+		}
+	}
+
+	// GPU geometry. Primitives and meshlet instances are packed per mesh instance, and meshlets per mesh asset.
+	if (primitiveCounts.size() != meshInstances.size() || meshletInstances.size() != meshInstances.size())
+	{
+		sections.Fail("GPU geometry does not match the mesh instances");
+	}
+
+	size_t primitiveCountSum = 0;
+	for (const uint32_t count : primitiveCounts)
+	{
+		primitiveCountSum += count;
+	}
+
+	if (primitiveCountSum != gpuPrimitives.size())
+	{
+		sections.Fail("Primitive counts do not match the GPU primitives");
+	}
+
+	auto IsMaterial = [&materials](int index) { return IsOptionalIndex(index, materials.size()); };
+	for (const FGpuPrimitive& primitive : gpuPrimitives)
+	{
+		if (!IsIndex(primitive.m_meshIndex, meshInstances.size()) || !IsAccessor(primitive.m_indexAccessor) ||
+			!IsAccessor(primitive.m_positionAccessor) || !IsAccessor(primitive.m_uvAccessor) || !IsAccessor(primitive.m_normalAccessor) ||
+			!IsAccessor(primitive.m_tangentAccessor) || !IsMaterial(primitive.m_materialIndex))
+		{
+			sections.Fail("GPU primitive index out of range");
+		}
+	}
+
+	for (const FGpuMeshlet& meshlet : gpuMeshlets)
+	{
+		if (!IsAccessor(meshlet.m_positionAccessor) || !IsAccessor(meshlet.m_uvAccessor) || !IsAccessor(meshlet.m_normalAccessor) ||
+			!IsAccessor(meshlet.m_tangentAccessor) || !IsMaterial(meshlet.m_materialIndex))
+		{
+			sections.Fail("GPU meshlet index out of range");
+		}
+
+		const bool bValidDeltaSize = meshlet.m_vertexDeltaSize == 1 || meshlet.m_vertexDeltaSize == 2 || meshlet.m_vertexDeltaSize == 4;
+		if (!bValidDeltaSize ||
+			!IsRange(meshlet.m_vertexBegin, (uint64_t)meshlet.m_vertexCount * meshlet.m_vertexDeltaSize, meshletVertexIndices.size()) ||
+			!IsRange(meshlet.m_triangleBegin, meshlet.m_triangleCount, meshletTriangleIndices.size()))
+		{
+			sections.Fail("GPU meshlet outside of the packed meshlet indices");
+		}
+	}
+
+	uint64_t instanceMeshletCount = 0;
+	for (const FGpuMeshletInstance& instance : meshletInstances)
+	{
+		if (!IsIndex(instance.m_assetIndex, assets.size()) || !IsRange(instance.m_meshletBegin, instance.m_meshletCount, gpuMeshlets.size()) ||
+			instance.m_instanceMeshletBegin != instanceMeshletCount)
+		{
+			sections.Fail("GPU meshlet instance out of range");
+		}
+
+		instanceMeshletCount += instance.m_meshletCount;
+	}
+
+	// Materials
+	for (const FMaterial& material : materials)
+	{
+		for (int FMaterial::* textureIndex : MaterialTextureIndices)
+		{
+			if (!IsOptionalIndex(material.*textureIndex, textures.size()))
+			{
+				sections.Fail("Material texture out of range");
+			}
+		}
+
+		for (int FMaterial::* samplerIndex : MaterialSamplerIndices)
+		{
+			if (!IsOptionalIndex(material.*samplerIndex, samplers.size()))
+			{
+				sections.Fail("Material sampler out of range");
+			}
+		}
+	}
+
+	error = sections.m_error;
+	return error.empty();
+}
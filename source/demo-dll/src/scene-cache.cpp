@@ -0,0 +1,211 @@
+#include <scene-cache.h>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	size_t AlignSection(size_t offset)
+	{
+		return (offset + SceneCache::SectionAlignment - 1) & ~(SceneCache::SectionAlignment - 1);
+	}
+}
+
+void SceneCache::FWriter::Add(Section section, const void* data, size_t size)
+{
+	std::vector<uint8_t>& dest = m_sections[(size_t)section];
+	dest.insert(dest.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+SceneCache::FStringRecord SceneCache::FWriter::AddString(const std::string& str)
+{
+	std::vector<uint8_t>& strings = m_sections[(size_t)Section::Strings];
+	const FStringRecord record = { (uint32_t)strings.size(), (uint32_t)str.size() };
+	strings.insert(strings.end(), str.cbegin(), str.cend());
+	strings.push_back(0);
+	return record;
+}
+
+bool SceneCache::FWriter::Save(const std::string& filename, uint64_t sourceKey) const
+{
+	FHeader header = {};
+	header.m_magic = Magic;
+	header.m_version = Version;
+	header.m_sourceKey = sourceKey;
+
+	size_t offset = AlignSection(sizeof(FHeader));
+	for (size_t section = 0; section < (size_t)Section::Count; ++section)
+	{
+		header.m_sections[section] = { offset, m_sections[section].size() };
+		offset = AlignSection(offset + m_sections[section].size());
+	}
+
+	header.m_fileSize = offset;
+
+	const std::string tempFilename = filename + ".tmp";
+	{
+		std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		const char padding[SectionAlignment] = {};
+		file.write((const char*)&header, sizeof(header));
+		file.write(padding, header.m_sections[0].m_offset - sizeof(header));
+		for (size_t section = 0; section < (size_t)Section::Count; ++section)
+		{
+			const FSectionEntry& entry = header.m_sections[section];
+			file.write((const char*)m_sections[section].data(), entry.m_size);
+
+			const size_t end = section + 1 < (size_t)Section::Count ? header.m_sections[section + 1].m_offset : header.m_fileSize;
+			file.write(padding, end - (entry.m_offset + entry.m_size));
+		}
+
+		if (!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempFilename, filename, error);
+	return !error;
+}
+
+SceneCache::FReader::~FReader()
+{
+	Close();
+}
+
+bool SceneCache::FReader::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(file, &fileSize);
+	m_mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	CloseHandle(file);
+	if (!m_mapping)
+		return false;
+
+	m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	m_size = fileSize.QuadPart;
+#else
+	const int file = open(filename.c_str(), O_RDONLY);
+	if (file == -1)
+		return false;
+
+	struct stat fileStat = {};
+	fstat(file, &fileStat);
+	void* view = fileStat.st_size > 0 ? mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+	close(file);
+
+	m_data = view != MAP_FAILED ? (const uint8_t*)view : nullptr;
+	m_size = fileStat.st_size;
+#endif
+
+	if (!m_data || m_size < sizeof(FHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const FHeader* header = (const FHeader*)m_data;
+	bool bValid = header->m_magic == Magic && header->m_version == Version && header->m_fileSize == m_size;
+	for (size_t section = 0; bValid && section < (size_t)Section::Count; ++section)
+	{
+		const FSectionEntry& entry = header->m_sections[section];
+		bValid = entry.m_offset % SectionAlignment == 0 && entry.m_offset <= m_size && entry.m_size <= m_size - entry.m_offset;
+	}
+
+	if (!bValid)
+	{
+		Close();
+		return false;
+	}
+
+	m_header = header;
+	return true;
+}
+
+void SceneCache::FReader::Close()
+{
+	if (m_data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap((void*)m_data, m_size);
+#endif
+	}
+
+#ifdef _WIN32
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+#endif
+
+	m_header = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+}
+
+std::span<const uint8_t> SceneCache::FReader::GetBytes(Section section) const
+{
+	if (!m_header)
+		return {};
+
+	const FSectionEntry& entry = m_header->m_sections[(size_t)section];
+	return { m_data + entry.m_offset, (size_t)entry.m_size };
+}
+
+std::string SceneCache::FReader::GetString(const FStringRecord& record) const
+{
+	const std::span<const uint8_t> strings = GetBytes(Section::Strings);
+	if ((size_t)record.m_offset + record.m_length > strings.size())
+		return {};
+
+	return std::string{ (const char*)strings.data() + record.m_offset, record.m_length };
+}
+
+const char* SceneCache::GetSectionName(Section section)
+{
+	switch (section)
+	{
+	case Section::BufferData: return "BufferData";
+	case Section::BufferViews: return "BufferViews";
+	case Section::Accessors: return "Accessors";
+	case Section::AccessorFormats: return "AccessorFormats";
+	case Section::MeshAssets: return "MeshAssets";
+	case Section::MeshPrimitives: return "MeshPrimitives";
+	case Section::MeshInstances: return "MeshInstances";
+	case Section::DecalInstances: return "DecalInstances";
+	case Section::GpuPrimitives: return "GpuPrimitives";
+	case Section::GpuMeshlets: return "GpuMeshlets";
+	case Section::GpuMeshletInstances: return "GpuMeshletInstances";
+	case Section::MeshletVertexIndices: return "MeshletVertexIndices";
+	case Section::MeshletTriangleIndices: return "MeshletTriangleIndices";
+	case Section::PrimitiveCounts: return "PrimitiveCounts";
+	case Section::Materials: return "Materials";
+	case Section::Textures: return "Textures";
+	case Section::Samplers: return "Samplers";
+	case Section::Lights: return "Lights";
+	case Section::LightInstances: return "LightInstances";
+	case Section::Cameras: return "Cameras";
+	case Section::Strings: return "Strings";
+	default: return "Unknown";
+	}
+}
@@ -3,11 +3,18 @@
 #include <backend-d3d12.h>
 #include <common.h>
 #include <mesh-utils.h>
+#include <vertex-quantization.h>
+#include <accessor-view.h>
+#include <texture-pipeline.h>
+#include <image-decode.h>
+#include <content-cache.h>
 #include <gpu-shared-types.h>
 #include <concurrent_unordered_map.h>
 #include <ppltasks.h>
 #include <ppl.h>
 #include <dxcapi.h>
+#include <stb_image.h>
+#include <chrono>
 #include <scene.h>
 
 bool LoadImageCallback(
@@ -21,62 +28,32 @@ bool LoadImageCallback(
 	int size,
 	void* user_data)
 {
-	const char* pathStr = (const char*)user_data;
-	std::filesystem::path dirPath{ pathStr };
-	std::filesystem::path srcFilename{ image->uri };
-	std::filesystem::path destFilename = dirPath / srcFilename.stem();
-	destFilename += std::filesystem::path{ ".dds" };
-
-	if (Demo::GetConfig().UseContentCache && std::filesystem::exists(destFilename))
-	{
-		// Skip image data initialization. We will load compressed file from the cache instead
-		image->image.clear();
-		image->uri = destFilename.string();
-		return true;
-	}
-	else
+	// Keep the encoded image and only read its dimensions. The encoded bytes key the texture cache, and decoding is left to the
+	// texture pipeline so that it runs in parallel.
+	int width, height, component;
+	if (!stbi_info_from_memory(bytes, size, &width, &height, &component))
 	{
-		// Initialize image data using built-in loader
-		bool ok = tinygltf::LoadImageData(image, image_idx, err, warn, req_width, req_height, bytes, size, user_data);
-		if (ok)
+		if (err)
 		{
-			DebugAssert(image->pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE);
-			size_t bpp = (image->bits * 4) / 8;
-			size_t rowPitch = bpp * image->width;
-
-			// If the image has less than 4 components, pad in the remaining channels.
-			if (image->component < 4)
-			{
-				std::vector<uint8_t> originalImageData{ image->image };
-				size_t originalBpp = (image->bits * image->component) / 8;
-				size_t originalRowPitch = originalBpp * image->width;
-
-				image->image.resize(rowPitch * image->height);
-				for (int row = 0; row < image->height; ++row)
-				{
-					for (int col = 0; col < image->width; ++col)
-					{
-						const size_t srcPixelOffset = row * originalRowPitch + col * originalBpp;
-						const size_t destPixelOffset = row * rowPitch + col * bpp;
-						image->image[destPixelOffset + 0] = originalImageData[srcPixelOffset + 0];
-						image->image[destPixelOffset + 1] = image->component > 1 ? originalImageData[srcPixelOffset + 1] : 0;
-						image->image[destPixelOffset + 2] = image->component > 2 ? originalImageData[srcPixelOffset + 2] : 0;
-						image->image[destPixelOffset + 3] = image->component > 3 ? originalImageData[srcPixelOffset + 3] : 255;
-					}
-				}
-
-				image->component = 4;
-			}
+			*err += "Unknown image format. " + std::string{ stbi_failure_reason() } + "\n";
 		}
 
-		return ok;
+		return false;
 	}
+
+	image->width = width;
+	image->height = height;
+	image->component = 4;
+	image->bits = 8;
+	image->pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+	image->image.assign(bytes, bytes + size);
+	return true;
 }
 
-std::string GetContentCachePath(const std::string filename)
+std::string GetContentCachePath(const std::string filename, const char* dirName = ".content-cache")
 {
 	std::filesystem::path filepath{ filename };
-	std::filesystem::path dir{ ".content-cache" };
+	std::filesystem::path dir{ dirName };
 	std::filesystem::path dirPath = filepath.parent_path() / dir;
 
 	if (!std::filesystem::exists(dirPath))
@@ -88,21 +65,271 @@ std::string GetContentCachePath(const std::string filename)
 	return dirPath.string();
 }
 
+namespace
+{
+	using SceneCache::FMeshAssetRecord;
+	using SceneCache::FPrimitiveRecord;
+	using SceneCache::FInstanceRecord;
+	using SceneCache::FSamplerRecord;
+	using SceneCache::FCameraRecord;
+	using SceneCache::MaterialTextureIndices;
+	using SceneCache::MaterialSamplerIndices;
+
+	// Identifies the content that a scene cache is generated from, and the settings that change the generated data. The source 
+	// files are identified by MeshUtils::HashModelFiles() instead of parsing the GLTF for its buffers and images.
+	uint64_t GetSceneCacheKey(uint64_t modelFilesKey)
+	{
+		uint64_t seed1 = SceneCache::Version, seed2 = 0;
+		spookyhash_context context;
+		spookyhash_context_init(&context, seed1, seed2);
+		spookyhash_update(&context, &modelFilesKey, sizeof(modelFilesKey));
+
+		const FConfig& config = Demo::GetConfig();
+		const uint32_t settings[] = 
+		{ 
+			config.CompactVertexFormat, 
+			(uint32_t)config.MeshletizeChunkSize, 
+			MeshUtils::MeshletizerVersion, 
+			MeshUtils::DrawOrderVersion 
+		};
+		spookyhash_update(&context, settings, sizeof(settings));
+		spookyhash_update(&context, &config.CameraNearPlane, sizeof(config.CameraNearPlane));
+		spookyhash_final(&context, &seed1, &seed2);
+
+		return seed1 ^ (seed2 << 1);
+	}
+
+	// The scene cache only stores the packed GPU geometry. The CPU meshlets and the cluster DAG that is built over them are not in
+	// it, so scenes that generate cluster LOD are always loaded from the GLTF model.
+	bool UseSceneCache()
+	{
+		const FConfig& config = Demo::GetConfig();
+		return config.UseContentCache && !config.GenerateClusterLod;
+	}
+
+	// The scene cache only references the compressed textures, which have to be in the texture cache
+	bool HasCachedTextures(const SceneCache::FReader& sceneCache, const ContentCache::FManifest& textureManifest)
+	{
+		for (const uint64_t key : sceneCache.Get<uint64_t>(SceneCache::Section::Textures))
+		{
+			if (!textureManifest.Find(key))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Mesh buffers of all the model loaders. See FGeometryArenaRange.
+	struct FGeometryArena
+	{
+		std::mutex m_mutex;
+		FFreeListAllocator m_allocator;
+		std::unique_ptr<FShaderBuffer> m_buffer;
+	};
+
+	FGeometryArena s_geometryArena;
+
+	// Also keeps the 16 byte alignment of the packed buffer views
+	constexpr size_t GeometryArenaAlignment = 256;
+}
+
+FGeometryArenaRange::FGeometryArenaRange(FGeometryArenaRange&& other) noexcept :
+	m_offset{ other.m_offset },
+	m_size{ other.m_size },
+	m_dedicatedBuffer{ std::move(other.m_dedicatedBuffer) }
+{
+	other.m_offset = FFreeListAllocator::InvalidOffset;
+	other.m_size = 0;
+}
+
+FGeometryArenaRange& FGeometryArenaRange::operator=(FGeometryArenaRange&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		std::swap(m_offset, other.m_offset);
+		std::swap(m_size, other.m_size);
+		std::swap(m_dedicatedBuffer, other.m_dedicatedBuffer);
+	}
+
+	return *this;
+}
+
+FGeometryArenaRange::~FGeometryArenaRange()
+{
+	Release();
+}
+
+FGeometryArenaRange FGeometryArenaRange::Allocate(size_t size)
+{
+	FGeometryArenaRange range;
+	if (size == 0)
+		return range;
+
+	AbortOnFailure(size <= MaxSize, "Geometry arena range is larger than a raw buffer view can address", nullptr);
+
+	std::lock_guard<std::mutex> lock{ s_geometryArena.m_mutex };
+	if (!s_geometryArena.m_buffer)
+	{
+		const size_t capacity = std::min<size_t>((size_t)Demo::GetConfig().GeometryArenaSizeMB << 20, MaxSize);
+		s_geometryArena.m_allocator = FFreeListAllocator{ capacity };
+		s_geometryArena.m_buffer.reset(RenderBackend12::CreateNewShaderBuffer({
+			.name = L"scene_geometry_arena",
+			.type = FShaderBuffer::Type::Raw,
+			.accessMode = FResource::AccessMode::GpuReadOnly,
+			.alloc = FResource::Allocation::Persistent(),
+			.size = capacity
+		}));
+	}
+
+	range.m_offset = s_geometryArena.m_allocator.Allocate(size, GeometryArenaAlignment);
+	range.m_size = size;
+	if (range.IsValid())
+		return range;
+
+	// Scenes that are larger than the arena still load, at the cost of a descriptor and an allocation per range
+	if (s_geometryArena.m_allocator.GetAllocationCount() == 0)
+	{
+		s_geometryArena.m_buffer.reset(nullptr);
+	}
+
+	Print("Geometry arena is full, allocating a dedicated %u MB buffer. Increase FConfig::GeometryArenaSizeMB to avoid this.\n", (uint32_t)(size >> 20));
+	range.m_dedicatedBuffer.reset(RenderBackend12::CreateNewShaderBuffer({
+		.name = L"scene_geometry_dedicated",
+		.type = FShaderBuffer::Type::Raw,
+		.accessMode = FResource::AccessMode::GpuReadOnly,
+		.alloc = FResource::Allocation::Persistent(),
+		.size = GetAlignedSize(4, size)
+	}));
+
+	AbortOnFailure(range.m_dedicatedBuffer != nullptr, "Failed to allocate a geometry buffer", nullptr);
+	range.m_offset = 0;
+	return range;
+}
+
+void FGeometryArenaRange::Release()
+{
+	if (!IsValid())
+		return;
+
+	if (m_dedicatedBuffer)
+	{
+		m_dedicatedBuffer.reset(nullptr);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock{ s_geometryArena.m_mutex };
+		s_geometryArena.m_allocator.Free(m_offset);
+		if (s_geometryArena.m_allocator.GetAllocationCount() == 0)
+		{
+			s_geometryArena.m_buffer.reset(nullptr);
+		}
+	}
+
+	m_offset = FFreeListAllocator::InvalidOffset;
+	m_size = 0;
+}
+
+void FGeometryArenaRange::Upload(const std::vector<std::pair<size_t, std::span<const uint8_t>>>& chunks) const
+{
+	SCOPED_CPU_EVENT("upload_geometry_arena", PIX_COLOR_DEFAULT);
+	DebugAssert(IsValid());
+
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_geometry_arena", D3D12_COMMAND_LIST_TYPE_DIRECT);
+	std::unique_ptr<FSystemBuffer> uploadBuffer{ RenderBackend12::CreateNewSystemBuffer({
+		.name = L"geometry_arena_upload",
+		.accessMode = FResource::AccessMode::CpuWriteOnly,
+		.alloc = FResource::Allocation::Transient(cmdList->GetFence(FCommandList::SyncPoint::GpuFinish)),
+		.size = m_size,
+		.uploadCallback = [&chunks, size = m_size](uint8_t* pDest)
+		{
+			for (const auto& [offset, data] : chunks)
+			{
+				DebugAssert(offset + data.size() <= size);
+				memcpy(pDest + offset, data.data(), data.size());
+			}
+		}
+	}) };
+
+	// The copy is recorded on the direct queue so that it is ordered with the draws that read the rest of the arena
+	FResource* arena = m_dedicatedBuffer ? m_dedicatedBuffer->m_resource : s_geometryArena.m_buffer->m_resource;
+	arena->Transition(cmdList, arena->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COPY_DEST);
+	cmdList->m_d3dCmdList->CopyBufferRegion(arena->m_d3dResource, m_offset, uploadBuffer->m_resource->m_d3dResource, 0, m_size);
+	arena->Transition(cmdList, arena->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+}
+
+uint32_t FGeometryArenaRange::GetSrvIndex() const
+{
+	const FShaderBuffer* buffer = m_dedicatedBuffer ? m_dedicatedBuffer.get() : s_geometryArena.m_buffer.get();
+	return buffer ? buffer->m_descriptorIndices.SRV : ~0u;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS FGeometryArenaRange::GetGpuAddress() const
+{
+	const FShaderBuffer* buffer = m_dedicatedBuffer ? m_dedicatedBuffer.get() : s_geometryArena.m_buffer.get();
+	return buffer ? buffer->m_resource->m_d3dResource->GetGPUVirtualAddress() : 0;
+}
+
 void FScene::ReloadModel(const std::wstring& filename)
 {
 	SCOPED_CPU_EVENT("reload_model", PIX_COLOR_DEFAULT);
 
-	std::string modelFilepath = GetFilepathA(ws2s(filename));
+	const std::string modelFilepath = GetFilepathA(ws2s(filename));
 	FScene::s_loadProgress = 0.f;
 
-	tinygltf::TinyGLTF loader;
 	m_textureCachePath = GetContentCachePath(modelFilepath);
-	const char* path = m_textureCachePath.c_str();
-	loader.SetImageLoader(&LoadImageCallback, (void*)path);
+	m_modelCachePath = GetContentCachePath(modelFilepath, ".model-cache");
+	m_modelFilename = filename;
+
+	// Textures are looked up in the manifest of the texture cache, which is read once here
+	m_textureManifest = {};
+	if (Demo::GetConfig().UseContentCache)
+	{
+		m_textureManifest.Open(m_textureCachePath);
+	}
+
+	// Models that were loaded before from the same content and with the same settings are mapped from the scene cache
+	std::filesystem::path sceneCacheFilepath = std::filesystem::path{ m_modelCachePath } / std::filesystem::path{ filename }.stem();
+	sceneCacheFilepath += std::filesystem::path{ ".scene-cache" };
+	const uint64_t modelFilesKey = Demo::GetConfig().UseContentCache ? MeshUtils::HashModelFiles(modelFilepath) : 0;
+	const uint64_t sceneCacheKey = UseSceneCache() ? GetSceneCacheKey(modelFilesKey) : 0;
+
+	// A cache that doesn't pass the checks, or whose textures fail to load, is regenerated from the GLTF model
+	const auto loadStart = std::chrono::steady_clock::now();
+	SceneCache::FReader sceneCache;
+	std::string sceneCacheError;
+	if (UseSceneCache() && 
+		sceneCache.Open(sceneCacheFilepath.string()) && 
+		sceneCache.GetSourceKey() == sceneCacheKey &&
+		HasCachedTextures(sceneCache, m_textureManifest))
+	{
+		if (SceneCache::Validate(sceneCache, sceneCacheError))
+		{
+			Clear();
+			if (LoadSceneCache(sceneCache, sceneCacheError))
+			{
+				const auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart);
+				Print("Loaded scene cache %s in %u ms\n", sceneCacheFilepath.string().c_str(), (uint32_t)loadTime.count());
+				return;
+			}
+		}
+
+		Print("Scene cache %s rejected: %s\n", sceneCacheFilepath.string().c_str(), sceneCacheError.c_str());
+	}
+
+	sceneCache.Close();
+	LoadGltf(modelFilepath, modelFilesKey, sceneCacheFilepath.string(), sceneCacheKey);
+}
+
+void FScene::LoadGltf(const std::string& gltfFilepath, uint64_t modelFilesKey, const std::string& sceneCacheFilepath, uint64_t sceneCacheKey)
+{
+	tinygltf::TinyGLTF loader;
+	loader.SetImageLoader(&LoadImageCallback, nullptr);
 
 	// Load from model cache if a cached version exists
-	m_modelCachePath = GetContentCachePath(modelFilepath);
-	std::filesystem::path cachedFilepath = std::filesystem::path{ m_modelCachePath } / std::filesystem::path{ ws2s(filename) };
+	std::string modelFilepath = gltfFilepath;
+	std::filesystem::path cachedFilepath = std::filesystem::path{ m_modelCachePath } / std::filesystem::path{ ws2s(m_modelFilename) };
 	if (Demo::GetConfig().UseContentCache && std::filesystem::exists(cachedFilepath))
 	{
 		modelFilepath = cachedFilepath.string();
@@ -132,17 +359,23 @@ void FScene::ReloadModel(const std::wstring& filename)
 		FScene::s_loadProgress += FScene::s_modelLoadTimeFrac;
 	}
 
-	m_modelFilename = filename;
-
 	// Clear previous scene
 	Clear();
 
+	// Generated tangents and meshlets are cached per model and keyed by the content of the primitives they were generated from
+	FModelCache meshCache;
+	std::filesystem::path meshCacheFilepath = std::filesystem::path{ m_modelCachePath } / std::filesystem::path{ m_modelFilename }.stem();
+	meshCacheFilepath += std::filesystem::path{ ".mesh-cache" };
+	if (Demo::GetConfig().UseContentCache)
+	{
+		const uint64_t sourceKey = modelFilepath == gltfFilepath ? modelFilesKey : MeshUtils::HashModelFiles(modelFilepath);
+		MeshUtils::LoadModelCache(meshCacheFilepath.string(), sourceKey, meshCache);
+	}
+
 	// Load assets
-	bool requiresResave = MeshUtils::FixupMeshes(model);
+	MeshUtils::FixupMeshes(model, meshCache);
 	FScene::s_loadProgress += FScene::s_meshFixupTimeFrac;
-	LoadMeshBuffers(model);
-	LoadMeshBufferViews(model);
-	LoadMeshAccessors(model);
+	BeginTextureLoads();
 	LoadMaterials(model);
 	LoadLights(model);
 
@@ -158,6 +391,7 @@ void FScene::ReloadModel(const std::wstring& filename)
 
 	// Parse GLTF and initialize scene
 	// See https://github.com/KhronosGroup/glTF-Tutorials/blob/master/gltfTutorial/gltfTutorial_003_MinimalGltfFile.md
+	m_meshAssets.resize(model.meshes.size());
 	for (tinygltf::Scene& scene : model.scenes)
 	{
 		for (const int nodeIndex : scene.nodes)
@@ -166,6 +400,57 @@ void FScene::ReloadModel(const std::wstring& filename)
 		}
 	}
 
+	// Meshlet generation reorders the vertex streams, so the mesh buffers are uploaded after it
+	GenerateMeshlets(model, meshCache);
+	if (Demo::GetConfig().UseContentCache)
+	{
+		MeshUtils::SaveModelCache(meshCacheFilepath.string(), meshCache);
+	}
+
+	// The meshlets, bounds and cached data above are all generated from the float streams
+	m_accessorFormats.clear();
+	if (Demo::GetConfig().CompactVertexFormat)
+	{
+		VertexQuantization::CompactVertexStreams(model, m_accessorFormats);
+		PadBoundsForQuantization();
+	}
+
+	LoadMeshBuffers(model);
+	LoadMeshBufferViews(model);
+	LoadMeshAccessors(model);
+	ResolveRaytracingGeometry(model);
+
+	FPackedGpuGeometry geometry;
+	PackGpuGeometry(geometry);
+	CreateGpuGeometryBuffers(geometry.GetView());
+	FinalizeLoad();
+
+	// Textures are loaded while the meshes are processed above. The model has to outlive this, since the pipeline decodes its images.
+	FinishTextureLoads();
+
+	// Wait for all loading jobs to finish
+	auto joinTask = concurrency::when_all(std::begin(m_loadingJobs), std::end(m_loadingJobs));
+	joinTask.wait();
+	m_loadingJobs.clear();
+
+	// The scene cache references the compressed textures, which are only all written once the loading jobs are done
+	if (Demo::GetConfig().UseContentCache)
+	{
+		if (!m_textureManifest.Save())
+		{
+			Print("Failed to save texture cache manifest in %s\n", m_textureCachePath.c_str());
+		}
+	}
+
+	if (UseSceneCache())
+	{
+		SaveSceneCache(model, geometry, sceneCacheFilepath, sceneCacheKey);
+	}
+}
+
+// Work that is shared by scenes that are loaded from GLTF and from the scene cache
+void FScene::FinalizeLoad()
+{
 	// Scene bounds
 	std::vector<DirectX::BoundingBox> meshWorldBounds(m_sceneMeshes.m_objectSpaceBoundsList.size());
 	for (int i = 0; i < meshWorldBounds.size(); ++i)
@@ -194,28 +479,301 @@ void FScene::ReloadModel(const std::wstring& filename)
 		UpdateDynamicSky();
 	}
 
-	GenerateMeshlets(model);
-	CreateAccelerationStructures(model);
-	CreateGpuGeometryBuffers();
+	CreateAccelerationStructures();
 	CreateGpuLightBuffers();
+}
 
-	// Primitive & meshlet counts
-	m_primitiveCount = 0;
-	m_meshletCount = 0;
-	for (const FMesh& mesh : m_sceneMeshes.m_entityList)
+void FScene::SaveSceneCache(const tinygltf::Model& model, const FPackedGpuGeometry& geometry, const std::string& filename, uint64_t key) const
+{
+	SCOPED_CPU_EVENT("save_scene_cache", PIX_COLOR_DEFAULT);
+	using SceneCache::Section;
+
+	SceneCache::FWriter writer;
+
+	// Mesh buffers, packed the same way as they are in the geometry arena
+	const std::vector<FMeshBufferView> bufferViews = PackMeshBufferViews(model);
+	const std::vector<std::span<const uint8_t>> bufferViewData = GetMeshBufferViewData(model);
+	std::vector<uint8_t> bufferData;
+	for (size_t viewIndex = 0; viewIndex < bufferViews.size(); ++viewIndex)
 	{
-		m_primitiveCount += mesh.m_primitives.size();
+		const FMeshBufferView& view = bufferViews[viewIndex];
+		if (view.m_bufferSrvIndex != -1)
+		{
+			bufferData.resize(std::max<size_t>(bufferData.size(), view.m_byteOffset + view.m_byteLength));
+			memcpy(bufferData.data() + view.m_byteOffset, bufferViewData[viewIndex].data(), view.m_byteLength);
+		}
+	}
 
+	writer.Add(Section::BufferData, bufferData);
+	writer.Add(Section::BufferViews, bufferViews);
+	writer.Add(Section::Accessors, PackMeshAccessors(model));
+	writer.Add(Section::AccessorFormats, m_accessorFormats);
+
+	// Mesh assets and their primitives
+	std::vector<FMeshAssetRecord> assets;
+	std::vector<FPrimitiveRecord> primitives;
+	for (const FMesh& mesh : m_meshAssets)
+	{
+		assets.push_back({ (uint32_t)primitives.size(), (uint32_t)mesh.m_primitives.size(), mesh.m_bounds });
 		for (const FMeshPrimitive& primitive : mesh.m_primitives)
 		{
-			m_meshletCount += primitive.m_meshlets.size();
+			primitives.push_back({
+				primitive.m_indexAccessor,
+				primitive.m_positionAccessor,
+				primitive.m_uvAccessor,
+				primitive.m_normalAccessor,
+				primitive.m_tangentAccessor,
+				0,
+				primitive.m_indexCount,
+				primitive.m_topology,
+				primitive.m_materialIndex,
+				primitive.m_boundingSphere,
+				primitive.m_raytracingGeometry });
 		}
 	}
 
-	// Wait for all loading jobs to finish
-	auto joinTask = concurrency::when_all(std::begin(m_loadingJobs), std::end(m_loadingJobs));
-	joinTask.wait();
-	m_loadingJobs.clear();
+	writer.Add(Section::MeshAssets, assets);
+	writer.Add(Section::MeshPrimitives, primitives);
+
+	// Entities
+	auto AddInstances = [&writer](Section section, const auto& entities)
+	{
+		std::vector<FInstanceRecord> instances(entities.GetCount());
+		for (int i = 0; i < instances.size(); ++i)
+		{
+			instances[i].m_index = entities.m_entityList[i];
+			instances[i].m_visible = i < entities.m_visibleList.size() ? entities.m_visibleList[i] : 1;
+			instances[i].m_transform = entities.m_transformList[i];
+			instances[i].m_bounds = i < entities.m_objectSpaceBoundsList.size() ? entities.m_objectSpaceBoundsList[i] : DirectX::BoundingBox{};
+			instances[i].m_name = writer.AddString(entities.m_entityNames[i]);
+		}
+
+		writer.Add(section, instances);
+	};
+
+	AddInstances(Section::MeshInstances, m_sceneMeshes);
+	AddInstances(Section::DecalInstances, m_sceneMeshDecals);
+	AddInstances(Section::LightInstances, m_sceneLights);
+
+	// GPU geometry
+	writer.Add(Section::GpuPrimitives, geometry.m_primitives);
+	writer.Add(Section::GpuMeshlets, geometry.m_meshlets);
+	writer.Add(Section::GpuMeshletInstances, geometry.m_meshletInstances);
+	writer.Add(Section::MeshletVertexIndices, geometry.m_meshletVertexIndices);
+	writer.Add(Section::MeshletTriangleIndices, geometry.m_meshletTriangleIndices);
+	writer.Add(Section::PrimitiveCounts, geometry.m_primitiveCounts);
+
+	// Materials reference textures by their key in the texture cache, and samplers by their description, since the descriptor
+	// indices depend on what else was loaded before
+	std::unordered_map<int, tinygltf::Sampler> samplers;
+	for (const auto& [sampler, index] : Demo::GetSamplerCache().m_cachedSamplers)
+	{
+		samplers[(int)index] = sampler;
+	}
+
+	std::vector<FMaterial> materials = m_materialList;
+	std::vector<uint64_t> textureRecords;
+	std::vector<FSamplerRecord> samplerRecords;
+	std::unordered_map<int, int> textureRemap, samplerRemap;
+	for (FMaterial& material : materials)
+	{
+		for (int FMaterial::* textureIndex : MaterialTextureIndices)
+		{
+			const int srvIndex = material.*textureIndex;
+			if (srvIndex == -1)
+				continue;
+
+			auto remapIt = textureRemap.find(srvIndex);
+			if (remapIt == textureRemap.cend())
+			{
+				// Textures that were not written to the texture cache can't be restored
+				auto keyIt = m_textureKeys.find(srvIndex);
+				if (keyIt == m_textureKeys.cend() || !m_textureManifest.Find(keyIt->second))
+				{
+					Print("Scene cache skipped: texture %d is not in the texture cache\n", srvIndex);
+					return;
+				}
+
+				remapIt = textureRemap.insert({ srvIndex, (int)textureRecords.size() }).first;
+				textureRecords.push_back(keyIt->second);
+			}
+
+			material.*textureIndex = remapIt->second;
+		}
+
+		for (int FMaterial::* samplerIndex : MaterialSamplerIndices)
+		{
+			const int descriptorIndex = material.*samplerIndex;
+			if (descriptorIndex == -1)
+				continue;
+
+			auto remapIt = samplerRemap.find(descriptorIndex);
+			if (remapIt == samplerRemap.cend())
+			{
+				const tinygltf::Sampler& sampler = samplers.at(descriptorIndex);
+				remapIt = samplerRemap.insert({ descriptorIndex, (int)samplerRecords.size() }).first;
+				samplerRecords.push_back({ sampler.minFilter, sampler.magFilter, sampler.wrapS, sampler.wrapT });
+			}
+
+			material.*samplerIndex = remapIt->second;
+		}
+	}
+
+	writer.Add(Section::Materials, materials);
+	writer.Add(Section::Textures, textureRecords);
+	writer.Add(Section::Samplers, samplerRecords);
+
+	// Lights and cameras
+	writer.Add(Section::Lights, m_globalLightList);
+
+	std::vector<FCameraRecord> cameras;
+	for (const FCamera& camera : m_cameras)
+	{
+		cameras.push_back({ camera.m_viewTransform, camera.m_projectionTransform, writer.AddString(camera.m_name) });
+	}
+
+	writer.Add(Section::Cameras, cameras);
+
+	if (!writer.Save(filename, key))
+	{
+		Print("Failed to save scene cache %s\n", filename.c_str());
+	}
+}
+
+bool FScene::LoadSceneCache(const SceneCache::FReader& sceneCache, std::string& error)
+{
+	SCOPED_CPU_EVENT("load_scene_cache", PIX_COLOR_DEFAULT);
+	using SceneCache::Section;
+
+	// Mesh buffers are packed already, and are uploaded straight from the mapped file
+	const std::span<const uint8_t> bufferData = sceneCache.GetBytes(Section::BufferData);
+	const std::span<const FMeshBufferView> views = sceneCache.Get<FMeshBufferView>(Section::BufferViews);
+	std::vector<std::span<const uint8_t>> viewData(views.size());
+	for (size_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
+	{
+		const FMeshBufferView& view = views[viewIndex];
+		if (view.m_bufferSrvIndex != -1)
+		{
+			viewData[viewIndex] = bufferData.subspan(view.m_byteOffset, view.m_byteLength);
+		}
+	}
+
+	const std::span<const FAccessorFormat> accessorFormats = sceneCache.Get<FAccessorFormat>(Section::AccessorFormats);
+	m_accessorFormats.assign(accessorFormats.begin(), accessorFormats.end());
+
+	CreateMeshBuffers(views, viewData);
+	CreateMeshBufferViews(std::vector<FMeshBufferView>(views.begin(), views.end()));
+	CreateMeshAccessors(sceneCache.Get<FMeshAccessor>(Section::Accessors));
+
+	// Mesh assets
+	const std::span<const FPrimitiveRecord> primitives = sceneCache.Get<FPrimitiveRecord>(Section::MeshPrimitives);
+	for (const FMeshAssetRecord& assetRecord : sceneCache.Get<FMeshAssetRecord>(Section::MeshAssets))
+	{
+		FMesh& asset = m_meshAssets.emplace_back();
+		asset.m_bounds = assetRecord.m_bounds;
+		for (const FPrimitiveRecord& record : primitives.subspan(assetRecord.m_firstPrimitive, assetRecord.m_primitiveCount))
+		{
+			FMeshPrimitive& primitive = asset.m_primitives.emplace_back();
+			primitive.m_indexAccessor = record.m_indexAccessor;
+			primitive.m_positionAccessor = record.m_positionAccessor;
+			primitive.m_uvAccessor = record.m_uvAccessor;
+			primitive.m_normalAccessor = record.m_normalAccessor;
+			primitive.m_tangentAccessor = record.m_tangentAccessor;
+			primitive.m_indexCount = record.m_indexCount;
+			primitive.m_topology = record.m_topology;
+			primitive.m_materialIndex = record.m_materialIndex;
+			primitive.m_boundingSphere = record.m_boundingSphere;
+			primitive.m_raytracingGeometry = record.m_raytracingGeometry;
+		}
+	}
+
+	// Entities
+	auto LoadInstances = [&sceneCache](Section section, auto& entities)
+	{
+		for (const FInstanceRecord& instance : sceneCache.Get<FInstanceRecord>(section))
+		{
+			entities.m_entityList.push_back(instance.m_index);
+			entities.m_entityNames.push_back(sceneCache.GetString(instance.m_name));
+			entities.m_transformList.push_back(instance.m_transform);
+			if (section != Section::LightInstances)
+			{
+				entities.m_visibleList.push_back(instance.m_visible);
+				entities.m_objectSpaceBoundsList.push_back(instance.m_bounds);
+			}
+		}
+	};
+
+	LoadInstances(Section::MeshInstances, m_sceneMeshes);
+	LoadInstances(Section::DecalInstances, m_sceneMeshDecals);
+	LoadInstances(Section::LightInstances, m_sceneLights);
+
+	// Materials
+	{
+		SCOPED_CPU_EVENT("load_materials", PIX_COLOR_DEFAULT);
+
+		BeginTextureLoads();
+		std::vector<int> textures;
+		for (const uint64_t key : sceneCache.Get<uint64_t>(Section::Textures))
+		{
+			textures.push_back(LoadCachedTexture(key));
+		}
+
+		FinishTextureLoads();
+		if (std::find(textures.cbegin(), textures.cend(), -1) != textures.cend())
+		{
+			error = "Texture is not in the texture cache";
+			return false;
+		}
+
+		std::vector<int> samplers;
+		for (const FSamplerRecord& record : sceneCache.Get<FSamplerRecord>(Section::Samplers))
+		{
+			tinygltf::Sampler sampler = {};
+			sampler.minFilter = record.m_minFilter;
+			sampler.magFilter = record.m_magFilter;
+			sampler.wrapS = record.m_wrapS;
+			sampler.wrapT = record.m_wrapT;
+			samplers.push_back(Demo::GetSamplerCache().CacheSampler(sampler));
+		}
+
+		const std::span<const FMaterial> materials = sceneCache.Get<FMaterial>(Section::Materials);
+		m_materialList.assign(materials.begin(), materials.end());
+		for (FMaterial& material : m_materialList)
+		{
+			for (int FMaterial::* textureIndex : MaterialTextureIndices)
+			{
+				material.*textureIndex = material.*textureIndex != -1 ? textures.at(material.*textureIndex) : -1;
+			}
+
+			for (int FMaterial::* samplerIndex : MaterialSamplerIndices)
+			{
+				material.*samplerIndex = material.*samplerIndex != -1 ? samplers.at(material.*samplerIndex) : -1;
+			}
+		}
+
+		CreateMaterialBuffer();
+		FScene::s_loadProgress += FScene::s_materialLoadTimeFrac;
+	}
+
+	// Lights and cameras
+	const std::span<const FLight> lights = sceneCache.Get<FLight>(Section::Lights);
+	m_globalLightList.assign(lights.begin(), lights.end());
+
+	for (const FCameraRecord& record : sceneCache.Get<FCameraRecord>(Section::Cameras))
+	{
+		m_cameras.push_back({ sceneCache.GetString(record.m_name), record.m_viewTransform, record.m_projectionTransform });
+	}
+
+	CreateGpuGeometryBuffers({
+		sceneCache.Get<FGpuPrimitive>(Section::GpuPrimitives),
+		sceneCache.Get<FGpuMeshlet>(Section::GpuMeshlets),
+		sceneCache.Get<FGpuMeshletInstance>(Section::GpuMeshletInstances),
+		sceneCache.GetBytes(Section::MeshletVertexIndices),
+		sceneCache.Get<FInlineMeshlet::FPackedTriangle>(Section::MeshletTriangleIndices),
+		sceneCache.Get<uint32_t>(Section::PrimitiveCounts) });
+
+	FinalizeLoad();
+	return true;
 }
 
 void FScene::ReloadEnvironment(const std::wstring& filename)
@@ -280,28 +838,35 @@ void FScene::LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix&
 	const tinygltf::Mesh& mesh = model.meshes[meshIndex];
 	FSceneMeshEntities* sceneCollection = mesh.name.starts_with("decal") ? &m_sceneMeshDecals : &m_sceneMeshes;
 
-	SCOPED_CPU_EVENT("load_mesh", PIX_COLOR_DEFAULT);
-
-	auto CalcBounds = [&model](int positionAccessorIndex) -> DirectX::BoundingBox
+	// Nodes that instance a mesh which is already loaded only add an entity
+	FMesh& asset = m_meshAssets[meshIndex];
+	if (asset.m_primitives.size() != mesh.primitives.size())
 	{
-		const tinygltf::Accessor& accessor = model.accessors[positionAccessorIndex];
-		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		asset = LoadMeshAsset(meshIndex, model);
+	}
+
+	sceneCollection->m_entityList.push_back(meshIndex);
+	sceneCollection->m_visibleList.push_back(1);
+	sceneCollection->m_transformList.push_back(parentTransform);
+	sceneCollection->m_entityNames.push_back(mesh.name);
+	sceneCollection->m_objectSpaceBoundsList.push_back(asset.m_bounds);
+}
 
-		size_t dataSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type);
-		size_t dataStride = accessor.ByteStride(bufferView);
+FMesh FScene::LoadMeshAsset(int meshIndex, const tinygltf::Model& model)
+{
+	const tinygltf::Mesh& mesh = model.meshes[meshIndex];
 
-		const uint8_t* pData = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+	SCOPED_CPU_EVENT("load_mesh", PIX_COLOR_DEFAULT);
 
-		DirectX::BoundingBox bb = {};
-		DirectX::BoundingBox::CreateFromPoints(bb, accessor.count, (DirectX::XMFLOAT3*)pData, dataStride);
-		return bb;
+	auto CalcBounds = [&model](int positionAccessorIndex, DirectX::BoundingBox& outBox, DirectX::BoundingSphere& outSphere)
+	{
+		const FAccessorView positions = AccessorView::Get(model, positionAccessorIndex);
+		MeshUtils::ComputeBounds(positions.m_data, positions.m_count, positions.m_byteStride, outBox, outSphere);
 	};
 
 	FMesh newMesh = {};
 	newMesh.m_primitives.resize(mesh.primitives.size());
 
-	DirectX::BoundingBox meshBounds = {};
-
 	// Each primitive is a separate render mesh with its own vertex and index buffers
 	for (int primitiveIndex = 0; primitiveIndex < mesh.primitives.size(); ++primitiveIndex)
 	{
@@ -356,68 +921,168 @@ void FScene::LoadMesh(int meshIndex, const tinygltf::Model& model, const Matrix&
 		outPrimitive.m_materialIndex = primitive.material;
 
 		// Bounds
-		DirectX::BoundingBox primitiveBounds = CalcBounds(posIt->second);
-		DirectX::BoundingBox::CreateMerged(meshBounds, meshBounds, primitiveBounds);
-		DirectX::BoundingSphere::CreateFromBoundingBox(outPrimitive.m_boundingSphere, primitiveBounds);
+		DirectX::BoundingBox primitiveBounds = {};
+		CalcBounds(posIt->second, primitiveBounds, outPrimitive.m_boundingSphere);
+		DirectX::BoundingBox::CreateMerged(newMesh.m_bounds, newMesh.m_bounds, primitiveBounds);
 	}
 
-	sceneCollection->m_entityList.push_back(newMesh);
-	sceneCollection->m_visibleList.push_back(1);
-	sceneCollection->m_transformList.push_back(parentTransform);
-	sceneCollection->m_entityNames.push_back(mesh.name);
-	sceneCollection->m_objectSpaceBoundsList.push_back(meshBounds);
+	return newMesh;
 }
 
 void FModelLoader::LoadMeshBuffers(const tinygltf::Model& model)
+{
+	CreateMeshBuffers(PackMeshBufferViews(model), GetMeshBufferViewData(model));
+}
+
+void FModelLoader::LoadMeshBufferViews(const tinygltf::Model& model)
+{
+	CreateMeshBufferViews(PackMeshBufferViews(model));
+}
+
+void FModelLoader::LoadMeshAccessors(const tinygltf::Model& model)
+{
+	CreateMeshAccessors(PackMeshAccessors(model));
+}
+
+std::vector<FMeshBufferView> FModelLoader::PackMeshBufferViews(const tinygltf::Model& model)
+{
+	// Views that only hold images or other data that is never read by the shaders are skipped
+	std::vector<bool> bReferenced(model.bufferViews.size(), false);
+	for (const tinygltf::Accessor& accessor : model.accessors)
+	{
+		if (accessor.bufferView != -1)
+		{
+			bReferenced[accessor.bufferView] = true;
+		}
+	}
+
+	std::vector<FMeshBufferView> views(model.bufferViews.size());
+	size_t packedSize = 0;
+	for (int viewIndex = 0; viewIndex < model.bufferViews.size(); ++viewIndex)
+	{
+		// Buffers can be emptied when their streams are re-encoded by VertexQuantization::CompactVertexStreams
+		const tinygltf::BufferView& bufferView = model.bufferViews[viewIndex];
+		if (!bReferenced[viewIndex] || model.buffers[bufferView.buffer].data.empty())
+		{
+			views[viewIndex] = { -1, 0, 0 };
+			continue;
+		}
+
+		packedSize = GetAlignedSize(16, packedSize) + bufferView.byteOffset % 16;
+		views[viewIndex] = { 0, (uint32_t)packedSize, (uint32_t)bufferView.byteLength };
+		packedSize += bufferView.byteLength;
+	}
+
+	AbortOnFailure(packedSize <= UINT32_MAX, "Mesh buffers are too large for 32-bit offsets", nullptr);
+	return views;
+}
+
+std::vector<std::span<const uint8_t>> FModelLoader::GetMeshBufferViewData(const tinygltf::Model& model)
+{
+	std::vector<std::span<const uint8_t>> viewData(model.bufferViews.size());
+	for (int viewIndex = 0; viewIndex < model.bufferViews.size(); ++viewIndex)
+	{
+		const tinygltf::BufferView& bufferView = model.bufferViews[viewIndex];
+		const std::vector<unsigned char>& data = model.buffers[bufferView.buffer].data;
+		if (!data.empty())
+		{
+			viewData[viewIndex] = { data.data() + bufferView.byteOffset, bufferView.byteLength };
+		}
+	}
+
+	return viewData;
+}
+
+std::vector<FMeshAccessor> FModelLoader::PackMeshAccessors(const tinygltf::Model& model) const
+{
+	std::vector<FMeshAccessor> accessors(model.accessors.size());
+	concurrency::parallel_for(0, (int)model.accessors.size(), [&](int i)
+		{
+			const int bufferViewIndex = model.accessors[i].bufferView;
+			accessors[i].m_bufferViewIndex = bufferViewIndex;
+			accessors[i].m_byteOffset = (uint32_t)model.accessors[i].byteOffset;
+			accessors[i].m_byteStride = model.accessors[i].ByteStride(model.bufferViews[bufferViewIndex]);
+
+			const FAccessorFormat format = i < m_accessorFormats.size() ? m_accessorFormats[i] : FAccessorFormat{};
+			accessors[i].m_format = format.m_format;
+			accessors[i].m_quantizationOffset = format.m_offset;
+			accessors[i].m_quantizationScale = format.m_scale;
+		});
+
+	return accessors;
+}
+
+void FModelLoader::CreateMeshBuffers(std::span<const FMeshBufferView> views, const std::vector<std::span<const uint8_t>>& viewData)
 {
 	SCOPED_CPU_EVENT("load_mesh_buffers", PIX_COLOR_DEFAULT);
 
-	size_t uploadSize = 0;
-	for (const tinygltf::Buffer& buffer : model.buffers)
+	std::vector<size_t> referencedViews;
+	for (size_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
 	{
-		uploadSize += buffer.data.size();
+		if (views[viewIndex].m_bufferSrvIndex != -1)
+		{
+			DebugAssert(viewData[viewIndex].size() == views[viewIndex].m_byteLength);
+			AbortOnFailure(views[viewIndex].m_byteLength <= FGeometryArenaRange::MaxSize, "Mesh buffer view is larger than a raw buffer view can address", nullptr);
+			referencedViews.push_back(viewIndex);
+		}
 	}
 
-	float progressIncrement = FScene::s_meshBufferLoadTimeFrac / (float)model.buffers.size();
+	std::sort(referencedViews.begin(), referencedViews.end(), [&views](size_t a, size_t b) { return views[a].m_byteOffset < views[b].m_byteOffset; });
 
-	FResourceUploadContext uploader{ uploadSize };
+	// Views are packed in order, and a range ends before the first view that would make it larger than a raw view can address.
+	// Ranges start at a 16 byte aligned packed offset, so that the views keep their alignment.
+	m_meshBuffers.clear();
+	m_meshBufferPackedOffsets.clear();
+	m_meshBufferViewRanges.assign(views.size(), -1);
+	size_t rangeEnd = 0;
+	std::vector<std::pair<size_t, std::span<const uint8_t>>> chunks;
+	auto AllocateRange = [&]()
+	{
+		if (!chunks.empty())
+		{
+			FGeometryArenaRange& range = m_meshBuffers.emplace_back(FGeometryArenaRange::Allocate(rangeEnd - m_meshBufferPackedOffsets.back()));
+			range.Upload(chunks);
+			chunks.clear();
+		}
+	};
 
-	m_meshBuffers.resize(model.buffers.size());
-	for (int bufferIndex = 0; bufferIndex < model.buffers.size(); ++bufferIndex)
+	for (const size_t viewIndex : referencedViews)
 	{
-		m_meshBuffers[bufferIndex].reset(RenderBackend12::CreateNewShaderBuffer({
-			.name = PrintString(L"scene_mesh_buffer_%d", bufferIndex),
-			.type = FShaderBuffer::Type::Raw,
-			.accessMode = FResource::AccessMode::GpuReadOnly,
-			.alloc = FResource::Allocation::Persistent(),
-			.size = model.buffers[bufferIndex].data.size(),
-			.upload = {
-				.pData = model.buffers[bufferIndex].data.data(),
-				.context = &uploader 
-			}
-		}));
+		const FMeshBufferView& view = views[viewIndex];
+		if (chunks.empty() || view.m_byteOffset + view.m_byteLength - m_meshBufferPackedOffsets.back() > FGeometryArenaRange::MaxSize)
+		{
+			AllocateRange();
+			m_meshBufferPackedOffsets.push_back(view.m_byteOffset & ~15ull);
+		}
 
-		FScene::s_loadProgress += progressIncrement;
+		chunks.push_back({ view.m_byteOffset - m_meshBufferPackedOffsets.back(), viewData[viewIndex] });
+		m_meshBufferViewRanges[viewIndex] = (int)m_meshBuffers.size();
+		rangeEnd = std::max<size_t>(rangeEnd, view.m_byteOffset + view.m_byteLength);
 	}
 
-	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_mesh_buffers", D3D12_COMMAND_LIST_TYPE_DIRECT);
-	uploader.SubmitUploads(cmdList);
-	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+	AllocateRange();
+	FScene::s_loadProgress += FScene::s_meshBufferLoadTimeFrac;
 }
 
-void FModelLoader::LoadMeshBufferViews(const tinygltf::Model& model)
+void FModelLoader::CreateMeshBufferViews(std::vector<FMeshBufferView> views)
 {
 	SCOPED_CPU_EVENT("load_mesh_bufferviews", PIX_COLOR_DEFAULT);
 
-	// CPU Copy
-	std::vector<FMeshBufferView> views(model.bufferViews.size());
-	concurrency::parallel_for(0, (int)model.bufferViews.size(), [&](int viewIndex)
+	// Point the packed views into the ranges that CreateMeshBuffers() uploaded them to
+	DebugAssert(m_meshBufferViewRanges.size() == views.size());
+	for (size_t viewIndex = 0; viewIndex < views.size(); ++viewIndex)
+	{
+		FMeshBufferView& view = views[viewIndex];
+		if (view.m_bufferSrvIndex != -1)
 		{
-			const int meshBufferIndex = model.bufferViews[viewIndex].buffer;
-			views[viewIndex].m_bufferSrvIndex = m_meshBuffers[meshBufferIndex]->m_descriptorIndices.SRV;
-			views[viewIndex].m_byteLength = model.bufferViews[viewIndex].byteLength;
-			views[viewIndex].m_byteOffset = model.bufferViews[viewIndex].byteOffset;
-		});
+			const int rangeIndex = m_meshBufferViewRanges[viewIndex];
+			const FGeometryArenaRange& range = m_meshBuffers[rangeIndex];
+			view.m_bufferSrvIndex = (int)range.GetSrvIndex();
+			view.m_byteOffset = (uint32_t)(range.m_offset + view.m_byteOffset - m_meshBufferPackedOffsets[rangeIndex]);
+		}
+	}
+
+	m_meshBufferViews = views;
 
 	const size_t bufferSize = views.size() * sizeof(FMeshBufferView);
 	FResourceUploadContext uploader{ bufferSize };
@@ -441,21 +1106,16 @@ void FModelLoader::LoadMeshBufferViews(const tinygltf::Model& model)
 	FScene::s_loadProgress += FScene::s_meshBufferViewsLoadTimeFrac;
 }
 
-void FModelLoader::LoadMeshAccessors(const tinygltf::Model& model)
+D3D12_GPU_VIRTUAL_ADDRESS FModelLoader::GetMeshBufferViewAddress(int viewIndex) const
 {
-	SCOPED_CPU_EVENT("load_mesh_accessors", PIX_COLOR_DEFAULT);
+	return m_meshBuffers[m_meshBufferViewRanges[viewIndex]].GetGpuAddress() + m_meshBufferViews[viewIndex].m_byteOffset;
+}
 
-	// CPU Copy
-	std::vector<FMeshAccessor> accessors(model.accessors.size());
-	concurrency::parallel_for(0, (int)model.accessors.size(), [&](int i)
-		{
-			const int bufferViewIndex = model.accessors[i].bufferView;
-			accessors[i].m_bufferViewIndex = bufferViewIndex;
-			accessors[i].m_byteOffset = (uint32_t)model.accessors[i].byteOffset;
-			accessors[i].m_byteStride = model.accessors[i].ByteStride(model.bufferViews[bufferViewIndex]);
-		});
+void FModelLoader::CreateMeshAccessors(std::span<const FMeshAccessor> accessors)
+{
+	SCOPED_CPU_EVENT("load_mesh_accessors", PIX_COLOR_DEFAULT);
 
-	const size_t bufferSize = accessors.size() * sizeof(FMeshAccessor);
+	const size_t bufferSize = accessors.size_bytes();
 	FResourceUploadContext uploader{ bufferSize };
 
 	m_packedMeshAccessors.reset(RenderBackend12::CreateNewShaderBuffer({
@@ -477,68 +1137,110 @@ void FModelLoader::LoadMeshAccessors(const tinygltf::Model& model)
 	FScene::s_loadProgress += FScene::s_meshAccessorsLoadTimeFrac;
 }
 
-void FScene::CreateGpuGeometryBuffers()
+void FScene::PackGpuGeometry(FPackedGpuGeometry& output) const
 {
-	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_primitives", D3D12_COMMAND_LIST_TYPE_DIRECT);
+	SCOPED_CPU_EVENT("pack_gpu_geometry", PIX_COLOR_DEFAULT);
 
-	// Primitive and Meshlet buffers
+	std::vector<FGpuPrimitive>& primitives = output.m_primitives;
+	std::vector<FGpuMeshlet>& meshlets = output.m_meshlets;
+	std::vector<uint8_t>& packedMeshletVertexIndices = output.m_meshletVertexIndices;
+	std::vector<FInlineMeshlet::FPackedTriangle>& packedMeshletTriangleIndices = output.m_meshletTriangleIndices;
+
+	// Meshlets are packed once per mesh asset, and each instance refers to the range of its asset
+	std::vector<FGpuMeshletInstance>& meshletInstances = output.m_meshletInstances;
+	std::vector<int> assetMeshletBegin(m_meshAssets.size(), -1);
+	uint32_t instanceMeshletCount = 0;
+
+	for (int meshIndex = 0; meshIndex < m_sceneMeshes.GetCount(); ++meshIndex)
 	{
-		// Packed buffer that contains an array of FGpuPrimitive(s)
-		std::vector<FGpuPrimitive> primitives;
-		// Packed buffer that contains an array of FGpuMeshlet(s)
-		std::vector<FGpuMeshlet> meshlets;
-		// Packed array of meshlet vertex indices
-		std::vector<uint32_t> packedMeshletVertexIndices;
-		// Packed array of meshlet triangle indices
-		std::vector<FInlineMeshlet::FPackedTriangle> packedMeshletTriangleIndices;
+		const int assetIndex = m_sceneMeshes.m_entityList[meshIndex];
+		const FMesh& mesh = m_meshAssets[assetIndex];
+		const bool bPackMeshlets = assetMeshletBegin[assetIndex] == -1;
+		if (bPackMeshlets)
+		{
+			assetMeshletBegin[assetIndex] = (int)meshlets.size();
+		}
 
-		for (int meshIndex = 0; meshIndex < m_sceneMeshes.GetCount(); ++meshIndex)
+		for (const FMeshPrimitive& primitive : mesh.m_primitives)
 		{
-			const FMesh& mesh = m_sceneMeshes.m_entityList[meshIndex];
-			for (const FMeshPrimitive& primitive : mesh.m_primitives)
+			const DirectX::BoundingSphere& bounds = primitive.m_boundingSphere;
+			FGpuPrimitive newPrimitive = {};
+			newPrimitive.m_meshIndex = meshIndex;
+			newPrimitive.m_boundingSphere = Vector4(bounds.Center.x, bounds.Center.y, bounds.Center.z, bounds.Radius);
+			newPrimitive.m_indexAccessor = primitive.m_indexAccessor;
+			newPrimitive.m_positionAccessor = primitive.m_positionAccessor;
+			newPrimitive.m_uvAccessor = primitive.m_uvAccessor;
+			newPrimitive.m_normalAccessor = primitive.m_normalAccessor;
+			newPrimitive.m_tangentAccessor = primitive.m_tangentAccessor;
+			newPrimitive.m_materialIndex = primitive.m_materialIndex;
+			newPrimitive.m_indexCount = primitive.m_indexCount;
+			newPrimitive.m_indicesPerTriangle = 3;
+			primitives.push_back(newPrimitive);
+
+			if (!bPackMeshlets)
+				continue;
+
+			for (const FInlineMeshlet& meshlet : primitive.m_meshlets)
 			{
-				const DirectX::BoundingSphere& bounds = primitive.m_boundingSphere;
-				FGpuPrimitive newPrimitive = {};
-				newPrimitive.m_meshIndex = meshIndex;
-				newPrimitive.m_boundingSphere = Vector4(bounds.Center.x, bounds.Center.y, bounds.Center.z, bounds.Radius);
-				newPrimitive.m_indexAccessor = primitive.m_indexAccessor;
-				newPrimitive.m_positionAccessor = primitive.m_positionAccessor;
-				newPrimitive.m_uvAccessor = primitive.m_uvAccessor;
-				newPrimitive.m_normalAccessor = primitive.m_normalAccessor;
-				newPrimitive.m_tangentAccessor = primitive.m_tangentAccessor;
-				newPrimitive.m_materialIndex = primitive.m_materialIndex;
-				newPrimitive.m_indexCount = primitive.m_indexCount;
-				newPrimitive.m_indicesPerTriangle = 3;
-				primitives.push_back(newPrimitive);
-
-				for (const FInlineMeshlet& meshlet : primitive.m_meshlets)
-				{
-					const DirectX::BoundingSphere& bounds = meshlet.m_boundingSphere;
-					FGpuMeshlet newMeshlet = {};
-					newMeshlet.m_meshIndex = meshIndex;
-					newMeshlet.m_boundingSphere = Vector4(bounds.Center.x, bounds.Center.y, bounds.Center.z, bounds.Radius);
-					newMeshlet.m_positionAccessor = primitive.m_positionAccessor;
-					newMeshlet.m_uvAccessor = primitive.m_uvAccessor;
-					newMeshlet.m_normalAccessor = primitive.m_normalAccessor;
-					newMeshlet.m_tangentAccessor = primitive.m_tangentAccessor;
-					newMeshlet.m_materialIndex = primitive.m_materialIndex;
-					newMeshlet.m_vertexBegin = packedMeshletVertexIndices.size();
-					newMeshlet.m_vertexCount = meshlet.m_uniqueVertexIndices.size();
-					newMeshlet.m_triangleBegin = packedMeshletTriangleIndices.size();
-					newMeshlet.m_triangleCount = meshlet.m_primitiveIndices.size();
-					meshlets.push_back(newMeshlet);
-
-					// Append the meshlet information into the packed buffers
-					packedMeshletVertexIndices.insert(packedMeshletVertexIndices.end(), meshlet.m_uniqueVertexIndices.cbegin(), meshlet.m_uniqueVertexIndices.cend());
-					packedMeshletTriangleIndices.insert(packedMeshletTriangleIndices.end(), meshlet.m_primitiveIndices.cbegin(), meshlet.m_primitiveIndices.cend());
-				}
+				const DirectX::BoundingSphere& bounds = meshlet.m_boundingSphere;
+				FGpuMeshlet newMeshlet = {};
+				newMeshlet.m_boundingSphere = Vector4(bounds.Center.x, bounds.Center.y, bounds.Center.z, bounds.Radius);
+				newMeshlet.m_positionAccessor = primitive.m_positionAccessor;
+				newMeshlet.m_uvAccessor = primitive.m_uvAccessor;
+				newMeshlet.m_normalAccessor = primitive.m_normalAccessor;
+				newMeshlet.m_tangentAccessor = primitive.m_tangentAccessor;
+				newMeshlet.m_materialIndex = primitive.m_materialIndex;
+				newMeshlet.m_normalCone = meshlet.m_normalCone;
+				newMeshlet.m_vertexCount = meshlet.m_uniqueVertexIndices.size();
+				newMeshlet.m_triangleBegin = packedMeshletTriangleIndices.size();
+				newMeshlet.m_triangleCount = meshlet.m_primitiveIndices.size();
+
+				// Append the meshlet information into the packed buffers
+				const FMeshletVertexEncoding vertexEncoding = MeshUtils::EncodeMeshletVertices(meshlet, packedMeshletVertexIndices);
+				newMeshlet.m_vertexBegin = vertexEncoding.m_byteOffset;
+				newMeshlet.m_vertexBase = vertexEncoding.m_base;
+				newMeshlet.m_vertexDeltaSize = vertexEncoding.m_deltaSize;
+				meshlets.push_back(newMeshlet);
+
+				packedMeshletTriangleIndices.insert(packedMeshletTriangleIndices.end(), meshlet.m_primitiveIndices.cbegin(), meshlet.m_primitiveIndices.cend());
 			}
 		}
 
-		const size_t bufferSize = primitives.size() * sizeof(FGpuPrimitive)
-			+ meshlets.size() * sizeof(FGpuMeshlet)
-			+ packedMeshletVertexIndices.size() * sizeof(uint32_t)
-			+ packedMeshletTriangleIndices.size() * sizeof(FInlineMeshlet::FPackedTriangle);
+		FGpuMeshletInstance instance = {};
+		instance.m_assetIndex = assetIndex;
+		instance.m_meshletBegin = assetMeshletBegin[assetIndex];
+		instance.m_meshletCount = 0;
+		for (const FMeshPrimitive& primitive : mesh.m_primitives)
+		{
+			instance.m_meshletCount += primitive.m_meshlets.size();
+		}
+
+		instance.m_instanceMeshletBegin = instanceMeshletCount;
+		instanceMeshletCount += instance.m_meshletCount;
+		meshletInstances.push_back(instance);
+	}
+
+	// Primitive count for each mesh. This is used to calculate an offset to read from the packed primitives buffer
+	for (const int assetIndex : m_sceneMeshes.m_entityList)
+	{
+		output.m_primitiveCounts.push_back(m_meshAssets[assetIndex].m_primitives.size());
+	}
+}
+
+void FScene::CreateGpuGeometryBuffers(const FGpuGeometryView& geometry)
+{
+	m_primitiveCount = geometry.m_primitives.size();
+	m_meshletCount = geometry.m_meshletInstances.empty() ? 0 : geometry.m_meshletInstances.back().m_instanceMeshletBegin + geometry.m_meshletInstances.back().m_meshletCount;
+
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_primitives", D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+	// Primitive and Meshlet buffers
+	{
+		const size_t bufferSize = geometry.m_primitives.size_bytes()
+			+ geometry.m_meshlets.size_bytes()
+			+ geometry.m_meshletInstances.size_bytes()
+			+ geometry.m_meshletVertexIndices.size_bytes()
+			+ geometry.m_meshletTriangleIndices.size_bytes();
 
 		FResourceUploadContext uploader{ bufferSize };
 
@@ -547,9 +1249,9 @@ void FScene::CreateGpuGeometryBuffers()
 			.type = FShaderBuffer::Type::Raw,
 			.accessMode = FResource::AccessMode::GpuReadOnly,
 			.alloc = FResource::Allocation::Persistent(),
-			.size = primitives.size() * sizeof(FGpuPrimitive),
+			.size = geometry.m_primitives.size_bytes(),
 			.upload = {
-				.pData = (const uint8_t*)primitives.data(),
+				.pData = (const uint8_t*)geometry.m_primitives.data(),
 				.context = &uploader 
 			}
 		}));
@@ -559,9 +1261,21 @@ void FScene::CreateGpuGeometryBuffers()
 			.type = FShaderBuffer::Type::Raw,
 			.accessMode = FResource::AccessMode::GpuReadOnly,
 			.alloc = FResource::Allocation::Persistent(),
-			.size = meshlets.size() * sizeof(FGpuMeshlet),
+			.size = geometry.m_meshlets.size_bytes(),
+			.upload = {
+				.pData = (const uint8_t*)geometry.m_meshlets.data(),
+				.context = &uploader
+			}
+			}));
+
+		m_packedMeshletInstances.reset(RenderBackend12::CreateNewShaderBuffer({
+			.name = L"scene_meshlet_instances",
+			.type = FShaderBuffer::Type::Raw,
+			.accessMode = FResource::AccessMode::GpuReadOnly,
+			.alloc = FResource::Allocation::Persistent(),
+			.size = geometry.m_meshletInstances.size_bytes(),
 			.upload = {
-				.pData = (const uint8_t*)meshlets.data(),
+				.pData = (const uint8_t*)geometry.m_meshletInstances.data(),
 				.context = &uploader
 			}
 			}));
@@ -571,9 +1285,9 @@ void FScene::CreateGpuGeometryBuffers()
 			.type = FShaderBuffer::Type::Raw,
 			.accessMode = FResource::AccessMode::GpuReadOnly,
 			.alloc = FResource::Allocation::Persistent(),
-			.size = packedMeshletVertexIndices.size() * sizeof(uint32_t),
+			.size = geometry.m_meshletVertexIndices.size_bytes(),
 			.upload = {
-				.pData = (const uint8_t*)packedMeshletVertexIndices.data(),
+				.pData = geometry.m_meshletVertexIndices.data(),
 				.context = &uploader
 			}
 			}));
@@ -583,9 +1297,9 @@ void FScene::CreateGpuGeometryBuffers()
 			.type = FShaderBuffer::Type::Raw,
 			.accessMode = FResource::AccessMode::GpuReadOnly,
 			.alloc = FResource::Allocation::Persistent(),
-			.size = packedMeshletTriangleIndices.size() * sizeof(uint32_t),
+			.size = geometry.m_meshletTriangleIndices.size_bytes(),
 			.upload = {
-				.pData = (const uint8_t*)packedMeshletTriangleIndices.data(),
+				.pData = (const uint8_t*)geometry.m_meshletTriangleIndices.data(),
 				.context = &uploader
 			}
 			}));
@@ -595,13 +1309,7 @@ void FScene::CreateGpuGeometryBuffers()
 
 	// Buffer that contains primitive count for each mesh. This is used to calculate an offset to read from the packed primitives buffer
 	{
-		std::vector<uint32_t> primitiveCounts;
-		for (const auto& mesh : m_sceneMeshes.m_entityList)
-		{
-			primitiveCounts.push_back(mesh.m_primitives.size());
-		}
-
-		const size_t bufferSize = primitiveCounts.size() * sizeof(uint32_t);
+		const size_t bufferSize = geometry.m_primitiveCounts.size_bytes();
 		FResourceUploadContext uploader{ bufferSize };
 
 		m_packedPrimitiveCounts.reset(RenderBackend12::CreateNewShaderBuffer({
@@ -611,7 +1319,7 @@ void FScene::CreateGpuGeometryBuffers()
 			.alloc = FResource::Allocation::Persistent(),
 			.size = bufferSize,
 			.upload = {
-				.pData = (const uint8_t*)primitiveCounts.data(),
+				.pData = (const uint8_t*)geometry.m_primitiveCounts.data(),
 				.context = &uploader 
 			}
 		}));
@@ -669,18 +1377,112 @@ void FScene::CreateGpuLightBuffers()
 	}
 }
 
-void FScene::CreateAccelerationStructures(const tinygltf::Model& model)
+void FScene::ResolveRaytracingGeometry(const tinygltf::Model& model)
+{
+	for (FMesh& mesh : m_meshAssets)
+	{
+		for (FMeshPrimitive& primitive : mesh.m_primitives)
+		{
+			const tinygltf::Accessor& posAccessor = model.accessors[primitive.m_positionAccessor];
+			const tinygltf::Accessor& indexAccessor = model.accessors[primitive.m_indexAccessor];
+			const tinygltf::BufferView& posView = model.bufferViews[posAccessor.bufferView];
+
+			DXGI_FORMAT vertexFormat;
+			switch (posAccessor.type)
+			{
+			case TINYGLTF_TYPE_VEC2:
+				vertexFormat = DXGI_FORMAT_R32G32_FLOAT;
+				break;
+			case TINYGLTF_TYPE_VEC3:
+				vertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+				break;
+			case TINYGLTF_TYPE_VEC4:
+				vertexFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+				break;
+			}
+
+			// Quantized positions are dequantized by the BLAS transform
+			if (primitive.m_positionAccessor < m_accessorFormats.size() &&
+				m_accessorFormats[primitive.m_positionAccessor].m_format == VertexFormat::Unorm16Position)
+			{
+				vertexFormat = DXGI_FORMAT_R16G16B16A16_UNORM;
+			}
+
+			DXGI_FORMAT indexFormat;
+			switch (indexAccessor.componentType)
+			{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				indexFormat = DXGI_FORMAT_R8_UINT;
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				indexFormat = DXGI_FORMAT_R16_UINT;
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				indexFormat = DXGI_FORMAT_R32_UINT;
+				break;
+			}
+
+			FRaytracingGeometry& geometry = primitive.m_raytracingGeometry;
+			geometry.m_vertexBufferView = posAccessor.bufferView;
+			geometry.m_vertexByteOffset = posAccessor.byteOffset;
+			geometry.m_vertexStride = posAccessor.ByteStride(posView);
+			geometry.m_vertexCount = (uint32_t)posAccessor.count;
+			geometry.m_vertexFormat = vertexFormat;
+			geometry.m_indexBufferView = indexAccessor.bufferView;
+			geometry.m_indexByteOffset = indexAccessor.byteOffset;
+			geometry.m_indexCount = (uint32_t)indexAccessor.count;
+			geometry.m_indexFormat = indexFormat;
+		}
+	}
+}
+
+void FScene::CreateAccelerationStructures()
 {
 	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"create_acceleration_structure", D3D12_COMMAND_LIST_TYPE_DIRECT);
 	FFenceMarker gpuFinishFence = cmdList->GetFence(FCommandList::SyncPoint::GpuFinish);
 
+	// Quantized positions are read as UNORM and scaled back into object space by a per-geometry transform
+	std::vector<std::array<float, 12>> dequantizeTransforms;
+	std::unordered_map<int, size_t> dequantizeTransformIndices;
+	for (int accessorIndex = 0; accessorIndex < m_accessorFormats.size(); ++accessorIndex)
+	{
+		const FAccessorFormat& format = m_accessorFormats[accessorIndex];
+		if (format.m_format == VertexFormat::Unorm16Position)
+		{
+			const float s = 65535.f;
+			dequantizeTransformIndices[accessorIndex] = dequantizeTransforms.size();
+			dequantizeTransforms.push_back({
+				format.m_scale.x * s, 0.f, 0.f, format.m_offset.x,
+				0.f, format.m_scale.y * s, 0.f, format.m_offset.y,
+				0.f, 0.f, format.m_scale.z * s, format.m_offset.z });
+		}
+	}
+
+	std::unique_ptr<FSystemBuffer> dequantizeTransformBuffer;
+	if (!dequantizeTransforms.empty())
+	{
+		const size_t transformBufferSize = dequantizeTransforms.size() * sizeof(dequantizeTransforms[0]);
+		dequantizeTransformBuffer.reset(RenderBackend12::CreateNewSystemBuffer({
+			.name = L"blas_dequantize_transforms",
+			.accessMode = FResource::AccessMode::CpuWriteOnly,
+			.alloc = FResource::Allocation::Transient(gpuFinishFence),
+			.size = transformBufferSize,
+			.uploadCallback = [pData = dequantizeTransforms.data(), transformBufferSize](uint8_t* pDest)
+			{
+				memcpy(pDest, pData, transformBufferSize);
+			}
+		}));
+	}
+
+	m_blasList.resize(m_meshAssets.size());
+
 	std::vector<D3D12_RAYTRACING_INSTANCE_DESC> instanceDescs;
 	for (int meshIndex = 0; meshIndex < m_sceneMeshes.GetCount(); ++meshIndex)
 	{
-		const FMesh& mesh = m_sceneMeshes.m_entityList[meshIndex];
+		const int assetIndex = m_sceneMeshes.m_entityList[meshIndex];
+		const FMesh& mesh = m_meshAssets[assetIndex];
 		const std::string& meshName = m_sceneMeshes.m_entityNames[meshIndex];
-		auto search = m_blasList.find(meshName);
-		if (search == m_blasList.cend())
+		if (!m_blasList[assetIndex])
 		{
 			std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> primitiveDescs;
 			primitiveDescs.reserve(mesh.m_primitives.size());
@@ -690,54 +1492,30 @@ void FScene::CreateAccelerationStructures(const tinygltf::Model& model)
 			{
 				const FMeshPrimitive& primitive = mesh.m_primitives[primitiveIndex];
 
-				tinygltf::Accessor posAccessor = model.accessors[primitive.m_positionAccessor];
-				tinygltf::Accessor indexAccessor = model.accessors[primitive.m_indexAccessor];
-				tinygltf::BufferView posView = model.bufferViews[posAccessor.bufferView];
-				tinygltf::BufferView indexView = model.bufferViews[indexAccessor.bufferView];
+				const FRaytracingGeometry& source = primitive.m_raytracingGeometry;
 
-				DXGI_FORMAT vertexFormat;
-				switch (posAccessor.type)
-				{
-				case TINYGLTF_TYPE_VEC2:
-					vertexFormat = DXGI_FORMAT_R32G32_FLOAT;
-					break;
-				case TINYGLTF_TYPE_VEC3:
-					vertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
-					break;
-				case TINYGLTF_TYPE_VEC4:
-					vertexFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
-					break;
-				}
+				D3D12_RAYTRACING_GEOMETRY_DESC geometry = {};
+				geometry.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+				geometry.Triangles.VertexBuffer.StartAddress = GetMeshBufferViewAddress(source.m_vertexBufferView) + source.m_vertexByteOffset;
+				geometry.Triangles.VertexBuffer.StrideInBytes = source.m_vertexStride;
+				geometry.Triangles.VertexCount = source.m_vertexCount;
+				geometry.Triangles.VertexFormat = source.m_vertexFormat;
+				geometry.Triangles.IndexBuffer = GetMeshBufferViewAddress(source.m_indexBufferView) + source.m_indexByteOffset;
+				geometry.Triangles.IndexFormat = source.m_indexFormat;
+				geometry.Triangles.IndexCount = source.m_indexCount;
+				geometry.Triangles.Transform3x4 = 0;
 
-				DXGI_FORMAT indexFormat;
-				switch (indexAccessor.componentType)
+				auto dequantizeIt = dequantizeTransformIndices.find(primitive.m_positionAccessor);
+				if (dequantizeIt != dequantizeTransformIndices.cend())
 				{
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-					indexFormat = DXGI_FORMAT_R8_UINT;
-					break;
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-					indexFormat = DXGI_FORMAT_R16_UINT;
-					break;
-				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-					indexFormat = DXGI_FORMAT_R32_UINT;
-					break;
+					geometry.Triangles.Transform3x4 = dequantizeTransformBuffer->m_resource->m_d3dResource->GetGPUVirtualAddress() + dequantizeIt->second * sizeof(dequantizeTransforms[0]);
 				}
 
-				D3D12_RAYTRACING_GEOMETRY_DESC geometry = {};
-				geometry.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-				geometry.Triangles.VertexBuffer.StartAddress = m_meshBuffers[posView.buffer]->m_resource->m_d3dResource->GetGPUVirtualAddress() + posAccessor.byteOffset + posView.byteOffset;
-				geometry.Triangles.VertexBuffer.StrideInBytes = posAccessor.ByteStride(posView);
-				geometry.Triangles.VertexCount = posAccessor.count;
-				geometry.Triangles.VertexFormat = vertexFormat;
-				geometry.Triangles.IndexBuffer = m_meshBuffers[indexView.buffer]->m_resource->m_d3dResource->GetGPUVirtualAddress() + indexAccessor.byteOffset + indexView.byteOffset;
-				geometry.Triangles.IndexFormat = indexFormat;
-				geometry.Triangles.IndexCount = indexAccessor.count;
-				geometry.Triangles.Transform3x4 = 0;
 				geometry.Flags = m_materialList[primitive.m_materialIndex].m_alphaMode == AlphaMode::Opaque ? D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE : D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
 				primitiveDescs.push_back(geometry);
 			}
 
-			// Build BLAS - One per mesh entity
+			// Build BLAS - One per mesh asset
 			{
 				D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS blasInputsDesc = {};
 				blasInputsDesc.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
@@ -756,7 +1534,7 @@ void FScene::CreateAccelerationStructures(const tinygltf::Model& model)
 					.alloc = FResource::Allocation::Transient(gpuFinishFence),
 					.size = GetAlignedSize(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT, blasPreBuildInfo.ScratchDataSizeInBytes) })};
 
-				m_blasList[meshName].reset(RenderBackend12::CreateNewShaderBuffer({
+				m_blasList[assetIndex].reset(RenderBackend12::CreateNewShaderBuffer({
 					.name = PrintString(L"%s_blas", s2ws(meshName)),
 					.type = FShaderBuffer::Type::AccelerationStructure,
 					.accessMode = FResource::AccessMode::GpuReadWrite,
@@ -766,9 +1544,9 @@ void FScene::CreateAccelerationStructures(const tinygltf::Model& model)
 				D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
 				buildDesc.Inputs = blasInputsDesc;
 				buildDesc.ScratchAccelerationStructureData = blasScratch->m_resource->m_d3dResource->GetGPUVirtualAddress();
-				buildDesc.DestAccelerationStructureData = m_blasList[meshName]->m_resource->m_d3dResource->GetGPUVirtualAddress();
+				buildDesc.DestAccelerationStructureData = m_blasList[assetIndex]->m_resource->m_d3dResource->GetGPUVirtualAddress();
 				cmdList->m_d3dCmdList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
-				m_blasList[meshName]->m_resource->UavBarrier(cmdList);
+				m_blasList[assetIndex]->m_resource->UavBarrier(cmdList);
 			}
 		}
 
@@ -785,7 +1563,7 @@ void FScene::CreateAccelerationStructures(const tinygltf::Model& model)
 		instance.InstanceContributionToHitGroupIndex = 0;
 		instance.InstanceMask = 1;
 		instance.Flags = bDoubleSided ? D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE : D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-		instance.AccelerationStructure = m_blasList[meshName]->m_resource->m_d3dResource->GetGPUVirtualAddress();
+		instance.AccelerationStructure = m_blasList[assetIndex]->m_resource->m_d3dResource->GetGPUVirtualAddress();
 
 		// Transpose and convert to 3x4 matrix
 		const Matrix& localToWorld = m_sceneMeshes.m_transformList[meshIndex];
@@ -863,7 +1641,34 @@ void FScene::LoadMaterials(const tinygltf::Model& model)
 		FScene::s_loadProgress += progressIncrement;
 	}//);
 
+	CreateMaterialBuffer();
+}
+
+void FScene::BeginTextureLoads()
+{
+	// Uploads are batched up to this size so that each upload context and command list covers several textures
+	const size_t uploadBatchSize = 64ull << 20;
+
+	const FConfig& config = Demo::GetConfig();
+	const size_t workerCount = config.TextureLoadWorkers > 0 ? config.TextureLoadWorkers : std::thread::hardware_concurrency();
+	m_texturePipeline = std::make_unique<FTexturePipeline>(workerCount, (size_t)config.TextureLoadBudgetMB << 20, uploadBatchSize);
+}
+
+void FScene::FinishTextureLoads()
+{
+	const FTexturePipeline::FStats stats = m_texturePipeline->Finish();
+	m_texturePipeline.reset();
+
+	// Compare cold loads, with none of the textures cached, against TextureLoadWorkers = 1 for the serial baseline
+	auto ms = [](double seconds) { return (uint32_t)(seconds * 1000.0); };
+	Print("Loaded %u textures (%u from the texture cache) on %u workers in %u ms. Decode %u ms, mips %u ms, compression %u ms, cache write %u ms, upload %u ms in %u batches. Peak %u MB in flight.\n",
+		(uint32_t)stats.m_textureCount, (uint32_t)stats.m_cachedTextureCount, (uint32_t)stats.m_workerCount, ms(stats.m_totalSeconds), ms(stats.m_decodeSeconds),
+		ms(stats.m_mipSeconds), ms(stats.m_compressSeconds), ms(stats.m_cacheWriteSeconds), ms(stats.m_uploadSeconds), (uint32_t)stats.m_uploadBatchCount,
+		(uint32_t)(stats.m_peakBytesInFlight >> 20));
+}
 
+void FScene::CreateMaterialBuffer()
+{
 	const size_t bufferSize = m_materialList.size() * sizeof(FMaterial);
 	FResourceUploadContext uploader{ bufferSize };
 
@@ -888,7 +1693,7 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 {
 	SCOPED_CPU_EVENT("load_material", PIX_COLOR_DEFAULT);
 
-	tinygltf::Material material = model.materials[materialIndex];
+	const tinygltf::Material& material = model.materials[materialIndex];
 
 	// The occlusion texture is sometimes packed with the metal/roughness texture. This is currently not supported since the filtered normal roughness texture point to the same location as the cached AO texture
 	DebugAssert(material.occlusionTexture.index == -1 || (material.occlusionTexture.index != material.pbrMetallicRoughness.metallicRoughnessTexture.index), "Not supported");
@@ -899,9 +1704,9 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 	mat.m_metallicFactor = (float)material.pbrMetallicRoughness.metallicFactor;
 	mat.m_roughnessFactor = (float)material.pbrMetallicRoughness.roughnessFactor;
 	mat.m_aoStrength = (float)material.occlusionTexture.strength;
-	mat.m_emissiveTextureIndex = material.emissiveTexture.index != -1 ? LoadTexture(model.images[model.textures[material.emissiveTexture.index].source], DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_BC3_UNORM_SRGB) : -1;
-	mat.m_baseColorTextureIndex = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].source], DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_BC3_UNORM_SRGB) : -1;
-	mat.m_aoTextureIndex = material.occlusionTexture.index != -1 ? LoadTexture(model.images[model.textures[material.occlusionTexture.index].source], DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC4_UNORM) : -1;
+	mat.m_emissiveTextureIndex = material.emissiveTexture.index != -1 ? LoadTexture(model.images[model.textures[material.emissiveTexture.index].source], ContentCache::TextureSlot::Emissive) : -1;
+	mat.m_baseColorTextureIndex = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].source], ContentCache::TextureSlot::BaseColor) : -1;
+	mat.m_aoTextureIndex = material.occlusionTexture.index != -1 ? LoadTexture(model.images[model.textures[material.occlusionTexture.index].source], ContentCache::TextureSlot::Occlusion) : -1;
 	mat.m_emissiveSamplerIndex = material.emissiveTexture.index != -1 ? Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[material.emissiveTexture.index].sampler]) : -1;
 	mat.m_baseColorSamplerIndex = material.pbrMetallicRoughness.baseColorTexture.index != -1 ? Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[material.pbrMetallicRoughness.baseColorTexture.index].sampler]) : -1;
 	mat.m_metallicRoughnessSamplerIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].sampler]) : -1;
@@ -912,25 +1717,13 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 	if (material.normalTexture.index != -1 && material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1)
 	{
 		// If a normalmap and roughness map are specified, prefilter together to reduce specular aliasing
-		const tinygltf::Image& normalmapImage = model.images[model.textures[material.normalTexture.index].source];
-		const tinygltf::Image& metallicRoughnessImage = model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source];
-
-		// Skip pre-filtering if a cached version is available, which means that they are already pre-filtered
-		if (normalmapImage.image.empty() && metallicRoughnessImage.image.empty())
-		{
-			mat.m_metallicRoughnessTextureIndex = LoadTexture(metallicRoughnessImage);
-			mat.m_normalTextureIndex = LoadTexture(normalmapImage);
-		}
-		else
-		{
-			std::tie(mat.m_normalTextureIndex, mat.m_metallicRoughnessTextureIndex) = PrefilterNormalRoughnessTextures(model.images[model.textures[material.normalTexture.index].source], model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source]);
-		}
+		std::tie(mat.m_normalTextureIndex, mat.m_metallicRoughnessTextureIndex) = PrefilterNormalRoughnessTextures(model.images[model.textures[material.normalTexture.index].source], model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source]);
 	}
 	else
 	{
 		// Otherwise filter individually
-		mat.m_metallicRoughnessTextureIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source], DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_BC5_UNORM) : -1; // Note that this uses a swizzled format to extract the G and B channels for metal/roughness
-		mat.m_normalTextureIndex = material.normalTexture.index != -1 ? LoadTexture(model.images[model.textures[material.normalTexture.index].source], DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC5_SNORM) : -1;
+		mat.m_metallicRoughnessTextureIndex = material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1 ? LoadTexture(model.images[model.textures[material.pbrMetallicRoughness.metallicRoughnessTexture.index].source], ContentCache::TextureSlot::MetallicRoughness) : -1;
+		mat.m_normalTextureIndex = material.normalTexture.index != -1 ? LoadTexture(model.images[model.textures[material.normalTexture.index].source], ContentCache::TextureSlot::Normal) : -1;
 	}
 
 	// ## TRANSMISSION ##
@@ -945,7 +1738,7 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 		if (transmissionIt->second.Has("transmissionTexture"))
 		{
 			int texId = transmissionIt->second.Get("transmissionTexture").Get("index").GetNumberAsInt();
-			mat.m_transmissionTextureIndex = LoadTexture(model.images[model.textures[texId].source], DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC4_UNORM);
+			mat.m_transmissionTextureIndex = LoadTexture(model.images[model.textures[texId].source], ContentCache::TextureSlot::Transmission);
 			mat.m_transmissionSamplerIndex = Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[texId].sampler]);
 		}
 	}
@@ -968,7 +1761,7 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 		if (clearcoatIt->second.Has("clearcoatTexture"))
 		{
 			int texId = clearcoatIt->second.Get("clearcoatTexture").Get("index").GetNumberAsInt();
-			mat.m_clearcoatTextureIndex = LoadTexture(model.images[model.textures[texId].source], DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC4_UNORM);
+			mat.m_clearcoatTextureIndex = LoadTexture(model.images[model.textures[texId].source], ContentCache::TextureSlot::Clearcoat);
 			mat.m_clearcoatSamplerIndex = Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[texId].sampler]);
 		}
 
@@ -979,25 +1772,13 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 		if (clearcoatNormalTexId != -1 && clearcoatRoughnessTexId != -1)
 		{
 			// If a normalmap and roughness map are specified, prefilter together to reduce specular aliasing
-			const tinygltf::Image& normalmapImage = model.images[model.textures[clearcoatNormalTexId].source];
-			const tinygltf::Image& roughnessImage = model.images[model.textures[clearcoatRoughnessTexId].source];
-
-			// Skip pre-filtering if a cached version is available, which means that they are already pre-filtered
-			if (normalmapImage.image.empty() && roughnessImage.image.empty())
-			{
-				mat.m_clearcoatRoughnessTextureIndex = LoadTexture(roughnessImage);
-				mat.m_clearcoatNormalTextureIndex = LoadTexture(normalmapImage);
-			}
-			else
-			{
-				std::tie(mat.m_clearcoatNormalTextureIndex, mat.m_clearcoatRoughnessTextureIndex) = PrefilterNormalRoughnessTextures(model.images[model.textures[clearcoatNormalTexId].source], model.images[model.textures[clearcoatRoughnessTexId].source]);
-			}
+			std::tie(mat.m_clearcoatNormalTextureIndex, mat.m_clearcoatRoughnessTextureIndex) = PrefilterNormalRoughnessTextures(model.images[model.textures[clearcoatNormalTexId].source], model.images[model.textures[clearcoatRoughnessTexId].source]);
 		}
 		else
 		{
 			// Otherwise filter individually
-			mat.m_clearcoatRoughnessTextureIndex = clearcoatRoughnessTexId != -1 ? LoadTexture(model.images[model.textures[clearcoatRoughnessTexId].source], DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_BC5_UNORM) : -1;
-			mat.m_clearcoatNormalTextureIndex = clearcoatNormalTexId != -1 ? LoadTexture(model.images[model.textures[clearcoatNormalTexId].source], DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC5_SNORM) : -1;
+			mat.m_clearcoatRoughnessTextureIndex = clearcoatRoughnessTexId != -1 ? LoadTexture(model.images[model.textures[clearcoatRoughnessTexId].source], ContentCache::TextureSlot::ClearcoatRoughness) : -1;
+			mat.m_clearcoatNormalTextureIndex = clearcoatNormalTexId != -1 ? LoadTexture(model.images[model.textures[clearcoatNormalTexId].source], ContentCache::TextureSlot::ClearcoatNormal) : -1;
 		}
 
 		mat.m_clearcoatRoughnessSamplerIndex = clearcoatRoughnessTexId != -1 ? Demo::GetSamplerCache().CacheSampler(model.samplers[model.textures[clearcoatRoughnessTexId].sampler]) : -1;
@@ -1017,237 +1798,245 @@ FMaterial FScene::LoadMaterial(const tinygltf::Model& model, const int materialI
 	return mat;
 }
 
-int FScene::LoadTexture(const tinygltf::Image& image, const DXGI_FORMAT srcFormat, const DXGI_FORMAT compressedFormat)
+int FScene::LoadTexture(const tinygltf::Image& image, const ContentCache::TextureSlot slot)
 {
 	SCOPED_CPU_EVENT("load_texture", PIX_COLOR_DEFAULT);
 	DebugAssert(!image.uri.empty(), "Embedded image data is not yet supported.");
+	DebugAssert(image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && image.component == 4, "Source Images are always 4 channel 8bpp");
+
+	const ContentCache::FTextureSettings settings = ContentCache::GetTextureSettings(slot);
+	const DXGI_FORMAT srcFormat = (DXGI_FORMAT)settings.m_srcFormat;
+	const DXGI_FORMAT compressedFormat = (DXGI_FORMAT)settings.m_compressedFormat;
+	const uint64_t key = ContentCache::GetTextureKey(ContentCache::HashSource(image.image), slot);
+
+	const int cachedSrvIndex = LoadCachedTexture(key);
+	if (cachedSrvIndex != -1)
+		return cachedSrvIndex;
 
-	if (image.image.empty())
+	SCOPED_CPU_EVENT("content_cache_miss", PIX_COLOR_DEFAULT);
+
+	// The texture is created empty here and its data is loaded by the texture pipeline
+	FTexturePipeline::FRequest request = {};
+	request.m_image = &image;
+	request.m_srcFormat = srcFormat;
+	request.m_compressedFormat = compressedFormat;
+	request.m_mipCount = FTexturePipeline::GetBlockCompressedMipCount(image.width, image.height);
+	if (Demo::GetConfig().UseContentCache)
 	{
-		SCOPED_CPU_EVENT("content_cache_hit", PIX_COLOR_DEFAULT);
+		// The manifest is only saved after the pipeline has written the file
+		request.m_ddsFilename = s2ws(m_textureManifest.GetFilepath(key));
+		m_textureManifest.Add(key, { (uint32_t)compressedFormat, (uint32_t)image.width, (uint32_t)image.height, (uint32_t)request.m_mipCount });
+	}
+
+	FTextureCache& textureCache = Demo::GetTextureCache();
+	const std::wstring name = s2ws(ContentCache::GetFilename(key));
+	const int srvIndex = (int)textureCache.CacheEmptyTexture2D(name, compressedFormat, image.width, image.height, request.m_mipCount);
+	request.m_destination = textureCache.m_cachedTextures[name]->m_resource;
+	m_texturePipeline->Enqueue(std::move(request));
+	m_textureKeys[srvIndex] = key;
+	return srvIndex;
+}
 
-		// Compressed image was found in texture cache
-		const std::wstring cachedFilepath = s2ws(image.uri);
-		DebugAssert(std::filesystem::exists(cachedFilepath), "File not found in texture cache");
+// Textures are named by their key, so a texture that was already loaded from the same sources and settings is shared
+int FScene::LoadCachedTexture(const uint64_t key)
+{
+	FTextureCache& textureCache = Demo::GetTextureCache();
+	const std::wstring name = s2ws(ContentCache::GetFilename(key));
+	auto search = textureCache.m_cachedTextures.find(name);
+	if (search != textureCache.m_cachedTextures.cend())
+	{
+		const int srvIndex = (int)search->second->m_srvIndex;
+		m_textureKeys[srvIndex] = key;
+		return srvIndex;
+	}
 
-		// Load from cache
-		DirectX::TexMetadata metadata;
-		DirectX::ScratchImage scratch;
-		{
-			SCOPED_CPU_EVENT("load_dds", PIX_COLOR_DEFAULT);
-			AssertIfFailed(DirectX::LoadFromDDSFile(cachedFilepath.c_str(), DirectX::DDS_FLAGS_NONE, &metadata, scratch));
-		}
+	const ContentCache::FEntry* entry = m_textureManifest.Find(key);
+	if (!entry)
+		return -1;
 
-		// Upload
-		std::wstring name = std::filesystem::path{ cachedFilepath }.filename().wstring();
-		FResourceUploadContext uploader{ RenderBackend12::GetResourceSize(scratch) };
-		uint32_t bindlessIndex = Demo::GetTextureCache().CacheTexture2D(
-			&uploader,
-			name,
-			metadata.format,
-			metadata.width,
-			metadata.height,
-			scratch.GetImages(),
-			scratch.GetImageCount());
-
-		FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_texture", D3D12_COMMAND_LIST_TYPE_DIRECT);
-		uploader.SubmitUploads(cmdList);
-		RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
-		return bindlessIndex;
+	SCOPED_CPU_EVENT("content_cache_hit", PIX_COLOR_DEFAULT);
+
+	FTexturePipeline::FRequest request = {};
+	request.m_ddsFilename = s2ws(m_textureManifest.GetFilepath(key));
+	request.m_mipCount = entry->m_mipCount;
+
+	const int srvIndex = (int)textureCache.CacheEmptyTexture2D(name, (DXGI_FORMAT)entry->m_format, entry->m_width, entry->m_height, entry->m_mipCount);
+	request.m_destination = textureCache.m_cachedTextures[name]->m_resource;
+	m_texturePipeline->Enqueue(std::move(request));
+	m_textureKeys[srvIndex] = key;
+	return srvIndex;
+}
+
+std::pair<int, int> FScene::PrefilterNormalRoughnessTextures(const tinygltf::Image& normalmap, const tinygltf::Image& metallicRoughnessmap)
+{
+	// Output compression format to use
+	const DXGI_FORMAT normalmapCompressionFormat = (DXGI_FORMAT)ContentCache::PrefilteredNormalSettings.m_compressedFormat;
+	const DXGI_FORMAT metalRoughnessCompressionFormat = (DXGI_FORMAT)ContentCache::PrefilteredRoughnessSettings.m_compressedFormat;
+
+	// Skip pre-filtering if both are loaded already or in the texture cache
+	const auto [normalmapKey, metalRoughnessKey] = ContentCache::GetPrefilteredTextureKeys(
+		ContentCache::HashSource(normalmap.image),
+		ContentCache::HashSource(metallicRoughnessmap.image));
+
+	const std::wstring normalmapName = s2ws(ContentCache::GetFilename(normalmapKey));
+	const std::wstring metalRoughnessName = s2ws(ContentCache::GetFilename(metalRoughnessKey));
+	const auto& cachedTextures = Demo::GetTextureCache().m_cachedTextures;
+	const bool bNormalmapCached = cachedTextures.find(normalmapName) != cachedTextures.cend() || m_textureManifest.Find(normalmapKey);
+	const bool bMetalRoughnessCached = cachedTextures.find(metalRoughnessName) != cachedTextures.cend() || m_textureManifest.Find(metalRoughnessKey);
+	if (bNormalmapCached && bMetalRoughnessCached)
+	{
+		return std::make_pair(LoadCachedTexture(normalmapKey), LoadCachedTexture(metalRoughnessKey));
 	}
-	else
+
+	DebugAssert(normalmap.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && normalmap.component == 4, "Source Images are always 4 channel 8bpp");
+	DebugAssert(metallicRoughnessmap.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && metallicRoughnessmap.component == 4, "Source Images are always 4 channel 8bpp");
+	DebugAssert(normalmap.width == metallicRoughnessmap.width && normalmap.height == metallicRoughnessmap.height, "Assuming texture dimensions are same for now");
+
+	// Initialize destination textures that the filtered results are uploaded to
+	const size_t mipCount = RenderUtils12::CalcMipCount(normalmap.width, normalmap.height, true);
+	int normalmapSrvIndex = (int)Demo::GetTextureCache().CacheEmptyTexture2D(normalmapName, normalmapCompressionFormat, normalmap.width, normalmap.height, mipCount);
+	int metalRoughnessSrvIndex = (int)Demo::GetTextureCache().CacheEmptyTexture2D(metalRoughnessName, metalRoughnessCompressionFormat, metallicRoughnessmap.width, metallicRoughnessmap.height, mipCount);
+	m_textureKeys[normalmapSrvIndex] = normalmapKey;
+	m_textureKeys[metalRoughnessSrvIndex] = metalRoughnessKey;
+
+	// The processing jobs write the files before the manifest is saved
+	std::string normalmapCacheFilepath, metalRoughnessCacheFilepath;
+	if (Demo::GetConfig().UseContentCache)
 	{
-		SCOPED_CPU_EVENT("content_cache_miss", PIX_COLOR_DEFAULT);
-		DebugAssert(image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && image.component == 4, "Source Images are always 4 channel 8bpp");
-
-		// Source image
-		size_t bpp = (image.bits * image.component) / 8;
-		DirectX::Image srcImage = {};
-		srcImage.width = image.width;
-		srcImage.height = image.height;
-		srcImage.format = srcFormat;
-		srcImage.rowPitch = bpp * image.width;
-		srcImage.slicePitch = srcImage.rowPitch * image.height;
-		srcImage.pixels = (uint8_t*)image.image.data();
-
-		// Calculate mips upto 4x4 for block compression
-		int numMips = 0;
-		size_t width = image.width, height = image.height;
-		while (width >= 4 && height >= 4)
-		{
-			numMips++;
-			width = width >> 1;
-			height = height >> 1;
-		}
+		normalmapCacheFilepath = m_textureManifest.GetFilepath(normalmapKey);
+		metalRoughnessCacheFilepath = m_textureManifest.GetFilepath(metalRoughnessKey);
+		m_textureManifest.Add(normalmapKey, { (uint32_t)normalmapCompressionFormat, (uint32_t)normalmap.width, (uint32_t)normalmap.height, (uint32_t)mipCount });
+		m_textureManifest.Add(metalRoughnessKey, { (uint32_t)metalRoughnessCompressionFormat, (uint32_t)metallicRoughnessmap.width, (uint32_t)metallicRoughnessmap.height, (uint32_t)mipCount });
+	}
 
-		// Generate mips
-		DirectX::ScratchImage mipchain = {};
-		HRESULT hr;
-		{
-			SCOPED_CPU_EVENT("generate_mips", PIX_COLOR_DEFAULT);
-			hr = DirectX::GenerateMipMaps(srcImage, DirectX::TEX_FILTER_LINEAR, numMips, mipchain);
-		}
+	if (Demo::GetConfig().CompareNormalRoughnessWithGpu)
+	{
+		CompareNormalRoughnessWithGpu(normalmap, metallicRoughnessmap, mipCount);
+	}
 
+	// Filter on the CPU while the meshes and the other textures load. The model outlives the loading jobs, so the images are not
+	// copied. Each pair is filtered on a single thread, since the pairs of all materials are filtered in parallel.
+	using FFilteredMips = std::pair<std::vector<NormalRoughnessFilter::FMip>, std::vector<NormalRoughnessFilter::FMip>>;
+	auto filterJob = concurrency::create_task([normalmap = &normalmap, metallicRoughnessmap = &metallicRoughnessmap, mipCount]()
+		{
+			SCOPED_CPU_EVENT("vmf_filtering", PIX_COLOR_DEFAULT);
+			std::vector<uint8_t> normalmapPixels, metallicRoughnessPixels;
+			const bool bDecoded = ImageDecode::DecodeRgba8(*normalmap, normalmapPixels) && ImageDecode::DecodeRgba8(*metallicRoughnessmap, metallicRoughnessPixels);
+			DebugAssert(bDecoded, "Failed to decode image");
+
+			auto filteredMips = std::make_shared<FFilteredMips>();
+			NormalRoughnessFilter::Prefilter(
+				normalmapPixels.data(), metallicRoughnessPixels.data(),
+				normalmap->width, normalmap->height, mipCount,
+				filteredMips->first, filteredMips->second, 1);
+			return filteredMips;
+		});
 
-		if (SUCCEEDED((hr)))
+	// Compress and upload both outputs in parallel
+	auto normalmapProcessingJob = filterJob.then([
+		name = normalmapName,
+		cacheFilepath = normalmapCacheFilepath,
+		compressionFmt = normalmapCompressionFormat,
+		this]
+		(std::shared_ptr<FFilteredMips> filteredMips)
 		{
-			SCOPED_CPU_EVENT("block_compression", PIX_COLOR_DEFAULT);
+			ProcessFilteredTexture(filteredMips->first, name, cacheFilepath, compressionFmt);
+		});
 
-			// Block compression
-			DirectX::ScratchImage compressedScratch;
-			{
-				SCOPED_CPU_EVENT("block_compression", PIX_COLOR_DEFAULT);
-				AssertIfFailed(DirectX::Compress(mipchain.GetImages(), numMips, mipchain.GetMetadata(), compressedFormat, DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, compressedScratch));
-			}
+	auto metallicRoughnessProcessingJob = filterJob.then([
+		name = metalRoughnessName,
+		cacheFilepath = metalRoughnessCacheFilepath,
+		compressionFmt = metalRoughnessCompressionFormat,
+		this]
+		(std::shared_ptr<FFilteredMips> filteredMips)
+		{
+			ProcessFilteredTexture(filteredMips->second, name, cacheFilepath, compressionFmt);
+		});
 
-			// Save to disk
-			if (Demo::GetConfig().UseContentCache)
-			{
-				SCOPED_CPU_EVENT("save_to_disk", PIX_COLOR_DEFAULT);
-				std::filesystem::path dirPath{ m_textureCachePath };
-				std::filesystem::path srcFilename{ image.uri };
-				std::filesystem::path destFilename = dirPath / srcFilename.stem();
-				destFilename += std::filesystem::path{ ".dds" };
-				DirectX::TexMetadata compressedMetadata = compressedScratch.GetMetadata();
-				AssertIfFailed(DirectX::SaveToDDSFile(compressedScratch.GetImages(), compressedScratch.GetImageCount(), compressedMetadata, DirectX::DDS_FLAGS_NONE, destFilename.wstring().c_str()));
-			}
+	m_loadingJobs.push_back(normalmapProcessingJob);
+	m_loadingJobs.push_back(metallicRoughnessProcessingJob);
 
-			std::wstring name{ image.uri.begin(), image.uri.end() };
-			FResourceUploadContext uploader{ RenderBackend12::GetResourceSize(compressedScratch) };
-			uint32_t bindlessIndex = Demo::GetTextureCache().CacheTexture2D(
-				&uploader,
-				name,
-				compressedFormat,
-				srcImage.width,
-				srcImage.height,
-				compressedScratch.GetImages(),
-				compressedScratch.GetImageCount());
-
-			FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_texture", D3D12_COMMAND_LIST_TYPE_DIRECT);
-			uploader.SubmitUploads(cmdList);
-			RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
-			return bindlessIndex;
-		}
-		else
-		{
-			SCOPED_CPU_EVENT("uncompressed", PIX_COLOR_DEFAULT);
-
-			// No mips and no compression. Don't save to cache and load directly
-			DirectX::ScratchImage scratch;
-			scratch.InitializeFromImage(srcImage);
-			std::wstring name{ image.uri.begin(), image.uri.end() };
-			FResourceUploadContext uploader{ RenderBackend12::GetResourceSize(scratch) };
-			uint32_t bindlessIndex = Demo::GetTextureCache().CacheTexture2D(
-				&uploader,
-				name,
-				compressedFormat,
-				srcImage.width,
-				srcImage.height,
-				&srcImage,
-				1);
-
-			FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_texture", D3D12_COMMAND_LIST_TYPE_DIRECT);
-			uploader.SubmitUploads(cmdList);
-			RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
-			return bindlessIndex;
-		}
-	}
+	return std::make_pair(normalmapSrvIndex, metalRoughnessSrvIndex);
 }
 
-std::pair<int, int> FScene::PrefilterNormalRoughnessTextures(const tinygltf::Image& normalmap, const tinygltf::Image& metallicRoughnessmap)
+// Runs content-pipeline/prefilter-normal-roughness.hlsl on the pair and reads the result back, to check the CPU filter against the 
+// shader that it replaces. The golden data of "mesh-tool normal-roughness" is generated by the CPU reference, so this is the only 
+// comparison with the GPU. It stalls until the GPU is done, so it is only for debugging.
+void FScene::CompareNormalRoughnessWithGpu(const tinygltf::Image& normalmap, const tinygltf::Image& metallicRoughnessmap, const size_t mipCount)
 {
-	SCOPED_CPU_EVENT("vmf_filtering", PIX_COLOR_DEFAULT);
+	SCOPED_CPU_EVENT("compare_vmf_filtering", PIX_COLOR_DEFAULT);
 
-	// Output compression format to use
-	const DXGI_FORMAT normalmapCompressionFormat = DXGI_FORMAT_BC5_SNORM;
-	const DXGI_FORMAT metalRoughnessCompressionFormat = DXGI_FORMAT_BC5_UNORM;
+	std::vector<uint8_t> normalmapPixels, metallicRoughnessPixels;
+	const bool bDecoded = ImageDecode::DecodeRgba8(normalmap, normalmapPixels) && ImageDecode::DecodeRgba8(metallicRoughnessmap, metallicRoughnessPixels);
+	DebugAssert(bDecoded, "Failed to decode image");
 
-	// Source normal image data
-	DebugAssert(normalmap.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && normalmap.component == 4, "Source Images are always 4 channel 8bpp");
-	size_t bpp = (normalmap.bits * normalmap.component) / 8;
-	DirectX::Image normalmapImage = {};
-	normalmapImage.width = normalmap.width;
-	normalmapImage.height = normalmap.height;
-	normalmapImage.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	normalmapImage.rowPitch = bpp * normalmap.width;
-	normalmapImage.slicePitch = normalmapImage.rowPitch * normalmap.height;
-	normalmapImage.pixels = (uint8_t*)normalmap.image.data();
-
-	DirectX::ScratchImage normalScratch;
-	normalScratch.InitializeFromImage(normalmapImage);
+	std::vector<NormalRoughnessFilter::FMip> cpuNormalMips, cpuMetallicRoughnessMips;
+	NormalRoughnessFilter::Prefilter(
+		normalmapPixels.data(), metallicRoughnessPixels.data(),
+		normalmap.width, normalmap.height, mipCount,
+		cpuNormalMips, cpuMetallicRoughnessMips);
 
-	// Source metallic roughness image data
-	DebugAssert(metallicRoughnessmap.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && metallicRoughnessmap.component == 4, "Source Images are always 4 channel 8bpp");
-	bpp = (metallicRoughnessmap.bits * metallicRoughnessmap.component) / 8;
-	DirectX::Image metallicRoughnessImage = {};
-	metallicRoughnessImage.width = metallicRoughnessmap.width;
-	metallicRoughnessImage.height = metallicRoughnessmap.height;
-	metallicRoughnessImage.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	metallicRoughnessImage.rowPitch = bpp * metallicRoughnessmap.width;
-	metallicRoughnessImage.slicePitch = metallicRoughnessImage.rowPitch * metallicRoughnessmap.height;
-	metallicRoughnessImage.pixels = (uint8_t*)metallicRoughnessmap.image.data();
-
-	DirectX::ScratchImage metallicRoughnessScratch;
-	metallicRoughnessScratch.InitializeFromImage(metallicRoughnessImage);
+	auto GetSourceImage = [&normalmap](const std::vector<uint8_t>& pixels)
+	{
+		DirectX::Image image = {};
+		image.width = normalmap.width;
+		image.height = normalmap.height;
+		image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		image.rowPitch = 4 * image.width;
+		image.slicePitch = image.rowPitch * image.height;
+		image.pixels = (uint8_t*)pixels.data();
+		return image;
+	};
 
-	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"prefilter_normal_roughness", D3D12_COMMAND_LIST_TYPE_DIRECT);
+	DirectX::Image normalmapImage = GetSourceImage(normalmapPixels);
+	DirectX::Image metallicRoughnessImage = GetSourceImage(metallicRoughnessPixels);
+
+	FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"compare_prefilter_normal_roughness", D3D12_COMMAND_LIST_TYPE_DIRECT);
 	FFenceMarker gpuFinishFence = cmdList->GetFence(FCommandList::SyncPoint::GpuFinish);
 
-	// Create source textures
-	const size_t uploadSize = RenderBackend12::GetResourceSize(normalScratch) + RenderBackend12::GetResourceSize(metallicRoughnessScratch);
-	FResourceUploadContext uploader{ uploadSize };
+	// Source textures. The upload buffer is sized for the aligned rows of the GPU copies.
+	DirectX::ScratchImage normalScratch, metallicRoughnessScratch;
+	normalScratch.InitializeFromImage(normalmapImage);
+	metallicRoughnessScratch.InitializeFromImage(metallicRoughnessImage);
+	FResourceUploadContext uploader{ RenderBackend12::GetResourceSize(normalScratch) + RenderBackend12::GetResourceSize(metallicRoughnessScratch) };
+	auto CreateSourceTexture = [&](const wchar_t* name, DirectX::Image& image)
+	{
+		return std::unique_ptr<FTexture>{ RenderBackend12::CreateNewTexture({
+			.name = name,
+			.type = FTexture::Type::Tex2D,
+			.alloc = FResource::Allocation::Transient(gpuFinishFence),
+			.format = image.format,
+			.width = image.width,
+			.height = image.height,
+			.resourceState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+			.upload = {
+				.images = &image,
+				.context = &uploader
+			}
+		})};
+	};
 
-	std::unique_ptr<FTexture> srcNormalmap{ RenderBackend12::CreateNewTexture({
-		.name = L"src_normalmap",
-		.type = FTexture::Type::Tex2D,
-		.alloc = FResource::Allocation::Transient(gpuFinishFence),
-		.format = normalmapImage.format,
-		.width = normalmapImage.width,
-		.height = normalmapImage.height,
-		.resourceState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		.upload = {
-			.images = &normalmapImage,
-			.context = &uploader 
-		}
-	})};
+	std::unique_ptr<FTexture> srcNormalmap = CreateSourceTexture(L"src_normalmap", normalmapImage);
+	std::unique_ptr<FTexture> srcMetallicRoughnessmap = CreateSourceTexture(L"src_metallic_roughness", metallicRoughnessImage);
 
-	std::unique_ptr<FTexture> srcMetallicRoughnessmap{ RenderBackend12::CreateNewTexture({
-		.name = L"src_metallic_roughness",
-		.type = FTexture::Type::Tex2D,
-		.alloc = FResource::Allocation::Transient(gpuFinishFence),
-		.format = metallicRoughnessImage.format,
-		.width = metallicRoughnessImage.width,
-		.height = metallicRoughnessImage.height,
-		.resourceState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-		.upload = {
-			.images = &metallicRoughnessImage,
-			.context = &uploader
-		}
-	})};
+	// Filtered mips
+	auto CreateFilterUav = [&](const wchar_t* name)
+	{
+		return std::unique_ptr<FShaderSurface>{ RenderBackend12::CreateNewShaderSurface({
+			.name = name,
+			.type = FShaderSurface::Type::UAV,
+			.alloc = FResource::Allocation::Transient(gpuFinishFence),
+			.format = DXGI_FORMAT_R8G8B8A8_UNORM,
+			.width = normalmapImage.width,
+			.height = normalmapImage.height,
+			.mipLevels = mipCount })};
+	};
 
-	// Create UAVs for prefiltering
-	size_t normalmapMipCount = RenderUtils12::CalcMipCount(normalmapImage.width, normalmapImage.height, true);	
-	std::unique_ptr<FShaderSurface> normalmapFilterUav{ RenderBackend12::CreateNewShaderSurface({
-		.name = L"dest_normalmap",
-		.type = FShaderSurface::Type::UAV,
-		.alloc = FResource::Allocation::Transient(gpuFinishFence),
-		.format = normalmapImage.format,
-		.width = normalmapImage.width,
-		.height = normalmapImage.height,
-		.mipLevels = normalmapMipCount })};
-
-	size_t metallicRoughnessMipCount = RenderUtils12::CalcMipCount(metallicRoughnessImage.width, metallicRoughnessImage.height, true);
-	std::unique_ptr<FShaderSurface> metallicRoughnessFilterUav{ RenderBackend12::CreateNewShaderSurface({
-		.name = L"dest_metallicRoughnessmap",
-		.type = FShaderSurface::Type::UAV,
-		.alloc = FResource::Allocation::Transient(gpuFinishFence),
-		.format = metallicRoughnessImage.format,
-		.width = metallicRoughnessImage.width,
-		.height = metallicRoughnessImage.height,
-		.mipLevels = metallicRoughnessMipCount })};
+	std::unique_ptr<FShaderSurface> normalmapFilterUav = CreateFilterUav(L"dest_normalmap");
+	std::unique_ptr<FShaderSurface> metallicRoughnessFilterUav = CreateFilterUav(L"dest_metallicRoughnessmap");
 
 	D3DCommandList_t* d3dCmdList = cmdList->m_d3dCmdList.get();
-	SCOPED_COMMAND_QUEUE_EVENT(cmdList->m_type, "prefilter_normal_roughness", 0);
+	SCOPED_COMMAND_QUEUE_EVENT(cmdList->m_type, "compare_prefilter_normal_roughness", 0);
 	uploader.SubmitUploads(cmdList);
 
 	{
@@ -1281,13 +2070,10 @@ std::pair<int, int> FScene::PrefilterNormalRoughnessTextures(const tinygltf::Ima
 		D3DPipelineState_t* pso = RenderBackend12::FetchComputePipelineState(psoDesc);
 		d3dCmdList->SetPipelineState(pso);
 
-		DebugAssert(normalmapImage.width == metallicRoughnessImage.width && normalmapImage.height == metallicRoughnessImage.height, "Assuming texture dimensions are same for now");
-
 		// Prefilter
-		size_t numMips = std::min<size_t>(normalmapMipCount, metallicRoughnessMipCount);
-		size_t mipWidth = std::min<size_t>(normalmapImage.width, metallicRoughnessImage.width);
-		size_t mipHeight = std::min<size_t>(normalmapImage.height, metallicRoughnessImage.height);
-		for (uint32_t mipIndex = 0; mipIndex < numMips; ++mipIndex)
+		size_t mipWidth = normalmapImage.width;
+		size_t mipHeight = normalmapImage.height;
+		for (uint32_t mipIndex = 0; mipIndex < mipCount; ++mipIndex)
 		{
 			struct
 			{
@@ -1314,85 +2100,62 @@ std::pair<int, int> FScene::PrefilterNormalRoughnessTextures(const tinygltf::Ima
 		}
 	}
 
-	// Transition to COMMON because we will be doing a GPU readback after filtering is done on the GPU
+	// Transition to COMMON for the readback
 	normalmapFilterUav->m_resource->Transition(cmdList, normalmapFilterUav->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COMMON);
 	metallicRoughnessFilterUav->m_resource->Transition(cmdList, metallicRoughnessFilterUav->m_resource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_COMMON);
-
-	// Execute CL
 	RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
-	FFenceMarker completionFence = cmdList->GetFence(FCommandList::SyncPoint::GpuFinish);
 
-	// Initialize destination textures where the filtered results will be copied
-	int normalmapSrvIndex = (int)Demo::GetTextureCache().CacheEmptyTexture2D(s2ws(normalmap.uri), normalmapCompressionFormat, normalmap.width, normalmap.height, normalmapMipCount);
-	int metalRoughnessSrvIndex = (int)Demo::GetTextureCache().CacheEmptyTexture2D(s2ws(metallicRoughnessmap.uri), metalRoughnessCompressionFormat, metallicRoughnessmap.width, metallicRoughnessmap.height, metallicRoughnessMipCount);
+	const FFenceMarker completionFence = cmdList->GetFence(FCommandList::SyncPoint::GpuFinish);
+	FResourceReadbackContext normalmapReadback{ normalmapFilterUav->m_resource };
+	FResourceReadbackContext metallicRoughnessReadback{ metallicRoughnessFilterUav->m_resource };
+	normalmapReadback.StageSubresources(completionFence).Wait();
+	metallicRoughnessReadback.StageSubresources(completionFence).Wait();
 
-	// Copy back normal texture and compress
-	auto normalmapReadbackContext = std::make_shared<FResourceReadbackContext>(normalmapFilterUav->m_resource);
-	FFenceMarker normalmapStageCompleteMarker = normalmapReadbackContext->StageSubresources(completionFence);
-	auto normalmapProcessingJob = concurrency::create_task([normalmapStageCompleteMarker, this]()
-		{
-			normalmapStageCompleteMarker.Wait();
-		}).then([
-			normalmapReadbackContext,
-			width = normalmap.width,
-			height = normalmap.height,
-			filename = normalmap.uri,
-			mipCount = normalmapMipCount,
-			compressionFmt = normalmapCompressionFormat,
-			bpp = (normalmap.bits * normalmap.component) / 8,
-			this]
-			()
+	// Rows are padded in the readback buffer
+	auto ReadMips = [&cpuNormalMips](FResourceReadbackContext& readback)
+	{
+		std::vector<NormalRoughnessFilter::FMip> mips = cpuNormalMips;
+		for (size_t mipIndex = 0; mipIndex < mips.size(); ++mipIndex)
 		{
-			ProcessReadbackTexture(normalmapReadbackContext.get(), filename, width, height, mipCount, compressionFmt, bpp);
-		});
-
-		// Copy back metallic-roughness texture and compress
-		auto metallicRoughnessReadbackContext = std::make_shared<FResourceReadbackContext>(metallicRoughnessFilterUav->m_resource);
-		FFenceMarker metallicRoughnessStageCompleteMarker = metallicRoughnessReadbackContext->StageSubresources(completionFence);
-		auto metallicRoughnessProcessingJob = concurrency::create_task([metallicRoughnessStageCompleteMarker, this]()
+			NormalRoughnessFilter::FMip& mip = mips[mipIndex];
+			const D3D12_SUBRESOURCE_DATA data = readback.GetTextureData((int)mipIndex);
+			for (size_t row = 0; row < mip.m_height; ++row)
 			{
-				metallicRoughnessStageCompleteMarker.Wait();
-			}).then([
-				metallicRoughnessReadbackContext,
-				width = metallicRoughnessmap.width,
-				height = metallicRoughnessmap.height,
-				filename = metallicRoughnessmap.uri,
-				mipCount = metallicRoughnessMipCount,
-				compressionFmt = metalRoughnessCompressionFormat,
-				bpp = (metallicRoughnessmap.bits * metallicRoughnessmap.component) / 8,
-				this]
-				()
-			{
-				ProcessReadbackTexture(metallicRoughnessReadbackContext.get(), filename, width, height, mipCount, compressionFmt, bpp);
-			});
+				memcpy(&mip.m_texels[row * mip.m_width * 4], (const uint8_t*)data.pData + row * data.RowPitch, mip.m_width * 4);
+			}
+		}
 
-			m_loadingJobs.push_back(normalmapProcessingJob);
-			m_loadingJobs.push_back(metallicRoughnessProcessingJob);
+		return mips;
+	};
 
-			return std::make_pair(normalmapSrvIndex, metalRoughnessSrvIndex);
+	const NormalRoughnessFilter::FDifference normalDifference = NormalRoughnessFilter::Compare(cpuNormalMips, ReadMips(normalmapReadback));
+	const NormalRoughnessFilter::FDifference metallicRoughnessDifference = NormalRoughnessFilter::Compare(cpuMetallicRoughnessMips, ReadMips(metallicRoughnessReadback));
+	Print("Prefiltered %s and %s (%dx%d, %u mips) on the CPU and the GPU. Normals differ by at most %d in %u channels, metallic/roughness by at most %d in %u channels.\n",
+		normalmap.uri.c_str(), metallicRoughnessmap.uri.c_str(), normalmap.width, normalmap.height, (uint32_t)mipCount,
+		normalDifference.m_maxDifference, (uint32_t)normalDifference.m_differentChannelCount,
+		metallicRoughnessDifference.m_maxDifference, (uint32_t)metallicRoughnessDifference.m_differentChannelCount);
 }
 
-void FScene::ProcessReadbackTexture(FResourceReadbackContext* context, const std::string& filename, const int width, const int height, const size_t mipCount, const DXGI_FORMAT fmt, const int bpp)
+void FScene::ProcessFilteredTexture(const std::vector<NormalRoughnessFilter::FMip>& mips, const std::wstring& name, const std::string& cacheFilepath, const DXGI_FORMAT fmt)
 {
-	std::vector<DirectX::Image> mipchain(mipCount);
+	std::vector<DirectX::Image> mipchain(mips.size());
 
 	for (int i = 0; i < mipchain.size(); ++i)
 	{
-		D3D12_SUBRESOURCE_DATA data = context->GetTextureData(i);
 		DirectX::Image& mip = mipchain[i];
-		mip.width = width >> i;
-		mip.height = height >> i;
+		mip.width = mips[i].m_width;
+		mip.height = mips[i].m_height;
 		mip.format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		mip.rowPitch = data.RowPitch;
-		mip.slicePitch = data.SlicePitch;
-		mip.pixels = (uint8_t*)data.pData;
+		mip.rowPitch = 4 * mip.width;
+		mip.slicePitch = mip.rowPitch * mip.height;
+		mip.pixels = (uint8_t*)mips[i].m_texels.data();
 	}
 
 	// Block compression
 	DirectX::ScratchImage compressedScratch;
 	DirectX::TexMetadata metadata = {
-		.width = (size_t)width,
-		.height = (size_t)height,
+		.width = mipchain[0].width,
+		.height = mipchain[0].height,
 		.depth = 1,
 		.arraySize = 1,
 		.mipLevels = mipchain.size(),
@@ -1401,14 +2164,10 @@ void FScene::ProcessReadbackTexture(FResourceReadbackContext* context, const std
 	AssertIfFailed(DirectX::Compress(mipchain.data(), mipchain.size(), metadata, fmt, DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, compressedScratch));
 
 	// Save to disk
-	if (Demo::GetConfig().UseContentCache)
+	if (!cacheFilepath.empty())
 	{
-		std::filesystem::path dirPath{ m_textureCachePath };
-		std::filesystem::path srcFilename{ filename };
-		std::filesystem::path destFilename = dirPath / srcFilename.stem();
-		destFilename += std::filesystem::path{ ".dds" };
 		DirectX::TexMetadata compressedMetadata = compressedScratch.GetMetadata();
-		AssertIfFailed(DirectX::SaveToDDSFile(compressedScratch.GetImages(), compressedScratch.GetImageCount(), compressedMetadata, DirectX::DDS_FLAGS_NONE, destFilename.wstring().c_str()));
+		AssertIfFailed(DirectX::SaveToDDSFile(compressedScratch.GetImages(), compressedScratch.GetImageCount(), compressedMetadata, DirectX::DDS_FLAGS_NONE, s2ws(cacheFilepath).c_str()));
 	}
 
 	// Upload texture data
@@ -1423,7 +2182,7 @@ void FScene::ProcessReadbackTexture(FResourceReadbackContext* context, const std
 		srcData[mipIndex].SlicePitch = images[mipIndex].slicePitch;
 	}
 
-	FResource* texResource = Demo::GetTextureCache().m_cachedTextures[s2ws(filename)]->m_resource;
+	FResource* texResource = Demo::GetTextureCache().m_cachedTextures[name]->m_resource;
 
 	uploader.UpdateSubresources(
 		texResource,
@@ -1485,76 +2244,121 @@ void FScene::LoadLights(const tinygltf::Model& model)
 	FScene::s_loadProgress += FScene::s_lightsLoadTimeFrac;
 }
 
-void FScene::GenerateMeshlets(const tinygltf::Model& model)
+bool FScene::GenerateMeshlets(tinygltf::Model& model, FModelCache& cache)
 {
 	SCOPED_CPU_EVENT("generate_meshlets", PIX_COLOR_DEFAULT);
 
-	// Generate Meshlets
-	int totalCount = 0;
-	std::vector<FMeshPrimitive*> primitiveList;
-	for (FMesh& mesh : m_sceneMeshes.m_entityList)
+	// Meshes are loaded once however many nodes instance them, but different meshes can still share index and position accessors, 
+	// so meshletize each set only once. Meshes that no node references have no primitives.
+	using AccessorKey = std::pair<int, int>;
+	std::map<AccessorKey, std::vector<FMeshPrimitive*>> primitiveGroups;
+	for (FMesh& mesh : m_meshAssets)
 	{
 		for (FMeshPrimitive& primitive : mesh.m_primitives)
 		{
-			primitiveList.push_back(&primitive);
-			totalCount++;
+			primitiveGroups[{ primitive.m_indexAccessor, primitive.m_positionAccessor }].push_back(&primitive);
+		}
+	}
+
+	std::map<AccessorKey, const tinygltf::Primitive*> sourcePrimitives;
+	for (const tinygltf::Mesh& mesh : model.meshes)
+	{
+		for (const tinygltf::Primitive& primitive : mesh.primitives)
+		{
+			auto posIt = primitive.attributes.find("POSITION");
+			if (posIt != primitive.attributes.cend())
+			{
+				sourcePrimitives[{ primitive.indices, posIt->second }] = &primitive;
+			}
 		}
 	}
 
+	const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+
+	std::vector<std::pair<const tinygltf::Primitive*, std::vector<FMeshPrimitive*>*>> workList;
+	for (auto& [key, group] : primitiveGroups)
+	{
+		workList.push_back({ sourcePrimitives[key], &group });
+	}
+
 	const float beforeProgress = FScene::s_loadProgress;
-	const float progressIncrement = FScene::s_meshletizationTimeFrac / totalCount;
+	const float progressIncrement = FScene::s_meshletizationTimeFrac / workList.size();
 	std::mutex progressUpdateMutex;
 
-	concurrency::parallel_for(0, (int)primitiveList.size(), [&](int i)
+	const uint32_t chunkSize = (uint32_t)Demo::GetConfig().MeshletizeChunkSize;
+	std::atomic<bool> bGenerated = false;
+
+	concurrency::parallel_for(0, (int)workList.size(), [&](int i)
 		{
-			SCOPED_CPU_EVENT("meshletize", PIX_COLOR_DEFAULT);
-
-			FMeshPrimitive* primitive = primitiveList[i];
-
-			// Construct index buffer for generating meshlets
-			const tinygltf::Accessor& indexAccessor = model.accessors[primitive->m_indexAccessor];
-			std::vector<uint32_t> indices;
-			indices.reserve(indexAccessor.count);
-			const tinygltf::BufferView indexBufferView = model.bufferViews[indexAccessor.bufferView];
-			const tinygltf::Buffer indexBuffer = model.buffers[indexBufferView.buffer];
-			const unsigned char* pIndexData = &indexBuffer.data[indexBufferView.byteOffset + indexAccessor.byteOffset];
-			const size_t indexByteStride = indexAccessor.ByteStride(indexBufferView);
-			for (int i = 0; i < indexAccessor.count; ++i)
+			const tinygltf::Primitive* sourcePrimitive = workList[i].first;
+			std::vector<FMeshPrimitive*>& group = *workList[i].second;
+			FMeshPrimitive* primitive = group.front();
+
+			if (MeshUtils::GeneratePrimitiveMeshlets(
+				model, sourcePrimitive,
+				primitive->m_indexAccessor, primitive->m_positionAccessor,
+				accessorRefCounts, chunkSize, cache,
+				primitive->m_meshlets))
 			{
-				// Read 16-bit or 32-bit indices. In either case, we convert to 32-bit.
-				uint32_t indexData = indexByteStride == 2 ? *(uint16_t*)pIndexData : *(uint32_t*)pIndexData;
-				indices.push_back(indexData);
-				pIndexData += indexByteStride;
+				bGenerated = true;
 			}
 
-			// Construct position buffer for generating meshlets
-			const tinygltf::Accessor& positionAccessor = model.accessors[primitive->m_positionAccessor];
-			std::vector<XMFLOAT3> positions;
-			positions.reserve(positionAccessor.count);
-			const tinygltf::BufferView positionBufferView = model.bufferViews[positionAccessor.bufferView];
-			const tinygltf::Buffer positionBuffer = model.buffers[positionBufferView.buffer];
-			const unsigned char* pPositionData = &positionBuffer.data[positionBufferView.byteOffset + positionAccessor.byteOffset];
-			const size_t positionByteStride = positionAccessor.ByteStride(positionBufferView);
-			for (int i = 0; i < positionAccessor.count; ++i)
+			// Simplified cluster hierarchy over the final meshlets
+			if (Demo::GetConfig().GenerateClusterLod)
 			{
-				positions.push_back(XMFLOAT3((float*)pPositionData));
-				pPositionData += positionByteStride;
+				std::vector<XMFLOAT3> positionScratch;
+				const std::span<const XMFLOAT3> positions = AccessorView::Read(AccessorView::Get(model, primitive->m_positionAccessor), positionScratch);
+				std::vector<uint32_t> vertexReps;
+				MeshUtils::WeldVertices(model, *sourcePrimitive, vertexReps);
+				ClusterLod::BuildDag(
+					MeshUtils::MeshletMaxVertices, MeshUtils::MeshletMaxPrimitives,
+					primitive->m_meshlets,
+					positions.data(), positions.size(),
+					vertexReps,
+					primitive->m_clusterDag);
 			}
 
-			// Generate meshlets
-			constexpr uint32_t MAX_VERTS = 64;
-			constexpr uint32_t MAX_PRIMITIVES = 126;
-			MeshUtils::Meshletize(
-				MAX_VERTS, MAX_PRIMITIVES, 
-				indices.data(), indices.size(),
-				positions.data(), positions.size(),
-				primitive->m_meshlets);
+			for (size_t sharedIndex = 1; sharedIndex < group.size(); ++sharedIndex)
+			{
+				group[sharedIndex]->m_meshlets = primitive->m_meshlets;
+				group[sharedIndex]->m_clusterDag = primitive->m_clusterDag;
+			}
 
 			std::lock_guard<std::mutex> guard(progressUpdateMutex);
 			FScene::s_loadProgress += progressIncrement;
 		});
 
 	FScene::s_loadProgress = beforeProgress + FScene::s_meshletizationTimeFrac;
+	return bGenerated;
+}
+
+void FScene::PadBoundsForQuantization()
+{
+	// Bounds are computed from the float positions, so grow them by the largest distance that a decoded position can move
+	auto PositionError = [this](int positionAccessor)
+	{
+		const XMFLOAT3 error = VertexQuantization::MaxPositionError(m_accessorFormats[positionAccessor]);
+		return m_accessorFormats[positionAccessor].m_format == VertexFormat::Unorm16Position ? Vector3{ error }.Length() : 0.f;
+	};
+
+	for (FMesh& mesh : m_meshAssets)
+	{
+		for (FMeshPrimitive& primitive : mesh.m_primitives)
+		{
+			const float error = PositionError(primitive.m_positionAccessor);
+			primitive.m_boundingSphere.Radius += error;
+
+			for (FInlineMeshlet& meshlet : primitive.m_meshlets)
+			{
+				meshlet.m_boundingSphere.Radius += error;
+			}
+
+			for (FLodCluster& cluster : primitive.m_clusterDag.m_clusters)
+			{
+				cluster.m_meshlet.m_boundingSphere.Radius += error;
+			}
+		}
+	}
 }
 
 void FScene::Clear()
@@ -1564,14 +2368,20 @@ void FScene::Clear()
 
 	m_cameras.clear();
 	m_meshBuffers.clear();
+	m_meshBufferPackedOffsets.clear();
+	m_meshBufferViews.clear();
+	m_meshBufferViewRanges.clear();
 	m_blasList.clear();
+	m_meshAssets.clear();
 	m_materialList.clear();
+	m_textureKeys.clear();
 	m_sceneMeshes.Clear();
 	m_sceneMeshDecals.Clear();
 	m_sceneLights.Clear();
 
 	m_packedMeshBufferViews.reset(nullptr);
 	m_packedMeshAccessors.reset(nullptr);
+	m_accessorFormats.clear();
 	m_packedMaterials.reset(nullptr);
 	m_tlas.reset(nullptr);
 	m_dynamicSkyEnvmap.reset();
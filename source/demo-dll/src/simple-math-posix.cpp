@@ -0,0 +1,41 @@
+// The constants of DirectXTK/src/SimpleMath.cpp, for the tools that build on other platforms than Windows. SimpleMath.cpp itself
+// includes the Windows precompiled header of DirectXTK. The out of line Quaternion, Rectangle and Viewport functions are not
+// defined here, since the mesh and content processing doesn't use them.
+#include <SimpleMath.h>
+
+namespace DirectX
+{
+    namespace SimpleMath
+    {
+        const Vector2 Vector2::Zero = { 0.f, 0.f };
+        const Vector2 Vector2::One = { 1.f, 1.f };
+        const Vector2 Vector2::UnitX = { 1.f, 0.f };
+        const Vector2 Vector2::UnitY = { 0.f, 1.f };
+
+        const Vector3 Vector3::Zero = { 0.f, 0.f, 0.f };
+        const Vector3 Vector3::One = { 1.f, 1.f, 1.f };
+        const Vector3 Vector3::UnitX = { 1.f, 0.f, 0.f };
+        const Vector3 Vector3::UnitY = { 0.f, 1.f, 0.f };
+        const Vector3 Vector3::UnitZ = { 0.f, 0.f, 1.f };
+        const Vector3 Vector3::Up = { 0.f, 1.f, 0.f };
+        const Vector3 Vector3::Down = { 0.f, -1.f, 0.f };
+        const Vector3 Vector3::Right = { 1.f, 0.f, 0.f };
+        const Vector3 Vector3::Left = { -1.f, 0.f, 0.f };
+        const Vector3 Vector3::Forward = { 0.f, 0.f, -1.f };
+        const Vector3 Vector3::Backward = { 0.f, 0.f, 1.f };
+
+        const Vector4 Vector4::Zero = { 0.f, 0.f, 0.f, 0.f };
+        const Vector4 Vector4::One = { 1.f, 1.f, 1.f, 1.f };
+        const Vector4 Vector4::UnitX = { 1.f, 0.f, 0.f, 0.f };
+        const Vector4 Vector4::UnitY = { 0.f, 1.f, 0.f, 0.f };
+        const Vector4 Vector4::UnitZ = { 0.f, 0.f, 1.f, 0.f };
+        const Vector4 Vector4::UnitW = { 0.f, 0.f, 0.f, 1.f };
+
+        const Matrix Matrix::Identity = { 1.f, 0.f, 0.f, 0.f,
+                                          0.f, 1.f, 0.f, 0.f,
+                                          0.f, 0.f, 1.f, 0.f,
+                                          0.f, 0.f, 0.f, 1.f };
+
+        const Quaternion Quaternion::Identity = { 0.f, 0.f, 0.f, 1.f };
+    }
+}
@@ -0,0 +1,305 @@
+#include <texture-pipeline.h>
+#include <profiling.h>
+#include <common.h>
+#include <image-decode.h>
+#include <filesystem>
+#include <algorithm>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double GetSeconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Source images are held as RGBA8 while mipmapping, plus the mip chain and the compressed result
+	size_t EstimateBytes(const FTexturePipeline::FRequest& request)
+	{
+		if (request.m_image)
+		{
+			const size_t pixelCount = (size_t)request.m_image->width * request.m_image->height;
+			return pixelCount * 4 * 3;
+		}
+
+		std::error_code ec;
+		const size_t fileSize = (size_t)std::filesystem::file_size(request.m_ddsFilename, ec);
+		return ec ? 0 : fileSize;
+	}
+}
+
+FTexturePipeline::FTexturePipeline(size_t workerCount, size_t memoryBudget, size_t uploadBatchSize) :
+	m_memoryBudget{ memoryBudget },
+	m_uploadBatchSize{ uploadBatchSize },
+	m_compressFlags{ workerCount > 1 ? DirectX::TEX_COMPRESS_DEFAULT : DirectX::TEX_COMPRESS_PARALLEL },	// Textures are already compressed in parallel with each other
+	m_startTime{ Clock::now() }
+{
+	workerCount = std::max<size_t>(workerCount, 1);
+	m_activeWorkers = workerCount;
+	m_stats.m_workerCount = workerCount;
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back([this] { RunWorker(); });
+	}
+
+	m_uploader = std::thread{ [this] { RunUploader(); } };
+}
+
+FTexturePipeline::~FTexturePipeline()
+{
+	Finish();
+}
+
+void FTexturePipeline::Enqueue(FRequest request)
+{
+	const size_t estimatedBytes = EstimateBytes(request);
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		DebugAssert(!m_bFinishing, "Textures cannot be enqueued after Finish()");
+		m_pending.push_back({ std::move(request), estimatedBytes });
+	}
+
+	m_condition.notify_all();
+}
+
+FTexturePipeline::FStats FTexturePipeline::Finish()
+{
+	SCOPED_CPU_EVENT("wait_texture_pipeline", PIX_COLOR_DEFAULT);
+
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_bFinishing = true;
+	}
+
+	m_condition.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+
+	if (m_uploader.joinable())
+	{
+		m_uploader.join();
+		m_stats.m_totalSeconds = GetSeconds(m_startTime);
+	}
+
+	return m_stats;
+}
+
+size_t FTexturePipeline::GetBlockCompressedMipCount(size_t width, size_t height)
+{
+	size_t mipCount = 0;
+	while (width >= 4 && height >= 4)
+	{
+		mipCount++;
+		width = width >> 1;
+		height = height >> 1;
+	}
+
+	return std::max<size_t>(mipCount, 1);
+}
+
+void FTexturePipeline::RunWorker()
+{
+	FStats stats;
+	while (true)
+	{
+		FPendingTexture texture;
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+
+			// Wait for the next texture to fit in the budget. A texture that is larger than the whole budget still goes through on its own.
+			m_condition.wait(lock, [this]
+				{
+					if (m_pending.empty())
+						return m_bFinishing;
+
+					return m_bytesInFlight == 0 || m_bytesInFlight + m_pending.front().m_estimatedBytes <= m_memoryBudget;
+				});
+
+			if (m_pending.empty())
+				break;
+
+			texture = std::move(m_pending.front());
+			m_pending.pop_front();
+			m_bytesInFlight += texture.m_estimatedBytes;
+			m_stats.m_peakBytesInFlight = std::max(m_stats.m_peakBytesInFlight, m_bytesInFlight);
+		}
+
+		FProcessedTexture processed = Process(texture, stats);
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_processed.push_back(std::move(processed));
+		}
+
+		m_condition.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_activeWorkers--;
+		m_stats.m_textureCount += stats.m_textureCount;
+		m_stats.m_cachedTextureCount += stats.m_cachedTextureCount;
+		m_stats.m_decodeSeconds += stats.m_decodeSeconds;
+		m_stats.m_mipSeconds += stats.m_mipSeconds;
+		m_stats.m_compressSeconds += stats.m_compressSeconds;
+		m_stats.m_cacheWriteSeconds += stats.m_cacheWriteSeconds;
+	}
+
+	m_condition.notify_all();
+}
+
+void FTexturePipeline::RunUploader()
+{
+	while (true)
+	{
+		std::vector<FProcessedTexture> batch;
+		size_t uploadSize = 0;
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			m_condition.wait(lock, [this] { return !m_processed.empty() || m_activeWorkers == 0; });
+			if (m_processed.empty())
+				return;
+
+			// Fill the batch up to its size, but always take at least one texture
+			while (!m_processed.empty())
+			{
+				const size_t textureSize = RenderBackend12::GetResourceSize(m_processed.front().m_scratch) + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+				if (!batch.empty() && uploadSize + textureSize > m_uploadBatchSize)
+					break;
+
+				uploadSize += textureSize;
+				batch.push_back(std::move(m_processed.front()));
+				m_processed.pop_front();
+			}
+		}
+
+		const auto uploadStart = Clock::now();
+		{
+			SCOPED_CPU_EVENT("upload_texture_batch", PIX_COLOR_DEFAULT);
+			FResourceUploadContext uploader{ uploadSize };
+			for (FProcessedTexture& texture : batch)
+			{
+				const DirectX::Image* images = texture.m_scratch.GetImages();
+				std::vector<D3D12_SUBRESOURCE_DATA> srcData(texture.m_scratch.GetImageCount());
+				for (int mipIndex = 0; mipIndex < srcData.size(); ++mipIndex)
+				{
+					srcData[mipIndex].pData = images[mipIndex].pixels;
+					srcData[mipIndex].RowPitch = images[mipIndex].rowPitch;
+					srcData[mipIndex].SlicePitch = images[mipIndex].slicePitch;
+				}
+
+				FResource* texResource = texture.m_destination;
+				uploader.UpdateSubresources(
+					texResource,
+					srcData,
+					[texResource](FCommandList* cmdList)
+					{
+						texResource->Transition(cmdList, texResource->GetTransitionToken(), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+					});
+			}
+
+			FCommandList* cmdList = RenderBackend12::FetchCommandlist(L"upload_textures", D3D12_COMMAND_LIST_TYPE_DIRECT);
+			uploader.SubmitUploads(cmdList);
+			RenderBackend12::ExecuteCommandlists(D3D12_COMMAND_LIST_TYPE_DIRECT, { cmdList });
+		}
+
+		// The texture data has been copied to the upload buffer, so the scratch images can be released
+		size_t releasedBytes = 0;
+		for (const FProcessedTexture& texture : batch)
+		{
+			releasedBytes += texture.m_estimatedBytes;
+		}
+
+		batch.clear();
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_bytesInFlight -= releasedBytes;
+			m_stats.m_uploadBatchCount++;
+			m_stats.m_uploadSeconds += GetSeconds(uploadStart);
+		}
+
+		m_condition.notify_all();
+	}
+}
+
+FTexturePipeline::FProcessedTexture FTexturePipeline::Process(const FPendingTexture& texture, FStats& stats) const
+{
+	SCOPED_CPU_EVENT("process_texture", PIX_COLOR_DEFAULT);
+
+	const FRequest& request = texture.m_request;
+	FProcessedTexture result = {};
+	result.m_destination = request.m_destination;
+	result.m_estimatedBytes = texture.m_estimatedBytes;
+	stats.m_textureCount++;
+
+	// Compressed image was found in texture cache
+	if (!request.m_image)
+	{
+		SCOPED_CPU_EVENT("load_dds", PIX_COLOR_DEFAULT);
+		const auto start = Clock::now();
+		AssertIfFailed(DirectX::LoadFromDDSFile(request.m_ddsFilename.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, result.m_scratch));
+		stats.m_decodeSeconds += GetSeconds(start);
+		stats.m_cachedTextureCount++;
+		return result;
+	}
+
+	std::vector<uint8_t> pixels;
+	{
+		SCOPED_CPU_EVENT("decode_image", PIX_COLOR_DEFAULT);
+		const auto start = Clock::now();
+		const bool bDecoded = ImageDecode::DecodeRgba8(*request.m_image, pixels);
+		DebugAssert(bDecoded, "Failed to decode image");
+		stats.m_decodeSeconds += GetSeconds(start);
+	}
+
+	DirectX::Image srcImage = {};
+	srcImage.width = request.m_image->width;
+	srcImage.height = request.m_image->height;
+	srcImage.format = request.m_srcFormat;
+	srcImage.rowPitch = 4 * srcImage.width;
+	srcImage.slicePitch = srcImage.rowPitch * srcImage.height;
+	srcImage.pixels = pixels.data();
+
+	// Generate mips
+	DirectX::ScratchImage mipchain;
+	{
+		SCOPED_CPU_EVENT("generate_mips", PIX_COLOR_DEFAULT);
+		const auto start = Clock::now();
+		if (request.m_mipCount > 1)
+		{
+			AssertIfFailed(DirectX::GenerateMipMaps(srcImage, DirectX::TEX_FILTER_LINEAR, request.m_mipCount, mipchain));
+		}
+		else
+		{
+			AssertIfFailed(mipchain.InitializeFromImage(srcImage));
+		}
+
+		stats.m_mipSeconds += GetSeconds(start);
+	}
+
+	pixels = {};
+
+	// Block compression
+	{
+		SCOPED_CPU_EVENT("block_compression", PIX_COLOR_DEFAULT);
+		const auto start = Clock::now();
+		AssertIfFailed(DirectX::Compress(mipchain.GetImages(), mipchain.GetImageCount(), mipchain.GetMetadata(), request.m_compressedFormat, m_compressFlags, DirectX::TEX_THRESHOLD_DEFAULT, result.m_scratch));
+		stats.m_compressSeconds += GetSeconds(start);
+	}
+
+	// Save to disk
+	if (!request.m_ddsFilename.empty())
+	{
+		SCOPED_CPU_EVENT("save_to_disk", PIX_COLOR_DEFAULT);
+		const auto start = Clock::now();
+		AssertIfFailed(DirectX::SaveToDDSFile(result.m_scratch.GetImages(), result.m_scratch.GetImageCount(), result.m_scratch.GetMetadata(), DirectX::DDS_FLAGS_NONE, request.m_ddsFilename.c_str()));
+		stats.m_cacheWriteSeconds += GetSeconds(start);
+	}
+
+	return result;
+}
@@ -358,6 +358,8 @@ void UI::Update(Demo::App* demoApp, const float deltaTime)
 					ImGui::Checkbox("Forward Lighting", &settings->ForwardLighting);
 					ImGui::SameLine();
 					ImGui::Checkbox("Frustum Culling", &settings->FrustumCulling);
+					ImGui::SameLine();
+					ImGuiExt::EditCondition(settings->UseMeshlets, [&]() { ImGui::Checkbox("Backface Culling", &settings->BackfaceCulling); });
 				}
 			});
 
@@ -0,0 +1,346 @@
+#include <vertex-quantization.h>
+#include <accessor-view.h>
+#include <profiling.h>
+#include <common.h>
+#include <DirectXPackedVector.h>
+#include <parallel.h>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr float Unorm16Max = 65535.f;
+	constexpr float Snorm16Max = 32767.f;
+	constexpr float Snorm15Max = 16383.f;
+
+	float SignNotZero(float v)
+	{
+		return v >= 0.f ? 1.f : -1.f;
+	}
+
+	// Octahedral projection of a unit vector onto [-1, 1]^2 (Cigolle et al. 2014, "A Survey of Efficient Representations for
+	// Independent Unit Vectors"). The lower hemisphere is folded over the diagonals.
+	XMFLOAT2 OctahedralEncode(const XMFLOAT3& v)
+	{
+		const float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		if (l1 == 0.f)
+			return XMFLOAT2{ 0.f, 0.f };
+
+		const float x = v.x / l1;
+		const float y = v.y / l1;
+		if (v.z >= 0.f)
+			return XMFLOAT2{ x, y };
+
+		return XMFLOAT2{ (1.f - std::abs(y)) * SignNotZero(x), (1.f - std::abs(x)) * SignNotZero(y) };
+	}
+
+	XMFLOAT3 OctahedralDecode(float x, float y)
+	{
+		XMFLOAT3 v = { x, y, 1.f - std::abs(x) - std::abs(y) };
+		const float t = std::max(-v.z, 0.f);
+		v.x += v.x >= 0.f ? -t : t;
+		v.y += v.y >= 0.f ? -t : t;
+		XMStoreFloat3(&v, XMVector3Normalize(XMLoadFloat3(&v)));
+		return v;
+	}
+
+	int16_t QuantizeSnorm(float v, float maxValue)
+	{
+		return (int16_t)std::round(std::clamp(v, -1.f, 1.f) * maxValue);
+	}
+
+	// Accessors that are referenced with more than one semantic, or by a morph target, stay as floats
+	constexpr int UnusedAccessor = -1;
+	constexpr int SharedAccessor = -2;
+
+	struct FCompactStream
+	{
+		int m_accessorIndex;
+		FAccessorFormat m_format;
+		uint32_t m_byteStride;
+		std::vector<uint8_t> m_data;
+	};
+}
+
+XMFLOAT3 VertexQuantization::MaxPositionError(const FAccessorFormat& format)
+{
+	// Half a quantization step, plus the float rounding of offset + scale * q
+	auto AxisError = [](float offset, float scale)
+	{
+		return 0.5f * scale + 2.f * FLT_EPSILON * (std::abs(offset) + scale * Unorm16Max);
+	};
+
+	return XMFLOAT3{
+		AxisError(format.m_offset.x, format.m_scale.x),
+		AxisError(format.m_offset.y, format.m_scale.y),
+		AxisError(format.m_offset.z, format.m_scale.z) };
+}
+
+FAccessorFormat VertexQuantization::ComputePositionFormat(const XMFLOAT3* positions, uint32_t count)
+{
+	XMVECTOR minPoint = count > 0 ? XMLoadFloat3(&positions[0]) : g_XMZero;
+	XMVECTOR maxPoint = minPoint;
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		const XMVECTOR p = XMLoadFloat3(&positions[i]);
+		minPoint = XMVectorMin(minPoint, p);
+		maxPoint = XMVectorMax(maxPoint, p);
+	}
+
+	FAccessorFormat format;
+	format.m_format = VertexFormat::Unorm16Position;
+	XMStoreFloat3(&format.m_offset, minPoint);
+	XMStoreFloat3(&format.m_scale, (maxPoint - minPoint) / Unorm16Max);
+	return format;
+}
+
+void VertexQuantization::EncodePosition(const XMFLOAT3& position, const FAccessorFormat& format, uint16_t output[4])
+{
+	auto Quantize = [](float v, float offset, float scale) -> uint16_t
+	{
+		return scale > 0.f ? (uint16_t)std::clamp(std::round((v - offset) / scale), 0.f, Unorm16Max) : 0;
+	};
+
+	output[0] = Quantize(position.x, format.m_offset.x, format.m_scale.x);
+	output[1] = Quantize(position.y, format.m_offset.y, format.m_scale.y);
+	output[2] = Quantize(position.z, format.m_offset.z, format.m_scale.z);
+	output[3] = 0;
+}
+
+XMFLOAT3 VertexQuantization::DecodePosition(const uint16_t input[4], const FAccessorFormat& format)
+{
+	return XMFLOAT3{
+		format.m_offset.x + format.m_scale.x * input[0],
+		format.m_offset.y + format.m_scale.y * input[1],
+		format.m_offset.z + format.m_scale.z * input[2] };
+}
+
+uint32_t VertexQuantization::EncodeNormal(const XMFLOAT3& normal)
+{
+	const XMFLOAT2 oct = OctahedralEncode(normal);
+	return (uint16_t)QuantizeSnorm(oct.x, Snorm16Max) | ((uint32_t)(uint16_t)QuantizeSnorm(oct.y, Snorm16Max) << 16);
+}
+
+XMFLOAT3 VertexQuantization::DecodeNormal(uint32_t input)
+{
+	return OctahedralDecode((int16_t)(input & 0xffff) / Snorm16Max, (int16_t)(input >> 16) / Snorm16Max);
+}
+
+uint32_t VertexQuantization::EncodeTangent(const XMFLOAT4& tangent)
+{
+	const XMFLOAT2 oct = OctahedralEncode(XMFLOAT3{ tangent.x, tangent.y, tangent.z });
+	const uint16_t y = (uint16_t)(QuantizeSnorm(oct.y, Snorm15Max) * 2) | (tangent.w < 0.f ? 1 : 0);
+	return (uint16_t)QuantizeSnorm(oct.x, Snorm16Max) | ((uint32_t)y << 16);
+}
+
+XMFLOAT4 VertexQuantization::DecodeTangent(uint32_t input)
+{
+	const int16_t y = (int16_t)(input >> 16);
+	const XMFLOAT3 t = OctahedralDecode((int16_t)(input & 0xffff) / Snorm16Max, (y >> 1) / Snorm15Max);
+	return XMFLOAT4{ t.x, t.y, t.z, (y & 1) ? -1.f : 1.f };
+}
+
+uint32_t VertexQuantization::EncodeTexcoord(const XMFLOAT2& uv)
+{
+	return PackedVector::XMConvertFloatToHalf(uv.x) | ((uint32_t)PackedVector::XMConvertFloatToHalf(uv.y) << 16);
+}
+
+XMFLOAT2 VertexQuantization::DecodeTexcoord(uint32_t input)
+{
+	return XMFLOAT2{ PackedVector::XMConvertHalfToFloat(input & 0xffff), PackedVector::XMConvertHalfToFloat(input >> 16) };
+}
+
+void VertexQuantization::CompactVertexStreams(tinygltf::Model& model, std::vector<FAccessorFormat>& formats)
+{
+	SCOPED_CPU_EVENT("compact_vertex_streams", PIX_COLOR_DEFAULT);
+
+	formats.assign(model.accessors.size(), FAccessorFormat{});
+
+	std::vector<int> semantics(model.accessors.size(), UnusedAccessor);
+	auto Claim = [&](const std::map<std::string, int>& attributes, const char* name, VertexFormat::Type format)
+	{
+		auto it = attributes.find(name);
+		if (it != attributes.cend() && it->second >= 0)
+		{
+			int& semantic = semantics[it->second];
+			semantic = (semantic == UnusedAccessor || semantic == format) ? format : SharedAccessor;
+		}
+	};
+
+	for (const tinygltf::Mesh& mesh : model.meshes)
+	{
+		for (const tinygltf::Primitive& primitive : mesh.primitives)
+		{
+			Claim(primitive.attributes, "POSITION", VertexFormat::Unorm16Position);
+			Claim(primitive.attributes, "NORMAL", VertexFormat::Octahedral16Normal);
+			Claim(primitive.attributes, "TANGENT", VertexFormat::Octahedral16Tangent);
+			Claim(primitive.attributes, "TEXCOORD_0", VertexFormat::Half2Texcoord);
+
+			for (const std::map<std::string, int>& target : primitive.targets)
+			{
+				for (const auto& [name, accessorIndex] : target)
+				{
+					semantics[accessorIndex] = SharedAccessor;
+				}
+			}
+		}
+	}
+
+	std::vector<FCompactStream> streams;
+	for (int accessorIndex = 0; accessorIndex < model.accessors.size(); ++accessorIndex)
+	{
+		const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+		const int semantic = semantics[accessorIndex];
+		const int expectedType =
+			semantic == VertexFormat::Octahedral16Tangent ? TINYGLTF_TYPE_VEC4 :
+			semantic == VertexFormat::Half2Texcoord ? TINYGLTF_TYPE_VEC2 : TINYGLTF_TYPE_VEC3;
+
+		if (semantic >= 0 && accessor.bufferView != -1 && !accessor.sparse.isSparse && accessor.count > 0 &&
+			accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && accessor.type == expectedType)
+		{
+			streams.push_back({ accessorIndex, FAccessorFormat{ (VertexFormat::Type)semantic } });
+		}
+	}
+
+	Parallel::ForEach(streams.begin(), streams.end(), [&model](FCompactStream& stream)
+	{
+		const size_t count = model.accessors[stream.m_accessorIndex].count;
+		switch (stream.m_format.m_format)
+		{
+		case VertexFormat::Unorm16Position:
+		{
+			std::vector<XMFLOAT3> scratch;
+			const std::span<const XMFLOAT3> positions = AccessorView::Read(AccessorView::Get(model, stream.m_accessorIndex), scratch);
+			stream.m_format = ComputePositionFormat(positions.data(), positions.size());
+			stream.m_byteStride = 4 * sizeof(uint16_t);
+			stream.m_data.resize(count * stream.m_byteStride);
+			for (size_t i = 0; i < count; ++i)
+			{
+				EncodePosition(positions[i], stream.m_format, (uint16_t*)&stream.m_data[i * stream.m_byteStride]);
+			}
+			break;
+		}
+		case VertexFormat::Octahedral16Normal:
+		{
+			std::vector<XMFLOAT3> scratch;
+			const std::span<const XMFLOAT3> normals = AccessorView::Read(AccessorView::Get(model, stream.m_accessorIndex), scratch);
+			stream.m_byteStride = sizeof(uint32_t);
+			stream.m_data.resize(count * stream.m_byteStride);
+			for (size_t i = 0; i < count; ++i)
+			{
+				((uint32_t*)stream.m_data.data())[i] = EncodeNormal(normals[i]);
+			}
+			break;
+		}
+		case VertexFormat::Octahedral16Tangent:
+		{
+			std::vector<XMFLOAT4> scratch;
+			const std::span<const XMFLOAT4> tangents = AccessorView::Read(AccessorView::Get(model, stream.m_accessorIndex), scratch);
+			stream.m_byteStride = sizeof(uint32_t);
+			stream.m_data.resize(count * stream.m_byteStride);
+			for (size_t i = 0; i < count; ++i)
+			{
+				((uint32_t*)stream.m_data.data())[i] = EncodeTangent(tangents[i]);
+			}
+			break;
+		}
+		case VertexFormat::Half2Texcoord:
+		{
+			std::vector<XMFLOAT2> scratch;
+			const std::span<const XMFLOAT2> uvs = AccessorView::Read(AccessorView::Get(model, stream.m_accessorIndex), scratch);
+			const bool bFitsHalf = std::all_of(uvs.begin(), uvs.end(), [](const XMFLOAT2& uv)
+			{
+				return std::abs(uv.x) <= 65504.f && std::abs(uv.y) <= 65504.f;
+			});
+
+			if (!bFitsHalf)
+			{
+				stream.m_format = FAccessorFormat{};
+				break;
+			}
+
+			stream.m_byteStride = sizeof(uint32_t);
+			stream.m_data.resize(count * stream.m_byteStride);
+			for (size_t i = 0; i < count; ++i)
+			{
+				((uint32_t*)stream.m_data.data())[i] = EncodeTexcoord(uvs[i]);
+			}
+			break;
+		}
+		}
+	});
+
+	// Append the compact streams to a new buffer and point their accessors at it
+	const int compactBufferIndex = model.buffers.size();
+	model.buffers.emplace_back();
+	model.buffers.back().name = "compact_vertex_streams";
+	std::vector<uint8_t>& compactData = model.buffers.back().data;
+
+	for (const FCompactStream& stream : streams)
+	{
+		if (stream.m_format.m_format == VertexFormat::Float)
+			continue;
+
+		tinygltf::BufferView view = {};
+		view.buffer = compactBufferIndex;
+		view.byteOffset = GetAlignedSize(16, compactData.size());
+		view.byteLength = stream.m_data.size();
+		view.byteStride = stream.m_byteStride;
+		compactData.resize(view.byteOffset);
+		compactData.insert(compactData.end(), stream.m_data.cbegin(), stream.m_data.cend());
+		model.bufferViews.push_back(view);
+
+		tinygltf::Accessor& accessor = model.accessors[stream.m_accessorIndex];
+		accessor.bufferView = model.bufferViews.size() - 1;
+		accessor.byteOffset = 0;
+		accessor.componentType = stream.m_format.m_format == VertexFormat::Unorm16Position ? TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT : TINYGLTF_COMPONENT_TYPE_SHORT;
+		accessor.normalized = true;
+		formats[stream.m_accessorIndex] = stream.m_format;
+	}
+
+	// Drop the bytes of buffer views that are no longer referenced. Views are repacked in order with 16 byte alignment, which
+	// keeps every accessor aligned to its component size.
+	std::vector<bool> liveViews(model.bufferViews.size(), false);
+	for (const tinygltf::Accessor& accessor : model.accessors)
+	{
+		if (accessor.bufferView != -1)
+			liveViews[accessor.bufferView] = true;
+
+		if (accessor.sparse.isSparse)
+		{
+			liveViews[accessor.sparse.indices.bufferView] = true;
+			liveViews[accessor.sparse.values.bufferView] = true;
+		}
+	}
+
+	for (const tinygltf::Image& image : model.images)
+	{
+		if (image.bufferView != -1)
+			liveViews[image.bufferView] = true;
+	}
+
+	std::vector<std::vector<uint8_t>> packedBuffers(model.buffers.size());
+	for (int viewIndex = 0; viewIndex < model.bufferViews.size(); ++viewIndex)
+	{
+		tinygltf::BufferView& view = model.bufferViews[viewIndex];
+		if (!liveViews[viewIndex])
+		{
+			view.byteOffset = 0;
+			view.byteLength = 0;
+			continue;
+		}
+
+		const std::vector<uint8_t>& source = model.buffers[view.buffer].data;
+		std::vector<uint8_t>& packed = packedBuffers[view.buffer];
+		const size_t packedOffset = GetAlignedSize(16, packed.size());
+		packed.resize(packedOffset);
+		packed.insert(packed.end(), source.cbegin() + view.byteOffset, source.cbegin() + view.byteOffset + view.byteLength);
+		view.byteOffset = packedOffset;
+	}
+
+	for (int bufferIndex = 0; bufferIndex < model.buffers.size(); ++bufferIndex)
+	{
+		model.buffers[bufferIndex].data = std::move(packedBuffers[bufferIndex]);
+	}
+}
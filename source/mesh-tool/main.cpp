@@ -0,0 +1,3094 @@
+// Offline reports for the mesh processing in demo-dll/src/mesh-utils.cpp
+// Usage: mesh-tool locality <model.gltf>
+//        mesh-tool indices <model.gltf>
+//        mesh-tool lod <model.gltf>
+//        mesh-tool draw-order <model.gltf>
+//        mesh-tool bounds <model.gltf>
+//        mesh-tool tangents <model.gltf>
+//        mesh-tool quantize <model.gltf>
+//        mesh-tool quantize-check
+//        mesh-tool adjacency <million triangles>
+//        mesh-tool meshletize <million triangles>
+//        mesh-tool scene-cache <model.scene-cache>
+//        mesh-tool scene-cache-check
+//        mesh-tool accessors <model.gltf> [copy|views]
+//        mesh-tool arena <iterations>
+//        mesh-tool content-index <file count>
+//        mesh-tool normal-roughness <golden.bin> [update]
+//        mesh-tool cluster-dag
+//        mesh-tool cone-cull
+//        mesh-tool envmap-cache
+//        mesh-tool texture-manifest
+//        mesh-tool envmap-filter <golden.bin> [update]
+//        mesh-tool report <model.gltf> [max verts] [max primitives]
+
+#include <mesh-utils.h>
+#include <cluster-lod.h>
+#include <vertex-quantization.h>
+#include <scene-cache-records.h>
+#include <accessor-view.h>
+#include <free-list-allocator.h>
+#include <content-index.h>
+#include <normal-roughness-filter.h>
+#include <content-cache.h>
+#include <envmap-filter.h>
+#include <MikkTSpace/mikktspace.h>
+#include <profiling.h>
+#include <common.h>
+#include <cstdio>
+#include <map>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <numeric>
+#include <limits>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace DirectX::SimpleMath;
+
+// The tool doesn't link the renderer, so CPU events are no-ops
+Profiling::ScopedCpuEvent::ScopedCpuEvent(const char* groupName, const char* eventName, uint64_t color) {}
+Profiling::ScopedCpuEvent::ScopedCpuEvent(const char* groupName, const wchar_t* eventName, uint64_t color) {}
+Profiling::ScopedCpuEvent::~ScopedCpuEvent() {}
+
+namespace
+{
+	// Skip decoding images since only the geometry is needed
+	bool SkipImage(tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*)
+	{
+		return true;
+	}
+
+	bool LoadModel(const std::string& filename, tinygltf::Model& model)
+	{
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(&SkipImage, nullptr);
+
+		std::string errors, warnings;
+		bool ok = filename.ends_with(".glb") ?
+			loader.LoadBinaryFromFile(&model, &errors, &warnings, filename) :
+			loader.LoadASCIIFromFile(&model, &errors, &warnings, filename);
+
+		// Reports are written to stdout, so keep it clean for them
+		if (!warnings.empty())
+		{
+			fprintf(stderr, "Warn: %s\n", warnings.c_str());
+		}
+
+		if (!errors.empty())
+		{
+			fprintf(stderr, "Error: %s\n", errors.c_str());
+		}
+
+		return ok;
+	}
+
+	// Named pass/fail checks of a self-contained command, and the measurements that are reported with them. Finish() prints the JSON
+	// report to stdout and the failed checks to stderr, and returns the exit code of the command.
+	struct FCheckReport
+	{
+		nlohmann::json m_report = nlohmann::json::object();
+		std::vector<std::string> m_failures;
+
+		void Check(const std::string& name, bool bPassed)
+		{
+			m_report[name] = bPassed;
+			if (!bPassed)
+			{
+				m_failures.push_back(name);
+			}
+		}
+
+		// Nests the checks and measurements of a part of the command under name
+		void Add(const std::string& name, const FCheckReport& part)
+		{
+			m_report[name] = part.m_report;
+			for (const std::string& failure : part.m_failures)
+			{
+				m_failures.push_back(name + "." + failure);
+			}
+		}
+
+		nlohmann::json& operator[](const std::string& name)
+		{
+			return m_report[name];
+		}
+
+		int Finish()
+		{
+			m_report["passed"] = m_failures.empty();
+			printf("%s\n", m_report.dump(2).c_str());
+			for (const std::string& failure : m_failures)
+			{
+				fprintf(stderr, "Error: check %s failed\n", failure.c_str());
+			}
+
+			return m_failures.empty() ? 0 : 1;
+		}
+	};
+
+	struct FLocalityTotals
+	{
+		double m_triangles = 0.0;
+		double m_vertices = 0.0;
+		double m_meshlets = 0.0;
+		double m_acmr = 0.0;
+		double m_atvr = 0.0;
+		double m_lines = 0.0;
+		double m_idealLines = 0.0;
+
+		void Add(size_t triCount, size_t vertCount, size_t meshletCount, const FVertexCacheStats& cache, const FMeshletFetchStats& fetch)
+		{
+			m_triangles += triCount;
+			m_vertices += vertCount;
+			m_meshlets += meshletCount;
+			m_acmr += cache.m_acmr * triCount;
+			m_atvr += cache.m_atvr * vertCount;
+			m_lines += fetch.m_linesPerMeshlet * meshletCount;
+			m_idealLines += fetch.m_idealLinesPerMeshlet * meshletCount;
+		}
+	};
+
+	// Runs the same meshlet and vertex locality pass as FScene::GenerateMeshlets and reports the post-transform cache 
+	// efficiency of the index buffer, and the number of cache lines of the position stream that each meshlet reads.
+	int ReportLocality(tinygltf::Model& model)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+		constexpr uint32_t CACHE_SIZE = 32;
+		constexpr uint32_t CACHE_LINE_SIZE = 64;
+		const uint32_t chunkSize = FConfig{}.MeshletizeChunkSize;
+
+		const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+		FLocalityTotals before, after;
+
+		printf("%-40s %9s | %13s | %13s | %19s\n", "primitive", "tris", "ACMR", "ATVR", "lines/meshlet");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend())
+					continue;
+
+				const tinygltf::Accessor& positionAccessor = model.accessors[posIt->second];
+				const uint32_t positionStride = positionAccessor.ByteStride(model.bufferViews[positionAccessor.bufferView]);
+
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+
+				std::vector<FInlineMeshlet> meshlets;
+				MeshUtils::MeshletizeParallel(
+					MAX_VERTS, MAX_PRIMITIVES,
+					indices.data(), indices.size(),
+					positions.data(), positions.size(),
+					chunkSize,
+					meshlets);
+
+				const FVertexCacheStats cacheBefore = MeshUtils::AnalyzeVertexCache(indices.data(), indices.size(), positions.size(), CACHE_SIZE);
+				const FMeshletFetchStats fetchBefore = MeshUtils::AnalyzeMeshletFetch(meshlets, positionStride, CACHE_LINE_SIZE);
+
+				MeshUtils::SortMeshlets(meshlets);
+				const bool bRemapped = MeshUtils::CanRemapPrimitiveVertices(model, primitive, accessorRefCounts);
+				if (bRemapped)
+				{
+					MeshUtils::RemapPrimitiveVertices(model, primitive, meshlets);
+					MeshUtils::ReadIndices(model, primitive.indices, indices);
+				}
+
+				const FVertexCacheStats cacheAfter = MeshUtils::AnalyzeVertexCache(indices.data(), indices.size(), positions.size(), CACHE_SIZE);
+				const FMeshletFetchStats fetchAfter = MeshUtils::AnalyzeMeshletFetch(meshlets, positionStride, CACHE_LINE_SIZE);
+
+				const std::string name = PrintString("%s[%d]%s", model.meshes[meshIndex].name.c_str(), primitiveIndex, bRemapped ? "" : " (shared)");
+				printf("%-40s %9zu | %5.3f > %5.3f | %5.3f > %5.3f | %5.1f > %5.1f (%4.1f)\n",
+					name.c_str(), indices.size() / 3,
+					cacheBefore.m_acmr, cacheAfter.m_acmr,
+					cacheBefore.m_atvr, cacheAfter.m_atvr,
+					fetchBefore.m_linesPerMeshlet, fetchAfter.m_linesPerMeshlet, fetchAfter.m_idealLinesPerMeshlet);
+
+				before.Add(indices.size() / 3, positions.size(), meshlets.size(), cacheBefore, fetchBefore);
+				after.Add(indices.size() / 3, positions.size(), meshlets.size(), cacheAfter, fetchAfter);
+			}
+		}
+
+		if (before.m_triangles > 0.0)
+		{
+			printf("%-40s %9.0f | %5.3f > %5.3f | %5.3f > %5.3f | %5.1f > %5.1f (%4.1f)\n",
+				"total", before.m_triangles,
+				before.m_acmr / before.m_triangles, after.m_acmr / after.m_triangles,
+				before.m_atvr / before.m_vertices, after.m_atvr / after.m_vertices,
+				before.m_lines / before.m_meshlets, after.m_lines / after.m_meshlets, after.m_idealLines / after.m_meshlets);
+		}
+
+		return 0;
+	}
+
+	// Reports the size of the packed meshlet vertex index buffer with 32-bit indices and with the per-meshlet delta 
+	// encoding that FScene::CreateGpuGeometryBuffers uploads, and checks that every index decodes back to its source.
+	int ReportIndexEncoding(tinygltf::Model& model)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+		const uint32_t chunkSize = FConfig{}.MeshletizeChunkSize;
+
+		const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+		size_t totalBytes32 = 0, totalBytesEncoded = 0;
+		size_t deltaSizeCounts[5] = {};
+		bool ok = true;
+
+		printf("%-40s %9s | %10s | %10s\n", "primitive", "meshlets", "32-bit", "encoded");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend())
+					continue;
+
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+
+				std::vector<FInlineMeshlet> meshlets;
+				MeshUtils::MeshletizeParallel(
+					MAX_VERTS, MAX_PRIMITIVES,
+					indices.data(), indices.size(),
+					positions.data(), positions.size(),
+					chunkSize,
+					meshlets);
+
+				MeshUtils::SortMeshlets(meshlets);
+				if (MeshUtils::CanRemapPrimitiveVertices(model, primitive, accessorRefCounts))
+				{
+					MeshUtils::RemapPrimitiveVertices(model, primitive, meshlets);
+				}
+
+				size_t bytes32 = 0;
+				std::vector<uint8_t> packedVertexIndices;
+				for (const FInlineMeshlet& meshlet : meshlets)
+				{
+					const FMeshletVertexEncoding encoding = MeshUtils::EncodeMeshletVertices(meshlet, packedVertexIndices);
+					for (uint32_t i = 0; i < meshlet.m_uniqueVertexIndices.size(); ++i)
+					{
+						ok = ok && MeshUtils::DecodeMeshletVertex(encoding, packedVertexIndices.data(), i) == meshlet.m_uniqueVertexIndices[i];
+					}
+
+					bytes32 += meshlet.m_uniqueVertexIndices.size() * sizeof(uint32_t);
+					deltaSizeCounts[encoding.m_deltaSize]++;
+				}
+
+				const std::string name = PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex);
+				printf("%-40s %9zu | %10zu | %10zu\n", name.c_str(), meshlets.size(), bytes32, packedVertexIndices.size());
+
+				totalBytes32 += bytes32;
+				totalBytesEncoded += packedVertexIndices.size();
+			}
+		}
+
+		if (totalBytes32 > 0)
+		{
+			printf("%-40s %9s | %10zu | %10zu (%.1f%% saved)\n", "total", "", totalBytes32, totalBytesEncoded, 100.0 * (1.0 - totalBytesEncoded / (double)totalBytes32));
+			printf("meshlets with 8/16/32-bit deltas: %zu/%zu/%zu\n", deltaSizeCounts[1], deltaSizeCounts[2], deltaSizeCounts[4]);
+		}
+
+		if (!ok)
+		{
+			fprintf(stderr, "Error: encoded meshlet vertex indices do not round-trip\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Runs the same pipeline as FScene::GenerateMeshlets and reports the post-transform cache efficiency of the index buffer that the 
+	// non-meshlet path draws: as authored, in meshlet order after the vertex remap, after OptimizeVertexCache and after OptimizeOverdraw.
+	// Primitives that share their vertex streams keep their authored order until OptimizeVertexCache.
+	int ReportDrawOrder(tinygltf::Model& model)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+		constexpr uint32_t CACHE_SIZE = 16;
+		constexpr float OVERDRAW_THRESHOLD = 1.05f;
+		const uint32_t chunkSize = FConfig{}.MeshletizeChunkSize;
+
+		const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+		double totalTriangles = 0.0, totalAuthored = 0.0, totalMeshletOrder = 0.0, totalVertexCache = 0.0, totalOverdraw = 0.0;
+
+		printf("%-40s %9s | %8s | %8s | %8s | %8s | %8s\n", "primitive", "tris", "authored", "meshlets", "tipsify", "overdraw", "clusters");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend())
+					continue;
+
+				// The renderer only reorders primitives that own their index buffer
+				const bool bRemap = MeshUtils::CanRemapPrimitiveVertices(model, primitive, accessorRefCounts);
+				if (!bRemap && !MeshUtils::CanReorderPrimitiveTriangles(model, primitive, accessorRefCounts))
+					continue;
+
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+				const float authored = MeshUtils::AnalyzeVertexCache(indices.data(), indices.size(), positions.size(), CACHE_SIZE).m_acmr;
+
+				std::vector<FInlineMeshlet> meshlets;
+				MeshUtils::MeshletizeParallel(
+					MAX_VERTS, MAX_PRIMITIVES,
+					indices.data(), indices.size(),
+					positions.data(), positions.size(),
+					chunkSize,
+					meshlets);
+
+				MeshUtils::SortMeshlets(meshlets);
+				if (bRemap)
+				{
+					MeshUtils::RemapPrimitiveVertices(model, primitive, meshlets);
+					MeshUtils::ReadIndices(model, primitive.indices, indices);
+					MeshUtils::ReadPositions(model, posIt->second, positions);
+				}
+
+				const float meshletOrder = MeshUtils::AnalyzeVertexCache(indices.data(), indices.size(), positions.size(), CACHE_SIZE).m_acmr;
+
+				std::vector<uint32_t> drawIndices(indices.size());
+				std::vector<uint32_t> clusterStarts;
+				MeshUtils::OptimizeVertexCache(indices.data(), indices.size(), positions.size(), CACHE_SIZE, drawIndices.data(), clusterStarts);
+				const float vertexCache = MeshUtils::AnalyzeVertexCache(drawIndices.data(), drawIndices.size(), positions.size(), CACHE_SIZE).m_acmr;
+
+				MeshUtils::OptimizeOverdraw(drawIndices.data(), drawIndices.size(), positions.data(), positions.size(), clusterStarts, CACHE_SIZE, OVERDRAW_THRESHOLD);
+				const float overdraw = MeshUtils::AnalyzeVertexCache(drawIndices.data(), drawIndices.size(), positions.size(), CACHE_SIZE).m_acmr;
+
+				const size_t triCount = indices.size() / 3;
+				const std::string name = PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex);
+				printf("%-40s %9zu | %8.3f | %8.3f | %8.3f | %8.3f | %8zu\n", name.c_str(), triCount, authored, meshletOrder, vertexCache, overdraw, clusterStarts.size());
+
+				totalTriangles += triCount;
+				totalAuthored += authored * triCount;
+				totalMeshletOrder += meshletOrder * triCount;
+				totalVertexCache += vertexCache * triCount;
+				totalOverdraw += overdraw * triCount;
+			}
+		}
+
+		if (totalTriangles > 0.0)
+		{
+			printf("%-40s %9.0f | %8.3f | %8.3f | %8.3f | %8.3f |\n", "total", totalTriangles,
+				totalAuthored / totalTriangles, totalMeshletOrder / totalTriangles, totalVertexCache / totalTriangles, totalOverdraw / totalTriangles);
+		}
+
+		return 0;
+	}
+
+	// Checks that errors and bounds never decrease from a cluster to its parents, and that a cut never 
+	// draws a group's children together with the clusters that were generated from them.
+	bool ValidateClusterDag(const FClusterDag& dag, const std::vector<uint32_t>& cut)
+	{
+		for (const FLodCluster& cluster : dag.m_clusters)
+		{
+			if (cluster.m_parentGroup == -1)
+				continue;
+
+			const float distance = Vector3::Distance(Vector3{ cluster.m_lodBounds.Center }, Vector3{ cluster.m_parentLodBounds.Center });
+			if (cluster.m_error > cluster.m_parentError || distance + cluster.m_lodBounds.Radius > cluster.m_parentLodBounds.Radius)
+				return false;
+		}
+
+		std::vector<uint8_t> selected(dag.m_clusters.size(), 0);
+		for (uint32_t clusterIndex : cut)
+		{
+			selected[clusterIndex] = 1;
+		}
+
+		for (const FLodClusterGroup& group : dag.m_groups)
+		{
+			const bool bChildSelected = std::any_of(group.m_children.cbegin(), group.m_children.cend(), [&](uint32_t i) { return selected[i]; });
+			const bool bParentSelected = std::any_of(group.m_parents.cbegin(), group.m_parents.cend(), [&](uint32_t i) { return selected[i]; });
+			if (bChildSelected && bParentSelected)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Builds the cluster DAG of every primitive and reports the triangles that a 1 pixel error cut draws at increasing distances
+	int ReportClusterLod(tinygltf::Model& model)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+		const uint32_t chunkSize = FConfig{}.MeshletizeChunkSize;
+		const float distances[] = { 2.f, 8.f, 32.f, 128.f, 512.f };
+
+		FClusterLodView view = {};
+		view.m_projectionScale = 0.5f * 1080.f / std::tan(0.5f * FConfig{}.Fov);
+		view.m_nearPlane = FConfig{}.CameraNearPlane;
+		view.m_errorThreshold = 1.f;
+
+		const std::vector<int> accessorRefCounts = MeshUtils::CountAccessorReferences(model);
+		bool ok = true;
+
+		printf("%-40s %6s %9s |", "primitive", "levels", "clusters");
+		for (float distance : distances)
+		{
+			printf(" %8.0fr", distance);
+		}
+		printf("\n");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend())
+					continue;
+
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+
+				std::vector<FInlineMeshlet> meshlets;
+				MeshUtils::MeshletizeParallel(
+					MAX_VERTS, MAX_PRIMITIVES,
+					indices.data(), indices.size(),
+					positions.data(), positions.size(),
+					chunkSize,
+					meshlets);
+
+				MeshUtils::SortMeshlets(meshlets);
+				if (MeshUtils::CanRemapPrimitiveVertices(model, primitive, accessorRefCounts))
+				{
+					MeshUtils::RemapPrimitiveVertices(model, primitive, meshlets);
+					MeshUtils::ReadPositions(model, posIt->second, positions);
+				}
+
+				std::vector<uint32_t> vertexReps;
+				MeshUtils::WeldVertices(model, primitive, vertexReps);
+
+				FClusterDag dag;
+				ClusterLod::BuildDag(MAX_VERTS, MAX_PRIMITIVES, meshlets, positions.data(), positions.size(), vertexReps, dag);
+
+				const std::string name = PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex);
+				printf("%-40s %6u %9zu |", name.c_str(), dag.m_levelCount, dag.m_clusters.size());
+
+				// View the primitive head-on from a multiple of its bounding radius
+				BoundingSphere bounds;
+				BoundingSphere::CreateFromPoints(bounds, positions.size(), positions.data(), sizeof(XMFLOAT3));
+				for (float distance : distances)
+				{
+					view.m_eyePosition = Vector3{ bounds.Center } + Vector3{ 0.f, 0.f, distance * bounds.Radius };
+
+					std::vector<uint32_t> cut;
+					ClusterLod::SelectCut(dag, Matrix::Identity, view, cut);
+					ok = ok && ValidateClusterDag(dag, cut);
+
+					size_t triCount = 0;
+					for (uint32_t clusterIndex : cut)
+					{
+						triCount += dag.m_clusters[clusterIndex].m_meshlet.m_primitiveIndices.size();
+					}
+
+					printf(" %9zu", triCount);
+				}
+				printf("\n");
+			}
+		}
+
+		if (!ok)
+		{
+			fprintf(stderr, "Error: inconsistent cluster DAG or cut\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// The MikkTSpace callbacks that MeshUtils::FixupMeshes used before MeshUtils::GenerateTangents, which look up the attribute 
+	// accessors and the index for every vertex of every face. Kept as the reference for ReportTangents.
+	struct FReferenceTangentContext
+	{
+		const tinygltf::Model* m_model;
+		const tinygltf::Primitive* m_primitive;
+		std::vector<XMFLOAT4>* m_tangents;
+	};
+
+	uint32_t GetReferenceIndex(const SMikkTSpaceContext* context, const int face, const int vert)
+	{
+		const FReferenceTangentContext* ref = (const FReferenceTangentContext*)context->m_pUserData;
+		const tinygltf::Model* model = ref->m_model;
+		const tinygltf::Accessor& indexAccessor = model->accessors[ref->m_primitive->indices];
+		const tinygltf::BufferView& indexBufferView = model->bufferViews[indexAccessor.bufferView];
+		const tinygltf::Buffer& indexBuffer = model->buffers[indexBufferView.buffer];
+		const uint8_t* pData = indexBuffer.data.data() + indexBufferView.byteOffset + indexAccessor.byteOffset;
+
+		const size_t indexBufferIdx = face * 3 + vert;
+		return tinygltf::GetComponentSizeInBytes(indexAccessor.componentType) == sizeof(uint16_t) ?
+			((const uint16_t*)pData)[indexBufferIdx] :
+			((const uint32_t*)pData)[indexBufferIdx];
+	}
+
+	const float* GetReferenceAttributeData(std::string attributeName, const SMikkTSpaceContext* context, const int face, const int vert)
+	{
+		const FReferenceTangentContext* ref = (const FReferenceTangentContext*)context->m_pUserData;
+		const tinygltf::Model* model = ref->m_model;
+		auto vertexIt = ref->m_primitive->attributes.find(attributeName);
+		const tinygltf::Accessor& vertexAccessor = model->accessors[vertexIt->second];
+		const tinygltf::BufferView& vertexBufferView = model->bufferViews[vertexAccessor.bufferView];
+		const tinygltf::Buffer& vertexBuffer = model->buffers[vertexBufferView.buffer];
+
+		const float* verts = (const float*)(vertexBuffer.data.data() + vertexBufferView.byteOffset + vertexAccessor.byteOffset);
+		return &verts[GetReferenceIndex(context, face, vert) * tinygltf::GetNumComponentsInType(vertexAccessor.type)];
+	}
+
+	void GenerateReferenceTangents(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<XMFLOAT4>& tangents)
+	{
+		SMikkTSpaceInterface tspaceInterface = {};
+		tspaceInterface.m_getNumFaces = [](const SMikkTSpaceContext* context)
+		{
+			const FReferenceTangentContext* ref = (const FReferenceTangentContext*)context->m_pUserData;
+			return (int)ref->m_model->accessors[ref->m_primitive->indices].count / 3;
+		};
+		tspaceInterface.m_getNumVerticesOfFace = [](const SMikkTSpaceContext*, const int) { return 3; };
+		tspaceInterface.m_getPosition = [](const SMikkTSpaceContext* context, float out[], const int face, const int vert)
+		{
+			memcpy(out, GetReferenceAttributeData("POSITION", context, face, vert), 3 * sizeof(float));
+		};
+		tspaceInterface.m_getNormal = [](const SMikkTSpaceContext* context, float out[], const int face, const int vert)
+		{
+			memcpy(out, GetReferenceAttributeData("NORMAL", context, face, vert), 3 * sizeof(float));
+		};
+		tspaceInterface.m_getTexCoord = [](const SMikkTSpaceContext* context, float out[], const int face, const int vert)
+		{
+			memcpy(out, GetReferenceAttributeData("TEXCOORD_0", context, face, vert), 2 * sizeof(float));
+		};
+		tspaceInterface.m_setTSpaceBasic = [](const SMikkTSpaceContext* context, const float tangent[], const float sign, const int face, const int vert)
+		{
+			const FReferenceTangentContext* ref = (const FReferenceTangentContext*)context->m_pUserData;
+			(*ref->m_tangents)[GetReferenceIndex(context, face, vert)] = XMFLOAT4{ tangent[0], tangent[1], tangent[2], sign };
+		};
+
+		FReferenceTangentContext ref = { &model, &primitive, &tangents };
+		SMikkTSpaceContext tspaceContext = {};
+		tspaceContext.m_pInterface = &tspaceInterface;
+		tspaceContext.m_pUserData = &ref;
+		genTangSpaceDefault(&tspaceContext);
+	}
+
+	// Times MeshUtils::GenerateTangents, including reading the vertex streams, against the reference callbacks on every indexed 
+	// primitive with normals and UVs, and checks that the tangents are bitwise identical
+	int ReportTangents(const tinygltf::Model& model)
+	{
+		double totalReferenceTime = 0.0, totalTime = 0.0;
+		size_t mismatches = 0;
+
+		printf("%-40s %9s | %10s | %10s | %7s\n", "primitive", "verts", "ref ms", "new ms", "speedup");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				// The reference only handles tightly packed float streams with 16 or 32-bit indices
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				auto normalIt = primitive.attributes.find("NORMAL");
+				auto uvIt = primitive.attributes.find("TEXCOORD_0");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend() || 
+					normalIt == primitive.attributes.cend() || uvIt == primitive.attributes.cend() ||
+					tinygltf::GetComponentSizeInBytes(model.accessors[primitive.indices].componentType) == sizeof(uint8_t))
+					continue;
+
+				bool bPacked = true;
+				for (int accessorIndex : { posIt->second, normalIt->second, uvIt->second })
+				{
+					const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+					bPacked = bPacked && accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+						accessor.ByteStride(model.bufferViews[accessor.bufferView]) == sizeof(float) * tinygltf::GetNumComponentsInType(accessor.type);
+				}
+
+				if (!bPacked)
+					continue;
+
+				const size_t vertexCount = model.accessors[posIt->second].count;
+				std::vector<XMFLOAT4> referenceTangents(vertexCount), tangents(vertexCount);
+
+				auto start = std::chrono::steady_clock::now();
+				GenerateReferenceTangents(model, primitive, referenceTangents);
+				const std::chrono::duration<double, std::milli> referenceTime = std::chrono::steady_clock::now() - start;
+
+				start = std::chrono::steady_clock::now();
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions, normals;
+				std::vector<XMFLOAT2> uvs;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+				MeshUtils::ReadPositions(model, normalIt->second, normals);
+				MeshUtils::ReadTexcoords(model, uvIt->second, uvs);
+				MeshUtils::GenerateTangents(indices.data(), indices.size(), positions.data(), normals.data(), uvs.data(), tangents.data());
+				const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+				const bool bMatch = memcmp(referenceTangents.data(), tangents.data(), vertexCount * sizeof(XMFLOAT4)) == 0;
+				mismatches += !bMatch;
+
+				const std::string name = PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex);
+				printf("%-40s %9zu | %10.3f | %10.3f | %6.1fx%s\n", name.c_str(), vertexCount, referenceTime.count(), time.count(), 
+					referenceTime.count() / time.count(), bMatch ? "" : " MISMATCH");
+
+				totalReferenceTime += referenceTime.count();
+				totalTime += time.count();
+			}
+		}
+
+		if (totalTime > 0.0)
+		{
+			printf("%-40s %9s | %10.3f | %10.3f | %6.1fx\n", "total", "", totalReferenceTime, totalTime, totalReferenceTime / totalTime);
+		}
+
+		if (mismatches != 0)
+		{
+			fprintf(stderr, "Error: %zu primitives with tangents that differ from the reference\n", mismatches);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Same test as FrustumCull() in culling/batch-culling.hlsl: the near and side planes of a reverse-Z view projection, 
+	// extracted in object space
+	bool FrustumCull(const DirectX::BoundingSphere& bounds, const Matrix& localToWorld, const Matrix& viewProjection)
+	{
+		const Matrix M = (localToWorld * viewProjection).Transpose();
+		const Vector4 rows[4] = {
+			Vector4{ M._11, M._12, M._13, M._14 },
+			Vector4{ M._21, M._22, M._23, M._24 },
+			Vector4{ M._31, M._32, M._33, M._34 },
+			Vector4{ M._41, M._42, M._43, M._44 } };
+
+		const Vector4 planes[5] = { rows[3] - rows[2], rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1] };
+		const Vector4 center = { bounds.Center.x, bounds.Center.y, bounds.Center.z, 1.f };
+
+		for (const Vector4& plane : planes)
+		{
+			if (center.Dot(plane) + bounds.Radius * Vector3{ plane.x, plane.y, plane.z }.Length() < 0.f)
+				return false;
+		}
+
+		return true;
+	}
+
+	void CollectMeshInstances(const tinygltf::Model& model, int nodeIndex, const Matrix& parentTransform, std::vector<std::pair<int, Matrix>>& instances)
+	{
+		const tinygltf::Node& node = model.nodes[nodeIndex];
+
+		// Same as FScene::LoadNode
+		Matrix nodeTransform = Matrix::Identity;
+		if (!node.matrix.empty())
+		{
+			const auto& m = node.matrix;
+			nodeTransform = Matrix{
+				(float)m[0], (float)m[1], (float)m[2], (float)m[3],
+				(float)m[4], (float)m[5], (float)m[6], (float)m[7],
+				(float)m[8], (float)m[9], (float)m[10],(float)m[11],
+				(float)m[12], (float)m[13], (float)m[14],(float)m[15]
+			};
+		}
+		else if (!node.translation.empty() || !node.rotation.empty() || !node.scale.empty())
+		{
+			Matrix translation = !node.translation.empty() ? Matrix::CreateTranslation((float)node.translation[0], (float)node.translation[1], (float)node.translation[2]) : Matrix::Identity;
+			Matrix rotation = !node.rotation.empty() ? Matrix::CreateFromQuaternion(Quaternion{ (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2], (float)node.rotation[3] }) : Matrix::Identity;
+			Matrix scale = !node.scale.empty() ? Matrix::CreateScale(node.scale[0], node.scale[1], node.scale[2]) : Matrix::Identity;
+
+			nodeTransform = scale * rotation * translation;
+		}
+
+		if (node.mesh != -1)
+		{
+			instances.emplace_back(node.mesh, nodeTransform * parentTransform);
+		}
+
+		for (const int childIndex : node.children)
+		{
+			CollectMeshInstances(model, childIndex, nodeTransform * parentTransform, instances);
+		}
+	}
+
+	// Compares MeshUtils::ComputeBounds against the sphere around the DirectX::BoundingBox::CreateFromPoints AABB that FScene::LoadMesh 
+	// used before: radius and time per primitive, and the fraction of primitive instances that FrustumCull() rejects over a set of 
+	// random views from inside the scene bounds
+	int ReportBounds(const tinygltf::Model& model)
+	{
+		constexpr int VIEW_COUNT = 4096;
+		constexpr int TIMING_REPEATS = 16;
+
+		struct FPrimitiveBounds
+		{
+			DirectX::BoundingBox m_box;
+			DirectX::BoundingSphere m_looseSphere;
+			DirectX::BoundingSphere m_tightSphere;
+		};
+
+		std::vector<std::vector<FPrimitiveBounds>> meshBounds(model.meshes.size());
+		double totalPoints = 0.0, totalLooseTime = 0.0, totalTightTime = 0.0, totalLooseVolume = 0.0, totalTightVolume = 0.0;
+		bool ok = true;
+
+		printf("%-40s %9s | %10s | %10s | %9s | %9s\n", "primitive", "verts", "aabb r", "tight r", "aabb ns/v", "tight ns/v");
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (posIt == primitive.attributes.cend())
+					continue;
+
+				const tinygltf::Accessor& accessor = model.accessors[posIt->second];
+				const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+				const uint32_t stride = accessor.ByteStride(bufferView);
+				const uint8_t* pData = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+
+				FPrimitiveBounds bounds = {};
+				auto start = std::chrono::steady_clock::now();
+				for (int i = 0; i < TIMING_REPEATS; ++i)
+				{
+					DirectX::BoundingBox::CreateFromPoints(bounds.m_box, accessor.count, (const XMFLOAT3*)pData, stride);
+					DirectX::BoundingSphere::CreateFromBoundingBox(bounds.m_looseSphere, bounds.m_box);
+				}
+				const std::chrono::duration<double, std::nano> looseTime = std::chrono::steady_clock::now() - start;
+
+				DirectX::BoundingBox tightBox;
+				start = std::chrono::steady_clock::now();
+				for (int i = 0; i < TIMING_REPEATS; ++i)
+				{
+					MeshUtils::ComputeBounds(pData, accessor.count, stride, tightBox, bounds.m_tightSphere);
+				}
+				const std::chrono::duration<double, std::nano> tightTime = std::chrono::steady_clock::now() - start;
+
+				// The sphere must contain every point, and the box must match DirectXMath's
+				for (size_t i = 0; i < accessor.count; ++i)
+				{
+					ok = ok && bounds.m_tightSphere.Contains(XMLoadFloat3((const XMFLOAT3*)(pData + i * stride))) != DirectX::DISJOINT;
+				}
+
+				ok = ok && XMVector3NearEqual(XMLoadFloat3(&tightBox.Center), XMLoadFloat3(&bounds.m_box.Center), XMVectorReplicate(1e-5f)) &&
+					XMVector3NearEqual(XMLoadFloat3(&tightBox.Extents), XMLoadFloat3(&bounds.m_box.Extents), XMVectorReplicate(1e-5f));
+
+				const double count = (double)std::max<size_t>(accessor.count, 1);
+				const std::string name = PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex);
+				printf("%-40s %9zu | %10.4f | %10.4f | %9.2f | %9.2f\n", 
+					name.c_str(), accessor.count, 
+					bounds.m_looseSphere.Radius, bounds.m_tightSphere.Radius,
+					looseTime.count() / (TIMING_REPEATS * count), tightTime.count() / (TIMING_REPEATS * count));
+
+				totalPoints += accessor.count;
+				totalLooseTime += looseTime.count() / TIMING_REPEATS;
+				totalTightTime += tightTime.count() / TIMING_REPEATS;
+				totalLooseVolume += std::pow(bounds.m_looseSphere.Radius, 3.f);
+				totalTightVolume += std::pow(bounds.m_tightSphere.Radius, 3.f);
+				meshBounds[meshIndex].push_back(bounds);
+			}
+		}
+
+		if (totalPoints == 0.0)
+			return 0;
+
+		printf("%-40s %9.0f | sphere volume %5.1f%% of aabb sphere | %9.2f | %9.2f\n", "total", totalPoints,
+			100.0 * totalTightVolume / totalLooseVolume, totalLooseTime / totalPoints, totalTightTime / totalPoints);
+
+		// Cull rates over random views of the default scene
+		std::vector<std::pair<int, Matrix>> instances;
+		const int sceneIndex = model.defaultScene != -1 ? model.defaultScene : 0;
+		if (sceneIndex < model.scenes.size())
+		{
+			for (const int nodeIndex : model.scenes[sceneIndex].nodes)
+			{
+				CollectMeshInstances(model, nodeIndex, Matrix::Identity, instances);
+			}
+		}
+
+		DirectX::BoundingBox sceneBounds = {};
+		bool bFirst = true;
+		for (const auto& [meshIndex, transform] : instances)
+		{
+			for (const FPrimitiveBounds& bounds : meshBounds[meshIndex])
+			{
+				DirectX::BoundingBox worldBox;
+				bounds.m_box.Transform(worldBox, transform);
+				if (bFirst)
+					sceneBounds = worldBox;
+				else
+					DirectX::BoundingBox::CreateMerged(sceneBounds, sceneBounds, worldBox);
+
+				bFirst = false;
+			}
+		}
+
+		// Reverse-Z infinite projection, same as Demo::Utils::GetReverseZInfinitePerspectiveFovLH
+		const float fov = XM_PIDIV4, aspectRatio = 16.f / 9.f, nearPlane = 0.001f * Vector3{ sceneBounds.Extents }.Length();
+		const Matrix projection = {
+			1.f / (aspectRatio * std::tan(fov / 2.f)), 0.f, 0.f, 0.f,
+			0.f, 1.f / std::tan(fov / 2.f), 0.f, 0.f,
+			0.f, 0.f, 0.f, 1.f,
+			0.f, 0.f, nearPlane, 0.f };
+
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+		size_t tests = 0, looseCulled = 0, tightCulled = 0;
+
+		for (int view = 0; view < VIEW_COUNT && !instances.empty(); ++view)
+		{
+			const Vector3 eye = Vector3{ sceneBounds.Center } + Vector3{ unit(rng), unit(rng), unit(rng) } * Vector3{ sceneBounds.Extents };
+			Vector3 dir;
+			do
+			{
+				dir = Vector3{ unit(rng), unit(rng), unit(rng) };
+			} while (dir.LengthSquared() > 1.f || dir.LengthSquared() < 1e-4f);
+
+			dir.Normalize();
+			const Vector3 up = std::abs(dir.y) < 0.99f ? Vector3::UnitY : Vector3::UnitX;
+			const Matrix viewProjection = Matrix{ XMMatrixLookToLH(eye, dir, up) } * projection;
+
+			for (const auto& [meshIndex, transform] : instances)
+			{
+				for (const FPrimitiveBounds& bounds : meshBounds[meshIndex])
+				{
+					tests++;
+					looseCulled += !FrustumCull(bounds.m_looseSphere, transform, viewProjection);
+					tightCulled += !FrustumCull(bounds.m_tightSphere, transform, viewProjection);
+				}
+			}
+		}
+
+		if (tests != 0)
+		{
+			printf("\n%d random views, %zu primitive instances: %.2f%% culled with aabb spheres, %.2f%% with tight spheres\n",
+				VIEW_COUNT, tests / VIEW_COUNT, 100.0 * looseCulled / tests, 100.0 * tightCulled / tests);
+		}
+
+		if (!ok)
+		{
+			fprintf(stderr, "Error: tight bounds don't contain every point or the AABB doesn't match\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Jittered grid with a column of duplicated seam vertices every few cells, so that welding has work to do. Triangles are
+	// shuffled so that the edge build doesn't benefit from the generation order. vertexBands receives the band of columns between
+	// two seams that each vertex belongs to, the way a UV chart would.
+	void MakeGrid(size_t triangleCount, std::vector<uint32_t>& indices, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>* vertexBands = nullptr)
+	{
+		constexpr size_t seamInterval = 7;
+		const size_t n = std::max<size_t>(std::sqrt(triangleCount / 2.0), 2);
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+
+		std::vector<uint32_t> vertex((n + 1) * (n + 1)), seamVertex((n + 1) * (n + 1));
+		positions.reserve((n + 1) * (n + 1) * (seamInterval + 1) / seamInterval);
+		for (size_t y = 0; y <= n; ++y)
+		{
+			for (size_t x = 0; x <= n; ++x)
+			{
+				const size_t k = y * (n + 1) + x;
+				const XMFLOAT3 p = { (x + jitter(rng)) * 0.37f, (y + jitter(rng)) * 0.41f, jitter(rng) };
+				vertex[k] = seamVertex[k] = positions.size();
+				positions.push_back(p);
+
+				// The first vertex of a seam column belongs to the band on its left, and the duplicate to the band on its right
+				const bool bSeam = x % seamInterval == 0;
+				if (vertexBands)
+				{
+					vertexBands->push_back(bSeam && x > 0 ? (uint32_t)(x / seamInterval - 1) : (uint32_t)(x / seamInterval));
+				}
+
+				if (bSeam)
+				{
+					seamVertex[k] = positions.size();
+					positions.push_back(p);
+					if (vertexBands)
+					{
+						vertexBands->push_back((uint32_t)(x / seamInterval));
+					}
+				}
+			}
+		}
+
+		std::vector<uint32_t> cells(n * n);
+		std::iota(cells.begin(), cells.end(), 0);
+		std::shuffle(cells.begin(), cells.end(), rng);
+
+		indices.reserve(n * n * 6);
+		for (uint32_t cell : cells)
+		{
+			const size_t x = cell % n, y = cell / n;
+			const auto& left = (x % seamInterval == 0) ? seamVertex : vertex;
+			const uint32_t a = left[y * (n + 1) + x];
+			const uint32_t b = vertex[y * (n + 1) + x + 1];
+			const uint32_t c = left[(y + 1) * (n + 1) + x];
+			const uint32_t d = vertex[(y + 1) * (n + 1) + x + 1];
+			indices.insert(indices.end(), { a, b, c, b, d, c });
+		}
+	}
+
+	// Unit UV sphere with outward facing counter-clockwise triangles. The pole vertices are repeated per segment at exactly the same
+	// position, so the sphere is closed once positions are welded.
+	void MakeSphere(uint32_t rings, uint32_t segments, std::vector<uint32_t>& indices, std::vector<XMFLOAT3>& positions)
+	{
+		for (uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			const float theta = XM_PI * ring / rings;
+			const bool bPole = ring == 0 || ring == rings;
+			for (uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const float phi = XM_2PI * segment / segments;
+				positions.push_back(bPole ? XMFLOAT3{ 0.f, 0.f, std::cos(theta) } : XMFLOAT3{ std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) });
+			}
+		}
+
+		for (uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const uint32_t i00 = ring * segments + segment;
+				const uint32_t i01 = ring * segments + (segment + 1) % segments;
+				const uint32_t i10 = i00 + segments;
+				const uint32_t i11 = i01 + segments;
+				if (ring != 0)
+				{
+					indices.insert(indices.end(), { i00, i10, i01 });
+				}
+
+				if (ring != rings - 1)
+				{
+					indices.insert(indices.end(), { i01, i10, i11 });
+				}
+			}
+		}
+	}
+
+	// Times MeshUtils::BuildAdjacency on a synthetic mesh and checks that the result is symmetric
+	int BenchmarkAdjacency(double millionTriangles)
+	{
+		std::vector<uint32_t> indices;
+		std::vector<XMFLOAT3> positions;
+		MakeGrid(size_t(millionTriangles * 1e6), indices, positions);
+
+		std::vector<uint32_t> adjacency(indices.size());
+		const auto start = std::chrono::steady_clock::now();
+		MeshUtils::BuildAdjacency(indices.data(), indices.size(), positions.data(), positions.size(), adjacency.data());
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		size_t matched = 0, asymmetric = 0;
+		for (size_t i = 0; i < adjacency.size(); ++i)
+		{
+			if (adjacency[i] == uint32_t(-1))
+				continue;
+
+			const uint32_t tri = i / 3;
+			const uint32_t* other = &adjacency[adjacency[i] * 3];
+			matched++;
+			asymmetric += (other[0] != tri && other[1] != tri && other[2] != tri);
+		}
+
+		printf("%zu triangles, %zu vertices: %.2f s, %zu of %zu edges matched\n", indices.size() / 3, positions.size(), elapsed.count(), matched, adjacency.size());
+		if (asymmetric != 0)
+		{
+			fprintf(stderr, "Error: %zu edges without a matching edge on the adjacent triangle\n", asymmetric);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	bool SameMeshlets(const std::vector<FInlineMeshlet>& a, const std::vector<FInlineMeshlet>& b)
+	{
+		return std::equal(a.cbegin(), a.cend(), b.cbegin(), b.cend(), [](const FInlineMeshlet& x, const FInlineMeshlet& y)
+			{
+				return x.m_uniqueVertexIndices == y.m_uniqueVertexIndices &&
+					x.m_primitiveIndices.size() == y.m_primitiveIndices.size() &&
+					memcmp(x.m_primitiveIndices.data(), y.m_primitiveIndices.data(), x.m_primitiveIndices.size() * sizeof(FInlineMeshlet::FPackedTriangle)) == 0;
+			});
+	}
+
+	// Times MeshUtils::MeshletizeParallel on a synthetic mesh with 1, 2, 4, ... threads up to the hardware thread count, and checks
+	// that the meshlets don't depend on the thread count
+	int BenchmarkMeshletize(double millionTriangles)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+		constexpr int Repeats = 3;
+		const uint32_t chunkSize = FConfig{}.MeshletizeChunkSize;
+
+		std::vector<uint32_t> indices;
+		std::vector<XMFLOAT3> positions;
+		MakeGrid(size_t(millionTriangles * 1e6), indices, positions);
+
+		auto Time = [&](std::vector<FInlineMeshlet>& meshlets, uint32_t chunkTriangleCount)
+		{
+			double best = std::numeric_limits<double>::max();
+			for (int repeat = 0; repeat < Repeats; ++repeat)
+			{
+				meshlets.clear();
+				const auto start = std::chrono::steady_clock::now();
+				MeshUtils::MeshletizeParallel(MAX_VERTS, MAX_PRIMITIVES, indices.data(), indices.size(), positions.data(), positions.size(), chunkTriangleCount, meshlets);
+				best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			}
+
+			return best;
+		};
+
+		std::vector<FInlineMeshlet> unchunked;
+		Parallel::GetThreadLimit() = 1;
+		const double unchunkedTime = Time(unchunked, 0);
+
+		printf("%zu triangles, %u triangle chunks, %u hardware threads, best of %d\n", indices.size() / 3, chunkSize, std::thread::hardware_concurrency(), Repeats);
+		printf("unchunked      %8.3f s, %zu meshlets\n", unchunkedTime, unchunked.size());
+		printf("%7s %10s %8s %10s %s\n", "threads", "seconds", "speedup", "meshlets", "output");
+
+		const size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		std::vector<FInlineMeshlet> reference;
+		double referenceTime = 0.0;
+		bool bIdentical = true;
+		for (size_t threadCount = 1; threadCount <= maxThreads; threadCount = threadCount < maxThreads ? std::min(threadCount * 2, maxThreads) : maxThreads + 1)
+		{
+			Parallel::GetThreadLimit() = threadCount;
+			std::vector<FInlineMeshlet> meshlets;
+			const double time = Time(meshlets, chunkSize);
+			if (threadCount == 1)
+			{
+				reference = meshlets;
+				referenceTime = time;
+			}
+
+			const bool bSame = SameMeshlets(meshlets, reference);
+			bIdentical = bIdentical && bSame;
+			printf("%7zu %10.3f %7.2fx %10zu %s\n", threadCount, time, referenceTime / time, meshlets.size(), bSame ? "identical" : "DIFFERENT");
+		}
+
+		Parallel::GetThreadLimit() = 0;
+		if (!bIdentical)
+		{
+			fprintf(stderr, "Error: the meshlets depend on the thread count\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Angle between two directions in radians, in double precision so that the measurement itself doesn't dominate the error
+	double AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		const double cx = (double)a.y * b.z - (double)a.z * b.y;
+		const double cy = (double)a.z * b.x - (double)a.x * b.z;
+		const double cz = (double)a.x * b.y - (double)a.y * b.x;
+		const double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+		return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+	}
+
+	// Error of a half precision texcoord component relative to its magnitude, or to the smallest normal half below that
+	double TexcoordError(float original, float decoded)
+	{
+		return std::abs((double)decoded - original) / std::max(std::abs((double)original), 6.103515625e-05);
+	}
+
+	const uint8_t* GetElement(const tinygltf::Model& model, int accessorIndex, size_t elementIndex)
+	{
+		const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		return &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset + elementIndex * accessor.ByteStride(bufferView)];
+	}
+
+	struct FQuantizationErrors
+	{
+		double m_position = 0.0;		// Largest error relative to VertexQuantization::MaxPositionError()
+		double m_normal = 0.0;
+		double m_tangent = 0.0;
+		double m_texcoord = 0.0;
+		size_t m_signMismatches = 0;
+		size_t m_count[4] = {};
+
+		bool Passes() const
+		{
+			return m_position <= 1.0 && 
+				m_normal <= VertexQuantization::MaxNormalAngleError &&
+				m_tangent <= VertexQuantization::MaxTangentAngleError &&
+				m_texcoord <= VertexQuantization::MaxTexcoordRelativeError &&
+				m_signMismatches == 0;
+		}
+
+		void Print(const char* label) const
+		{
+			printf("%-8s positions %9zu, max error %.3f of bound\n", label, m_count[0], m_position);
+			printf("%-8s normals   %9zu, max error %.3g rad (bound %.3g)\n", label, m_count[1], m_normal, VertexQuantization::MaxNormalAngleError);
+			printf("%-8s tangents  %9zu, max error %.3g rad (bound %.3g), %zu sign mismatches\n", label, m_count[2], m_tangent, VertexQuantization::MaxTangentAngleError, m_signMismatches);
+			printf("%-8s texcoords %9zu, max error %.3g (bound %.3g)\n", label, m_count[3], m_texcoord, VertexQuantization::MaxTexcoordRelativeError);
+		}
+	};
+
+	// Round trips random positions, directions and texcoords through the encoders, and fails if any error exceeds its bound. This
+	// needs no model, so that it can run as a test.
+	int CheckQuantization()
+	{
+		FQuantizationErrors errors;
+		std::mt19937 rng{ 17 };
+		std::normal_distribution<float> gaussian;
+		std::uniform_real_distribution<float> uniform{ -64.f, 64.f };
+
+		// Positions in boxes of very different sizes and offsets, each quantized to its own bounds
+		for (int box = 0; box < 16; ++box)
+		{
+			const float scale = std::ldexp(1.f, box - 8);
+			std::vector<XMFLOAT3> positions(1 << 16);
+			for (XMFLOAT3& p : positions)
+			{
+				p = { uniform(rng) * scale + 1000.f * box, uniform(rng) * scale * 0.25f, uniform(rng) * scale - 10.f };
+			}
+
+			const FAccessorFormat format = VertexQuantization::ComputePositionFormat(positions.data(), (uint32_t)positions.size());
+			const XMFLOAT3 bound = VertexQuantization::MaxPositionError(format);
+			for (const XMFLOAT3& p : positions)
+			{
+				uint16_t q[4];
+				VertexQuantization::EncodePosition(p, format, q);
+				const XMFLOAT3 decoded = VertexQuantization::DecodePosition(q, format);
+				errors.m_position = std::max({ errors.m_position,
+					(double)std::abs(decoded.x - p.x) / std::max(bound.x, FLT_MIN),
+					(double)std::abs(decoded.y - p.y) / std::max(bound.y, FLT_MIN),
+					(double)std::abs(decoded.z - p.z) / std::max(bound.z, FLT_MIN) });
+			}
+
+			errors.m_count[0] += positions.size();
+		}
+
+		for (int i = 0; i < 1 << 20; ++i)
+		{
+			Vector3 v{ gaussian(rng), gaussian(rng), gaussian(rng) };
+			v.Normalize();
+			const float sign = (i & 1) ? 1.f : -1.f;
+
+			const XMFLOAT4 tangent = VertexQuantization::DecodeTangent(VertexQuantization::EncodeTangent(XMFLOAT4{ v.x, v.y, v.z, sign }));
+			errors.m_normal = std::max(errors.m_normal, AngleBetween(v, VertexQuantization::DecodeNormal(VertexQuantization::EncodeNormal(v))));
+			errors.m_tangent = std::max(errors.m_tangent, AngleBetween(v, XMFLOAT3{ tangent.x, tangent.y, tangent.z }));
+			errors.m_signMismatches += tangent.w != sign;
+
+			const XMFLOAT2 uv = { uniform(rng), uniform(rng) };
+			const XMFLOAT2 decodedUv = VertexQuantization::DecodeTexcoord(VertexQuantization::EncodeTexcoord(uv));
+			errors.m_texcoord = std::max({ errors.m_texcoord, TexcoordError(uv.x, decodedUv.x), TexcoordError(uv.y, decodedUv.y) });
+		}
+
+		errors.m_count[1] = errors.m_count[2] = errors.m_count[3] = 1 << 20;
+		errors.Print("random");
+
+		if (!errors.Passes())
+		{
+			fprintf(stderr, "Error: decode error exceeds the bounds in vertex-quantization.h\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Compacts the vertex streams of the model the same way as the loader does and decodes every compacted element against the
+	// float data it was encoded from. Fails if any error exceeds its bound. The model-free round trips are in CheckQuantization().
+	int ReportQuantization(tinygltf::Model& model)
+	{
+		// Keep the float data of every accessor since compaction repoints the accessors and drops their original bytes
+		std::vector<std::vector<float>> original(model.accessors.size());
+		size_t bytesBefore = 0;
+		for (int accessorIndex = 0; accessorIndex < model.accessors.size(); ++accessorIndex)
+		{
+			const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+			if (accessor.bufferView == -1 || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+				continue;
+
+			const int components = tinygltf::GetNumComponentsInType(accessor.type);
+			original[accessorIndex].resize(accessor.count * components);
+			for (size_t i = 0; i < accessor.count; ++i)
+			{
+				memcpy(&original[accessorIndex][i * components], GetElement(model, accessorIndex, i), components * sizeof(float));
+			}
+		}
+
+		for (const tinygltf::Buffer& buffer : model.buffers)
+		{
+			bytesBefore += buffer.data.size();
+		}
+
+		std::vector<FAccessorFormat> formats;
+		const auto start = std::chrono::steady_clock::now();
+		VertexQuantization::CompactVertexStreams(model, formats);
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		FQuantizationErrors errors;
+		size_t streamBytesBefore = 0, streamBytesAfter = 0, bytesAfter = 0;
+		for (int accessorIndex = 0; accessorIndex < model.accessors.size(); ++accessorIndex)
+		{
+			const FAccessorFormat& format = formats[accessorIndex];
+			if (format.m_format == VertexFormat::Float)
+				continue;
+
+			const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+			const float* source = original[accessorIndex].data();
+			streamBytesBefore += original[accessorIndex].size() * sizeof(float);
+			streamBytesAfter += accessor.count * accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+
+			for (size_t i = 0; i < accessor.count; ++i)
+			{
+				const uint8_t* element = GetElement(model, accessorIndex, i);
+				uint32_t packed;
+				memcpy(&packed, element, sizeof(packed));
+
+				switch (format.m_format)
+				{
+				case VertexFormat::Unorm16Position:
+				{
+					uint16_t q[4];
+					memcpy(q, element, sizeof(q));
+					const XMFLOAT3 decoded = VertexQuantization::DecodePosition(q, format);
+					const XMFLOAT3 bound = VertexQuantization::MaxPositionError(format);
+					const float* p = &source[i * 3];
+					errors.m_position = std::max({ errors.m_position,
+						(double)std::abs(decoded.x - p[0]) / std::max(bound.x, FLT_MIN),
+						(double)std::abs(decoded.y - p[1]) / std::max(bound.y, FLT_MIN),
+						(double)std::abs(decoded.z - p[2]) / std::max(bound.z, FLT_MIN) });
+					errors.m_count[0]++;
+					break;
+				}
+				case VertexFormat::Octahedral16Normal:
+				{
+					Vector3 n{ &source[i * 3] };
+					n.Normalize();
+					errors.m_normal = std::max(errors.m_normal, AngleBetween(n, VertexQuantization::DecodeNormal(packed)));
+					errors.m_count[1]++;
+					break;
+				}
+				case VertexFormat::Octahedral16Tangent:
+				{
+					Vector3 t{ &source[i * 4] };
+					t.Normalize();
+					const XMFLOAT4 decoded = VertexQuantization::DecodeTangent(packed);
+					errors.m_tangent = std::max(errors.m_tangent, AngleBetween(t, XMFLOAT3{ decoded.x, decoded.y, decoded.z }));
+					errors.m_signMismatches += (decoded.w < 0.f) != (source[i * 4 + 3] < 0.f);
+					errors.m_count[2]++;
+					break;
+				}
+				case VertexFormat::Half2Texcoord:
+				{
+					const XMFLOAT2 decoded = VertexQuantization::DecodeTexcoord(packed);
+					errors.m_texcoord = std::max({ errors.m_texcoord, TexcoordError(source[i * 2], decoded.x), TexcoordError(source[i * 2 + 1], decoded.y) });
+					errors.m_count[3]++;
+					break;
+				}
+				}
+			}
+		}
+
+		for (const tinygltf::Buffer& buffer : model.buffers)
+		{
+			bytesAfter += buffer.data.size();
+		}
+
+		errors.Print("model");
+		printf("vertex streams: %.2f MB -> %.2f MB, buffers: %.2f MB -> %.2f MB, %.1f ms\n",
+			streamBytesBefore / 1048576.0, streamBytesAfter / 1048576.0, bytesBefore / 1048576.0, bytesAfter / 1048576.0, elapsed.count());
+
+		if (!errors.Passes())
+		{
+			fprintf(stderr, "Error: decode error exceeds the bounds in vertex-quantization.h\n");
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Minimum, mean, percentiles and maximum of a set of samples
+	nlohmann::json Summarize(std::vector<float> samples)
+	{
+		if (samples.empty())
+			return nullptr;
+
+		std::sort(samples.begin(), samples.end());
+		auto Percentile = [&samples](double p) { return samples[std::min<size_t>(p * samples.size(), samples.size() - 1)]; };
+		const double sum = std::accumulate(samples.cbegin(), samples.cend(), 0.0);
+
+		return {
+			{ "min", samples.front() },
+			{ "mean", sum / samples.size() },
+			{ "p50", Percentile(0.5) },
+			{ "p95", Percentile(0.95) },
+			{ "max", samples.back() }
+		};
+	}
+
+	// Runs the single threaded meshletizer over every primitive and prints JSON with its throughput and the quality of the meshlets, 
+	// so that results can be diffed between commits. Radii are also reported relative to the bounding sphere of the primitive, 
+	// which makes them comparable across models.
+	int ReportMeshletizer(tinygltf::Model& model, const std::string& modelName, uint32_t maxVerts, uint32_t maxPrims)
+	{
+		nlohmann::json primitives = nlohmann::json::array();
+		std::vector<float> allVertexFill, allPrimitiveFill, allRadii, allRelativeRadii, allConeAngles;
+		size_t totalTriangles = 0, totalMeshlets = 0, totalCullable = 0;
+		double totalSeconds = 0.0;
+
+		for (int meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex)
+		{
+			for (int primitiveIndex = 0; primitiveIndex < model.meshes[meshIndex].primitives.size(); ++primitiveIndex)
+			{
+				const tinygltf::Primitive& primitive = model.meshes[meshIndex].primitives[primitiveIndex];
+				auto posIt = primitive.attributes.find("POSITION");
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.indices == -1 || posIt == primitive.attributes.cend())
+					continue;
+
+				std::vector<uint32_t> indices;
+				std::vector<XMFLOAT3> positions;
+				MeshUtils::ReadIndices(model, primitive.indices, indices);
+				MeshUtils::ReadPositions(model, posIt->second, positions);
+
+				std::vector<FInlineMeshlet> meshlets;
+				const auto start = std::chrono::steady_clock::now();
+				MeshUtils::Meshletize(
+					maxVerts, maxPrims,
+					indices.data(), indices.size(),
+					positions.data(), positions.size(),
+					meshlets);
+				const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+				DirectX::BoundingSphere primitiveBounds;
+				DirectX::BoundingSphere::CreateFromPoints(primitiveBounds, positions.size(), positions.data(), sizeof(XMFLOAT3));
+				const float invPrimitiveRadius = primitiveBounds.Radius > 0.f ? 1.f / primitiveBounds.Radius : 0.f;
+
+				std::vector<float> vertexFill, primitiveFill, radii, relativeRadii, coneAngles;
+				for (const FInlineMeshlet& meshlet : meshlets)
+				{
+					vertexFill.push_back(meshlet.m_uniqueVertexIndices.size() / (float)maxVerts);
+					primitiveFill.push_back(meshlet.m_primitiveIndices.size() / (float)maxPrims);
+					radii.push_back(meshlet.m_boundingSphere.Radius);
+					relativeRadii.push_back(meshlet.m_boundingSphere.Radius * invPrimitiveRadius);
+
+					// Half-angle of the normal cone in degrees. Cones with a cutoff of 1 span a hemisphere or more and never cull.
+					const int8_t cutoff = (int8_t)(meshlet.m_normalCone >> 24);
+					if (cutoff < 127)
+					{
+						coneAngles.push_back(DirectX::XMConvertToDegrees(std::asin(cutoff / 127.f)));
+					}
+				}
+
+				const size_t triCount = indices.size() / 3;
+				primitives.push_back({
+					{ "name", PrintString("%s[%d]", model.meshes[meshIndex].name.c_str(), primitiveIndex) },
+					{ "triangles", triCount },
+					{ "vertices", positions.size() },
+					{ "seconds", elapsed.count() },
+					{ "trianglesPerSecond", elapsed.count() > 0.0 ? triCount / elapsed.count() : 0.0 },
+					{ "meshlets", meshlets.size() },
+					{ "vertexFill", Summarize(vertexFill) },
+					{ "primitiveFill", Summarize(primitiveFill) },
+					{ "radius", Summarize(radii) },
+					{ "relativeRadius", Summarize(relativeRadii) },
+					{ "cullableMeshlets", coneAngles.size() },
+					{ "coneHalfAngle", Summarize(coneAngles) }
+				});
+
+				totalTriangles += triCount;
+				totalMeshlets += meshlets.size();
+				totalCullable += coneAngles.size();
+				totalSeconds += elapsed.count();
+				allVertexFill.insert(allVertexFill.end(), vertexFill.cbegin(), vertexFill.cend());
+				allPrimitiveFill.insert(allPrimitiveFill.end(), primitiveFill.cbegin(), primitiveFill.cend());
+				allRadii.insert(allRadii.end(), radii.cbegin(), radii.cend());
+				allRelativeRadii.insert(allRelativeRadii.end(), relativeRadii.cbegin(), relativeRadii.cend());
+				allConeAngles.insert(allConeAngles.end(), coneAngles.cbegin(), coneAngles.cend());
+			}
+		}
+
+		const nlohmann::json report = {
+			{ "model", modelName },
+			{ "maxVerts", maxVerts },
+			{ "maxPrimitives", maxPrims },
+			{ "primitives", primitives },
+			{ "total", {
+				{ "triangles", totalTriangles },
+				{ "seconds", totalSeconds },
+				{ "trianglesPerSecond", totalSeconds > 0.0 ? totalTriangles / totalSeconds : 0.0 },
+				{ "meshlets", totalMeshlets },
+				{ "vertexFill", Summarize(allVertexFill) },
+				{ "primitiveFill", Summarize(allPrimitiveFill) },
+				{ "radius", Summarize(allRadii) },
+				{ "relativeRadius", Summarize(allRelativeRadii) },
+				{ "cullableMeshlets", totalCullable },
+				{ "coneHalfAngle", Summarize(allConeAngles) } } }
+		};
+
+		printf("%s\n", report.dump(2).c_str());
+		return 0;
+	}
+	// Validates a scene cache written by the demo and reports the size of its sections, and the time that it takes to map the file
+	// and touch every page of it
+	int ReportSceneCache(const std::string& filename)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		SceneCache::FReader reader;
+		if (!reader.Open(filename))
+		{
+			fprintf(stderr, "Error: %s is not a valid scene cache (version %u)\n", filename.c_str(), SceneCache::Version);
+			return 1;
+		}
+
+		const std::chrono::duration<double> openTime = std::chrono::high_resolution_clock::now() - startTime;
+
+		uint64_t checksum = 0;
+		nlohmann::json sections = nlohmann::json::object();
+		for (uint32_t section = 0; section < (uint32_t)SceneCache::Section::Count; ++section)
+		{
+			const std::span<const uint8_t> bytes = reader.GetBytes((SceneCache::Section)section);
+			for (size_t offset = 0; offset < bytes.size(); offset += 4096)
+			{
+				checksum += bytes[offset];
+			}
+
+			sections[SceneCache::GetSectionName((SceneCache::Section)section)] = bytes.size();
+		}
+
+		const std::chrono::duration<double> readTime = std::chrono::high_resolution_clock::now() - startTime;
+
+		std::string error;
+		const bool bValid = SceneCache::Validate(reader, error);
+		const std::chrono::duration<double> validateTime = std::chrono::high_resolution_clock::now() - startTime;
+
+		const nlohmann::json report = {
+			{ "file", std::filesystem::path{ filename }.filename().string() },
+			{ "version", reader.m_header->m_version },
+			{ "sourceKey", reader.GetSourceKey() },
+			{ "bytes", reader.m_size },
+			{ "sections", sections },
+			{ "openSeconds", openTime.count() },
+			{ "touchSeconds", readTime.count() },
+			{ "validateSeconds", validateTime.count() },
+			{ "pageChecksum", checksum },
+			{ "valid", bValid },
+			{ "error", error }
+		};
+
+		printf("%s\n", report.dump(2).c_str());
+		return bValid ? 0 : 1;
+	}
+
+	// Sections of a small scene with two mesh assets, three instances of them, a material with a texture and a light, like the
+	// demo writes them
+	struct FSceneCacheContents
+	{
+		std::vector<uint8_t> m_bufferData = std::vector<uint8_t>(256);
+		std::vector<FMeshBufferView> m_views = { { 0, 0, 128 }, { 0, 128, 128 } };
+		std::vector<FMeshAccessor> m_accessors = { { 0, 0, 12, VertexFormat::Float, {}, {} }, { 1, 0, 4, VertexFormat::Float, {}, {} } };
+		std::vector<FAccessorFormat> m_accessorFormats = std::vector<FAccessorFormat>(2);
+		std::vector<SceneCache::FMeshAssetRecord> m_assets = { { 0, 1, {} }, { 1, 1, {} } };
+		std::vector<SceneCache::FPrimitiveRecord> m_primitives;
+		std::vector<SceneCache::FInstanceRecord> m_meshInstances;
+		std::vector<FGpuPrimitive> m_gpuPrimitives;
+		std::vector<FGpuMeshlet> m_meshlets;
+		std::vector<FGpuMeshletInstance> m_meshletInstances = { { 0, 0, 2, 0 }, { 1, 2, 2, 2 }, { 0, 0, 2, 4 } };
+		std::vector<uint8_t> m_meshletVertexIndices = std::vector<uint8_t>(12);
+		std::vector<FInlineMeshlet::FPackedTriangle> m_meshletTriangleIndices = { { 0, 1, 2, 0 }, { 0, 1, 2, 0 }, { 0, 1, 2, 0 }, { 0, 1, 2, 0 } };
+		std::vector<uint32_t> m_primitiveCounts = { 1, 1, 1 };
+		std::vector<FMaterial> m_materials = std::vector<FMaterial>(1);
+		std::vector<uint64_t> m_textures = { 0x0123456789abcdefull };
+		std::vector<SceneCache::FSamplerRecord> m_samplers = { { 9729, 9729, 10497, 10497 } };
+		std::vector<FLight> m_lights = std::vector<FLight>(1);
+		std::vector<SceneCache::FInstanceRecord> m_lightInstances;
+
+		FSceneCacheContents()
+		{
+			for (int assetIndex = 0; assetIndex < 2; ++assetIndex)
+			{
+				SceneCache::FPrimitiveRecord primitive = {};
+				primitive.m_indexAccessor = 1;
+				primitive.m_positionAccessor = 0;
+				primitive.m_uvAccessor = primitive.m_normalAccessor = primitive.m_tangentAccessor = -1;
+				primitive.m_indexCount = 3;
+				primitive.m_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				primitive.m_materialIndex = 0;
+				primitive.m_raytracingGeometry = { 0, 0, 0, 12, 3, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, 3, DXGI_FORMAT_R32_UINT };
+				m_primitives.push_back(primitive);
+
+				for (int meshletIndex = 0; meshletIndex < 2; ++meshletIndex)
+				{
+					FGpuMeshlet meshlet = {};
+					meshlet.m_vertexBegin = (uint32_t)m_meshlets.size() * 3;
+					meshlet.m_vertexCount = 3;
+					meshlet.m_triangleBegin = (uint32_t)m_meshlets.size();
+					meshlet.m_triangleCount = 1;
+					meshlet.m_vertexDeltaSize = 1;
+					meshlet.m_positionAccessor = 0;
+					meshlet.m_uvAccessor = meshlet.m_normalAccessor = meshlet.m_tangentAccessor = -1;
+					meshlet.m_materialIndex = 0;
+					m_meshlets.push_back(meshlet);
+				}
+			}
+
+			for (int instanceIndex = 0; instanceIndex < 3; ++instanceIndex)
+			{
+				m_meshInstances.push_back({ instanceIndex % 2, 1, Matrix::Identity, {}, {} });
+
+				FGpuPrimitive primitive = {};
+				primitive.m_meshIndex = instanceIndex;
+				primitive.m_indexAccessor = 1;
+				primitive.m_positionAccessor = 0;
+				primitive.m_uvAccessor = primitive.m_normalAccessor = primitive.m_tangentAccessor = -1;
+				primitive.m_materialIndex = 0;
+				primitive.m_indicesPerTriangle = 3;
+				primitive.m_indexCount = 3;
+				m_gpuPrimitives.push_back(primitive);
+			}
+
+			for (int FMaterial::* textureIndex : SceneCache::MaterialTextureIndices)
+			{
+				m_materials[0].*textureIndex = -1;
+			}
+
+			for (int FMaterial::* samplerIndex : SceneCache::MaterialSamplerIndices)
+			{
+				m_materials[0].*samplerIndex = -1;
+			}
+
+			m_materials[0].m_baseColorTextureIndex = 0;
+			m_materials[0].m_baseColorSamplerIndex = 0;
+			m_lightInstances.push_back({ 0, 1, Matrix::Identity, {}, {} });
+		}
+
+		SceneCache::FWriter Write() const
+		{
+			using SceneCache::Section;
+
+			SceneCache::FWriter writer;
+			writer.Add(Section::BufferData, m_bufferData);
+			writer.Add(Section::BufferViews, m_views);
+			writer.Add(Section::Accessors, m_accessors);
+			writer.Add(Section::AccessorFormats, m_accessorFormats);
+			writer.Add(Section::MeshAssets, m_assets);
+			writer.Add(Section::MeshPrimitives, m_primitives);
+			writer.Add(Section::GpuPrimitives, m_gpuPrimitives);
+			writer.Add(Section::GpuMeshlets, m_meshlets);
+			writer.Add(Section::GpuMeshletInstances, m_meshletInstances);
+			writer.Add(Section::MeshletVertexIndices, m_meshletVertexIndices);
+			writer.Add(Section::MeshletTriangleIndices, m_meshletTriangleIndices);
+			writer.Add(Section::PrimitiveCounts, m_primitiveCounts);
+			writer.Add(Section::Materials, m_materials);
+			writer.Add(Section::Textures, m_textures);
+			writer.Add(Section::Samplers, m_samplers);
+			writer.Add(Section::Lights, m_lights);
+
+			// Instance names go to the Strings section
+			std::vector<SceneCache::FInstanceRecord> meshInstances = m_meshInstances;
+			for (SceneCache::FInstanceRecord& instance : meshInstances)
+			{
+				instance.m_name = writer.AddString("mesh");
+			}
+
+			std::vector<SceneCache::FInstanceRecord> lightInstances = m_lightInstances;
+			for (SceneCache::FInstanceRecord& instance : lightInstances)
+			{
+				instance.m_name = writer.AddString("light");
+			}
+
+			const std::vector<SceneCache::FCameraRecord> cameras = { { Matrix::Identity, Matrix::Identity, writer.AddString("camera") } };
+			writer.Add(Section::MeshInstances, meshInstances);
+			writer.Add(Section::LightInstances, lightInstances);
+			writer.Add(Section::Cameras, cameras);
+			return writer;
+		}
+	};
+
+	// Round trips a scene cache through a file, and checks that SceneCache::Validate() accepts it and rejects copies with an index
+	// or a range that is out of bounds, or a section that doesn't hold whole records
+	int CheckSceneCache()
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "mesh-tool-scene-cache";
+		std::filesystem::create_directories(directory);
+		const std::string filepath = (directory / "check.scene-cache").string();
+		const uint64_t sourceKey = 0x5eed5eed5eed5eedull;
+
+		FCheckReport report;
+
+		const FSceneCacheContents contents;
+		const SceneCache::FWriter writer = contents.Write();
+		report.Check("save", writer.Save(filepath, sourceKey));
+
+		double validateSeconds = 0.0;
+		{
+			SceneCache::FReader reader;
+			report.Check("open", reader.Open(filepath));
+			report.Check("sourceKey", reader.GetSourceKey() == sourceKey);
+
+			bool bSameSections = true;
+			for (uint32_t section = 0; section < (uint32_t)SceneCache::Section::Count; ++section)
+			{
+				const std::span<const uint8_t> bytes = reader.GetBytes((SceneCache::Section)section);
+				const std::vector<uint8_t>& written = writer.m_sections[section];
+				bSameSections &= bytes.size() == written.size() && std::equal(bytes.begin(), bytes.end(), written.begin());
+			}
+
+			report.Check("roundTrip", bSameSections);
+
+			std::string error;
+			const auto startTime = std::chrono::high_resolution_clock::now();
+			const bool bValid = SceneCache::Validate(reader, error);
+			validateSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+			report.Check("valid", bValid && error.empty());
+		}
+
+		// Each damaged scene is written to its own file, which has to open but fail the checks
+		auto Rejects = [&](const std::string& name, const SceneCache::FWriter& damagedWriter)
+		{
+			const std::string damagedFilepath = (directory / (name + ".scene-cache")).string();
+			SceneCache::FReader reader;
+			std::string error;
+			report.Check(name, damagedWriter.Save(damagedFilepath, sourceKey) && reader.Open(damagedFilepath) && !SceneCache::Validate(reader, error) && !error.empty());
+		};
+
+		auto RejectsChange = [&](const std::string& name, auto change)
+		{
+			FSceneCacheContents damaged = contents;
+			change(damaged);
+			Rejects(name, damaged.Write());
+		};
+
+		RejectsChange("viewOutsideBuffer", [](FSceneCacheContents& c) { c.m_views[1].m_byteLength = 129; });
+		RejectsChange("accessorView", [](FSceneCacheContents& c) { c.m_accessors[1].m_bufferViewIndex = 2; });
+		RejectsChange("accessorOffset", [](FSceneCacheContents& c) { c.m_accessors[0].m_byteOffset = 129; });
+		RejectsChange("accessorFormatCount", [](FSceneCacheContents& c) { c.m_accessorFormats.pop_back(); });
+		RejectsChange("accessorFormat", [](FSceneCacheContents& c) { c.m_accessorFormats[0].m_format = (VertexFormat::Type)7; });
+		RejectsChange("assetPrimitives", [](FSceneCacheContents& c) { c.m_assets[1].m_primitiveCount = 2; });
+		RejectsChange("primitiveAccessor", [](FSceneCacheContents& c) { c.m_primitives[0].m_positionAccessor = 2; });
+		RejectsChange("primitiveMaterial", [](FSceneCacheContents& c) { c.m_primitives[1].m_materialIndex = 1; });
+		RejectsChange("raytracingView", [](FSceneCacheContents& c) { c.m_primitives[0].m_raytracingGeometry.m_indexBufferView = 2; });
+		RejectsChange("instanceAsset", [](FSceneCacheContents& c) { c.m_meshInstances[2].m_index = 2; });
+		RejectsChange("negativeInstanceAsset", [](FSceneCacheContents& c) { c.m_meshInstances[0].m_index = -1; });
+		RejectsChange("lightInstance", [](FSceneCacheContents& c) { c.m_lightInstances[0].m_index = 1; });
+		RejectsChange("gpuPrimitiveMesh", [](FSceneCacheContents& c) { c.m_gpuPrimitives[2].m_meshIndex = 3; });
+		RejectsChange("gpuPrimitiveMaterial", [](FSceneCacheContents& c) { c.m_gpuPrimitives[0].m_materialIndex = 1; });
+		RejectsChange("primitiveCounts", [](FSceneCacheContents& c) { c.m_primitiveCounts[2] = 2; });
+		RejectsChange("meshletAccessor", [](FSceneCacheContents& c) { c.m_meshlets[3].m_positionAccessor = 2; });
+		RejectsChange("meshletTriangles", [](FSceneCacheContents& c) { c.m_meshlets[3].m_triangleCount = 2; });
+		RejectsChange("meshletVertices", [](FSceneCacheContents& c) { c.m_meshlets[3].m_vertexBegin = 10; });
+		RejectsChange("meshletDeltaSize", [](FSceneCacheContents& c) { c.m_meshlets[0].m_vertexDeltaSize = 3; });
+		RejectsChange("meshletInstanceAsset", [](FSceneCacheContents& c) { c.m_meshletInstances[1].m_assetIndex = 2; });
+		RejectsChange("meshletInstanceRange", [](FSceneCacheContents& c) { c.m_meshletInstances[1].m_meshletCount = 3; });
+		RejectsChange("meshletInstanceBegin", [](FSceneCacheContents& c) { c.m_meshletInstances[2].m_instanceMeshletBegin = 5; });
+		RejectsChange("meshletInstanceCount", [](FSceneCacheContents& c) { c.m_meshletInstances.pop_back(); });
+		RejectsChange("materialTexture", [](FSceneCacheContents& c) { c.m_materials[0].m_normalTextureIndex = 1; });
+		RejectsChange("materialSampler", [](FSceneCacheContents& c) { c.m_materials[0].m_aoSamplerIndex = -2; });
+
+		SceneCache::FWriter partialRecord = writer;
+		partialRecord.m_sections[(size_t)SceneCache::Section::MeshInstances].push_back(0);
+		Rejects("partialRecord", partialRecord);
+
+		std::filesystem::remove_all(directory);
+
+		report["validateSeconds"] = validateSeconds;
+		return report.Finish();
+	}
+
+	// Reads the index, position, normal and texcoord streams of every primitive twice. First the way the loader used to, with a copy
+	// of the whole source buffer and then one element at a time, and then through accessor views, which only convert the streams
+	// that don't already have the layout that the loader wants. Reports the bytes that each pass allocates, and fails if the views
+	// read anything different from the element by element copy.
+	// High water mark of the resident memory of the process
+	size_t GetPeakRssBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+		rusage usage = {};
+		return getrusage(RUSAGE_SELF, &usage) == 0 ? (size_t)usage.ru_maxrss * 1024 : 0;
+#endif
+	}
+
+	// Compares reading the index, position, normal and texcoord streams like the loader used to, with a copy of the whole buffer
+	// per stream, against reading them through accessor views. The peak resident memory only grows, so a mode of "copy" or "views"
+	// runs just that path for measuring it. Without a mode both paths run, and their results are compared.
+	int ReportAccessorViews(const tinygltf::Model& model, const std::string& mode)
+	{
+		struct FStream
+		{
+			int m_accessor;
+			uint32_t m_components;	// 0 for indices
+		};
+
+		std::vector<FStream> streams;
+		for (const tinygltf::Mesh& mesh : model.meshes)
+		{
+			for (const tinygltf::Primitive& primitive : mesh.primitives)
+			{
+				if (primitive.indices != -1)
+					streams.push_back({ primitive.indices, 0 });
+
+				for (const auto& [name, components] : { std::pair{ "POSITION", 3u }, { "NORMAL", 3u }, { "TEXCOORD_0", 2u } })
+				{
+					auto it = primitive.attributes.find(name);
+					if (it != primitive.attributes.cend() && model.accessors[it->second].bufferView != -1)
+						streams.push_back({ it->second, components });
+				}
+			}
+		}
+
+		const bool bCopy = mode != "views";
+		const bool bViews = mode != "copy";
+		const size_t modelPeakRss = GetPeakRssBytes();
+
+		// Single element views always take the scalar conversion path. When only this path runs, each copy is released after its
+		// stream like the loader did.
+		size_t copiedBytes = 0, largestCopy = 0;
+		std::vector<std::vector<uint8_t>> copies(streams.size());
+		const auto copyStart = std::chrono::steady_clock::now();
+		for (size_t s = 0; s < streams.size() && bCopy; ++s)
+		{
+			const FAccessorView view = AccessorView::Get(model, streams[s].m_accessor);
+			const tinygltf::Buffer& source = model.buffers[model.bufferViews[model.accessors[streams[s].m_accessor].bufferView].buffer];
+			const tinygltf::Buffer buffer = source;
+			largestCopy = std::max(largestCopy, buffer.data.size());
+
+			const size_t elementSize = streams[s].m_components == 0 ? sizeof(uint32_t) : streams[s].m_components * sizeof(float);
+			copies[s].resize(view.m_count * elementSize);
+			for (size_t i = 0; i < view.m_count; ++i)
+			{
+				FAccessorView element = view;
+				element.m_data = buffer.data.data() + (view.GetElement(i) - source.data.data());
+				element.m_count = 1;
+				if (streams[s].m_components == 0)
+				{
+					AccessorView::ConvertIndices(element, (uint32_t*)&copies[s][i * elementSize]);
+				}
+				else
+				{
+					AccessorView::ConvertFloats(element, streams[s].m_components, (float*)&copies[s][i * elementSize]);
+				}
+			}
+
+			copiedBytes += buffer.data.size() + copies[s].size();
+			if (!bViews)
+			{
+				copies[s] = {};
+			}
+		}
+		const std::chrono::duration<double> copyTime = std::chrono::steady_clock::now() - copyStart;
+
+		// One scratch buffer per stream type, reused across primitives like the loader does
+		size_t convertedBytes = 0, inPlace = 0, mismatches = 0;
+		std::vector<uint32_t> indexScratch;
+		std::vector<XMFLOAT3> float3Scratch;
+		std::vector<XMFLOAT2> float2Scratch;
+		std::chrono::duration<double> viewTime{};
+		for (size_t s = 0; s < streams.size() && bViews; ++s)
+		{
+			const FAccessorView view = AccessorView::Get(model, streams[s].m_accessor);
+			const auto viewStart = std::chrono::steady_clock::now();
+			std::span<const uint8_t> bytes;
+			switch (streams[s].m_components)
+			{
+			case 0: { const auto elements = AccessorView::Read(view, indexScratch); bytes = { (const uint8_t*)elements.data(), elements.size_bytes() }; break; }
+			case 2: { const auto elements = AccessorView::Read(view, float2Scratch); bytes = { (const uint8_t*)elements.data(), elements.size_bytes() }; break; }
+			default: { const auto elements = AccessorView::Read(view, float3Scratch); bytes = { (const uint8_t*)elements.data(), elements.size_bytes() }; break; }
+			}
+			viewTime += std::chrono::steady_clock::now() - viewStart;
+
+			if (bytes.data() == view.m_data)
+			{
+				inPlace++;
+			}
+			else
+			{
+				convertedBytes += bytes.size();
+			}
+
+			if (bCopy)
+			{
+				mismatches += bytes.size() != copies[s].size() || memcmp(bytes.data(), copies[s].data(), bytes.size()) != 0;
+			}
+		}
+
+		nlohmann::json report = {
+			{ "streams", streams.size() },
+			{ "modelPeakRssBytes", modelPeakRss },
+			{ "peakRssBytes", GetPeakRssBytes() },
+			{ "mismatches", mismatches }
+		};
+
+		if (bCopy)
+		{
+			report["copy"] = { { "bytes", copiedBytes }, { "largestBufferBytes", largestCopy }, { "seconds", copyTime.count() } };
+		}
+
+		if (bViews)
+		{
+			report["views"] = { { "convertedBytes", convertedBytes }, { "inPlaceStreams", inPlace }, { "seconds", viewTime.count() } };
+		}
+
+		printf("%s\n", report.dump(2).c_str());
+		if (mismatches != 0)
+		{
+			fprintf(stderr, "Error: %zu streams read differently through accessor views\n", mismatches);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Checks the placement policy of the allocator that sub-allocates the geometry arena on a few fixed cases, then loads and unloads
+	// model sized ranges at random and validates the free list after every step. Reports how fragmented the arena ends up.
+	int TestArenaAllocator(int iterations)
+	{
+		FCheckReport report;
+
+		{
+			FFreeListAllocator allocator{ 1000 };
+			const size_t a = allocator.Allocate(100);
+			const size_t b = allocator.Allocate(300);
+			const size_t c = allocator.Allocate(50);
+			const size_t d = allocator.Allocate(200);
+			allocator.Allocate(100);
+			report.Check("backToBack", a == 0 && b == 100 && c == 400 && d == 450);
+
+			// Holes of 300 at 100, 200 at 450 and 250 at 750
+			allocator.Free(b);
+			allocator.Free(d);
+			report.Check("bestFit", allocator.Allocate(180) == 450);
+			report.Check("exactFit", allocator.Allocate(250) == 750);
+			report.Check("tooLarge", allocator.Allocate(400) == FFreeListAllocator::InvalidOffset);
+			report.Check("validAfterBestFit", allocator.Validate());
+
+			allocator.Free(a);
+			allocator.Free(c);
+			report.Check("mergeNeighbours", allocator.GetFreeRangeCount() == 2);
+			report.Check("mergedRange", allocator.GetLargestFreeRange() == 450);
+		}
+
+		{
+			FFreeListAllocator allocator{ 1024 };
+			allocator.Allocate(10);
+			const size_t aligned = allocator.Allocate(100, 256);
+			report.Check("alignedOffset", aligned == 256);
+			report.Check("alignmentPaddingFree", allocator.Allocate(246) == 10);
+			allocator.Free(aligned);
+			report.Check("validAfterAligned", allocator.Validate() && allocator.GetUsedSize() == 256);
+		}
+
+		{
+			FFreeListAllocator allocator{ 1000 };
+			const size_t a = allocator.Allocate(500);
+			const size_t b = allocator.Allocate(500);
+			report.Check("full", allocator.Allocate(1) == FFreeListAllocator::InvalidOffset);
+			allocator.Free(b);
+			allocator.Free(a);
+			report.Check("freeAll", allocator.GetFreeRangeCount() == 1 && allocator.GetLargestFreeRange() == 1000);
+			report.Check("emptyNotFragmented", allocator.GetFragmentation() == 0.f);
+		}
+
+		// Models between 64 KB and 64 MB in a 512 MB arena, with log-uniform sizes
+		std::mt19937 rng{ 7 };
+		std::uniform_real_distribution<double> logSize{ std::log(64.0 * 1024), std::log(64.0 * 1024 * 1024) };
+		FFreeListAllocator allocator{ 512ull << 20 };
+		std::vector<size_t> live;
+		size_t failedAllocations = 0, invalidSteps = 0;
+		double fragmentationSum = 0.0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			if (live.empty() || rng() % 2 == 0)
+			{
+				const size_t offset = allocator.Allocate((size_t)std::exp(logSize(rng)), 256);
+				if (offset == FFreeListAllocator::InvalidOffset)
+				{
+					failedAllocations++;
+				}
+				else
+				{
+					live.push_back(offset);
+				}
+			}
+			else
+			{
+				const size_t index = rng() % live.size();
+				allocator.Free(live[index]);
+				live[index] = live.back();
+				live.pop_back();
+			}
+
+			invalidSteps += !allocator.Validate();
+			fragmentationSum += allocator.GetFragmentation();
+		}
+
+		report.Check("randomValid", invalidSteps == 0);
+
+		report.m_report.update({
+			{ "iterations", iterations },
+			{ "liveAllocations", live.size() },
+			{ "usedBytes", allocator.GetUsedSize() },
+			{ "freeRanges", allocator.GetFreeRangeCount() },
+			{ "largestFreeRange", allocator.GetLargestFreeRange() },
+			{ "fragmentation", allocator.GetFragmentation() },
+			{ "meanFragmentation", iterations > 0 ? fragmentationSum / iterations : 0.0 },
+			{ "failedAllocations", failedAllocations }
+		});
+
+		return report.Finish();
+	}
+
+	// Times the startup lookups on a generated content tree, by walking the tree for each of them as GetFilepathA used to, and from a
+	// content index that is built from scratch, loaded from its saved file, and refreshed after a change. The results have to match.
+	// Lookups of missing files are timed as well.
+	int BenchmarkContentIndex(int fileCount)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		const std::filesystem::path root = std::filesystem::temp_directory_path() / "mesh-tool-content-index";
+		std::filesystem::remove_all(root);
+
+		// 100 files per directory, two levels deep, with a cache directory next to every model
+		std::vector<std::string> lookups;
+		for (int i = 0; i < fileCount; ++i)
+		{
+			const std::filesystem::path dir = root / ("group" + std::to_string(i / 1000)) / ("asset" + std::to_string(i / 100));
+			const char* extension = i % 100 == 0 ? ".gltf" : (i % 250 == 0 ? ".hdr" : ".png");
+			const std::string filename = "file" + std::to_string(i) + extension;
+			std::filesystem::create_directories(dir);
+			std::ofstream{ dir / filename };
+			if (i % 100 == 0)
+			{
+				std::filesystem::create_directories(dir / ".content-cache");
+				std::ofstream{ dir / ".content-cache" / ("file" + std::to_string(i) + ".dds") };
+				lookups.push_back(filename);
+			}
+		}
+
+		// Model, environment map and debug primitives at startup, and a few model switches
+		lookups.resize(std::min<size_t>(lookups.size(), 8));
+
+		auto ScanFind = [&root](const std::string& filename)
+		{
+			for (auto& entry : std::filesystem::recursive_directory_iterator(root))
+			{
+				if (entry.is_regular_file() && entry.path().filename().string() == filename && entry.path().parent_path().string().rfind('.') == std::string::npos)
+					return entry.path();
+			}
+
+			return std::filesystem::path{};
+		};
+
+		auto ScanList = [&root](const std::string& extension)
+		{
+			std::vector<std::filesystem::path> files;
+			for (auto& entry : std::filesystem::recursive_directory_iterator(root))
+			{
+				if (entry.is_regular_file() && entry.path().extension().string() == extension && entry.path().parent_path().string().rfind('.') == std::string::npos)
+				{
+					files.push_back(entry.path());
+				}
+			}
+
+			std::sort(files.begin(), files.end());
+			return files;
+		};
+
+		auto start = Clock::now();
+		std::vector<std::filesystem::path> scanResults;
+		for (const std::string& filename : lookups)
+		{
+			scanResults.push_back(ScanFind(filename));
+		}
+
+		const std::vector<std::filesystem::path> scanModels = ScanList(".gltf");
+		const std::vector<std::filesystem::path> scanHdris = ScanList(".hdr");
+		const std::chrono::duration<double> scanTime = Clock::now() - start;
+
+		size_t mismatches = 0;
+		auto IndexStartup = [&](FContentIndex& index, size_t& changedCount)
+		{
+			changedCount = index.Open(root);
+			for (size_t i = 0; i < lookups.size(); ++i)
+			{
+				mismatches += index.Find(lookups[i]) != scanResults[i];
+			}
+
+			mismatches += index.List(".gltf") != scanModels;
+			mismatches += index.List(".hdr") != scanHdris;
+		};
+
+		size_t coldChanged = 0, warmChanged = 0, refreshChanged = 0;
+		start = Clock::now();
+		{
+			FContentIndex index;
+			IndexStartup(index, coldChanged);
+		}
+		const std::chrono::duration<double> coldTime = Clock::now() - start;
+
+		start = Clock::now();
+		{
+			FContentIndex index;
+			IndexStartup(index, warmChanged);
+		}
+		const std::chrono::duration<double> warmTime = Clock::now() - start;
+
+		// A new file in one directory only lists that directory again
+		FContentIndex index;
+		index.Open(root);
+		const std::filesystem::path addedFile = root / "group0" / "asset0" / "added.png";
+		std::ofstream{ addedFile };
+		start = Clock::now();
+		refreshChanged = index.Refresh();
+		const std::chrono::duration<double> refreshTime = Clock::now() - start;
+		mismatches += index.Find("added.png") != addedFile;
+
+		// Looking up missing files, as when probing for optional files, refreshes at most once per interval
+		constexpr int MissCount = 1000;
+		start = Clock::now();
+		for (int i = 0; i < MissCount; ++i)
+		{
+			mismatches += !index.Find("missing.png").empty();
+		}
+		const std::chrono::duration<double> missTime = Clock::now() - start;
+
+		const size_t indexedFiles = index.GetFileCount();
+		const size_t indexedDirectories = index.GetDirectoryCount();
+
+		// The refresh saved the index. A path length or a path count that is larger than the rest of the file stops the load, and 
+		// the directories that were not read are listed again. The first record is the root directory, with an empty path.
+		const std::filesystem::path indexFilepath = root / ".content-index" / "index.bin";
+		std::vector<char> indexBytes;
+		{
+			std::ifstream file(indexFilepath, std::ios::binary);
+			indexBytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		}
+
+		size_t damagedListed = 0;
+		for (const size_t damagedOffset : { 16, 28 })
+		{
+			std::vector<char> damaged = indexBytes;
+			const uint32_t hugeLength = 0xfffffff0u;
+			memcpy(damaged.data() + damagedOffset, &hugeLength, sizeof(hugeLength));
+			{
+				std::ofstream file(indexFilepath, std::ios::binary | std::ios::trunc);
+				file.write(damaged.data(), damaged.size());
+			}
+
+			FContentIndex damagedIndex;
+			IndexStartup(damagedIndex, damagedListed);
+			mismatches += damagedIndex.Find("added.png") != addedFile;
+			mismatches += damagedListed != indexedDirectories;
+		}
+
+		std::filesystem::remove_all(root);
+
+		FCheckReport report;
+		report.m_report = {
+			{ "files", indexedFiles },
+			{ "directories", indexedDirectories },
+			{ "lookups", lookups.size() },
+			{ "scan", { { "seconds", scanTime.count() } } },
+			{ "indexCold", { { "seconds", coldTime.count() }, { "listedDirectories", coldChanged } } },
+			{ "indexWarm", { { "seconds", warmTime.count() }, { "listedDirectories", warmChanged } } },
+			{ "refreshAfterAdd", { { "seconds", refreshTime.count() }, { "listedDirectories", refreshChanged } } },
+			{ "missedLookups", { { "count", MissCount }, { "seconds", missTime.count() } } },
+			{ "damagedIndex", { { "listedDirectories", damagedListed } } },
+			{ "mismatches", mismatches }
+		};
+
+		report.Check("lookupsMatch", mismatches == 0);
+		return report.Finish();
+	}
+
+	// Inputs of the golden data, generated with integer math only so that they are the same on every compiler. The normals tilt
+	// in bands that diverge at different rates, and the roughness covers the whole range, including rows at 0 and 1.
+	void GenerateNormalRoughnessInputs(uint32_t width, uint32_t height, std::vector<uint8_t>& normalmap, std::vector<uint8_t>& metallicRoughnessmap)
+	{
+		normalmap.resize((size_t)width * height * 4);
+		metallicRoughnessmap.resize((size_t)width * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const size_t offset = ((size_t)y * width + x) * 4;
+				const uint32_t hash = (x * 73856093u) ^ (y * 19349663u);
+				normalmap[offset + 0] = (uint8_t)(128 + (int)((x * 37 + y * 11 + (hash >> 7)) % 97) - 48);
+				normalmap[offset + 1] = (uint8_t)(128 + (int)((x * 5 + y * 29 + (hash >> 13)) % 61) - 30);
+				normalmap[offset + 2] = (uint8_t)(200 + (hash >> 17) % 56);
+				normalmap[offset + 3] = 255;
+
+				metallicRoughnessmap[offset + 0] = (uint8_t)(hash >> 3);
+				metallicRoughnessmap[offset + 1] = y % 9 == 0 ? 0 : (y % 9 == 1 ? 255 : (uint8_t)(x * 5 + y * 3));
+				metallicRoughnessmap[offset + 2] = ((x / 4 + y / 4) % 2) * 255;
+				metallicRoughnessmap[offset + 3] = 255;
+			}
+		}
+	}
+
+	// Checks NormalRoughnessFilter::Prefilter and PrefilterReference against checked in output of the reference. The golden file is
+	// the header below and then the normal and metallic/roughness texels of each mip. With update, the file is written instead.
+	// The reference is a port of the shader and not a capture of it. The demo compares the CPU filter with the shader itself when
+	// FConfig::CompareNormalRoughnessWithGpu is set.
+	int CheckNormalRoughnessGolden(const std::string& goldenFilepath, bool bUpdate)
+	{
+		constexpr uint32_t Magic = 0x4746524e; // "NRFG"
+		constexpr uint32_t Version = 1;
+		constexpr uint32_t Width = 52;				// Odd mip sizes exercise the texels that the SIMD path filters one at a time
+		constexpr uint32_t Height = 36;
+		constexpr int Tolerance = 1;
+
+		std::vector<uint8_t> normalmap, metallicRoughnessmap;
+		GenerateNormalRoughnessInputs(Width, Height, normalmap, metallicRoughnessmap);
+		const size_t mipCount = NormalRoughnessFilter::GetMipCount(Width, Height);
+
+		std::vector<NormalRoughnessFilter::FMip> referenceNormals, referenceMetallicRoughness;
+		NormalRoughnessFilter::PrefilterReference(normalmap.data(), metallicRoughnessmap.data(), Width, Height, mipCount, referenceNormals, referenceMetallicRoughness);
+
+		if (bUpdate)
+		{
+			std::ofstream file(goldenFilepath, std::ios::binary | std::ios::trunc);
+			const uint32_t header[] = { Magic, Version, Width, Height, (uint32_t)mipCount };
+			file.write((const char*)header, sizeof(header));
+			for (size_t mipIndex = 0; mipIndex < mipCount; ++mipIndex)
+			{
+				file.write((const char*)referenceNormals[mipIndex].m_texels.data(), referenceNormals[mipIndex].m_texels.size());
+				file.write((const char*)referenceMetallicRoughness[mipIndex].m_texels.data(), referenceMetallicRoughness[mipIndex].m_texels.size());
+			}
+
+			printf("Wrote %s\n", goldenFilepath.c_str());
+			return file ? 0 : 1;
+		}
+
+		std::ifstream file(goldenFilepath, std::ios::binary);
+		uint32_t header[5] = {};
+		file.read((char*)header, sizeof(header));
+		if (!file || header[0] != Magic || header[1] != Version || header[2] != Width || header[3] != Height || header[4] != mipCount)
+		{
+			fprintf(stderr, "Error: %s is missing or was written for different inputs\n", goldenFilepath.c_str());
+			return 1;
+		}
+
+		std::vector<NormalRoughnessFilter::FMip> goldenNormals = referenceNormals, goldenMetallicRoughness = referenceMetallicRoughness;
+		for (size_t mipIndex = 0; mipIndex < mipCount; ++mipIndex)
+		{
+			file.read((char*)goldenNormals[mipIndex].m_texels.data(), goldenNormals[mipIndex].m_texels.size());
+			file.read((char*)goldenMetallicRoughness[mipIndex].m_texels.data(), goldenMetallicRoughness[mipIndex].m_texels.size());
+		}
+
+		if (!file)
+		{
+			fprintf(stderr, "Error: %s is truncated\n", goldenFilepath.c_str());
+			return 1;
+		}
+
+		// Single threaded and split into a row per thread, which must give the same result
+		std::vector<NormalRoughnessFilter::FMip> normals, metallicRoughness, threadedNormals, threadedMetallicRoughness;
+		NormalRoughnessFilter::Prefilter(normalmap.data(), metallicRoughnessmap.data(), Width, Height, mipCount, normals, metallicRoughness, 1);
+		NormalRoughnessFilter::Prefilter(normalmap.data(), metallicRoughnessmap.data(), Width, Height, mipCount, threadedNormals, threadedMetallicRoughness, Height);
+
+		using FDifference = NormalRoughnessFilter::FDifference;
+		auto Report = [](const FDifference& normalDifference, const FDifference& metallicRoughnessDifference)
+		{
+			return nlohmann::json{
+				{ "normals", { { "maxDifference", normalDifference.m_maxDifference }, { "differentChannels", normalDifference.m_differentChannelCount } } },
+				{ "metallicRoughness", { { "maxDifference", metallicRoughnessDifference.m_maxDifference }, { "differentChannels", metallicRoughnessDifference.m_differentChannelCount } } } };
+		};
+
+		const FDifference referenceNormalDifference = NormalRoughnessFilter::Compare(referenceNormals, goldenNormals);
+		const FDifference referenceMetallicRoughnessDifference = NormalRoughnessFilter::Compare(referenceMetallicRoughness, goldenMetallicRoughness);
+		const FDifference normalDifference = NormalRoughnessFilter::Compare(normals, goldenNormals);
+		const FDifference metallicRoughnessDifference = NormalRoughnessFilter::Compare(metallicRoughness, goldenMetallicRoughness);
+		const bool bThreadingMatches =
+			NormalRoughnessFilter::Compare(normals, threadedNormals).m_maxDifference == 0 &&
+			NormalRoughnessFilter::Compare(metallicRoughness, threadedMetallicRoughness).m_maxDifference == 0;
+
+		// Timing on a texture of a typical size
+		using Clock = std::chrono::high_resolution_clock;
+		constexpr uint32_t BenchmarkSize = 2048;
+		std::vector<uint8_t> largeNormalmap, largeMetallicRoughnessmap;
+		GenerateNormalRoughnessInputs(BenchmarkSize, BenchmarkSize, largeNormalmap, largeMetallicRoughnessmap);
+		const size_t largeMipCount = NormalRoughnessFilter::GetMipCount(BenchmarkSize, BenchmarkSize);
+
+		auto start = Clock::now();
+		NormalRoughnessFilter::PrefilterReference(largeNormalmap.data(), largeMetallicRoughnessmap.data(), BenchmarkSize, BenchmarkSize, largeMipCount, referenceNormals, referenceMetallicRoughness);
+		const std::chrono::duration<double> referenceTime = Clock::now() - start;
+
+		start = Clock::now();
+		NormalRoughnessFilter::Prefilter(largeNormalmap.data(), largeMetallicRoughnessmap.data(), BenchmarkSize, BenchmarkSize, largeMipCount, normals, metallicRoughness, 1);
+		const std::chrono::duration<double> singleThreadTime = Clock::now() - start;
+
+		start = Clock::now();
+		NormalRoughnessFilter::Prefilter(largeNormalmap.data(), largeMetallicRoughnessmap.data(), BenchmarkSize, BenchmarkSize, largeMipCount, normals, metallicRoughness);
+		const std::chrono::duration<double> threadedTime = Clock::now() - start;
+
+		const bool bWithinTolerance =
+			std::max(referenceNormalDifference.m_maxDifference, referenceMetallicRoughnessDifference.m_maxDifference) <= Tolerance &&
+			std::max(normalDifference.m_maxDifference, metallicRoughnessDifference.m_maxDifference) <= Tolerance;
+
+		FCheckReport report;
+		report.m_report = {
+			{ "size", { Width, Height } },
+			{ "mips", mipCount },
+			{ "tolerance", Tolerance },
+			{ "reference", Report(referenceNormalDifference, referenceMetallicRoughnessDifference) },
+			{ "simd", Report(normalDifference, metallicRoughnessDifference) },
+			{ "benchmark", {
+				{ "size", BenchmarkSize },
+				{ "referenceSeconds", referenceTime.count() },
+				{ "simdSeconds", singleThreadTime.count() },
+				{ "simdThreadedSeconds", threadedTime.count() },
+				{ "threads", std::thread::hardware_concurrency() } } }
+		};
+
+		report.Check("withinTolerance", bWithinTolerance);
+		report.Check("threadingMatches", bThreadingMatches);
+		return report.Finish();
+	}
+
+	// Directed edges that aren't cancelled by an opposite edge, sorted. Two triangle lists over the same welded vertices cover the
+	// same patch without cracks or overlaps only if their open edges match.
+	std::vector<std::pair<uint32_t, uint32_t>> GetOpenEdges(const std::vector<uint32_t>& triangles)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> edges;
+		edges.reserve(triangles.size());
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				edges.push_back({ triangles[i + corner], triangles[i + (corner + 1) % 3] });
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+
+		std::vector<std::pair<uint32_t, uint32_t>> openEdges;
+		for (auto it = edges.cbegin(); it != edges.cend();)
+		{
+			const auto next = std::upper_bound(it, edges.cend(), *it);
+			const auto opposite = std::equal_range(edges.cbegin(), edges.cend(), std::pair{ it->second, it->first });
+			for (ptrdiff_t i = std::distance(opposite.first, opposite.second); i < std::distance(it, next); ++i)
+			{
+				openEdges.push_back(*it);
+			}
+
+			it = next;
+		}
+
+		return openEdges;
+	}
+
+	// Builds the cluster DAG of a mesh and checks its invariants independently of how ClusterLod builds it: the links between
+	// clusters and groups, errors that never decrease towards the roots, nested bounds, that the parents of every group cover the
+	// same patch as its children, and that cuts at increasing distances cover the mesh without cracks with fewer triangles
+	// If vertexBands isn't empty, triangles of the source mesh never mix vertices of different bands, and neither may the clusters
+	FCheckReport CheckClusterDag(
+		const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions,
+		const std::vector<uint32_t>& vertexReps, const std::vector<uint32_t>& vertexBands)
+	{
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+
+		std::vector<FInlineMeshlet> meshlets;
+		MeshUtils::Meshletize(MAX_VERTS, MAX_PRIMITIVES, indices.data(), (uint32_t)indices.size(), positions.data(), (uint32_t)positions.size(), meshlets);
+
+		FClusterDag dag;
+		ClusterLod::BuildDag(MAX_VERTS, MAX_PRIMITIVES, meshlets, positions.data(), (uint32_t)positions.size(), vertexReps, dag);
+
+		// Weld by position so that attribute seams don't show up as open edges
+		std::vector<uint32_t> welded(positions.size());
+		std::map<std::tuple<float, float, float>, uint32_t> firstVertex;
+		for (uint32_t v = 0; v < positions.size(); ++v)
+		{
+			welded[v] = firstVertex.try_emplace({ positions[v].x, positions[v].y, positions[v].z }, v).first->second;
+		}
+
+		std::vector<uint32_t> sourceTriangles(indices.size());
+		std::transform(indices.cbegin(), indices.cend(), sourceTriangles.begin(), [&](uint32_t v) { return welded[v]; });
+		const std::vector<std::pair<uint32_t, uint32_t>> sourceOpenEdges = GetOpenEdges(sourceTriangles);
+
+		// Meshlet triangles have reversed winding
+		auto AppendTriangles = [&](uint32_t clusterIndex, std::vector<uint32_t>& triangles)
+		{
+			const FInlineMeshlet& meshlet = dag.m_clusters[clusterIndex].m_meshlet;
+			for (const FInlineMeshlet::FPackedTriangle& tri : meshlet.m_primitiveIndices)
+			{
+				triangles.push_back(welded[meshlet.m_uniqueVertexIndices[tri.i2]]);
+				triangles.push_back(welded[meshlet.m_uniqueVertexIndices[tri.i1]]);
+				triangles.push_back(welded[meshlet.m_uniqueVertexIndices[tri.i0]]);
+			}
+		};
+
+		FCheckReport report;
+		report.Check("levels", dag.m_levelCount >= 3);
+
+		bool bLeaves = true;
+		std::vector<uint32_t> leafTriangles;
+		for (uint32_t clusterIndex = 0; clusterIndex < dag.m_clusters.size(); ++clusterIndex)
+		{
+			const FLodCluster& cluster = dag.m_clusters[clusterIndex];
+			bLeaves &= (cluster.m_level == 0) == (cluster.m_childGroup == -1);
+			if (cluster.m_level == 0)
+			{
+				bLeaves &= cluster.m_error == 0.f;
+				AppendTriangles(clusterIndex, leafTriangles);
+			}
+		}
+
+		report.Check("leaves", bLeaves && leafTriangles.size() == sourceTriangles.size() && GetOpenEdges(leafTriangles) == sourceOpenEdges);
+
+		// Every cluster is the child of at most one group and the parent of at most one group, and the links agree both ways
+		bool bLinks = true, bMonotonicError = true, bNestedBounds = true, bGroupCoverage = true;
+		size_t linkedChildren = 0, linkedParents = 0;
+		for (int groupIndex = 0; groupIndex < dag.m_groups.size(); ++groupIndex)
+		{
+			const FLodClusterGroup& group = dag.m_groups[groupIndex];
+			bLinks &= !group.m_children.empty() && !group.m_parents.empty();
+			linkedChildren += group.m_children.size();
+			linkedParents += group.m_parents.size();
+
+			std::vector<uint32_t> childTriangles, parentTriangles;
+			for (uint32_t child : group.m_children)
+			{
+				const FLodCluster& cluster = dag.m_clusters[child];
+				bLinks &= cluster.m_parentGroup == groupIndex && cluster.m_level + 1 == dag.m_clusters[group.m_parents.front()].m_level;
+				bMonotonicError &= cluster.m_error <= group.m_error && cluster.m_parentError == group.m_error;
+
+				const float distance = Vector3::Distance(Vector3{ cluster.m_lodBounds.Center }, Vector3{ group.m_lodBounds.Center });
+				bNestedBounds &= distance + cluster.m_lodBounds.Radius <= group.m_lodBounds.Radius;
+				AppendTriangles(child, childTriangles);
+			}
+
+			for (uint32_t parent : group.m_parents)
+			{
+				const FLodCluster& cluster = dag.m_clusters[parent];
+				bLinks &= cluster.m_childGroup == groupIndex;
+				bMonotonicError &= cluster.m_error == group.m_error && cluster.m_error <= cluster.m_parentError;
+				AppendTriangles(parent, parentTriangles);
+			}
+
+			bGroupCoverage &= parentTriangles.size() < childTriangles.size() && GetOpenEdges(parentTriangles) == GetOpenEdges(childTriangles);
+		}
+
+		for (const FLodCluster& cluster : dag.m_clusters)
+		{
+			linkedChildren -= cluster.m_parentGroup != -1 ? 1 : 0;
+			linkedParents -= cluster.m_childGroup != -1 ? 1 : 0;
+			bMonotonicError &= cluster.m_parentGroup != -1 || cluster.m_parentError == FLT_MAX;
+		}
+
+		report.Check("links", bLinks && linkedChildren == 0 && linkedParents == 0);
+		report.Check("monotonicError", bMonotonicError);
+		report.Check("nestedBounds", bNestedBounds);
+		report.Check("groupCoverage", bGroupCoverage);
+
+		FClusterLodView view = {};
+		view.m_projectionScale = 0.5f * 1080.f / std::tan(0.5f * FConfig{}.Fov);
+		view.m_nearPlane = FConfig{}.CameraNearPlane;
+		view.m_errorThreshold = 1.f;
+
+		BoundingSphere bounds;
+		BoundingSphere::CreateFromPoints(bounds, positions.size(), positions.data(), sizeof(XMFLOAT3));
+
+		bool bCutCoverage = true, bCutShrinks = true;
+		size_t previousTriangleCount = std::numeric_limits<size_t>::max();
+		nlohmann::json cutTriangles = nlohmann::json::object();
+		for (uint32_t distance = 2; distance <= 4096; distance *= 2)
+		{
+			view.m_eyePosition = Vector3{ bounds.Center } + Vector3{ 0.f, 0.f, distance * bounds.Radius };
+
+			std::vector<uint32_t> cut;
+			ClusterLod::SelectCut(dag, Matrix::Identity, view, cut);
+
+			std::vector<uint32_t> triangles;
+			for (uint32_t clusterIndex : cut)
+			{
+				AppendTriangles(clusterIndex, triangles);
+			}
+
+			bCutCoverage &= ValidateClusterDag(dag, cut) && GetOpenEdges(triangles) == sourceOpenEdges;
+			bCutShrinks &= triangles.size() / 3 <= previousTriangleCount;
+			previousTriangleCount = triangles.size() / 3;
+			cutTriangles[PrintString("%ur", distance)] = triangles.size() / 3;
+		}
+
+		report.Check("cutCoverage", bCutCoverage);
+		report.Check("cutShrinks", bCutShrinks);
+
+		// Parent clusters must reference the seam vertex on the side of each triangle, not whichever one the weld kept
+		if (!vertexBands.empty())
+		{
+			bool bSeams = true;
+			for (const FLodCluster& cluster : dag.m_clusters)
+			{
+				for (const FInlineMeshlet::FPackedTriangle& tri : cluster.m_meshlet.m_primitiveIndices)
+				{
+					const uint32_t band = vertexBands[cluster.m_meshlet.m_uniqueVertexIndices[tri.i0]];
+					bSeams &= vertexBands[cluster.m_meshlet.m_uniqueVertexIndices[tri.i1]] == band && vertexBands[cluster.m_meshlet.m_uniqueVertexIndices[tri.i2]] == band;
+				}
+			}
+
+			report.Check("attributeSeams", bSeams);
+		}
+
+		report["triangles"] = indices.size() / 3;
+		report["levelCount"] = dag.m_levelCount;
+		report["clusters"] = dag.m_clusters.size();
+		report["groups"] = dag.m_groups.size();
+		report["cutTriangles"] = cutTriangles;
+		return report;
+	}
+
+	int CheckClusterDag()
+	{
+		FCheckReport report;
+
+		std::vector<uint32_t> indices;
+		std::vector<XMFLOAT3> positions;
+		MakeSphere(128, 256, indices, positions);
+		report.Add("sphere", CheckClusterDag(indices, positions, {}, {}));
+
+		// The same sphere without shared vertices, as glTF exporters write unindexed meshes. Every corner is its own vertex, and
+		// only the vertex reps tell the simplifier that the corners of a position have the same attributes.
+		std::vector<uint32_t> cornerIndices(indices.size());
+		std::vector<XMFLOAT3> cornerPositions(indices.size());
+		std::vector<uint32_t> firstCorner(positions.size(), ~0u);
+		std::vector<uint32_t> cornerReps(indices.size());
+		for (uint32_t corner = 0; corner < indices.size(); ++corner)
+		{
+			cornerIndices[corner] = corner;
+			cornerPositions[corner] = positions[indices[corner]];
+			if (firstCorner[indices[corner]] == ~0u)
+			{
+				firstCorner[indices[corner]] = corner;
+			}
+
+			cornerReps[corner] = firstCorner[indices[corner]];
+		}
+
+		FCheckReport unindexedReport = CheckClusterDag(cornerIndices, cornerPositions, cornerReps, {});
+		unindexedReport.Check("simplified", unindexedReport["levelCount"].get<uint32_t>() >= 3);
+		report.Add("unindexedSphere", unindexedReport);
+
+		indices.clear();
+		positions.clear();
+		std::vector<uint32_t> vertexBands;
+		MakeGrid(100000, indices, positions, &vertexBands);
+		report.Add("grid", CheckClusterDag(indices, positions, {}, vertexBands));
+
+		return report.Finish();
+	}
+
+	// Checks MeshUtils::ConeCull() against cones and eye positions with a known answer, the s8 packing against the decode of
+	// culling/batch-culling.hlsl, and the cones that Meshletize fits against the triangles of a closed sphere
+	int CheckConeCull()
+	{
+		FCheckReport report;
+
+		// Every s8 value in every lane, next to neighbours that would leak into it if the sign extension was wrong
+		bool bRoundTrip = true;
+		for (int value = -128; value <= 127; ++value)
+		{
+			const int8_t v = (int8_t)value;
+			const XMINT4 a = MeshUtils::UnpackNormalCone(MeshUtils::PackNormalCone(v, -1, 127, -128));
+			const XMINT4 b = MeshUtils::UnpackNormalCone(MeshUtils::PackNormalCone(-128, v, -1, 127));
+			const XMINT4 c = MeshUtils::UnpackNormalCone(MeshUtils::PackNormalCone(127, -128, v, -1));
+			const XMINT4 d = MeshUtils::UnpackNormalCone(MeshUtils::PackNormalCone(-1, 127, -128, v));
+			bRoundTrip &= a.x == value && a.y == -1 && a.z == 127 && a.w == -128;
+			bRoundTrip &= b.x == -128 && b.y == value && b.z == -1 && b.w == 127;
+			bRoundTrip &= c.x == 127 && c.y == -128 && c.z == value && c.w == -1;
+			bRoundTrip &= d.x == -1 && d.y == 127 && d.z == -128 && d.w == value;
+		}
+
+		report.Check("packingRoundTrip", bRoundTrip);
+
+		// Normals within 30 degrees of +Z around a unit sphere at the origin. The RH to LH root transform mirrors Z, and a mirror
+		// culls the side that the normals point away from.
+		const DirectX::BoundingSphere bounds = { XMFLOAT3{ 0.f, 0.f, 0.f }, 1.f };
+		const uint32_t cone = MeshUtils::PackNormalCone(0, 0, 127, 64);
+		const uint32_t fullCone = MeshUtils::PackNormalCone(0, 0, 127, 127);
+		const Matrix mirror = Matrix::CreateScale(1.f, 1.f, -1.f);
+		auto Visible = [&](uint32_t normalCone, const Matrix& localToWorld, const Vector3& localEye)
+		{
+			return MeshUtils::ConeCull(bounds, normalCone, localToWorld, Vector3::Transform(localEye, localToWorld));
+		};
+
+		const float sin80 = std::sin(XMConvertToRadians(80.f));
+		const float cos80 = std::cos(XMConvertToRadians(80.f));
+		report.Check("frontFacing", Visible(cone, mirror, { 0.f, 0.f, 10.f }));
+		report.Check("backFacing", !Visible(cone, mirror, { 0.f, 0.f, -10.f }));
+		report.Check("backFacingOblique", !Visible(cone, mirror, { 70.f, 0.f, -70.f }));
+		report.Check("grazing", Visible(cone, mirror, { 100.f * sin80, 0.f, -100.f * cos80 }));
+		report.Check("insideSphere", Visible(cone, mirror, { 0.f, 0.f, -0.5f }));
+		report.Check("fullCone", Visible(fullCone, mirror, { 0.f, 0.f, -10.f }));
+		report.Check("notMirroredFrontFacing", Visible(cone, Matrix::Identity, { 0.f, 0.f, -10.f }));
+		report.Check("notMirroredBackFacing", !Visible(cone, Matrix::Identity, { 0.f, 0.f, 10.f }));
+
+		const Matrix scaled = Matrix::CreateScale(4.f, 0.5f, -2.f) * Matrix::CreateTranslation(10.f, -3.f, 7.f);
+		report.Check("nonUniformScaleFrontFacing", Visible(cone, scaled, { 0.f, 0.f, 10.f }));
+		report.Check("nonUniformScaleBackFacing", !Visible(cone, scaled, { 0.f, 0.f, -10.f }));
+
+		constexpr uint32_t MAX_VERTS = 64;
+		constexpr uint32_t MAX_PRIMITIVES = 126;
+
+		// Triangles without area have no normal, so their meshlet must never be culled
+		const std::vector<XMFLOAT3> degeneratePositions = { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, { 2.f, 0.f, 0.f } };
+		const std::vector<uint32_t> degenerateIndices = { 0, 1, 2, 2, 1, 0 };
+		std::vector<FInlineMeshlet> degenerateMeshlets;
+		MeshUtils::Meshletize(MAX_VERTS, MAX_PRIMITIVES, degenerateIndices.data(), (uint32_t)degenerateIndices.size(), degeneratePositions.data(), (uint32_t)degeneratePositions.size(), degenerateMeshlets);
+		report.Check("degenerateMeshlet", !degenerateMeshlets.empty() && std::all_of(degenerateMeshlets.cbegin(), degenerateMeshlets.cend(), [fullCone](const FInlineMeshlet& meshlet)
+			{
+				return meshlet.m_normalCone == fullCone;
+			}));
+
+		std::vector<uint32_t> indices;
+		std::vector<XMFLOAT3> positions;
+		MakeSphere(96, 192, indices, positions);
+
+		std::vector<FInlineMeshlet> meshlets;
+		MeshUtils::Meshletize(MAX_VERTS, MAX_PRIMITIVES, indices.data(), (uint32_t)indices.size(), positions.data(), (uint32_t)positions.size(), meshlets);
+
+		// Meshlet triangles have reversed winding. A rejected meshlet must not have a single triangle facing the eye.
+		auto AnyFrontFacing = [&](const FInlineMeshlet& meshlet, const Vector3& localEye, bool bMirrored)
+		{
+			for (const FInlineMeshlet::FPackedTriangle& prim : meshlet.m_primitiveIndices)
+			{
+				const Vector3 p0 = positions[meshlet.m_uniqueVertexIndices[prim.i0]];
+				const Vector3 p1 = positions[meshlet.m_uniqueVertexIndices[prim.i1]];
+				const Vector3 p2 = positions[meshlet.m_uniqueVertexIndices[prim.i2]];
+				const float facing = (p2 - p0).Cross(p1 - p0).Dot(localEye - p0);
+				if (bMirrored ? facing > 0.f : facing < 0.f)
+					return true;
+			}
+
+			return false;
+		};
+
+		std::mt19937 rng(4);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+		std::uniform_real_distribution<float> distance(1.05f, 8.f);
+		size_t tests = 0, rejected = 0, wronglyRejected = 0;
+		for (int eyeIndex = 0; eyeIndex < 200; ++eyeIndex)
+		{
+			Vector3 direction = { unit(rng), unit(rng), unit(rng) };
+			direction.Normalize();
+			const Vector3 localEye = direction * distance(rng);
+			for (const Matrix& localToWorld : { mirror, Matrix::Identity, scaled })
+			{
+				const bool bMirrored = localToWorld.Determinant() < 0.f;
+				const Vector3 eye = Vector3::Transform(localEye, localToWorld);
+				for (const FInlineMeshlet& meshlet : meshlets)
+				{
+					++tests;
+					if (!MeshUtils::ConeCull(meshlet.m_boundingSphere, meshlet.m_normalCone, localToWorld, eye))
+					{
+						++rejected;
+						wronglyRejected += AnyFrontFacing(meshlet, localEye, bMirrored) ? 1 : 0;
+					}
+				}
+			}
+		}
+
+		report.Check("sphereConservative", wronglyRejected == 0);
+		report.Check("sphereRejects", rejected > tests / 4);
+
+		report["sphere"] = { { "triangles", indices.size() / 3 }, { "meshlets", meshlets.size() }, { "tests", tests }, { "rejected", rejected }, { "rejectedRatio", (double)rejected / tests } };
+		return report.Finish();
+	}
+
+	// Round trips a synthetic environment map through the content cache, and checks that every kind of damaged or outdated file
+	// is rejected instead of loaded.
+	int CheckEnvmapCache()
+	{
+		ContentCache::FEnvmap envmap{};
+		envmap.m_format = 26;	// DXGI_FORMAT_R11G11B10_FLOAT
+		envmap.m_size = 32;
+		envmap.m_mipCount = 4;
+		envmap.m_producer = ContentCache::EnvmapProducer::Cpu;
+		envmap.m_texels.resize(envmap.GetTexelCount());
+		for (size_t i = 0; i < envmap.m_texels.size(); ++i)
+		{
+			envmap.m_texels[i] = (uint32_t)(i * 2654435761u);
+		}
+
+		for (size_t i = 0; i < envmap.m_sh.size(); ++i)
+		{
+			envmap.m_sh[i] = 0.25f * (float)i - 1.f;
+		}
+
+		const uint64_t sourceHash = ContentCache::HashSource(std::span<const uint8_t>{ (const uint8_t*)envmap.m_texels.data(), 64 });
+		const uint64_t key = ContentCache::GetEnvmapKey(sourceHash, envmap.m_size, envmap.m_producer);
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "mesh-tool-envmap-cache";
+		std::filesystem::create_directories(directory);
+		const std::string filepath = (directory / ContentCache::GetEnvmapFilename(key)).string();
+
+		FCheckReport report;
+
+		report.Check("keyDependsOnResolution", ContentCache::GetEnvmapKey(sourceHash, envmap.m_size / 2, envmap.m_producer) != key);
+		report.Check("keyDependsOnSource", ContentCache::GetEnvmapKey(sourceHash + 1, envmap.m_size, envmap.m_producer) != key);
+		report.Check("keyDependsOnProducer", ContentCache::GetEnvmapKey(sourceHash, envmap.m_size, ContentCache::EnvmapProducer::Gpu) != key);
+		report.Check("mipOffsets", envmap.GetMipOffset(1, 0) == 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 && envmap.GetMipOffset(0, 2) == 32 * 32 + 16 * 16);
+
+		ContentCache::FEnvmap loaded = {};
+		report.Check("missingFile", !ContentCache::LoadEnvmap((directory / "missing.envmap").string(), key, loaded));
+		report.Check("save", ContentCache::SaveEnvmap(filepath, key, envmap));
+		report.Check("load", ContentCache::LoadEnvmap(filepath, key, loaded));
+		report.Check("roundTrip",
+			loaded.m_format == envmap.m_format && loaded.m_size == envmap.m_size && loaded.m_mipCount == envmap.m_mipCount &&
+			loaded.m_producer == envmap.m_producer && loaded.m_texels == envmap.m_texels && loaded.m_sh == envmap.m_sh);
+		report.Check("wrongKey", !ContentCache::LoadEnvmap(filepath, key + 1, loaded));
+
+		ContentCache::FEnvmap incomplete = envmap;
+		incomplete.m_texels.pop_back();
+		report.Check("saveRejectsIncomplete", !ContentCache::SaveEnvmap((directory / "incomplete.envmap").string(), key, incomplete));
+
+		// Each damaged copy is written from the saved bytes
+		std::vector<char> bytes;
+		{
+			std::ifstream file(filepath, std::ios::binary);
+			bytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		}
+
+		auto LoadsDamaged = [&](const std::vector<char>& damaged)
+		{
+			const std::string damagedFilepath = (directory / "damaged.envmap").string();
+			{
+				std::ofstream file(damagedFilepath, std::ios::binary | std::ios::trunc);
+				file.write(damaged.data(), damaged.size());
+			}
+
+			ContentCache::FEnvmap result = {};
+			return ContentCache::LoadEnvmap(damagedFilepath, key, result);
+		};
+
+		std::vector<char> damaged = bytes;
+		damaged[4] ^= 1;
+		report.Check("wrongVersion", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged[24] ^= 0x7f;
+		report.Check("wrongMipCount", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged[28] ^= 1;
+		report.Check("wrongShCount", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged[32] = 0x7f;
+		report.Check("unknownProducer", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged[bytes.size() / 2] ^= 1;
+		report.Check("corruptTexel", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged.resize(bytes.size() - 1);
+		report.Check("truncated", !LoadsDamaged(damaged));
+
+		damaged = bytes;
+		damaged.push_back(0);
+		report.Check("trailingBytes", !LoadsDamaged(damaged));
+
+		report.Check("unchangedCopy", LoadsDamaged(bytes));
+		std::filesystem::remove_all(directory);
+
+		report["fileBytes"] = bytes.size();
+		return report.Finish();
+	}
+
+	// Round trips the texture cache manifest, and checks that damaged manifests are rejected before their records are allocated
+	int CheckTextureManifest()
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "mesh-tool-texture-manifest";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+
+		FCheckReport report;
+
+		ContentCache::FManifest manifest;
+		report.Check("missingManifest", !manifest.Open(directory.string()));
+		for (uint32_t i = 0; i < 100; ++i)
+		{
+			manifest.Add(0x9e3779b97f4a7c15ull * (i + 1), { 99 /* DXGI_FORMAT_BC7_UNORM */, 1024u >> (i % 4), 512u >> (i % 4), 11 - i % 4 });
+		}
+
+		report.Check("save", manifest.Save());
+
+		ContentCache::FManifest loaded;
+		bool bSameEntries = loaded.Open(directory.string()) && loaded.GetEntryCount() == 100;
+		for (uint32_t i = 0; i < 100 && bSameEntries; ++i)
+		{
+			const ContentCache::FEntry* entry = loaded.Find(0x9e3779b97f4a7c15ull * (i + 1));
+			bSameEntries = entry && entry->m_width == 1024u >> (i % 4) && entry->m_height == 512u >> (i % 4) && entry->m_mipCount == 11 - i % 4;
+		}
+
+		report.Check("roundTrip", bSameEntries);
+
+		const std::filesystem::path filepath = directory / "manifest.bin";
+		std::vector<char> bytes;
+		{
+			std::ifstream file(filepath, std::ios::binary);
+			bytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		}
+
+		auto OpensDamaged = [&](const std::vector<char>& damaged)
+		{
+			{
+				std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+				file.write(damaged.data(), damaged.size());
+			}
+
+			ContentCache::FManifest result;
+			return result.Open(directory.string());
+		};
+
+		std::vector<char> damaged = bytes;
+		damaged[4] ^= 1;
+		report.Check("wrongVersion", !OpensDamaged(damaged));
+
+		damaged = bytes;
+		damaged.resize(bytes.size() - 1);
+		report.Check("truncated", !OpensDamaged(damaged));
+
+		damaged = bytes;
+		damaged.resize(12);
+		report.Check("truncatedHeader", !OpensDamaged(damaged));
+
+		damaged = bytes;
+		const uint64_t hugeCount = 1ull << 60;
+		memcpy(damaged.data() + 8, &hugeCount, sizeof(hugeCount));
+		report.Check("hugeRecordCount", !OpensDamaged(damaged));
+
+		report.Check("unchangedCopy", OpensDamaged(bytes));
+		std::filesystem::remove_all(directory);
+
+		report["fileBytes"] = bytes.size();
+		return report.Finish();
+	}
+
+	// Latlong of the golden data, with values that are exact in floating point so that they are the same on every compiler. The
+	// columns at the seam differ to exercise the wrap, and a small sun makes most of the energy come from a few texels like in an HDRI.
+	EnvmapFilter::FImage GenerateLatlong(uint32_t width, uint32_t height)
+	{
+		EnvmapFilter::FImage latlong = { width, height, std::vector<float>((size_t)width * height * 4) };
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t hash = (x * 73856093u) ^ (y * 19349663u);
+				const bool bSun = x * 64 / width >= 40 && x * 64 / width < 43 && y * 32 / height >= 8 && y * 32 / height < 10;
+				float* texel = &latlong.m_texels[((size_t)y * width + x) * 4];
+				texel[0] = bSun ? 3000.f / 64.f : (float)(16 + y * 96 / height + (x * 7) % 13) / 64.f;
+				texel[1] = bSun ? 2800.f / 64.f : (float)((x * x + y * 11) % 50 + 8) / 64.f;
+				texel[2] = bSun ? 2500.f / 64.f : (float)((hash >> 9) % 40 + 20) / 64.f;
+				texel[3] = 1.f;
+			}
+		}
+
+		return latlong;
+	}
+
+	// 2x2 box filtered mips, like the linear filter that the renderer generates the latlong mips with
+	std::vector<EnvmapFilter::FImage> GenerateLatlongMips(const EnvmapFilter::FImage& latlong, uint32_t mipCount)
+	{
+		std::vector<EnvmapFilter::FImage> mips = { latlong };
+		for (uint32_t mip = 1; mip < mipCount; ++mip)
+		{
+			const EnvmapFilter::FImage& source = mips.back();
+			EnvmapFilter::FImage dest = { source.m_width / 2, source.m_height / 2, std::vector<float>((size_t)(source.m_width / 2) * (source.m_height / 2) * 4) };
+			for (uint32_t y = 0; y < dest.m_height; ++y)
+			{
+				for (uint32_t x = 0; x < dest.m_width; ++x)
+				{
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						auto Texel = [&source, c](uint32_t sx, uint32_t sy) { return source.m_texels[((size_t)sy * source.m_width + sx) * 4 + c]; };
+						dest.m_texels[((size_t)y * dest.m_width + x) * 4 + c] = 0.25f * (Texel(2 * x, 2 * y) + Texel(2 * x + 1, 2 * y) + Texel(2 * x, 2 * y + 1) + Texel(2 * x + 1, 2 * y + 1));
+					}
+				}
+			}
+
+			mips.push_back(std::move(dest));
+		}
+
+		return mips;
+	}
+
+	// Texels of every face and mip, in the order of the golden file
+	std::vector<float> FlattenCubemap(const EnvmapFilter::FCubemap& cubemap)
+	{
+		std::vector<float> texels;
+		for (const EnvmapFilter::FImage& image : cubemap.m_images)
+		{
+			texels.insert(texels.end(), image.m_texels.cbegin(), image.m_texels.cend());
+		}
+
+		return texels;
+	}
+
+	// Largest difference of any channel, relative to the golden value where that is above 1
+	double CompareTexels(std::span<const float> a, std::span<const float> golden)
+	{
+		double maxDifference = 0.0;
+		for (size_t i = 0; i < golden.size(); ++i)
+		{
+			const double difference = std::abs((double)a[i] - (double)golden[i]) / std::max(std::abs((double)golden[i]), 1.0);
+			maxDifference = std::isnan(difference) ? std::numeric_limits<double>::infinity() : std::max(maxDifference, difference);
+		}
+
+		return maxDifference;
+	}
+
+	// Checks the EnvmapFilter kernels and their references against checked in output of the references. The golden file is the
+	// header below, then the texels of the cubemap and the prefiltered cubemap, and then the SH coefficients. With update, the file
+	// is written instead.
+	int CheckEnvmapFilterGolden(const std::string& goldenFilepath, bool bUpdate)
+	{
+		constexpr uint32_t Magic = 0x47464645; // "EFFG"
+		constexpr uint32_t Version = 1;
+		constexpr uint32_t Width = 64;
+		constexpr uint32_t Height = 32;
+		constexpr uint32_t CubemapSize = Height;	// As in FTextureCache::CacheHDRI()
+		constexpr uint32_t CubemapMipCount = 4;
+		constexpr uint32_t FilteredSize = CubemapSize / 2;
+		constexpr uint32_t FilteredMipCount = 4;	// Mips of 8 texels or less exercise the partial rows of the AVX2 kernels
+		constexpr uint32_t SampleCount = EnvmapFilter::DefaultSampleCount;
+		constexpr double Tolerance = 1e-4;
+
+		const std::vector<EnvmapFilter::FImage> latlongMips = GenerateLatlongMips(GenerateLatlong(Width, Height), CubemapMipCount);
+		EnvmapFilter::FCubemap referenceCubemap, referenceFiltered;
+		EnvmapFilter::FShCoefficients referenceSh;
+		EnvmapFilter::ConvertLatlongToCubemapReference(latlongMips, CubemapSize, CubemapMipCount, referenceCubemap);
+		EnvmapFilter::PrefilterCubemapReference(referenceCubemap, FilteredSize, FilteredMipCount, SampleCount, referenceFiltered);
+		EnvmapFilter::ProjectSHReference(latlongMips[0], referenceSh);
+
+		const std::vector<float> referenceCubemapTexels = FlattenCubemap(referenceCubemap);
+		const std::vector<float> referenceFilteredTexels = FlattenCubemap(referenceFiltered);
+		if (bUpdate)
+		{
+			std::ofstream file(goldenFilepath, std::ios::binary | std::ios::trunc);
+			const uint32_t header[] = { Magic, Version, Width, Height, CubemapSize, CubemapMipCount, FilteredSize, FilteredMipCount, SampleCount };
+			file.write((const char*)header, sizeof(header));
+			file.write((const char*)referenceCubemapTexels.data(), referenceCubemapTexels.size() * sizeof(float));
+			file.write((const char*)referenceFilteredTexels.data(), referenceFilteredTexels.size() * sizeof(float));
+			file.write((const char*)referenceSh.data(), referenceSh.size() * sizeof(float));
+
+			printf("Wrote %s\n", goldenFilepath.c_str());
+			return file ? 0 : 1;
+		}
+
+		std::ifstream file(goldenFilepath, std::ios::binary);
+		uint32_t header[9] = {};
+		file.read((char*)header, sizeof(header));
+		if (!file || header[0] != Magic || header[1] != Version || header[2] != Width || header[3] != Height || header[4] != CubemapSize ||
+			header[5] != CubemapMipCount || header[6] != FilteredSize || header[7] != FilteredMipCount || header[8] != SampleCount)
+		{
+			fprintf(stderr, "Error: %s is missing or was written for different inputs\n", goldenFilepath.c_str());
+			return 1;
+		}
+
+		std::vector<float> goldenCubemap(referenceCubemapTexels.size()), goldenFiltered(referenceFilteredTexels.size());
+		EnvmapFilter::FShCoefficients goldenSh = {};
+		file.read((char*)goldenCubemap.data(), goldenCubemap.size() * sizeof(float));
+		file.read((char*)goldenFiltered.data(), goldenFiltered.size() * sizeof(float));
+		file.read((char*)goldenSh.data(), goldenSh.size() * sizeof(float));
+		if (!file)
+		{
+			fprintf(stderr, "Error: %s is truncated\n", goldenFilepath.c_str());
+			return 1;
+		}
+
+		// Single threaded and with a thread per row, which must give the same result
+		EnvmapFilter::FCubemap cubemap, filtered, threadedCubemap, threadedFiltered;
+		EnvmapFilter::FShCoefficients sh, threadedSh;
+		EnvmapFilter::ConvertLatlongToCubemap(latlongMips, CubemapSize, CubemapMipCount, cubemap, 1);
+		EnvmapFilter::PrefilterCubemap(referenceCubemap, FilteredSize, FilteredMipCount, SampleCount, filtered, 1);
+		EnvmapFilter::ProjectSH(latlongMips[0], sh, 1);
+		EnvmapFilter::ConvertLatlongToCubemap(latlongMips, CubemapSize, CubemapMipCount, threadedCubemap, Height);
+		EnvmapFilter::PrefilterCubemap(referenceCubemap, FilteredSize, FilteredMipCount, SampleCount, threadedFiltered, Height);
+		EnvmapFilter::ProjectSH(latlongMips[0], threadedSh, Height);
+		const bool bThreadingMatches =
+			FlattenCubemap(cubemap) == FlattenCubemap(threadedCubemap) &&
+			FlattenCubemap(filtered) == FlattenCubemap(threadedFiltered) &&
+			sh == threadedSh;
+
+		const double differences[2][3] = {
+			{ CompareTexels(referenceCubemapTexels, goldenCubemap), CompareTexels(referenceFilteredTexels, goldenFiltered), CompareTexels(referenceSh, goldenSh) },
+			{ CompareTexels(FlattenCubemap(cubemap), goldenCubemap), CompareTexels(FlattenCubemap(filtered), goldenFiltered), CompareTexels(sh, goldenSh) } };
+
+		// Timing on a small HDRI, with the sizes that the renderer uses for it. The reference prefilter alone takes several seconds.
+		using Clock = std::chrono::high_resolution_clock;
+		constexpr uint32_t BenchmarkWidth = 256;
+		constexpr uint32_t BenchmarkMipCount = 6;
+		const std::vector<EnvmapFilter::FImage> largeLatlongMips = GenerateLatlongMips(GenerateLatlong(BenchmarkWidth, BenchmarkWidth / 2), BenchmarkMipCount);
+		auto Time = [&largeLatlongMips](auto convert, auto prefilter, auto project)
+		{
+			EnvmapFilter::FCubemap largeCubemap, largeFiltered;
+			EnvmapFilter::FShCoefficients largeSh;
+			auto start = Clock::now();
+			convert(largeLatlongMips, BenchmarkWidth / 2, BenchmarkMipCount, largeCubemap);
+			const std::chrono::duration<double> convertTime = Clock::now() - start;
+			start = Clock::now();
+			prefilter(largeCubemap, BenchmarkWidth / 4, BenchmarkMipCount - 1, SampleCount, largeFiltered);
+			const std::chrono::duration<double> prefilterTime = Clock::now() - start;
+			start = Clock::now();
+			project(largeLatlongMips[0], largeSh);
+			const std::chrono::duration<double> projectTime = Clock::now() - start;
+			return nlohmann::json{ { "convertSeconds", convertTime.count() }, { "prefilterSeconds", prefilterTime.count() }, { "shSeconds", projectTime.count() } };
+		};
+
+		auto Convert = [](size_t threadCount)
+		{
+			return [threadCount](const std::vector<EnvmapFilter::FImage>& mips, uint32_t size, uint32_t mipCount, EnvmapFilter::FCubemap& out) { EnvmapFilter::ConvertLatlongToCubemap(mips, size, mipCount, out, threadCount); };
+		};
+		auto Prefilter = [](size_t threadCount)
+		{
+			return [threadCount](const EnvmapFilter::FCubemap& source, uint32_t size, uint32_t mipCount, uint32_t sampleCount, EnvmapFilter::FCubemap& out) { EnvmapFilter::PrefilterCubemap(source, size, mipCount, sampleCount, out, threadCount); };
+		};
+		auto Project = [](size_t threadCount)
+		{
+			return [threadCount](const EnvmapFilter::FImage& latlong, EnvmapFilter::FShCoefficients& out) { EnvmapFilter::ProjectSH(latlong, out, threadCount); };
+		};
+
+		const nlohmann::json referenceTimes = Time(EnvmapFilter::ConvertLatlongToCubemapReference, EnvmapFilter::PrefilterCubemapReference, EnvmapFilter::ProjectSHReference);
+		const nlohmann::json singleThreadTimes = Time(Convert(1), Prefilter(1), Project(1));
+		const nlohmann::json threadedTimes = Time(Convert(0), Prefilter(0), Project(0));
+
+		auto Report = [](const double* difference)
+		{
+			return nlohmann::json{ { "cubemap", difference[0] }, { "prefiltered", difference[1] }, { "sh", difference[2] } };
+		};
+
+		const bool bWithinTolerance =
+			std::max({ differences[0][0], differences[0][1], differences[0][2], differences[1][0], differences[1][1], differences[1][2] }) <= Tolerance;
+
+		FCheckReport report;
+		report.m_report = {
+			{ "size", { Width, Height } },
+			{ "cubemap", { { "size", CubemapSize }, { "mips", CubemapMipCount } } },
+			{ "prefiltered", { { "size", FilteredSize }, { "mips", FilteredMipCount }, { "samples", SampleCount } } },
+			{ "avx2", EnvmapFilter::HasAvx2() },
+			{ "tolerance", Tolerance },
+			{ "reference", Report(differences[0]) },
+			{ "simd", Report(differences[1]) },
+			{ "benchmark", {
+				{ "size", { BenchmarkWidth, BenchmarkWidth / 2 } },
+				{ "reference", referenceTimes },
+				{ "simd", singleThreadTimes },
+				{ "simdThreaded", threadedTimes },
+				{ "threads", std::thread::hardware_concurrency() } } }
+		};
+
+		report.Check("withinTolerance", bWithinTolerance);
+		report.Check("threadingMatches", bThreadingMatches);
+		return report.Finish();
+	}
+}
+
+namespace
+{
+	// Commands either run on a model, which is loaded from their first argument, or on their own arguments
+	struct FCommand
+	{
+		const char* m_name;
+		const char* m_arguments;		// For the usage text
+		int m_requiredArgumentCount;
+		int (*m_run)(int argc, char* argv[]);
+		int (*m_runOnModel)(tinygltf::Model& model, const std::string& modelFilepath, int argc, char* argv[]);
+	};
+
+	const FCommand Commands[] =
+	{
+		{ "locality", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportLocality(model); } },
+		{ "indices", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportIndexEncoding(model); } },
+		{ "lod", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportClusterLod(model); } },
+		{ "draw-order", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportDrawOrder(model); } },
+		{ "bounds", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportBounds(model); } },
+		{ "tangents", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportTangents(model); } },
+		{ "quantize", "<model.gltf>", 1, nullptr, [](tinygltf::Model& model, const std::string&, int, char*[]) { return ReportQuantization(model); } },
+		{ "quantize-check", "", 0, [](int, char*[]) { return CheckQuantization(); }, nullptr },
+		{ "adjacency", "<million triangles>", 1, [](int, char* argv[]) { return BenchmarkAdjacency(std::atof(argv[2])); }, nullptr },
+		{ "meshletize", "<million triangles>", 1, [](int, char* argv[]) { return BenchmarkMeshletize(std::atof(argv[2])); }, nullptr },
+		{ "scene-cache", "<model.scene-cache>", 1, [](int, char* argv[]) { return ReportSceneCache(argv[2]); }, nullptr },
+		{ "scene-cache-check", "", 0, [](int, char*[]) { return CheckSceneCache(); }, nullptr },
+		{ "accessors", "<model.gltf> [copy|views]", 1, nullptr, [](tinygltf::Model& model, const std::string&, int argc, char* argv[])
+			{
+				const std::string mode = argc > 3 ? argv[3] : "";
+				if (!mode.empty() && mode != "copy" && mode != "views")
+				{
+					fprintf(stderr, "Error: unknown mode %s\n", mode.c_str());
+					return 1;
+				}
+
+				return ReportAccessorViews(model, mode);
+			} },
+		{ "arena", "<iterations>", 1, [](int, char* argv[]) { return TestArenaAllocator(std::atoi(argv[2])); }, nullptr },
+		{ "content-index", "<file count>", 1, [](int, char* argv[]) { return BenchmarkContentIndex(std::atoi(argv[2])); }, nullptr },
+		{ "normal-roughness", "<golden.bin> [update]", 1, [](int argc, char* argv[]) { return CheckNormalRoughnessGolden(argv[2], argc > 3 && std::string{ argv[3] } == "update"); }, nullptr },
+		{ "cluster-dag", "", 0, [](int, char*[]) { return CheckClusterDag(); }, nullptr },
+		{ "cone-cull", "", 0, [](int, char*[]) { return CheckConeCull(); }, nullptr },
+		{ "envmap-cache", "", 0, [](int, char*[]) { return CheckEnvmapCache(); }, nullptr },
+		{ "texture-manifest", "", 0, [](int, char*[]) { return CheckTextureManifest(); }, nullptr },
+		{ "envmap-filter", "<golden.bin> [update]", 1, [](int argc, char* argv[]) { return CheckEnvmapFilterGolden(argv[2], argc > 3 && std::string{ argv[3] } == "update"); }, nullptr },
+		{ "report", "<model.gltf> [max verts] [max primitives]", 1, nullptr, [](tinygltf::Model& model, const std::string& modelFilepath, int argc, char* argv[])
+			{
+				// Packed meshlet triangles have 10-bit vertex indices
+				const int maxVerts = argc > 3 ? std::atoi(argv[3]) : 64;
+				const int maxPrims = argc > 4 ? std::atoi(argv[4]) : 126;
+				if (maxVerts < 3 || maxVerts > 1024 || maxPrims < 1)
+				{
+					fprintf(stderr, "Error: max verts must be within [3, 1024] and max primitives at least 1\n");
+					return 1;
+				}
+
+				return ReportMeshletizer(model, std::filesystem::path{ modelFilepath }.filename().string(), maxVerts, maxPrims);
+			} },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string name = argc > 1 ? argv[1] : "";
+	const FCommand* command = std::find_if(std::begin(Commands), std::end(Commands), [&name](const FCommand& c) { return name == c.m_name; });
+	if (command == std::end(Commands) || argc < 2 + command->m_requiredArgumentCount)
+	{
+		for (const FCommand& usage : Commands)
+		{
+			fprintf(stderr, "%s mesh-tool %s%s%s\n", &usage == Commands ? "Usage:" : "      ", usage.m_name, *usage.m_arguments ? " " : "", usage.m_arguments);
+		}
+
+		fprintf(stderr, "Models that aren't found at the given path are looked up by filename under the content directory.\n");
+		return 1;
+	}
+
+	if (command->m_run)
+	{
+		return command->m_run(argc, argv);
+	}
+
+	std::string modelFilepath = argv[2];
+	if (!std::filesystem::exists(modelFilepath))
+	{
+		modelFilepath = GetFilepathA(modelFilepath);
+	}
+
+	tinygltf::Model model;
+	if (modelFilepath.empty() || !LoadModel(modelFilepath, model))
+	{
+		return 1;
+	}
+
+	return command->m_runOnModel(model, modelFilepath, argc, argv);
+}